@@ -26,6 +26,8 @@
 namespace polaris {
 
 /// @brief 获取单个服务实例请求
+///
+/// 请求对象可以重复使用，重复使用时会复用路由过程中创建的对象，减少内存分配
 class GetOneInstanceRequest : Noncopyable {
  public:
   /// @brief 构建获取单个服务实例请求对象
@@ -312,6 +314,57 @@ class InstancesResponse : Noncopyable {
   Impl* impl_;
 };
 
+/// @brief 服务实例查询结果视图
+///
+/// 与 @ref InstancesResponse 不同，视图不拷贝服务实例，而是引用路由计算得到的实例集合快照。
+/// 视图对象持有快照的引用计数，快照在所有引用它的视图析构后才会释放，因此可以在RCU区间外安全遍历。
+/// 视图对象可拷贝，拷贝只增加引用计数。重复使用同一个视图对象查询可以复用内部对象，避免内存分配
+class InstancesView {
+ public:
+  /// @brief 构造空的服务实例视图
+  InstancesView();
+
+  InstancesView(const InstancesView& other);
+
+  const InstancesView& operator=(const InstancesView& other);
+
+  /// @brief 析构服务实例视图，释放对实例快照的引用
+  ~InstancesView();
+
+  /// @brief 获取应答对应请求流水号
+  uint64_t GetFlowId() const;
+
+  /// @brief 获取服务名
+  const std::string& GetServiceName() const;
+
+  /// @brief 获取命名空间
+  const std::string& GetServiceNamespace() const;
+
+  /// @brief 获取服务元数据
+  const std::map<std::string, std::string>& GetMetadata() const;
+
+  /// @brief 获取服务版本信息
+  const std::string& GetRevision() const;
+
+  /// @brief 获取subset信息
+  const std::map<std::string, std::string>& GetSubset() const;
+
+  /// @brief 获取视图中的服务实例个数
+  std::size_t GetInstancesSize() const;
+
+  /// @brief 获取视图中指定下标的服务实例
+  ///
+  /// @param index 实例下标，必须小于 @ref GetInstancesSize
+  /// @return const Instance& 服务实例引用，在视图对象析构或者重新查询前有效
+  const Instance& GetInstance(std::size_t index) const;
+
+  class Impl;
+  Impl& GetImpl() const;
+
+ private:
+  Impl* impl_;
+};
+
 /// @brief 服务数据就绪通知对象接口
 class ServiceCacheNotify {
  public:
@@ -383,6 +436,14 @@ class ConsumerApi : Noncopyable {
   /// @return ReturnCode 调用结果
   ReturnCode GetOneInstance(const GetOneInstanceRequest& req, InstancesResponse*& resp);
 
+  /// @brief 同步获取单个服务实例，结果写入调用者提供的应答对象
+  ///
+  /// @note 重复使用同一个请求对象和应答对象查询时，稳定状态下不分配内存
+  /// @param req 获取单个服务实例请求
+  /// @param resp 服务实例获取结果，原有结果会被覆盖
+  /// @return ReturnCode 调用结果
+  ReturnCode GetOneInstance(const GetOneInstanceRequest& req, InstancesResponse& resp);
+
   /// @brief 同步获取批量服务实例
   ///
   /// @note 该接口不会返回熔断半开实例，实例熔断后，进入半开如何没有请求一段时间后会自动恢复
@@ -391,6 +452,15 @@ class ConsumerApi : Noncopyable {
   /// @return ReturnCode 调用结果
   ReturnCode GetInstances(const GetInstancesRequest& req, InstancesResponse*& resp);
 
+  /// @brief 同步获取批量服务实例，以视图方式返回，不拷贝服务实例
+  ///
+  /// @note 路由结果与 GetInstances(const GetInstancesRequest&, InstancesResponse*&) 一致
+  ///       实例较多时使用该接口可以避免每个实例的拷贝
+  /// @param req 批量获取服务实例请求
+  /// @param view 服务实例视图，查询成功后引用新的实例快照
+  /// @return ReturnCode 调用结果
+  ReturnCode GetInstances(const GetInstancesRequest& req, InstancesView& view);
+
   /// @brief 同步获取服务下全部服务实例，返回的实例与控制台看到的一致
   ///
   /// @param req 批量获取服务实例请求
@@ -419,6 +489,15 @@ class ConsumerApi : Noncopyable {
   /// @return ReturnCode 调用结果
   ReturnCode UpdateServiceCallResult(const ServiceCallResult& req);
 
+  /// @brief 批量上报服务调用结果，用于服务实例熔断和监控统计
+  /// @note 本调用没有网络操作，只是将数据写入内存。
+  ///       一批调用结果只进入一次RCU区域，相邻的相同服务调用结果共享一次服务上下文查找，
+  ///       适用于框架汇总一段时间内的调用结果后按服务排列上报
+  ///
+  /// @param results 服务实例调用结果列表，某个结果上报失败不影响其他结果的上报
+  /// @return ReturnCode 全部上报成功返回kReturnOk，否则返回最后一个失败的错误码
+  ReturnCode UpdateServiceCallResult(const std::vector<const ServiceCallResult*>& results);
+
   /// @brief 拉取路由规则配置的所有key
   ///
   /// @param service_key  需要预拉取规则的服务
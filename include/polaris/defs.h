@@ -96,6 +96,14 @@ static const LoadBalanceType kLoadBalanceTypeSimpleHash = "simpleHash";
 static const LoadBalanceType kLoadBalanceTypeCMurmurHash = "cMurmurHash";
 // 兼容brpc locality_aware的负载均衡
 static const LoadBalanceType kLoadBalanceTypeLocalityAware = "localityAware";
+// 有界负载的一致性hash，实例进行中的请求数超过平均值一定倍数时顺延到哈希环上的下一个实例
+static const LoadBalanceType kLoadBalanceTypeBoundedLoadHash = "boundedLoadHash";
+// 随机选择两个实例，选择其中进行中请求数较少的实例
+static const LoadBalanceType kLoadBalanceTypeP2CLeastRequest = "p2cLeastRequest";
+// 随机选择两个实例，选择其中 调用耗时峰值加权平均×(进行中请求数+1) 较小的实例
+static const LoadBalanceType kLoadBalanceTypePeakEwma = "peakEwma";
+// 加权最高随机权重哈希，选择与key组合得分最高的实例
+static const LoadBalanceType kLoadBalanceTypeRendezvousHash = "rendezvousHash";
 // 使用全局配置的负载均衡算法
 static const LoadBalanceType kLoadBalanceTypeDefaultConfig = "default";
 
@@ -94,6 +94,13 @@ void SetStatLogger(Logger* logger);
 /// @param log_dir 日志输出目录
 void SetLogDir(const std::string& log_dir);
 
+/// @brief 设置SDK默认日志对象使用异步输出
+///
+/// 开启后调用线程只将日志写入内存缓冲区，由后台线程写入文件，避免日志量大时调用线程竞争文件锁。
+/// 缓冲区满时日志会被丢弃，后台线程会在日志文件中输出丢弃的条数
+/// @note 只对SDK默认日志对象生效，开启后不能关闭
+void EnableAsyncLog();
+
 /// @brief 获取SDK全局日志对象
 Logger* GetLogger();
 
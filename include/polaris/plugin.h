@@ -235,6 +235,17 @@ class LoadBalancer : public Plugin {
   /// @param instance 被选择的服务实例
   /// @return ReturnCode 调用返回码
   virtual ReturnCode ChooseInstance(ServiceInstances* instances, const Criteria& criteria, Instance*& instance) = 0;
+
+  /// @brief 选择多个不重复的服务实例，用于获取备份实例
+  ///
+  /// 默认实现从随机位置开始顺序选择非半开实例，负载均衡插件可以根据自身的选择结构重写
+  /// @param instances 过滤后的服务缓存信息
+  /// @param criteria 负载均衡信息
+  /// @param instance_num 需要新选择的实例数，可选实例不足时选择所有可选实例
+  /// @param selected 已选择的服务实例，新选择的实例追加到末尾，与已有实例均不重复
+  /// @return ReturnCode 调用返回码
+  virtual ReturnCode ChooseInstances(ServiceInstances* instances, const Criteria& criteria, uint32_t instance_num,
+                                     std::vector<Instance*>& selected);
 };
 
 /// @brief 调用统计结果上报
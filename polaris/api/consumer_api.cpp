@@ -28,6 +28,7 @@
 #include "logger.h"
 #include "model/model_impl.h"
 #include "monitor/api_stat.h"
+#include "plugin/load_balancer/instance_load.h"
 #include "plugin/load_balancer/locality_aware/locality_aware.h"
 #include "polaris/config.h"
 #include "polaris/defs.h"
@@ -239,13 +240,16 @@ ConsumerApiImpl::~ConsumerApiImpl() {
 ReturnCode ConsumerApiImpl::PrepareRouteInfo(ServiceContext* service_context, RouteInfo& route_info, const char* action,
                                              uint64_t request_timeout) {
   // 准备路由过滤数据
+  ReusableRouteData* reusable_data = route_info.GetReusableData();
   ServiceData* instances = service_context->GetInstances();
   if (instances != nullptr) {
-    route_info.SetServiceInstances(new ServiceInstances(instances));
+    route_info.SetServiceInstances(reusable_data != nullptr ? reusable_data->GetServiceInstances(instances)
+                                                            : new ServiceInstances(instances));
   }
   ServiceData* routings = service_context->GetRoutings();
   if (routings != nullptr) {
-    route_info.SetServiceRouteRule(new ServiceRouteRule(routings));
+    route_info.SetServiceRouteRule(reusable_data != nullptr ? reusable_data->GetServiceRouteRule(routings)
+                                                            : new ServiceRouteRule(routings));
   }
   route_info.SetCircuitBreakerVersion(service_context->GetCircuitBreakerVersion());
   ServiceRouterChain* router_chain = service_context->GetServiceRouterChain();
@@ -262,6 +266,7 @@ ReturnCode ConsumerApiImpl::GetOneInstance(ServiceContext* service_context, Rout
                                            GetOneInstanceRequest::Impl& request, Instance& instance) {
   if (!request.GetLabels().empty()) {
     route_info.SetLables(request.GetLabels());
+    route_info.SetLabelsStr(request.labels_str_);
   }
   if (request.metadata_param_ != nullptr) {
     route_info.SetMetadataPara(*request.metadata_param_);
@@ -293,6 +298,7 @@ ReturnCode ConsumerApiImpl::GetOneInstance(ServiceContext* service_context, Rout
                 service_key.namespace_.c_str(), service_key.name_.c_str(), ReturnCodeToMsg(ret).c_str());
     return kReturnInstanceNotFound;
   }
+  InstanceLoadTracker::OnInstanceChosen(service_context, load_balancer, select_instance);
 
   // 返回结果
   instance = *select_instance;
@@ -304,8 +310,21 @@ ReturnCode ConsumerApiImpl::GetOneInstance(ServiceContext* service_context, Rout
 
 ReturnCode ConsumerApiImpl::GetOneInstance(ServiceContext* service_context, RouteInfo& route_info,
                                            GetOneInstanceRequest::Impl& req_impl, InstancesResponse*& resp) {
+  InstancesResponse* response = new InstancesResponse();
+  ReturnCode ret = GetOneInstance(service_context, route_info, req_impl, response->GetImpl());
+  if (ret != kReturnOk) {
+    delete response;
+    return ret;
+  }
+  resp = response;
+  return kReturnOk;
+}
+
+ReturnCode ConsumerApiImpl::GetOneInstance(ServiceContext* service_context, RouteInfo& route_info,
+                                           GetOneInstanceRequest::Impl& req_impl, InstancesResponse::Impl& resp_impl) {
   if (!req_impl.GetLabels().empty()) {
     route_info.SetLables(req_impl.GetLabels());
+    route_info.SetLabelsStr(req_impl.labels_str_);
   }
   if (req_impl.metadata_param_ != nullptr) {
     route_info.SetMetadataPara(*req_impl.metadata_param_);
@@ -343,144 +362,85 @@ ReturnCode ConsumerApiImpl::GetOneInstance(ServiceContext* service_context, Rout
                 service_key.namespace_.c_str(), service_key.name_.c_str(), ReturnCodeToMsg(ret).c_str());
     return kReturnInstanceNotFound;
   }
+  InstanceLoadTracker::OnInstanceChosen(service_context, load_balancer, instance);
 
-  // 选取backup实例
-  std::vector<Instance*> backup_instances;
-  backup_instances.push_back(instance);
-  GetBackupInstances(service_instances, load_balancer, req_impl.backup_instance_num_, req_impl.criteria_,
-                     backup_instances);
-
-  // 返回结果
-  resp = new InstancesResponse();
-  InstancesResponse::Impl& resp_impl = resp->GetImpl();
+  // 返回结果，复用应答对象已有的内存
   resp_impl.flow_id_ = req_impl.flow_id_.Value();
   resp_impl.metadata_ = service_instances->GetServiceMetadata();
   resp_impl.service_name_ = route_info.GetServiceKey().name_;
   resp_impl.service_namespace_ = route_info.GetServiceKey().namespace_;
   resp_impl.revision_ = service_instances->GetServiceData()->GetRevision();
   resp_impl.subset_ = route_result.GetSubset();
-  for (auto& instance : backup_instances) {
-    resp_impl.instances_.push_back(*instance);
-    if (instance->GetLocalityAwareInfo() > 0) {
-      delete instance;
+  resp_impl.instances_.clear();
+  resp_impl.instances_.push_back(*instance);
+  if (req_impl.backup_instance_num_ > 0) {  // 选取backup实例
+    std::vector<Instance*> backup_instances;
+    backup_instances.push_back(instance);
+    GetBackupInstances(service_instances, load_balancer, req_impl.backup_instance_num_, req_impl.criteria_,
+                       backup_instances);
+    for (std::size_t i = 1; i < backup_instances.size(); ++i) {
+      resp_impl.instances_.push_back(*backup_instances[i]);
+      if (backup_instances[i]->GetLocalityAwareInfo() > 0) {
+        delete backup_instances[i];
+      }
     }
   }
+  if (instance->GetLocalityAwareInfo() > 0) {
+    delete instance;
+  }
   return kReturnOk;
 }
 
 void ConsumerApiImpl::GetBackupInstances(ServiceInstances* service_instances, LoadBalancer* load_balancer,
                                          uint32_t backup_instance_num, const Criteria& criteria,
                                          std::vector<Instance*>& backup_instances) {
-  uint32_t target_num = backup_instance_num + 1;  // 加负载均衡选的那一个
-  if (target_num <= 1) {
+  if (backup_instance_num == 0) {
     return;
   }
-
-  LoadBalanceType lb_type = load_balancer->GetLoadBalanceType();  // 不从request中取，规避default
-  InstancesSet* instances_set = service_instances->GetAvailableInstances();
-  std::vector<Instance*> instances = instances_set->GetInstances();
-  Instance* instance = nullptr;
-  ReturnCode ret = kReturnOk;
-
-  // 内部ringhash, 返回节点后相邻的backup个不重复节点
-  if (lb_type == kLoadBalanceTypeRingHash || lb_type == kLoadBalanceTypeL5CstHash ||
-      lb_type == kLoadBalanceTypeCMurmurHash) {
-    uint32_t available_num = instances.size();  // 不考虑半开
-    if (target_num > available_num) {
-      POLARIS_LOG(LOG_WARN, "available instance num %d is small than needed instance num %d", available_num,
-                  target_num);
-      target_num = available_num;  // 修正目标值
-    }
-    int cycle_times = available_num;  // 循环次数上限
-    Criteria criteria_tmp = criteria;
-
-    for (int i = 1; i <= cycle_times; ++i) {
-      if (backup_instances.size() >= target_num) {
-        break;
-      }
-      criteria_tmp.replicate_index_ = i;
-      ret = load_balancer->ChooseInstance(service_instances, criteria_tmp, instance);
-      if (ret != kReturnOk) {
-        POLARIS_LOG(LOG_ERROR, "load balancer %s choose backup instance error %d", lb_type.c_str(), ret);
-        return;
-      }
-      // 添加不重复的节点到数组
-      bool repeat_flag = false;
-      for (size_t j = 0; j < backup_instances.size(); ++j) {
-        if (backup_instances[j]->GetId() == instance->GetId()) {
-          repeat_flag = true;
-          break;
-        }
-      }
-      if (repeat_flag == false) {
-        backup_instances.push_back(instance);
-      }
-    }
+  // 由负载均衡插件选择与已选实例不重复的实例：哈希类负载均衡返回哈希位置之后的实例，其它负载均衡返回随机的实例
+  ReturnCode ret = load_balancer->ChooseInstances(service_instances, criteria, backup_instance_num, backup_instances);
+  if (ret != kReturnOk) {
+    POLARIS_LOG(LOG_ERROR, "load balancer %s choose backup instance error %d",
+                load_balancer->GetLoadBalanceType().c_str(), ret);
     return;
   }
-
-  // 其它负载均衡
-  std::set<Instance*> half_open_instances;
-  service_instances->GetHalfOpenInstances(half_open_instances);  // 半开实例
-  instance = backup_instances[0];
-
-  uint32_t available_num = instances.size() - half_open_instances.size();
-  if (target_num > available_num) {
-    POLARIS_LOG(LOG_WARN, "available instance num %d is small than needed instance num %d", available_num, target_num);
-    target_num = available_num;
+  uint32_t target_num = backup_instance_num + 1;  // 加负载均衡选的那一个
+  if (backup_instances.size() < target_num) {
+    POLARIS_LOG(LOG_WARN, "available instance num %zu is small than needed instance num %u", backup_instances.size(),
+                target_num);
   }
+}
 
-  // 获取一个随机数
-  static __thread bool thread_local_seed_not_init = true;
-  static __thread unsigned int thread_local_seed = 0;
-  if (thread_local_seed_not_init) {
-    thread_local_seed_not_init = false;
-    thread_local_seed = time(nullptr) ^ pthread_self();
-  }
-  uint32_t index = rand_r(&thread_local_seed) % instances.size();
-  // 选择backup实例
-  for (size_t i = 0; i < instances.size(); ++i, ++index) {
-    if (backup_instances.size() >= target_num) {
-      break;  // 实例数已足够
-    }
-    if (index == instances.size()) {
-      index = 0;  // 回到起点
-    }
-    Instance*& item = instances[index];
-    if (item->GetId() == instance->GetId() || half_open_instances.find(item) != half_open_instances.end()) {
-      continue;  // 实例是负载均衡器选择的实例，或是一个半开实例
+ReturnCode ConsumerApiImpl::RouteInstances(ServiceContext* service_context, RouteInfo& route_info,
+                                           GetInstancesRequest::Impl& req_impl,
+                                           std::set<std::string>& open_instances_set) {
+  if (req_impl.GetSkipRouteFilter()) {
+    if (!req_impl.GetIncludeCircuitBreakerInstances()) {  // 需要过滤熔断实例
+      open_instances_set = route_info.GetServiceInstances()->GetService()->GetCircuitBreakerOpenInstances();
     }
-    backup_instances.push_back(item);
+    return kReturnOk;
   }
+  if (req_impl.GetIncludeCircuitBreakerInstances()) {
+    route_info.SetIncludeCircuitBreakerInstances();
+  }
+  if (req_impl.GetIncludeUnhealthyInstances()) {
+    route_info.SetIncludeUnhealthyInstances();
+  }
+  if (req_impl.metadata_param_ != nullptr) {
+    route_info.SetMetadataPara(*req_impl.metadata_param_);
+  }
+  RouteResult route_result;
+  return service_context->GetServiceRouterChain()->DoRoute(route_info, &route_result);
 }
 
 ReturnCode ConsumerApiImpl::GetInstances(ServiceContext* service_context, RouteInfo& route_info,
                                          GetInstancesRequest::Impl& req_impl, InstancesResponse*& resp) {
-  ReturnCode ret;
-  ServiceRouterChain* router_chain = service_context->GetServiceRouterChain();
-  ServiceInstances* service_instances;
   std::set<std::string> open_instances_set;
-  if (req_impl.GetSkipRouteFilter()) {
-    service_instances = route_info.GetServiceInstances();
-    if (!req_impl.GetIncludeCircuitBreakerInstances()) {  // 需要过滤熔断实例
-      open_instances_set = service_instances->GetService()->GetCircuitBreakerOpenInstances();
-    }
-  } else {
-    if (req_impl.GetIncludeCircuitBreakerInstances()) {
-      route_info.SetIncludeCircuitBreakerInstances();
-    }
-    if (req_impl.GetIncludeUnhealthyInstances()) {
-      route_info.SetIncludeUnhealthyInstances();
-    }
-    if (req_impl.metadata_param_ != nullptr) {
-      route_info.SetMetadataPara(*req_impl.metadata_param_);
-    }
-    RouteResult route_result;
-    if ((ret = router_chain->DoRoute(route_info, &route_result)) != kReturnOk) {
-      return ret;
-    }
-    service_instances = route_info.GetServiceInstances();
+  ReturnCode ret = RouteInstances(service_context, route_info, req_impl, open_instances_set);
+  if (ret != kReturnOk) {
+    return ret;
   }
+  ServiceInstances* service_instances = route_info.GetServiceInstances();
   InstancesSet* instances_set = service_instances->GetAvailableInstances();
   const std::vector<Instance*>& instances = instances_set->GetInstances();
   if (instances.empty()) {
@@ -502,6 +462,34 @@ ReturnCode ConsumerApiImpl::GetInstances(ServiceContext* service_context, RouteI
   return kReturnOk;
 }
 
+ReturnCode ConsumerApiImpl::GetInstances(ServiceContext* service_context, RouteInfo& route_info,
+                                         GetInstancesRequest::Impl& req_impl, InstancesView::Impl& view_impl) {
+  std::set<std::string> open_instances_set;
+  ReturnCode ret = RouteInstances(service_context, route_info, req_impl, open_instances_set);
+  if (ret != kReturnOk) {
+    return ret;
+  }
+  ServiceInstances* service_instances = route_info.GetServiceInstances();
+  InstancesSet* instances_set = service_instances->GetAvailableInstances();
+  const std::vector<Instance*>& instances = instances_set->GetInstances();
+  if (instances.empty()) {
+    return kReturnInstanceNotFound;
+  }
+
+  // 只增加实例快照的引用计数，不拷贝实例
+  view_impl.Reset(service_instances->GetServiceData(), instances_set, &service_instances->GetServiceMetadata());
+  view_impl.flow_id_ = req_impl.flow_id_.Value();
+  if (!open_instances_set.empty()) {  // 跳过路由时才需要过滤熔断实例
+    view_impl.use_filtered_ = true;
+    for (std::size_t i = 0; i < instances.size(); ++i) {
+      if (open_instances_set.find(instances[i]->GetId()) == open_instances_set.end()) {
+        view_impl.filtered_instances_.push_back(instances[i]);
+      }
+    }
+  }
+  return kReturnOk;
+}
+
 template <typename R>
 inline bool CheckAndSetRequest(R& request, const char* action, Context* context) {
   // 检查请求参数
@@ -579,6 +567,24 @@ ReturnCode ConsumerApi::GetServiceRouteRule(const ServiceKey& service_key, uint6
   return kReturnOk;
 }
 
+// 占用请求对象的复用路由数据，同一请求对象被多个线程同时使用时只有一个线程复用
+class ReusableRouteDataGuard {
+ public:
+  explicit ReusableRouteDataGuard(ReusableRouteData& reusable_data)
+      : reusable_data_(reusable_data.TryAcquire() ? &reusable_data : nullptr) {}
+
+  ~ReusableRouteDataGuard() {
+    if (reusable_data_ != nullptr) {
+      reusable_data_->Release();
+    }
+  }
+
+  ReusableRouteData* Get() const { return reusable_data_; }
+
+ private:
+  ReusableRouteData* reusable_data_;
+};
+
 ReturnCode ConsumerApi::GetOneInstance(const GetOneInstanceRequest& req, Instance& instance) {
   Context* context = impl_->GetContext();
   ContextImpl* context_impl = context->GetContextImpl();
@@ -597,7 +603,9 @@ ReturnCode ConsumerApi::GetOneInstance(const GetOneInstanceRequest& req, Instanc
     RECORD_THEN_RETURN(kReturnInvalidConfig);
   }
 
+  ReusableRouteDataGuard reusable_data_guard(req_impl.reusable_route_data_);
   RouteInfo route_info(req_impl.service_key_, req_impl.source_service_.get());
+  route_info.SetReusableData(reusable_data_guard.Get());
   ReturnCode ret = ConsumerApiImpl::PrepareRouteInfo(service_context, route_info, __func__, req_impl.timeout_.Value());
   if (POLARIS_LIKELY(ret == kReturnOk)) {
     ret = ConsumerApiImpl::GetOneInstance(service_context, route_info, req_impl, instance);
@@ -625,7 +633,9 @@ ReturnCode ConsumerApi::GetOneInstance(const GetOneInstanceRequest& req, Instanc
     RECORD_THEN_RETURN(kReturnInvalidConfig);
   }
 
+  ReusableRouteDataGuard reusable_data_guard(req_impl.reusable_route_data_);
   RouteInfo route_info(req_impl.service_key_, req_impl.source_service_.get());
+  route_info.SetReusableData(reusable_data_guard.Get());
   ReturnCode ret = ConsumerApiImpl::PrepareRouteInfo(service_context, route_info, __func__, req_impl.timeout_.Value());
   if (ret == kReturnOk) {
     ret = ConsumerApiImpl::GetOneInstance(service_context, route_info, req_impl, resp);
@@ -635,6 +645,36 @@ ReturnCode ConsumerApi::GetOneInstance(const GetOneInstanceRequest& req, Instanc
   RECORD_THEN_RETURN(ret);
 }
 
+ReturnCode ConsumerApi::GetOneInstance(const GetOneInstanceRequest& req, InstancesResponse& resp) {
+  Context* context = impl_->GetContext();
+  ContextImpl* context_impl = context->GetContextImpl();
+  ApiStat api_stat(context_impl, kApiStatConsumerGetOne);
+  GetOneInstanceRequest::Impl& req_impl = req.GetImpl();
+  if (POLARIS_UNLIKELY(!CheckAndSetRequest(req_impl, __func__, context))) {
+    RECORD_THEN_RETURN(kReturnInvalidArgument);
+  }
+
+  POLARIS_FORK_CHECK()
+
+  context_impl->RcuEnter();
+  ServiceContext* service_context = context_impl->GetServiceContext(req_impl.service_key_);
+  if (POLARIS_UNLIKELY(service_context == nullptr)) {
+    context_impl->RcuExit();
+    RECORD_THEN_RETURN(kReturnInvalidConfig);
+  }
+
+  ReusableRouteDataGuard reusable_data_guard(req_impl.reusable_route_data_);
+  RouteInfo route_info(req_impl.service_key_, req_impl.source_service_.get());
+  route_info.SetReusableData(reusable_data_guard.Get());
+  ReturnCode ret = ConsumerApiImpl::PrepareRouteInfo(service_context, route_info, __func__, req_impl.timeout_.Value());
+  if (POLARIS_LIKELY(ret == kReturnOk)) {
+    ret = ConsumerApiImpl::GetOneInstance(service_context, route_info, req_impl, resp.GetImpl());
+  }
+
+  context_impl->RcuExit();
+  RECORD_THEN_RETURN(ret);
+}
+
 ReturnCode ConsumerApi::GetInstances(const GetInstancesRequest& req, InstancesResponse*& resp) {
   Context* context = impl_->GetContext();
   ContextImpl* context_impl = context->GetContextImpl();
@@ -662,6 +702,37 @@ ReturnCode ConsumerApi::GetInstances(const GetInstancesRequest& req, InstancesRe
   RECORD_THEN_RETURN(ret);
 }
 
+ReturnCode ConsumerApi::GetInstances(const GetInstancesRequest& req, InstancesView& view) {
+  Context* context = impl_->GetContext();
+  ContextImpl* context_impl = context->GetContextImpl();
+  ApiStat api_stat(context_impl, kApiStatConsumerGetBatch);
+  GetInstancesRequest::Impl& req_impl = req.GetImpl();
+  if (!CheckAndSetRequest(req_impl, __func__, context)) {
+    RECORD_THEN_RETURN(kReturnInvalidArgument);
+  }
+
+  POLARIS_FORK_CHECK()
+
+  if (!view.GetImpl().IsUnique()) {  // 视图被拷贝过，不能修改共享的快照
+    view = InstancesView();
+  }
+
+  context_impl->RcuEnter();
+  ServiceContext* service_context = context_impl->GetServiceContext(req_impl.service_key_);
+  if (service_context == nullptr) {
+    context_impl->RcuExit();
+    RECORD_THEN_RETURN(kReturnInvalidConfig);
+  }
+
+  RouteInfo route_info(req_impl.service_key_, req_impl.source_service_.get());
+  ReturnCode ret = ConsumerApiImpl::PrepareRouteInfo(service_context, route_info, __func__, req_impl.timeout_.Value());
+  if (ret == kReturnOk) {
+    ret = ConsumerApiImpl::GetInstances(service_context, route_info, req_impl, view.GetImpl());
+  }
+  context_impl->RcuExit();
+  RECORD_THEN_RETURN(ret);
+}
+
 ReturnCode ConsumerApi::GetAllInstances(const GetInstancesRequest& req, InstancesResponse*& resp) {
   Context* context = impl_->GetContext();
   ContextImpl* context_impl = context->GetContextImpl();
@@ -769,6 +840,22 @@ ReturnCode ConsumerApi::AsyncGetInstances(const GetInstancesRequest& req, Instan
   return kReturnOk;
 }
 
+// 检查调用结果的实例参数，只设置了Host:Port时查找对应的服务实例ID
+static ReturnCode PrepareInstanceGauge(ContextImpl* context_impl, ServiceCallResult::Impl& req_impl) {
+  InstanceGauge& instance_gauge = req_impl.gauge_;
+  if (instance_gauge.instance_id.empty()) {
+    if (req_impl.instance_host_port_ == nullptr) {
+      POLARIS_LOG(LOG_ERROR, "update service call result failed because InstanceId and Host:Port is empty");
+      return kReturnInvalidArgument;
+    }
+    // 通过Host:Port获取服务实例ID
+    CacheManager* cache_manager = context_impl->GetCacheManager();
+    const ServiceKey& service_key = instance_gauge.service_key_;
+    return cache_manager->GetInstanceId(service_key, *req_impl.instance_host_port_, instance_gauge.instance_id);
+  }
+  return kReturnOk;
+}
+
 ReturnCode ConsumerApi::UpdateServiceCallResult(const ServiceCallResult& req) {
   Context* context = impl_->GetContext();
   ContextImpl* context_impl = context->GetContextImpl();
@@ -783,22 +870,47 @@ ReturnCode ConsumerApi::UpdateServiceCallResult(const ServiceCallResult& req) {
   POLARIS_FORK_CHECK()
 
   // 设置Gauge
-  InstanceGauge& instance_gauge = req_impl.gauge_;
-  ReturnCode ret_code;
-  if (instance_gauge.instance_id.empty()) {
-    if (req_impl.instance_host_port_ == nullptr) {
-      POLARIS_LOG(LOG_ERROR, "%s failed because InstanceId and Host:Port is empty", __func__);
-      RECORD_THEN_RETURN(kReturnInvalidArgument);
+  ReturnCode ret_code = PrepareInstanceGauge(context_impl, req_impl);
+  if (ret_code != kReturnOk) {
+    RECORD_THEN_RETURN(ret_code);
+  }
+  ret_code = impl_->UpdateServiceCallResult(context, req_impl.gauge_);
+  RECORD_THEN_RETURN(ret_code);
+}
+
+ReturnCode ConsumerApi::UpdateServiceCallResult(const std::vector<const ServiceCallResult*>& results) {
+  Context* context = impl_->GetContext();
+  ContextImpl* context_impl = context->GetContextImpl();
+  ApiStat api_stat(context_impl, kApiStatConsumerCallResult);
+  POLARIS_FORK_CHECK()
+
+  ReturnCode ret_code = kReturnOk;
+  std::vector<const InstanceGauge*> gauges;
+  gauges.reserve(results.size());
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    if (results[i] == nullptr) {
+      ret_code = kReturnInvalidArgument;
+      continue;
     }
-    // 通过Host:Port获取服务实例ID
-    CacheManager* cache_manager = context_impl->GetCacheManager();
-    const ServiceKey& service_key = instance_gauge.service_key_;
-    ret_code = cache_manager->GetInstanceId(service_key, *req_impl.instance_host_port_, instance_gauge.instance_id);
-    if (ret_code != kReturnOk) {
-      RECORD_THEN_RETURN(ret_code);
+    ServiceCallResult::Impl& req_impl = results[i]->GetImpl();
+    if (req_impl.gauge_.service_key_.name_.empty()) {
+      POLARIS_LOG(LOG_ERROR, "%s failed because request's service name is empty", __func__);
+      ret_code = kReturnInvalidArgument;
+      continue;
+    }
+    ReturnCode prepare_ret = PrepareInstanceGauge(context_impl, req_impl);
+    if (prepare_ret == kReturnOk) {
+      gauges.push_back(&req_impl.gauge_);
+    } else {
+      ret_code = prepare_ret;
+    }
+  }
+  if (!gauges.empty()) {
+    ReturnCode update_ret = impl_->UpdateServiceCallResult(context, gauges);
+    if (update_ret != kReturnOk) {
+      ret_code = update_ret;
     }
   }
-  ret_code = impl_->UpdateServiceCallResult(context, instance_gauge);
   RECORD_THEN_RETURN(ret_code);
 }
 
@@ -849,6 +961,42 @@ ReturnCode ConsumerApiImpl::UpdateServiceCallResult(Context* context, const Inst
     context_impl->RcuExit();
     return kReturnInvalidArgument;
   }
+  ReturnCode ret_code = ReportCallResult(context_impl, service_context, gauge);
+  context_impl->RcuExit();
+  return ret_code;
+}
+
+ReturnCode ConsumerApiImpl::UpdateServiceCallResult(Context* context, const std::vector<const InstanceGauge*>& gauges) {
+  ContextImpl* context_impl = context->GetContextImpl();
+  ReturnCode ret_code = kReturnOk;
+  const ServiceKey* last_service_key = nullptr;
+  ServiceContext* service_context = nullptr;
+  context_impl->RcuEnter();
+  for (std::size_t i = 0; i < gauges.size(); ++i) {
+    const InstanceGauge& gauge = *gauges[i];
+    const ServiceKey& service_key = gauge.service_key_;
+    // 与上一个调用结果服务相同时复用服务上下文
+    if (last_service_key == nullptr || !(*last_service_key == service_key)) {
+      service_context = context_impl->GetServiceContext(service_key);
+      last_service_key = &service_key;
+    }
+    if (service_context == nullptr) {
+      POLARIS_LOG(LOG_ERROR, "update service call result failed because context of service[%s/%s] not exist",
+                  service_key.namespace_.c_str(), service_key.name_.c_str());
+      ret_code = kReturnInvalidArgument;
+      continue;
+    }
+    ReturnCode report_ret = ReportCallResult(context_impl, service_context, gauge);
+    if (report_ret != kReturnOk) {
+      ret_code = report_ret;
+    }
+  }
+  context_impl->RcuExit();
+  return ret_code;
+}
+
+ReturnCode ConsumerApiImpl::ReportCallResult(ContextImpl* context_impl, ServiceContext* service_context,
+                                             const InstanceGauge& gauge) {
   // 执行上报统计插件
   StatReporter* stat_reporter = context_impl->GetStatReporter();
   stat_reporter->ReportStat(gauge);
@@ -860,21 +1008,22 @@ ReturnCode ConsumerApiImpl::UpdateServiceCallResult(Context* context, const Inst
     if (load_balancer == nullptr) {
       return kReturnPluginError;
     }
-    if (load_balancer != nullptr) {
-      LocalityAwareLoadBalancer* locality_aware_load_balancer = dynamic_cast<LocalityAwareLoadBalancer*>(load_balancer);
-      if (locality_aware_load_balancer != nullptr) {
-        FeedbackInfo info;
-        info.call_daley = gauge.call_daley * 1000;  // ms -> us
-        info.instance_id = gauge.instance_id;
-        info.locality_aware_info = gauge.locality_aware_info;
-        locality_aware_load_balancer->Feedback(info);
-      }
+    LocalityAwareLoadBalancer* locality_aware_load_balancer = dynamic_cast<LocalityAwareLoadBalancer*>(load_balancer);
+    if (locality_aware_load_balancer != nullptr) {
+      FeedbackInfo info;
+      info.call_daley = gauge.call_daley * 1000;  // ms -> us
+      info.instance_id = gauge.instance_id;
+      info.locality_aware_info = gauge.locality_aware_info;
+      locality_aware_load_balancer->Feedback(info);
     }
   }
+  // 感知实例负载的负载均衡根据调用结果更新实例负载
+  if (service_context->IsLoadAware()) {
+    InstanceLoadTracker::UpdateCallResult(service_context, gauge);
+  }
   // 执行熔断插件
   CircuitBreakerChain* circuit_breaker_chain = service_context->GetCircuitBreakerChain();
   circuit_breaker_chain->RealTimeCircuitBreak(gauge);
-  context_impl->RcuExit();
   return kReturnOk;
 }
 
@@ -15,6 +15,7 @@
 #define POLARIS_CPP_POLARIS_API_CONSUMER_API_H_
 
 #include <stdint.h>
+#include <set>
 #include <string>
 
 #include "context/context_impl.h"
@@ -76,11 +77,19 @@ class ConsumerApiImpl {
   static ReturnCode GetOneInstance(ServiceContext* service_context, RouteInfo& route_info,
                                    GetOneInstanceRequest::Impl& req_impl, InstancesResponse*& resp);
 
+  static ReturnCode GetOneInstance(ServiceContext* service_context, RouteInfo& route_info,
+                                   GetOneInstanceRequest::Impl& req_impl, InstancesResponse::Impl& resp_impl);
+
   static ReturnCode GetInstances(ServiceContext* service_context, RouteInfo& route_info,
                                  GetInstancesRequest::Impl& req_impl, InstancesResponse*& resp);
 
+  static ReturnCode GetInstances(ServiceContext* service_context, RouteInfo& route_info,
+                                 GetInstancesRequest::Impl& req_impl, InstancesView::Impl& view_impl);
+
   static ReturnCode UpdateServiceCallResult(Context* context, const InstanceGauge& gauge);
 
+  static ReturnCode UpdateServiceCallResult(Context* context, const std::vector<const InstanceGauge*>& gauges);
+
   static ReturnCode GetSystemServer(Context* context, const ServiceKey& service_key, const Criteria& criteria,
                                     Instance*& instance, uint64_t timeout, const std::string& protocol = "grpc");
 
@@ -91,6 +100,14 @@ class ConsumerApiImpl {
   Context* GetContext() const { return context_; }
 
  private:
+  // 执行批量获取实例的路由，跳过路由时返回需要过滤的熔断实例
+  static ReturnCode RouteInstances(ServiceContext* service_context, RouteInfo& route_info,
+                                   GetInstancesRequest::Impl& req_impl, std::set<std::string>& open_instances_set);
+
+  // 在RCU区域内执行调用结果的统计上报和熔断
+  static ReturnCode ReportCallResult(ContextImpl* context_impl, ServiceContext* service_context,
+                                     const InstanceGauge& gauge);
+
   static void GetBackupInstances(ServiceInstances* service_instances, LoadBalancer* load_balancer,
                                  uint32_t backup_instance_num, const Criteria& criteria,
                                  std::vector<Instance*>& backup_instances);
@@ -23,6 +23,7 @@
 #include "polaris/context.h"
 #include "polaris/plugin.h"
 #include "reactor/reactor.h"
+#include "utils/ip_utils.h"
 #include "utils/time_clock.h"
 
 namespace polaris {
@@ -160,6 +161,9 @@ void CacheManager::SubmitServiceDataChange(ServiceData* service_data) {
 }
 
 void CacheManager::OnServiceDataChange(ServiceData* service_data) {
+  if (service_data->GetDataType() == kServiceDataInstances) {
+    UpdateServiceHostPort(service_data);
+  }
   ServiceKeyWithType service_key_with_type;
   service_key_with_type.service_key_ = service_data->GetServiceKey();
   service_key_with_type.data_type_ = service_data->GetDataType();
@@ -184,6 +188,56 @@ void CacheManager::OnServiceDataChange(ServiceData* service_data) {
   }
 }
 
+void InstanceHostPortKey::Set(const std::string& host, int port) {
+  host_ = host;
+  port_ = port;
+  address_.port_ = port;
+  is_ip_ = IpUtils::StrIpToInt128(host, address_.ip_high_, address_.ip_low_);
+}
+
+void ServiceHostPort::AddInstance(const InstanceHostPortKey& host_port_key, const std::string& instance_id) {
+  if (host_port_key.is_ip_) {
+    address_mapping_.insert(std::make_pair(host_port_key.address_, instance_id));
+  } else {
+    mapping_.insert(std::make_pair(host_port_key, instance_id));
+  }
+}
+
+const std::string* ServiceHostPort::FindInstanceId(const InstanceHostPortKey& host_port_key) const {
+  if (host_port_key.is_ip_) {
+    std::unordered_map<InstanceAddressKey, std::string, InstanceAddressKeyHash>::const_iterator it =
+        address_mapping_.find(host_port_key.address_);
+    return it != address_mapping_.end() ? &it->second : nullptr;
+  }
+  std::map<InstanceHostPortKey, std::string>::const_iterator it = mapping_.find(host_port_key);
+  return it != mapping_.end() ? &it->second : nullptr;
+}
+
+ServiceHostPort* CacheManager::BuildServiceHostPort(ServiceData* service_data) {
+  ServiceHostPort* host_port_data = new ServiceHostPort(service_data->GetCacheVersion());
+  ServiceInstances service_instances(service_data);
+  std::map<std::string, Instance*>& instances = service_instances.GetInstances();
+  InstanceHostPortKey key;
+  for (std::map<std::string, Instance*>::iterator it = instances.begin(); it != instances.end(); ++it) {
+    key.Set(it->second->GetHost(), it->second->GetPort());
+    host_port_data->AddInstance(key, it->first);
+  }
+  return host_port_data;
+}
+
+void CacheManager::UpdateServiceHostPort(ServiceData* service_data) {
+  const ServiceKey& service_key = service_data->GetServiceKey();
+  ServiceHostPort* host_port_data = host_port_cache_.Get(service_key, false);
+  if (host_port_data == nullptr) {  // 没有通过Host:Port上报过的服务不创建索引
+    return;
+  }
+  bool need_update = host_port_data->GetVersion() < service_data->GetCacheVersion();
+  host_port_data->DecrementRef();
+  if (need_update) {
+    host_port_cache_.Update(service_key, BuildServiceHostPort(service_data));
+  }
+}
+
 ReturnCode CacheManager::GetOrCreateServiceHostPort(const ServiceKey& service_key, ServiceHostPort*& host_port_data) {
   LocalRegistry* local_register = context_->GetLocalRegistry();
   ServiceData* service_data = nullptr;
@@ -196,21 +250,14 @@ ReturnCode CacheManager::GetOrCreateServiceHostPort(const ServiceKey& service_ke
     return ret_code;
   }
   if (host_port_data != nullptr) {
-    if (host_port_data->version_ >= service_data->GetCacheVersion()) {
+    if (host_port_data->GetVersion() >= service_data->GetCacheVersion()) {
       host_port_data->DecrementRef();
+      service_data->DecrementRef();
       return kReturnInstanceNotFound;
     }
     host_port_data->DecrementRef();
   }
-  host_port_data = new ServiceHostPort();
-  host_port_data->version_ = service_data->GetCacheVersion();
-  ServiceInstances service_instances(service_data);
-  std::map<std::string, Instance*> instances = service_instances.GetInstances();
-  std::map<std::string, Instance*>::iterator it;
-  for (it = instances.begin(); it != instances.end(); ++it) {
-    InstanceHostPortKey key = {it->second->GetHost(), it->second->GetPort()};
-    host_port_data->mapping_.insert(std::make_pair(key, it->first));
-  }
+  host_port_data = BuildServiceHostPort(service_data);
   host_port_data->IncrementRef();
   host_port_cache_.Update(service_key, host_port_data);
   service_data->DecrementRef();
@@ -220,10 +267,10 @@ ReturnCode CacheManager::GetOrCreateServiceHostPort(const ServiceKey& service_ke
 ReturnCode CacheManager::GetInstanceId(const ServiceKey& service_key, const InstanceHostPortKey& host_port_key,
                                        std::string& instance_id) {
   ServiceHostPort* host_port_data = host_port_cache_.Get(service_key);
-  std::map<InstanceHostPortKey, std::string>::iterator it;
+  const std::string* found_id;
   if (host_port_data != nullptr) {
-    if ((it = host_port_data->mapping_.find(host_port_key)) != host_port_data->mapping_.end()) {
-      instance_id = it->second;
+    if ((found_id = host_port_data->FindInstanceId(host_port_key)) != nullptr) {
+      instance_id = *found_id;  // 复用调用方已有的字符串空间
       host_port_data->DecrementRef();
       return kReturnOk;
     }
@@ -233,8 +280,8 @@ ReturnCode CacheManager::GetInstanceId(const ServiceKey& service_key, const Inst
     return ret_code;
   }
   // 拿到更新数据后再找一次
-  if ((it = host_port_data->mapping_.find(host_port_key)) != host_port_data->mapping_.end()) {
-    instance_id = it->second;
+  if ((found_id = host_port_data->FindInstanceId(host_port_key)) != nullptr) {
+    instance_id = *found_id;
     host_port_data->DecrementRef();
     return kReturnOk;
   }
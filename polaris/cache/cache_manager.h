@@ -19,6 +19,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "cache/rcu_map.h"
@@ -61,9 +62,37 @@ class ServiceDataChangeTask : public Task {
   ServiceData* service_data_;
 };
 
+/// @brief 解析后的实例IP地址和端口，IP统一转换为128位整数，查找时无需比较字符串
+struct InstanceAddressKey {
+  uint64_t ip_high_;
+  uint64_t ip_low_;
+  int port_;
+};
+
+inline bool operator==(InstanceAddressKey const& lhs, InstanceAddressKey const& rhs) {
+  return lhs.ip_low_ == rhs.ip_low_ && lhs.port_ == rhs.port_ && lhs.ip_high_ == rhs.ip_high_;
+}
+
+struct InstanceAddressKeyHash {
+  std::size_t operator()(const InstanceAddressKey& key) const {
+    uint64_t hash = key.ip_low_ ^ (key.ip_high_ * 0x9e3779b97f4a7c15ULL) ^ (static_cast<uint64_t>(key.port_) << 48);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return static_cast<std::size_t>(hash);
+  }
+};
+
 struct InstanceHostPortKey {
+  InstanceHostPortKey() : port_(0), is_ip_(false) {}
+
+  /// @brief 设置host和port，host为IP地址时同时解析出地址key
+  void Set(const std::string& host, int port);
+
   std::string host_;
   int port_;
+  bool is_ip_;
+  InstanceAddressKey address_;  // is_ip_为true时有效
 };
 
 inline bool operator<(InstanceHostPortKey const& lhs, InstanceHostPortKey const& rhs) {
@@ -74,9 +103,21 @@ inline bool operator<(InstanceHostPortKey const& lhs, InstanceHostPortKey const&
   }
 }
 
+/// @brief 服务实例Host:Port到实例ID的索引，IP地址实例使用hash查找，域名等其他实例使用字符串查找
 class ServiceHostPort : public ServiceBase {
  public:
+  explicit ServiceHostPort(uint64_t version) : version_(version) {}
+
+  void AddInstance(const InstanceHostPortKey& host_port_key, const std::string& instance_id);
+
+  /// @brief 查找实例ID，不存在时返回NULL
+  const std::string* FindInstanceId(const InstanceHostPortKey& host_port_key) const;
+
+  uint64_t GetVersion() const { return version_; }
+
+ private:
   uint64_t version_;
+  std::unordered_map<InstanceAddressKey, std::string, InstanceAddressKeyHash> address_mapping_;
   std::map<InstanceHostPortKey, std::string> mapping_;
 };
 
@@ -118,6 +159,12 @@ class CacheManager : public Executor {
 
   ReturnCode GetOrCreateServiceHostPort(const ServiceKey& service_key, ServiceHostPort*& host_port_data);
 
+  // 服务实例变更时，已经创建过的Host:Port索引立即重建，避免上报时重建
+  // 查找线程通过RCU持有旧索引，因此整体构建新索引后替换，而不是在旧索引上增删实例
+  void UpdateServiceHostPort(ServiceData* service_data);
+
+  static ServiceHostPort* BuildServiceHostPort(ServiceData* service_data);
+
  private:
   CachePersist persist_;
   ReportClient report_client_;
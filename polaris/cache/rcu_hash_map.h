@@ -0,0 +1,445 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_CACHE_RCU_HASH_MAP_H_
+#define POLARIS_CPP_POLARIS_CACHE_RCU_HASH_MAP_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "cache/rcu_map.h"
+#include "logger.h"
+#include "utils/time_clock.h"
+
+namespace polaris {
+
+/// @brief 组合多个字段的hash值，用于为复合Key实现hash函数
+inline std::size_t HashCombine(std::size_t seed, std::size_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+/// @brief 双缓冲少写多读Hash Map
+///
+/// 与RcuMap的读写及延迟回收语义相同，区别在于read map为只读的开放寻址hash表：
+/// 1. dirty map为加锁访问的unordered map，read map在dirty map交换时根据dirty map整体重建后发布
+/// 2. read map发布后只修改槽位指向的MapValue内容，不再修改表结构，读线程无锁线性探测查询
+/// 3. 槽位只保存hash值和MapValue指针，每个cache line可容纳4个槽位，Key保存在MapValue中，
+///    只有hash值相同时才访问Key进行比较
+/// 因此Key类型需要提供hash函数以及operator==
+template <typename Key, typename Value, typename Hash = std::hash<Key> >
+class RcuHashMap {
+ private:
+  struct MapValue {
+    MapValue(const Key& key, Value* value) : key_(key), value_(value), used_time_(Time::GetCoarseSteadyTimeMs()) {}
+
+    const Key key_;
+    std::atomic<Value*> value_;
+    std::atomic<uint64_t> used_time_;
+  };
+  typedef std::unordered_map<Key, MapValue*, Hash> InnerMap;
+
+  // 只读开放寻址hash表，容量为2的幂，负载因子不超过0.5
+  class ReadTable {
+   public:
+    explicit ReadTable(const InnerMap& dirty_map);
+
+    MapValue* Find(const Key& key, std::size_t hash) const;
+
+   private:
+    struct Slot {
+      std::size_t hash_;
+      MapValue* map_value_;  // 为NULL表示空槽位
+    };
+    std::vector<Slot> slots_;
+    std::size_t mask_;
+  };
+
+  typedef void (*ValueOp)(Value* value);
+
+  struct DeletedValue {
+    Value* value_;
+    uint64_t delete_time_;
+  };
+
+  struct DeletedTable {
+    ReadTable* table_;
+    std::set<MapValue*>* deleted_values_;
+    uint64_t delete_time_;
+  };
+
+ public:
+  explicit RcuHashMap(ValueOp allocator = ValueIncrementRef, ValueOp deallocator = ValueDecrementRef);
+
+  ~RcuHashMap();
+
+  /// @brief 根据key获取指向value的指针，key不存在返回NULL
+  Value* Get(const Key& key, bool update_access_time = true);
+
+  /// @brief 根据key获取指向Value的指针，key不存在返回NULL
+  Value* GetWithRcuTime(const Key& key);
+
+  /// @brief 更新key对应的value
+  /// 如果key对应的value已存在，则将旧的value加入待释放列表，内部线程会延迟一定时间释放
+  /// 如果传入的value为NULL，则效果等同于调用Delete方法删除key
+  void Update(const Key& key, Value* value);
+
+  /// @brief 添加新的key,value
+  /// 如果key对应的value已存在，返回已存在的value
+  /// 如果key不存在，则使用creator函数创建新的value插入
+  Value* CreateOrGet(const Key& key, std::function<Value*()>& creator);
+
+  /// @brief 删除指定key，并将value加入待释放列表
+  void Delete(const Key& key);
+
+  /// @brief 获取可删除的数据
+  void CheckGc(uint64_t min_delete_time);
+
+  /// @brief 获取一定时间未访问的key
+  void CheckExpired(uint64_t min_access_time, std::vector<Key>& keys_need_expired);
+
+  /// @brief 获取所有Value的引用
+  void GetAllValuesWithRef(std::vector<Value*>& values);
+
+ private:
+  static std::size_t MixHash(std::size_t hash);
+
+  // 在dirty map中查找成功时调用，返回对应的value
+  Value* GetFromDirtyInLock(const Key& key, ReadTable* current_read, bool update_access_time);
+
+  void InsertInLock(const Key& key, std::size_t hash, Value* value);
+
+  void CheckSwapInLock();
+
+ private:
+  Hash hasher_;
+  std::atomic<ReadTable*> read_table_;  // 多线程读线程安全hash表
+  std::size_t miss_time_;               // 用于记录从dirty map中查到的次数
+
+  std::mutex dirty_lock_;
+  InnerMap dirty_map_;
+  std::set<MapValue*> deleted_values_;  // 已从dirty map删除但仍在read table中的MapValue
+
+  // 用于根据时间戳回收数据
+  std::list<DeletedValue> deleted_value_list_;
+  std::list<DeletedTable> deleted_table_list_;
+
+  ValueOp allocator_;
+  ValueOp deallocator_;
+};
+
+template <typename Key, typename Value, typename Hash>
+RcuHashMap<Key, Value, Hash>::ReadTable::ReadTable(const InnerMap& dirty_map) {
+  std::size_t capacity = 8;
+  while (capacity < dirty_map.size() * 2) {
+    capacity <<= 1;
+  }
+  Slot empty_slot = {0, nullptr};
+  slots_.assign(capacity, empty_slot);
+  mask_ = capacity - 1;
+  Hash hasher;
+  for (typename InnerMap::const_iterator it = dirty_map.begin(); it != dirty_map.end(); ++it) {
+    std::size_t hash = MixHash(hasher(it->first));
+    std::size_t index = hash & mask_;
+    while (slots_[index].map_value_ != nullptr) {
+      index = (index + 1) & mask_;
+    }
+    slots_[index].hash_ = hash;
+    slots_[index].map_value_ = it->second;
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+typename RcuHashMap<Key, Value, Hash>::MapValue* RcuHashMap<Key, Value, Hash>::ReadTable::Find(
+    const Key& key, std::size_t hash) const {
+  std::size_t index = hash & mask_;
+  for (;;) {
+    const Slot& slot = slots_[index];
+    if (slot.map_value_ == nullptr) {
+      return nullptr;
+    }
+    if (slot.hash_ == hash && slot.map_value_->key_ == key) {
+      return slot.map_value_;
+    }
+    index = (index + 1) & mask_;
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+RcuHashMap<Key, Value, Hash>::RcuHashMap(ValueOp allocator, ValueOp deallocator)
+    : read_table_(new ReadTable(InnerMap())), miss_time_(0), allocator_(allocator), deallocator_(deallocator) {}
+
+template <typename Key, typename Value, typename Hash>
+RcuHashMap<Key, Value, Hash>::~RcuHashMap() {
+  for (typename InnerMap::iterator it = dirty_map_.begin(); it != dirty_map_.end(); ++it) {
+    POLARIS_ASSERT(it->second->value_ != nullptr);  // dirty map中的MapValue，其value一定不为NULL
+    deallocator_(it->second->value_);
+    delete it->second;
+  }
+  dirty_map_.clear();
+
+  for (typename std::set<MapValue*>::iterator it = deleted_values_.begin(); it != deleted_values_.end(); ++it) {
+    delete *it;
+  }
+  delete read_table_.load();
+
+  while (!deleted_value_list_.empty()) {
+    deallocator_(deleted_value_list_.front().value_);
+    deleted_value_list_.pop_front();
+  }
+
+  while (!deleted_table_list_.empty()) {
+    DeletedTable& deleted_table = deleted_table_list_.front();
+    for (typename std::set<MapValue*>::iterator it = deleted_table.deleted_values_->begin();
+         it != deleted_table.deleted_values_->end(); ++it) {
+      delete *it;
+    }
+    delete deleted_table.deleted_values_;
+    delete deleted_table.table_;
+    deleted_table_list_.pop_front();
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+std::size_t RcuHashMap<Key, Value, Hash>::MixHash(std::size_t hash) {
+  // 使用murmur3的fmix64打散hash值，避免指针等低位相同的hash值集中在相邻槽位
+  uint64_t h = hash;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return static_cast<std::size_t>(h);
+}
+
+template <typename Key, typename Value, typename Hash>
+Value* RcuHashMap<Key, Value, Hash>::Get(const Key& key, bool update_access_time) {
+  // 查询read table，获取结果
+  Value* read_result = nullptr;
+  ReadTable* current_read = read_table_.load(std::memory_order_acquire);
+  MapValue* map_value = current_read->Find(key, MixHash(hasher_(key)));
+  if (map_value != nullptr) {  // MapValue包含的value指针在整个过程中是可能改变的
+    if (update_access_time) {
+      map_value->used_time_.store(Time::GetCoarseSteadyTimeMs(), std::memory_order_relaxed);
+    }
+    read_result = map_value->value_.load(std::memory_order_acquire);
+  } else {
+    // 从read table未读到数据，则加锁进行后续操作
+    const std::lock_guard<std::mutex> mutex_guard(dirty_lock_);
+    read_result = GetFromDirtyInLock(key, current_read, update_access_time);
+  }
+  if (read_result != nullptr) {
+    allocator_(read_result);
+  }
+  return read_result;
+}
+
+template <typename Key, typename Value, typename Hash>
+Value* RcuHashMap<Key, Value, Hash>::GetWithRcuTime(const Key& key) {
+  // 查询read table，获取结果
+  ReadTable* current_read = read_table_.load(std::memory_order_acquire);
+  MapValue* map_value = current_read->Find(key, MixHash(hasher_(key)));
+  if (map_value != nullptr) {  // MapValue包含的value指针在整个过程中是可能改变的
+    map_value->used_time_.store(Time::GetCoarseSteadyTimeMs(), std::memory_order_relaxed);
+    return map_value->value_.load(std::memory_order_acquire);
+  }
+  // 从read table未读到数据，则加锁进行后续操作
+  const std::lock_guard<std::mutex> mutex_guard(dirty_lock_);
+  return GetFromDirtyInLock(key, current_read, true);
+}
+
+template <typename Key, typename Value, typename Hash>
+Value* RcuHashMap<Key, Value, Hash>::GetFromDirtyInLock(const Key& key, ReadTable* current_read,
+                                                        bool update_access_time) {
+  typename InnerMap::iterator it = dirty_map_.find(key);
+  if (it == dirty_map_.end()) {
+    return nullptr;
+  }
+  if (update_access_time) {
+    it->second->used_time_.store(Time::GetCoarseSteadyTimeMs(), std::memory_order_relaxed);
+  }
+  Value* read_result = it->second->value_.load(std::memory_order_relaxed);
+  if (read_table_.load(std::memory_order_relaxed) == current_read) {
+    miss_time_++;  // 记录read table读失败，dirty map读成功次数
+  }
+  // 判断miss次数是否足够导致促使dirty map重建成read table
+  CheckSwapInLock();
+  return read_result;
+}
+
+template <typename Key, typename Value, typename Hash>
+void RcuHashMap<Key, Value, Hash>::CheckSwapInLock() {
+  if (miss_time_ < dirty_map_.size()) {
+    return;
+  }
+
+  DeletedTable deleted_table;
+  deleted_table.table_ = read_table_.load(std::memory_order_relaxed);
+  read_table_.store(new ReadTable(dirty_map_), std::memory_order_release);
+  deleted_table.delete_time_ = Time::GetCoarseSteadyTimeMs();
+  deleted_table.deleted_values_ = new std::set<MapValue*>();
+  deleted_table.deleted_values_->swap(deleted_values_);
+  deleted_table_list_.push_back(deleted_table);
+  miss_time_ = 0;
+}
+
+template <typename Key, typename Value, typename Hash>
+void RcuHashMap<Key, Value, Hash>::InsertInLock(const Key& key, std::size_t hash, Value* value) {
+  // 假如dirty map中没有key，那么此时可能在read table中包含被删除的key
+  // 先检查read table是否有key，有则复用该MapValue
+  MapValue* map_value = read_table_.load(std::memory_order_relaxed)->Find(key, hash);
+  if (map_value != nullptr) {
+    POLARIS_ASSERT(map_value->value_ == nullptr);
+    map_value->used_time_.store(Time::GetCoarseSteadyTimeMs(), std::memory_order_relaxed);  // 插入操作设置时间
+    map_value->value_.store(value, std::memory_order_release);
+    // read table删除后又插入，相当于更新，需要删除记录去掉
+    POLARIS_ASSERT(deleted_values_.find(map_value) != deleted_values_.end());
+    deleted_values_.erase(map_value);
+  } else {  // read table没有相同的key，则创建该value
+    map_value = new MapValue(key, value);
+  }
+  dirty_map_[key] = map_value;
+}
+
+template <typename Key, typename Value, typename Hash>
+void RcuHashMap<Key, Value, Hash>::Update(const Key& key, Value* value) {
+  if (value == nullptr) {  // 直接调用Delete
+    this->Delete(key);
+    return;
+  }
+
+  // 加锁将数据写入dirty map。
+  const std::lock_guard<std::mutex> mutex_guard(dirty_lock_);
+  typename InnerMap::iterator it = dirty_map_.find(key);
+  if (it != dirty_map_.end()) {  // 更新dirty map
+    Value* old_value = it->second->value_.exchange(value, std::memory_order_acq_rel);
+    POLARIS_ASSERT(old_value != nullptr);
+    DeletedValue deleted_value = {old_value, Time::GetCoarseSteadyTimeMs()};
+    deleted_value_list_.push_back(deleted_value);  // 旧的数据加入回收列表
+  } else {                                         // 插入
+    InsertInLock(key, MixHash(hasher_(key)), value);
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+Value* RcuHashMap<Key, Value, Hash>::CreateOrGet(const Key& key, std::function<Value*()>& creator) {
+  const std::lock_guard<std::mutex> mutex_guard(dirty_lock_);
+  typename InnerMap::iterator it = dirty_map_.find(key);
+  if (it != dirty_map_.end()) {
+    it->second->used_time_.store(Time::GetCoarseSteadyTimeMs(), std::memory_order_relaxed);
+    return it->second->value_.load(std::memory_order_relaxed);
+  }
+
+  Value* value = creator();
+  if (value == nullptr) {
+    return nullptr;
+  }
+  InsertInLock(key, MixHash(hasher_(key)), value);
+  return value;
+}
+
+template <typename Key, typename Value, typename Hash>
+void RcuHashMap<Key, Value, Hash>::Delete(const Key& key) {
+  const std::lock_guard<std::mutex> mutex_guard(dirty_lock_);
+  typename InnerMap::iterator it = dirty_map_.find(key);
+  // dirty map中没有的话，read table即使有value也已经释放成了NULL，退出即可
+  if (it == dirty_map_.end()) {
+    return;
+  }
+
+  // dirty map中有该key的数据，从dirty map删除，并检查read table
+  MapValue* map_value = it->second;
+  POLARIS_ASSERT(map_value != nullptr);
+  dirty_map_.erase(it);
+  // 被删除的数据放入GC，并重置MapValue中的value为NULL
+  Value* value = map_value->value_.exchange(nullptr, std::memory_order_acq_rel);
+  POLARIS_ASSERT(value != nullptr);
+  DeletedValue deleted_value = {value, Time::GetCoarseSteadyTimeMs()};
+  deleted_value_list_.push_back(deleted_value);
+  if (read_table_.load(std::memory_order_relaxed)->Find(key, MixHash(hasher_(key))) == map_value) {
+    deleted_values_.insert(map_value);  // read table仍引用该MapValue，随read table一起回收
+  } else {                              // 只有dirty map中有，则删除MapValue
+    delete map_value;
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+void RcuHashMap<Key, Value, Hash>::CheckGc(uint64_t min_delete_time) {
+  std::vector<Value*> values_need_delete;
+  do {  // 加锁获取需要删除的values
+    const std::lock_guard<std::mutex> mutex_guard(dirty_lock_);
+    while (!deleted_value_list_.empty()) {
+      DeletedValue& oldest_value = deleted_value_list_.front();
+      if (oldest_value.delete_time_ >= min_delete_time) {
+        break;
+      }
+      values_need_delete.push_back(oldest_value.value_);
+      deleted_value_list_.pop_front();
+    }
+  } while (false);
+  for (std::size_t i = 0; i < values_need_delete.size(); ++i) {
+    deallocator_(values_need_delete[i]);
+  }
+
+  std::vector<DeletedTable> table_need_delete;
+  do {  // 加锁获取需要删除的read table
+    const std::lock_guard<std::mutex> mutex_guard(dirty_lock_);
+    while (!deleted_table_list_.empty()) {
+      DeletedTable& oldest_table = deleted_table_list_.front();
+      if (oldest_table.delete_time_ >= min_delete_time) {
+        break;
+      }
+      table_need_delete.push_back(oldest_table);
+      deleted_table_list_.pop_front();
+    }
+  } while (false);
+  for (std::size_t i = 0; i < table_need_delete.size(); ++i) {
+    DeletedTable& deleted_table = table_need_delete[i];
+    for (typename std::set<MapValue*>::iterator it = deleted_table.deleted_values_->begin();
+         it != deleted_table.deleted_values_->end(); ++it) {
+      delete *it;
+    }
+    delete deleted_table.deleted_values_;
+    delete deleted_table.table_;
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+void RcuHashMap<Key, Value, Hash>::CheckExpired(uint64_t min_access_time, std::vector<Key>& keys_need_expired) {
+  const std::lock_guard<std::mutex> mutex_guard(dirty_lock_);
+  for (typename InnerMap::iterator it = dirty_map_.begin(); it != dirty_map_.end(); ++it) {
+    if (it->second->used_time_.load(std::memory_order_relaxed) <= min_access_time) {
+      keys_need_expired.push_back(it->first);
+    }
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+void RcuHashMap<Key, Value, Hash>::GetAllValuesWithRef(std::vector<Value*>& values) {
+  const std::lock_guard<std::mutex> mutex_guard(dirty_lock_);
+  for (typename InnerMap::iterator it = dirty_map_.begin(); it != dirty_map_.end(); ++it) {
+    Value* value = it->second->value_.load(std::memory_order_relaxed);
+    allocator_(value);
+    values.push_back(value);
+  }
+}
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_CACHE_RCU_HASH_MAP_H_
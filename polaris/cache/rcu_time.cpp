@@ -14,12 +14,16 @@
 #include "cache/rcu_time.h"
 
 #include <stddef.h>
+#include <stdlib.h>
+
+#include <new>
+
 #include "logger.h"
 #include "utils/time_clock.h"
 
 namespace polaris {
 
-ThreadTimeMgr::ThreadTimeMgr() {
+ThreadTimeMgr::ThreadTimeMgr() : head_block_(NewBlock()) {
   thread_time_key_ = 0;
   int rc = pthread_key_create(&thread_time_key_, &OnThreadExit);
   POLARIS_ASSERT(rc == 0);
@@ -27,21 +31,58 @@ ThreadTimeMgr::ThreadTimeMgr() {
 
 ThreadTimeMgr::~ThreadTimeMgr() {
   pthread_key_delete(thread_time_key_);
-  for (std::set<ThreadTime*>::iterator it = thread_time_set_.begin(); it != thread_time_set_.end(); ++it) {
-    delete (*it);
+  ThreadTimeBlock* block = head_block_;
+  while (block != nullptr) {
+    ThreadTimeBlock* next = block->next_.load(std::memory_order_relaxed);
+    block->~ThreadTimeBlock();
+    free(block);
+    block = next;
+  }
+}
+
+ThreadTimeBlock* ThreadTimeMgr::NewBlock() {
+  void* memory = nullptr;
+  int rc = posix_memalign(&memory, kThreadTimeCacheLineSize, sizeof(ThreadTimeBlock));
+  POLARIS_ASSERT(rc == 0);
+  ThreadTimeBlock* block = new (memory) ThreadTimeBlock();
+  for (std::size_t i = 0; i < ThreadTimeBlock::kSlotCount; ++i) {
+    block->slots_[i].thread_time_.store(Time::kMaxTime, std::memory_order_relaxed);
+    block->slots_[i].in_use_.store(false, std::memory_order_relaxed);
+  }
+  block->next_.store(nullptr, std::memory_order_relaxed);
+  return block;
+}
+
+ThreadTime* ThreadTimeMgr::AcquireSlot() {
+  ThreadTimeBlock* block = head_block_;
+  for (;;) {
+    for (std::size_t i = 0; i < ThreadTimeBlock::kSlotCount; ++i) {
+      ThreadTime& slot = block->slots_[i];
+      if (!slot.in_use_.load(std::memory_order_relaxed) && !slot.in_use_.exchange(true, std::memory_order_acquire)) {
+        return &slot;
+      }
+    }
+    ThreadTimeBlock* next = block->next_.load(std::memory_order_acquire);
+    if (next == nullptr) {  // 所有槽位都被占用，追加新的分组，追加失败说明其他线程已追加
+      ThreadTimeBlock* new_block = NewBlock();
+      if (block->next_.compare_exchange_strong(next, new_block, std::memory_order_acq_rel)) {
+        next = new_block;
+      } else {
+        new_block->~ThreadTimeBlock();
+        free(new_block);
+      }
+    }
+    block = next;
   }
 }
 
 void ThreadTimeMgr::RcuEnter() {
   ThreadTime* thread_time = static_cast<ThreadTime*>(pthread_getspecific(thread_time_key_));
-  if (thread_time != nullptr) {
-    thread_time->thread_time_.store(Time::GetCoarseSteadyTimeMs(), std::memory_order_release);
-    return;
+  if (thread_time == nullptr) {
+    thread_time = AcquireSlot();
+    pthread_setspecific(thread_time_key_, thread_time);
   }
-  thread_time = new ThreadTime(Time::GetCoarseSteadyTimeMs(), this);
-  pthread_setspecific(thread_time_key_, thread_time);
-  const std::lock_guard<std::mutex> mutex_guard(lock_);
-  thread_time_set_.insert(thread_time);
+  thread_time->thread_time_.store(Time::GetCoarseSteadyTimeMs(), std::memory_order_release);
 }
 
 void ThreadTimeMgr::RcuExit() {
@@ -53,11 +94,12 @@ void ThreadTimeMgr::RcuExit() {
 
 uint64_t ThreadTimeMgr::MinTime() {
   uint64_t min_time = Time::GetCoarseSteadyTimeMs();
-  const std::lock_guard<std::mutex> mutex_guard(lock_);
-  for (std::set<ThreadTime*>::iterator it = thread_time_set_.begin(); it != thread_time_set_.end(); ++it) {
-    uint64_t thread_time = (*it)->thread_time_.load(std::memory_order_acquire);  // 先获取时间再比较
-    if (thread_time < min_time) {
-      min_time = thread_time;
+  for (ThreadTimeBlock* block = head_block_; block != nullptr; block = block->next_.load(std::memory_order_acquire)) {
+    for (std::size_t i = 0; i < ThreadTimeBlock::kSlotCount; ++i) {
+      uint64_t thread_time = block->slots_[i].thread_time_.load(std::memory_order_acquire);  // 先获取时间再比较
+      if (thread_time < min_time) {
+        min_time = thread_time;
+      }
     }
   }
   return min_time;
@@ -67,13 +109,10 @@ void ThreadTimeMgr::OnThreadExit(void* ptr) {
   if (ptr == nullptr) {
     return;
   }
+  // 释放槽位，槽位所在分组由管理对象统一释放
   ThreadTime* thread_time = static_cast<ThreadTime*>(ptr);
-  ThreadTimeMgr* mgr = static_cast<ThreadTimeMgr*>(thread_time->mgr_ptr_);
-
-  mgr->lock_.lock();
-  mgr->thread_time_set_.erase(thread_time);
-  mgr->lock_.unlock();
-  delete thread_time;
+  thread_time->thread_time_.store(Time::kMaxTime, std::memory_order_release);
+  thread_time->in_use_.store(false, std::memory_order_release);
 }
 
 }  // namespace polaris
@@ -15,22 +15,36 @@
 #define POLARIS_CPP_POLARIS_CACHE_RCU_TIME_H_
 
 #include <pthread.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <atomic>
-#include <mutex>
-#include <set>
 
 namespace polaris {
 
-struct ThreadTime {
-  ThreadTime(uint64_t thread_time, void* mgr_ptr) : thread_time_(thread_time), mgr_ptr_(mgr_ptr) {}
+static const std::size_t kThreadTimeCacheLineSize = 64;
 
+/// @brief 线程进入RCU缓存的时间槽位
+///
+/// 每个槽位独占一个cache line，避免不同线程更新各自时间时产生伪共享
+struct ThreadTime {
   std::atomic<uint64_t> thread_time_;
-  void* mgr_ptr_;
+  std::atomic<bool> in_use_;  // 槽位是否已被线程占用
+  char padding_[kThreadTimeCacheLineSize - sizeof(std::atomic<uint64_t>) - sizeof(std::atomic<bool>)];
+};
+
+/// @brief 一组连续的线程时间槽位，按cache line对齐分配，多个分组通过链表连接
+struct ThreadTimeBlock {
+  static const std::size_t kSlotCount = 64;
+
+  ThreadTime slots_[kSlotCount];
+  std::atomic<ThreadTimeBlock*> next_;
 };
 
 /// @brief 记录线程进入RCU缓存的时间
+///
+/// 线程首次进入时无锁占用一个空闲槽位，槽位不够时追加新的分组，分组只增不减直到管理对象释放。
+/// 线程退出时释放槽位供其他线程复用。计算最小时间时无锁遍历所有槽位，空闲槽位的时间为最大值
 class ThreadTimeMgr {
  public:
   ThreadTimeMgr();
@@ -44,11 +58,14 @@ class ThreadTimeMgr {
   uint64_t MinTime();
 
  private:
+  ThreadTime* AcquireSlot();
+
+  static ThreadTimeBlock* NewBlock();
+
   static void OnThreadExit(void* ptr);
 
  private:
-  std::mutex lock_;
-  std::set<ThreadTime*> thread_time_set_;
+  ThreadTimeBlock* const head_block_;
 
   pthread_key_t thread_time_key_;
 };
@@ -16,16 +16,20 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <iosfwd>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
-#include "cache/rcu_map.h"
+#include "cache/rcu_hash_map.h"
 #include "model/model_impl.h"
+#include "model/service_route_rule.h"
 #include "plugin/service_router/service_router.h"
 #include "polaris/defs.h"
 #include "polaris/model.h"
+#include "polaris/noncopyable.h"
 #include "reactor/task.h"
 #include "utils/string_utils.h"
 
@@ -86,6 +90,14 @@ struct RuleRouteCacheKey {
       return this->parameters_ < rhs.parameters_;
     }
   }
+
+  bool operator==(const RuleRouteCacheKey& rhs) const {
+    return this->route_key_ == rhs.route_key_ && this->prior_data_ == rhs.prior_data_ &&
+           this->circuit_breaker_version_ == rhs.circuit_breaker_version_ && this->labels_ == rhs.labels_ &&
+           this->request_flags_ == rhs.request_flags_ &&
+           this->subset_circuit_breaker_version_ == rhs.subset_circuit_breaker_version_ &&
+           this->parameters_ == rhs.parameters_;
+  }
 };
 
 // 规则路由缓存Value
@@ -130,6 +142,11 @@ struct NearbyCacheKey {
       return this->circuit_breaker_version_ < rhs.circuit_breaker_version_;
     }
   }
+
+  bool operator==(const NearbyCacheKey& rhs) const {
+    return this->prior_data_ == rhs.prior_data_ && this->location_version_ == rhs.location_version_ &&
+           this->request_flags_ == rhs.request_flags_ && this->circuit_breaker_version_ == rhs.circuit_breaker_version_;
+  }
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -157,6 +174,11 @@ struct SetDivisionCacheKey {
       return this->request_flags_ < rhs.request_flags_;
     }
   }
+
+  bool operator==(const SetDivisionCacheKey& rhs) const {
+    return this->prior_data_ == rhs.prior_data_ && this->caller_set_name == rhs.caller_set_name &&
+           this->circuit_breaker_version_ == rhs.circuit_breaker_version_ && this->request_flags_ == rhs.request_flags_;
+  }
 };
 
 // 分SET路由缓存Value
@@ -188,14 +210,19 @@ struct CanaryCacheKey {
       return this->canary_value_ < rhs.canary_value_;
     }
   }
+
+  bool operator==(const CanaryCacheKey& rhs) const {
+    return this->prior_data_ == rhs.prior_data_ && this->circuit_breaker_version_ == rhs.circuit_breaker_version_ &&
+           this->canary_value_ == rhs.canary_value_;
+  }
 };
 
 ///////////////////////////////////////////////////////////////////////////////
-// 元数据路由缓存Key
+// 元数据路由缓存Key，元数据使用64位指纹表示，命中后由路由插件校验元数据
 struct MetadataCacheKey {
   InstancesSet* prior_data_;
   uint64_t circuit_breaker_version_;
-  std::map<std::string, std::string> metadata_;
+  uint64_t metadata_fingerprint_;
   MetadataFailoverType failover_type_;
 
   bool operator<(const MetadataCacheKey& rhs) const {
@@ -212,9 +239,57 @@ struct MetadataCacheKey {
     } else if (this->failover_type_ > rhs.failover_type_) {
       return false;
     } else {
-      return this->metadata_ < rhs.metadata_;
+      return this->metadata_fingerprint_ < rhs.metadata_fingerprint_;
     }
   }
+
+  bool operator==(const MetadataCacheKey& rhs) const {
+    return this->prior_data_ == rhs.prior_data_ && this->circuit_breaker_version_ == rhs.circuit_breaker_version_ &&
+           this->failover_type_ == rhs.failover_type_ && this->metadata_fingerprint_ == rhs.metadata_fingerprint_;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// 请求对象复用的路由数据
+// 同一个请求对象重复获取实例时，复用路由所需的服务实例、路由规则对象以及路由缓存Key，稳定状态下不再分配内存
+class ReusableRouteData : Noncopyable {
+ public:
+  ReusableRouteData() : in_use_(false) {}
+
+  // 尝试占用复用数据，已被其他线程占用时返回false
+  bool TryAcquire() { return !in_use_.exchange(true, std::memory_order_acquire); }
+
+  void Release() { in_use_.store(false, std::memory_order_release); }
+
+  ServiceInstances* GetServiceInstances(ServiceData* service_data) {
+    if (service_instances_ == nullptr) {
+      service_instances_.reset(new ServiceInstances(service_data));
+    } else {
+      ServiceInstances::Impl::Reset(*service_instances_, service_data);
+    }
+    return service_instances_.get();
+  }
+
+  ServiceRouteRule* GetServiceRouteRule(ServiceData* service_data) {
+    if (service_route_rule_ == nullptr) {
+      service_route_rule_.reset(new ServiceRouteRule(service_data));
+    } else {
+      service_route_rule_->Reset(service_data);
+    }
+    return service_route_rule_.get();
+  }
+
+  bool IsReused(ServiceInstances* service_instances) const { return service_instances == service_instances_.get(); }
+
+  bool IsReused(ServiceRouteRule* service_route_rule) const { return service_route_rule == service_route_rule_.get(); }
+
+ public:
+  RuleRouteCacheKey rule_cache_key_;
+
+ private:
+  std::atomic<bool> in_use_;
+  std::unique_ptr<ServiceInstances> service_instances_;
+  std::unique_ptr<ServiceRouteRule> service_route_rule_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -247,6 +322,9 @@ class ServiceCache : public Clearable {
 
   Value* GetWithRcuTime(const Key& key) { return buffered_cache_.GetWithRcuTime(key); }
 
+  /// @brief 替换key对应的value，value为NULL时删除key
+  void Update(const Key& key, Value* value) { buffered_cache_.Update(key, value); }
+
   virtual void Clear(uint64_t min_access_time) {
     typename std::vector<Key> clear_keys;
     buffered_cache_.CheckExpired(min_access_time, clear_keys);
@@ -281,7 +359,7 @@ class ServiceCache : public Clearable {
   }
 
  private:
-  RcuMap<Key, Value> buffered_cache_;
+  RcuHashMap<Key, Value> buffered_cache_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -345,4 +423,60 @@ class ServiceCacheUpdateTask : public Task {
 
 }  // namespace polaris
 
+namespace std {
+
+template <>
+struct hash<polaris::RuleRouteCacheKey> {
+  std::size_t operator()(const polaris::RuleRouteCacheKey& key) const {
+    std::size_t seed = hash<polaris::InstancesSet*>()(key.prior_data_);
+    seed = polaris::HashCombine(seed, hash<polaris::RouteRuleBound*>()(key.route_key_));
+    seed = polaris::HashCombine(seed, key.circuit_breaker_version_);
+    seed = polaris::HashCombine(seed, key.subset_circuit_breaker_version_);
+    seed = polaris::HashCombine(seed, hash<string>()(key.labels_));
+    seed = polaris::HashCombine(seed, key.request_flags_);
+    return polaris::HashCombine(seed, hash<string>()(key.parameters_));
+  }
+};
+
+template <>
+struct hash<polaris::NearbyCacheKey> {
+  std::size_t operator()(const polaris::NearbyCacheKey& key) const {
+    std::size_t seed = hash<polaris::InstancesSet*>()(key.prior_data_);
+    seed = polaris::HashCombine(seed, key.circuit_breaker_version_);
+    seed = polaris::HashCombine(seed, key.location_version_);
+    return polaris::HashCombine(seed, key.request_flags_);
+  }
+};
+
+template <>
+struct hash<polaris::SetDivisionCacheKey> {
+  std::size_t operator()(const polaris::SetDivisionCacheKey& key) const {
+    std::size_t seed = hash<polaris::InstancesSet*>()(key.prior_data_);
+    seed = polaris::HashCombine(seed, hash<string>()(key.caller_set_name));
+    seed = polaris::HashCombine(seed, key.circuit_breaker_version_);
+    return polaris::HashCombine(seed, key.request_flags_);
+  }
+};
+
+template <>
+struct hash<polaris::CanaryCacheKey> {
+  std::size_t operator()(const polaris::CanaryCacheKey& key) const {
+    std::size_t seed = hash<polaris::InstancesSet*>()(key.prior_data_);
+    seed = polaris::HashCombine(seed, key.circuit_breaker_version_);
+    return polaris::HashCombine(seed, hash<string>()(key.canary_value_));
+  }
+};
+
+template <>
+struct hash<polaris::MetadataCacheKey> {
+  std::size_t operator()(const polaris::MetadataCacheKey& key) const {
+    std::size_t seed = hash<polaris::InstancesSet*>()(key.prior_data_);
+    seed = polaris::HashCombine(seed, key.circuit_breaker_version_);
+    seed = polaris::HashCombine(seed, static_cast<std::size_t>(key.failover_type_));
+    return polaris::HashCombine(seed, key.metadata_fingerprint_);
+  }
+};
+
+}  // namespace std
+
 #endif  //  POLARIS_CPP_POLARIS_CACHE_SERVICE_CACHE_H_
@@ -109,6 +109,12 @@ class ContextImpl {
 
   CircuitBreakerExecutor* GetCircuitBreakerExecutor() { return engine_->GetCircuitBreakerExecutor(); }
 
+  void GetCacheRebuildExecutors(std::size_t count, std::vector<CacheRebuildExecutor*>& executors) {
+    engine_->GetCacheRebuildExecutors(count, executors);
+  }
+
+  std::size_t GetCacheRebuildExecutorCount() { return engine_->GetCacheRebuildExecutorCount(); }
+
   QuotaManager* GetQuotaManager() { return quota_manager_; }
 
   const v1::SDKToken& GetSdkToken() { return sdk_token_; }
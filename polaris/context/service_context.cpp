@@ -13,23 +13,86 @@
 
 #include "context/service_context.h"
 
+#include <inttypes.h>
+
+#include <algorithm>
+#include <utility>
+
 #include "context/context_impl.h"
+#include "engine/cache_rebuild_executor.h"
+#include "plugin/load_balancer/instance_load.h"
 #include "plugin/plugin_manager.h"
 #include "plugin/weight_adjuster/weight_adjuster.h"
+#include "reactor/task.h"
+#include "sync/cond_var.h"
+#include "utils/time_clock.h"
 
 namespace polaris {
 
+// 每个线程每执行该次数路由采样一次请求参数组合的访问次数
+static const uint32_t kCacheHitSampleInterval = 64;
+
+// 待重建的请求参数组合数达到该值时才提交给辅助线程并行重建，否则由发起线程直接重建
+static const uint32_t kParallelRebuildMinSize = 8;
+
+// 每轮参与重建的最大线程数，包括发起线程，辅助线程按需创建后常驻
+static const int kMaxEagerRebuildThreads = 16;
+
+/// @brief 一轮缓存重建任务，由发起线程和辅助线程通过原子下标共同消费
+///
+/// 辅助线程开始执行时任务可能已被发起线程消费完，发起线程只等待已被领取的任务完成，
+/// 因此任务对象通过引用计数释放，辅助线程只有领取到任务时才访问服务上下文
+struct CacheRebuildBatch : public ServiceBase {
+  explicit CacheRebuildBatch(const ServiceKey& service_key)
+      : service_context_(nullptr),
+        service_key_(service_key),
+        instances_(nullptr),
+        routings_(nullptr),
+        circuit_breaker_version_(0),
+        dynamic_weight_version_(0),
+        next_index_(0),
+        done_count_(0) {}
+
+  // 完成一个组合的重建，全部完成时唤醒发起线程
+  void Done() {
+    if (done_count_.fetch_add(1) + 1 == params_.size()) {
+      done_notify_.NotifyAll();
+    }
+  }
+
+  void WaitDone() {
+    while (done_count_.load() < params_.size()) {
+      done_notify_.WaitFor(1000);
+    }
+  }
+
+  ServiceContext* service_context_;
+  ServiceKey service_key_;
+  ServiceData* instances_;
+  ServiceData* routings_;
+  uint64_t circuit_breaker_version_;
+  uint64_t dynamic_weight_version_;
+  std::vector<ServiceCacheUpdateParam> params_;
+  std::atomic<std::size_t> next_index_;
+  std::atomic<std::size_t> done_count_;
+  sync::CondVarNotify done_notify_;
+};
+
 ServiceContext::ServiceContext()
     : context_(nullptr),
       service_router_chain_(nullptr),
       config_lb_type_(kLoadBalanceTypeDefaultConfig),
       load_balancer_(nullptr),
+      load_aware_(false),
+      latency_aware_(false),
       weight_adjuster_(nullptr),
       circuit_breaker_chain_(nullptr),
       health_checker_chain_(nullptr),
       service_instance_(nullptr),
       service_routings_(nullptr),
-      circuit_breaker_version_(0) {}
+      circuit_breaker_version_(0),
+      eager_rebuild_size_(64),
+      eager_rebuild_threads_(4) {}
 
 ServiceContext::~ServiceContext() {
   context_ = nullptr;
@@ -70,13 +133,7 @@ void ServiceContext::UpdateInstances(ServiceData* instances) {
   if (instances != nullptr) {
     instances->IncrementRef();
     if (service_instance_.load(std::memory_order_acquire) != nullptr) {
-      std::set<ServiceCacheUpdateParam> cache_update_set = GetAllCacheUpdate();
-      for (auto item : cache_update_set) {
-        RouteInfo route_info(instances->GetServiceKey(), item.GetSourceServiceInfo());
-        route_info.SetServiceInstances(new ServiceInstances(instances));
-        route_info.SetCircuitBreakerVersion(circuit_breaker_version_);
-        UpdateCache(route_info, item);
-      }
+      RebuildCache(instances->GetServiceKey(), instances, nullptr, circuit_breaker_version_, 0);
     }
   }
   ServiceData* old_instances = service_instance_.exchange(instances, std::memory_order_release);
@@ -98,13 +155,7 @@ void ServiceContext::UpdateRoutings(ServiceData* routings) {
   if (routings != nullptr) {
     routings->IncrementRef();
     if (service_routings_.load(std::memory_order_acquire) != nullptr) {
-      std::set<ServiceCacheUpdateParam> cache_update_set = GetAllCacheUpdate();
-      for (auto item : cache_update_set) {
-        RouteInfo route_info(routings->GetServiceKey(), item.GetSourceServiceInfo());
-        route_info.SetServiceRouteRule(new ServiceRouteRule(routings));
-        route_info.SetCircuitBreakerVersion(circuit_breaker_version_);
-        UpdateCache(route_info, item);
-      }
+      RebuildCache(routings->GetServiceKey(), nullptr, routings, circuit_breaker_version_, 0);
     }
   }
   ServiceData* old_routings = service_routings_.exchange(routings, std::memory_order_release);
@@ -124,6 +175,17 @@ ReturnCode ServiceContext::Init(const ServiceKey& service_key, Config* config, C
   Config* plugin_config = ServiceOrGlobalConfig(config, global_config, "serviceRouter");
   service_router_chain_ = new ServiceRouterChain(service_key);
   ReturnCode ret = service_router_chain_->Init(plugin_config, context);
+  // 数据更新时只提前重建访问最多的请求参数组合，其余组合由请求按需构建
+  eager_rebuild_size_ = std::max(plugin_config->GetIntOrDefault("eagerRebuildSize", 64), 0);
+  int eager_rebuild_threads = plugin_config->GetIntOrDefault("eagerRebuildThreads", 4);
+  if (eager_rebuild_threads < 1 || eager_rebuild_threads > kMaxEagerRebuildThreads) {
+    int adjusted_threads = std::min(std::max(eager_rebuild_threads, 1), kMaxEagerRebuildThreads);
+    POLARIS_LOG(LOG_WARN, "eagerRebuildThreads[%d] of service[%s/%s] out of range [1, %d], use %d",
+                eager_rebuild_threads, service_key.namespace_.c_str(), service_key.name_.c_str(),
+                kMaxEagerRebuildThreads, adjusted_threads);
+    eager_rebuild_threads = adjusted_threads;
+  }
+  eager_rebuild_threads_ = eager_rebuild_threads;
   delete plugin_config;
   if (ret != kReturnOk) {
     return ret;
@@ -146,6 +208,10 @@ ReturnCode ServiceContext::Init(const ServiceKey& service_key, Config* config, C
   delete plugin_config;
   config_lb_type_ = load_balancer_->GetLoadBalanceType();
   lb_map_.Update(config_lb_type_, load_balancer_);
+  if (InstanceLoadTracker::IsLoadAware(config_lb_type_)) {
+    latency_aware_.store(InstanceLoadTracker::IsLatencyAware(config_lb_type_), std::memory_order_relaxed);
+    load_aware_.store(true, std::memory_order_relaxed);
+  }
   if (ret != kReturnOk) {
     return ret;
   }
@@ -202,9 +268,12 @@ ReturnCode ServiceContext::Init(const ServiceKey& service_key, Config* config, C
 }
 
 ReturnCode ServiceContext::DoRoute(RouteInfo& route_info, RouteResult* route_result) {
+  static __thread uint32_t route_count = 0;
   ReturnCode ret_code = service_router_chain_->DoRoute(route_info, route_result);
   if (route_result->NewInstancesSet()) {
-    AddCacheUpdate(route_info);  // 有更新更新，且是内部触发缓存更新时记录请求
+    AddCacheUpdate(route_info, true);  // 有更新更新，且是内部触发缓存更新时记录请求
+  } else if (ret_code == kReturnOk && ++route_count % kCacheHitSampleInterval == 0) {
+    AddCacheUpdate(route_info, false);  // 采样命中缓存的请求，用于选出需要提前重建的组合
   }
   return ret_code;
 }
@@ -232,13 +301,18 @@ LoadBalancer* ServiceContext::GetLoadBalancer(const LoadBalanceType& load_balanc
     if (ret_code != kReturnOk) {
       POLARIS_LOG(LOG_ERROR, "failed to init load balancer : %s", load_balance_type.c_str());
       new_load_balancer.reset();
+    } else if (InstanceLoadTracker::IsLoadAware(load_balance_type)) {
+      if (InstanceLoadTracker::IsLatencyAware(load_balance_type)) {
+        latency_aware_.store(true, std::memory_order_relaxed);
+      }
+      load_aware_.store(true, std::memory_order_relaxed);
     }
     return new_load_balancer;
   });
   return created_load_balancer.get();
 }
 
-void ServiceContext::AddCacheUpdate(RouteInfo& route_info) {
+void ServiceContext::AddCacheUpdate(RouteInfo& route_info, bool create) {
   ServiceCacheUpdateParam update_param;
   if (route_info.GetSourceServiceInfo() != nullptr) {
     update_param.source_service_info_ = *route_info.GetSourceServiceInfo();
@@ -248,31 +322,129 @@ void ServiceContext::AddCacheUpdate(RouteInfo& route_info) {
   update_param.metadata_param_.metadata_ = route_info.GetMetadata();
 
   std::lock_guard<std::mutex> lock_guard(cache_lock_);
-  cache_update_set_.insert(update_param);
+  if (create) {
+    cache_update_map_.insert(std::make_pair(update_param, 0));
+    return;
+  }
+  auto it = cache_update_map_.find(update_param);
+  if (it != cache_update_map_.end()) {
+    it->second++;
+  }
 }
 
-std::set<ServiceCacheUpdateParam> ServiceContext::GetAllCacheUpdate() {
+std::size_t ServiceContext::GetHotCacheUpdate(std::vector<ServiceCacheUpdateParam>& hot_params) {
   std::lock_guard<std::mutex> lock_guard(cache_lock_);
-  return cache_update_set_;
+  if (cache_update_map_.size() <= eager_rebuild_size_) {  // 组合数不超过上限时全部提前重建
+    for (auto it = cache_update_map_.begin(); it != cache_update_map_.end(); ++it) {
+      hot_params.push_back(it->first);
+      it->second >>= 1;
+    }
+    return 0;
+  }
+  typedef std::pair<uint64_t, const ServiceCacheUpdateParam*> HitCount;
+  std::vector<HitCount> hits;
+  for (auto it = cache_update_map_.begin(); it != cache_update_map_.end(); ++it) {
+    if (it->second > 0) {
+      hits.push_back(std::make_pair(it->second, &it->first));
+    }
+    it->second >>= 1;  // 每轮重建后衰减访问次数，使排序反映最近的访问频率
+  }
+  std::size_t hot_size = std::min<std::size_t>(hits.size(), eager_rebuild_size_);
+  std::partial_sort(hits.begin(), hits.begin() + hot_size, hits.end(),
+                    [](const HitCount& lhs, const HitCount& rhs) { return lhs.first > rhs.first; });
+  for (std::size_t i = 0; i < hot_size; ++i) {
+    hot_params.push_back(*hits[i].second);
+  }
+  return cache_update_map_.size() - hot_size;
 }
 
-void ServiceContext::UpdateCircuitBreaker(const ServiceKey& service_key, uint64_t circuit_breaker_version) {
-  std::set<ServiceCacheUpdateParam> cache_update_set = GetAllCacheUpdate();
-  for (auto item : cache_update_set) {
-    RouteInfo route_info(service_key, item.GetSourceServiceInfo());
-    route_info.SetCircuitBreakerVersion(circuit_breaker_version);
-    UpdateCache(route_info, item);
+void ServiceContext::RebuildCache(const ServiceKey& service_key, ServiceData* instances, ServiceData* routings,
+                                  uint64_t circuit_breaker_version, uint64_t dynamic_weight_version) {
+  CacheRebuildBatch* batch = new CacheRebuildBatch(service_key);
+  batch->service_context_ = this;
+  batch->instances_ = instances;
+  batch->routings_ = routings;
+  batch->circuit_breaker_version_ = circuit_breaker_version;
+  batch->dynamic_weight_version_ = dynamic_weight_version;
+  std::size_t lazy_count = GetHotCacheUpdate(batch->params_);
+  uint32_t queue_depth = static_cast<uint32_t>(batch->params_.size());
+
+  uint64_t begin_time = Time::GetSteadyTimeUs();
+  if (queue_depth > 0) {
+    // 组合较少时直接重建，避免任务提交和线程唤醒的开销
+    if (queue_depth >= kParallelRebuildMinSize && eager_rebuild_threads_ > 1) {
+      std::vector<CacheRebuildExecutor*> executors;  // 辅助线程数不超过发起线程之外的组合数
+      std::size_t helper_count = std::min<std::size_t>(eager_rebuild_threads_ - 1, queue_depth - 1);
+      context_->GetContextImpl()->GetCacheRebuildExecutors(helper_count, executors);
+      for (std::size_t i = 0; i < executors.size(); ++i) {
+        executors[i]->SubmitTask(new FuncRefTask<CacheRebuildBatch>(RebuildTask, batch));
+      }
+    }
+    RunRebuild(*batch, batch->next_index_++, false);  // 发起线程已在RCU临界区内
+    batch->WaitDone();
+  }
+  batch->DecrementRef();
+  uint64_t rebuild_time = Time::GetSteadyTimeUs() - begin_time;
+  POLARIS_LOG(LOG_DEBUG, "rebuild cache for service[%s/%s] eager:%u lazy:%zu cost:%" PRIu64 "us",
+              service_key.namespace_.c_str(), service_key.name_.c_str(), queue_depth, lazy_count, rebuild_time);
+
+  std::lock_guard<std::mutex> lock_guard(rebuild_stat_lock_);
+  rebuild_stat_.rebuild_count_++;
+  rebuild_stat_.total_time_us_ += rebuild_time;
+  rebuild_stat_.max_time_us_ = std::max(rebuild_stat_.max_time_us_, rebuild_time);
+  rebuild_stat_.eager_count_ += queue_depth;
+  rebuild_stat_.lazy_count_ += lazy_count;
+  rebuild_stat_.max_queue_depth_ = std::max(rebuild_stat_.max_queue_depth_, queue_depth);
+}
+
+void ServiceContext::RebuildTask(CacheRebuildBatch* batch) {
+  // 先领取组合，领取到时发起线程还在等待其完成，才能访问服务上下文
+  std::size_t index = batch->next_index_++;
+  if (index < batch->params_.size()) {
+    batch->service_context_->RunRebuild(*batch, index, true);
+  }
+}
+
+void ServiceContext::RunRebuild(CacheRebuildBatch& batch, std::size_t index, bool rcu_enter) {
+  ContextImpl* context_impl = context_->GetContextImpl();
+  for (; index < batch.params_.size(); index = batch.next_index_++) {
+    ServiceCacheUpdateParam& item = batch.params_[index];
+    RouteInfo route_info(batch.service_key_, item.GetSourceServiceInfo());
+    if (batch.instances_ != nullptr) {
+      route_info.SetServiceInstances(new ServiceInstances(batch.instances_));
+    }
+    if (batch.routings_ != nullptr) {
+      route_info.SetServiceRouteRule(new ServiceRouteRule(batch.routings_));
+    }
+    route_info.SetCircuitBreakerVersion(batch.circuit_breaker_version_);
+    if (rcu_enter) {
+      context_impl->RcuEnter();  // 辅助线程每次重建前更新RCU时间，避免长时间阻塞缓存回收
+    }
+    UpdateCache(route_info, item, batch.dynamic_weight_version_);
+    batch.Done();  // 全部完成后发起线程可能返回并释放服务上下文，之后只能访问任务对象
+  }
+  if (rcu_enter) {
+    context_impl->RcuExit();
+  }
+}
+
+bool ServiceContext::CollectCacheRebuildStat(CacheRebuildStat& stat) {
+  std::lock_guard<std::mutex> lock_guard(rebuild_stat_lock_);
+  if (rebuild_stat_.rebuild_count_ == 0) {
+    return false;
   }
+  stat = rebuild_stat_;
+  rebuild_stat_ = CacheRebuildStat();
+  return true;
+}
+
+void ServiceContext::UpdateCircuitBreaker(const ServiceKey& service_key, uint64_t circuit_breaker_version) {
+  RebuildCache(service_key, nullptr, nullptr, circuit_breaker_version, 0);
   circuit_breaker_version_ = circuit_breaker_version;
 }
 
 void ServiceContext::BuildCacheForDynamicWeight(const ServiceKey& service_key, uint64_t dynamic_weight_version) {
-  std::set<ServiceCacheUpdateParam> cache_update_set = GetAllCacheUpdate();
-  for (auto item : cache_update_set) {
-    RouteInfo route_info(service_key, item.GetSourceServiceInfo());
-    route_info.SetCircuitBreakerVersion(circuit_breaker_version_);
-    UpdateCache(route_info, item, dynamic_weight_version);
-  }
+  RebuildCache(service_key, nullptr, nullptr, circuit_breaker_version_, dynamic_weight_version);
 }
 
 bool ServiceContext::UpdateCache(RouteInfo& route_info, const ServiceCacheUpdateParam& update_param,
@@ -310,6 +482,8 @@ bool ServiceContext::UpdateCache(RouteInfo& route_info, const ServiceCacheUpdate
     lb->ChooseInstance(service_instances, criteria, instance);
     if (instance != nullptr && instance->GetLocalityAwareInfo() > 0) {
       delete instance;
+    } else if (instance != nullptr && InstanceLoadTracker::IsLoadAware(lb->GetLoadBalanceType())) {
+      InstanceLoadTracker::ReleaseInflight(instance);  // 构建缓存时选出的实例不会发起调用
     }
   }
   return true;
@@ -14,8 +14,13 @@
 #ifndef POLARIS_CPP_POLARIS_CONTEXT_SERVICE_CONTEXT_H_
 #define POLARIS_CPP_POLARIS_CONTEXT_SERVICE_CONTEXT_H_
 
+#include <stdint.h>
+
+#include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
+#include <vector>
 
 #include "cache/rcu_unordered_map.h"
 #include "cache/service_cache.h"
@@ -36,6 +41,20 @@ struct hash<polaris::ServiceKey> {
 namespace polaris {
 
 class WeightAdjuster;
+struct CacheRebuildBatch;
+
+/// @brief 服务路由和负载均衡缓存重建统计
+struct CacheRebuildStat {
+  CacheRebuildStat()
+      : rebuild_count_(0), total_time_us_(0), max_time_us_(0), eager_count_(0), lazy_count_(0), max_queue_depth_(0) {}
+
+  uint32_t rebuild_count_;    // 重建轮数
+  uint64_t total_time_us_;    // 重建总耗时
+  uint64_t max_time_us_;      // 单轮重建最大耗时
+  uint64_t eager_count_;      // 提前重建的请求参数组合数
+  uint64_t lazy_count_;       // 未提前重建，由请求按需构建的请求参数组合数
+  uint32_t max_queue_depth_;  // 单轮待重建队列的最大长度
+};
 
 /// @brief 服务级别上下文
 class ServiceContext {
@@ -50,6 +69,12 @@ class ServiceContext {
 
   LoadBalancer* GetLoadBalancer(const LoadBalanceType& load_balance_type);
 
+  // 是否使用过感知实例负载的负载均衡插件，是则需要根据调用结果更新实例负载
+  bool IsLoadAware() const { return load_aware_.load(std::memory_order_relaxed); }
+
+  // 是否使用过感知实例耗时的负载均衡插件，是则需要根据调用结果更新实例耗时
+  bool IsLatencyAware() const { return latency_aware_.load(std::memory_order_relaxed); }
+
   WeightAdjuster* GetWeightAdjuster() const { return weight_adjuster_; }
 
   CircuitBreakerChain* GetCircuitBreakerChain() const { return circuit_breaker_chain_; }
@@ -75,11 +100,25 @@ class ServiceContext {
 
   void BuildCacheForDynamicWeight(const ServiceKey& service_key, uint64_t dynamic_weight_version);
 
+  // 获取并清空缓存重建统计，统计周期内没有重建时返回false
+  bool CollectCacheRebuildStat(CacheRebuildStat& stat);
+
  private:
-  // 注册需要触发更新缓存的请求
-  void AddCacheUpdate(RouteInfo& route_info);
+  // 注册需要触发更新缓存的请求，create为false时只累加已注册请求的访问次数
+  void AddCacheUpdate(RouteInfo& route_info, bool create);
 
-  std::set<ServiceCacheUpdateParam> GetAllCacheUpdate();
+  // 选出访问次数最多的请求参数组合，并衰减所有组合的访问次数，返回未选中的组合数
+  std::size_t GetHotCacheUpdate(std::vector<ServiceCacheUpdateParam>& hot_params);
+
+  // 并行重建访问次数最多的请求参数组合的缓存，其余组合由请求按需构建
+  void RebuildCache(const ServiceKey& service_key, ServiceData* instances, ServiceData* routings,
+                    uint64_t circuit_breaker_version, uint64_t dynamic_weight_version);
+
+  // 辅助线程执行的重建任务
+  static void RebuildTask(CacheRebuildBatch* batch);
+
+  // 从已领取的组合开始，持续领取并重建组合直到全部领取完
+  void RunRebuild(CacheRebuildBatch& batch, std::size_t index, bool rcu_enter);
 
   // 重建服务路由和负载均衡缓存
   bool UpdateCache(RouteInfo& route_info, const ServiceCacheUpdateParam& update_param,
@@ -91,6 +130,8 @@ class ServiceContext {
   LoadBalanceType config_lb_type_;
   std::shared_ptr<LoadBalancer> load_balancer_;
   RcuUnorderedMap<LoadBalanceType, LoadBalancer> lb_map_;
+  std::atomic<bool> load_aware_;
+  std::atomic<bool> latency_aware_;
   WeightAdjuster* weight_adjuster_;
   CircuitBreakerChain* circuit_breaker_chain_;
   HealthCheckerChain* health_checker_chain_;
@@ -99,7 +140,12 @@ class ServiceContext {
   std::atomic<uint64_t> circuit_breaker_version_;
 
   std::mutex cache_lock_;
-  std::set<ServiceCacheUpdateParam> cache_update_set_;
+  std::map<ServiceCacheUpdateParam, uint64_t> cache_update_map_;  // 请求参数组合及其采样访问次数
+  uint32_t eager_rebuild_size_;                                    // 每轮提前重建的组合数上限
+  uint32_t eager_rebuild_threads_;                                 // 每轮参与重建的线程数上限
+
+  std::mutex rebuild_stat_lock_;
+  CacheRebuildStat rebuild_stat_;
 };
 
 }  // namespace polaris
@@ -0,0 +1,29 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+
+#include "engine/cache_rebuild_executor.h"
+
+#include "reactor/reactor.h"
+#include "reactor/task.h"
+
+namespace polaris {
+
+CacheRebuildExecutor::CacheRebuildExecutor(Context* context) : Executor(context) {}
+
+void CacheRebuildExecutor::SubmitTask(Task* task) {
+  reactor_.SubmitTask(task);
+  reactor_.Notify();
+}
+
+}  // namespace polaris
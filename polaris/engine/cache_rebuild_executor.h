@@ -0,0 +1,47 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+
+#ifndef POLARIS_CPP_POLARIS_ENGINE_CACHE_REBUILD_EXECUTOR_H_
+#define POLARIS_CPP_POLARIS_ENGINE_CACHE_REBUILD_EXECUTOR_H_
+
+#include "engine/executor.h"
+
+namespace polaris {
+
+class Context;
+class Task;
+
+/// @brief 缓存重建任务执行者
+///
+/// 执行如下任务：
+///   - 服务数据更新时协助发起线程提前重建服务路由和负载均衡缓存
+class CacheRebuildExecutor : public Executor {
+ public:
+  explicit CacheRebuildExecutor(Context* context);
+
+  virtual ~CacheRebuildExecutor() {}
+
+  // 获取线程名字
+  virtual const char* GetName() { return "cache_rebuild"; }
+
+  // 只执行提交的重建任务，没有定时任务
+  virtual void SetupWork() {}
+
+  // 提交重建任务并唤醒线程
+  void SubmitTask(Task* task);
+};
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_ENGINE_CACHE_REBUILD_EXECUTOR_H_
@@ -13,6 +13,8 @@
 
 #include "engine/engine.h"
 
+#include <algorithm>
+
 #include "logger.h"
 
 namespace polaris {
@@ -22,10 +24,15 @@ Engine::Engine(Context* context)
       cache_manager_(context),
       monitor_reporter_(context_),
       circuit_breaker_executor_(context),
-      health_checker_executor_(context) {}
+      health_checker_executor_(context),
+      cache_rebuild_enable_(false) {}
 
 Engine::~Engine() {
   StopAndWait();
+  for (std::size_t i = 0; i < cache_rebuild_executors_.size(); ++i) {
+    delete cache_rebuild_executors_[i];
+  }
+  cache_rebuild_executors_.clear();
   context_ = nullptr;
 }
 
@@ -37,6 +44,8 @@ ReturnCode Engine::Start() {
       (ret_code = health_checker_executor_.Start()) != kReturnOk) {
     return ret_code;
   }
+  std::lock_guard<std::mutex> lock_guard(cache_rebuild_lock_);
+  cache_rebuild_enable_ = true;
   return kReturnOk;
 }
 
@@ -45,7 +54,35 @@ ReturnCode Engine::StopAndWait() {
   monitor_reporter_.StopAndWait();
   circuit_breaker_executor_.StopAndWait();
   health_checker_executor_.StopAndWait();
+  std::lock_guard<std::mutex> lock_guard(cache_rebuild_lock_);
+  cache_rebuild_enable_ = false;
+  for (std::size_t i = 0; i < cache_rebuild_executors_.size(); ++i) {
+    cache_rebuild_executors_[i]->StopAndWait();
+  }
   return kReturnOk;
 }
 
+void Engine::GetCacheRebuildExecutors(std::size_t count, std::vector<CacheRebuildExecutor*>& executors) {
+  std::lock_guard<std::mutex> lock_guard(cache_rebuild_lock_);
+  if (!cache_rebuild_enable_) {
+    return;
+  }
+  while (cache_rebuild_executors_.size() < count) {  // 按各服务配置的重建线程数按需创建
+    CacheRebuildExecutor* executor = new CacheRebuildExecutor(context_);
+    if (executor->Start() != kReturnOk) {
+      POLARIS_LOG(LOG_ERROR, "start cache rebuild executor failed, use %zu executors", cache_rebuild_executors_.size());
+      delete executor;
+      break;
+    }
+    cache_rebuild_executors_.push_back(executor);
+  }
+  count = std::min(count, cache_rebuild_executors_.size());
+  executors.assign(cache_rebuild_executors_.begin(), cache_rebuild_executors_.begin() + count);
+}
+
+std::size_t Engine::GetCacheRebuildExecutorCount() {
+  std::lock_guard<std::mutex> lock_guard(cache_rebuild_lock_);
+  return cache_rebuild_executors_.size();
+}
+
 }  // namespace polaris
@@ -14,7 +14,11 @@
 #ifndef POLARIS_CPP_POLARIS_ENGINE_ENGINE_H_
 #define POLARIS_CPP_POLARIS_ENGINE_ENGINE_H_
 
+#include <mutex>
+#include <vector>
+
 #include "cache/cache_manager.h"
+#include "engine/cache_rebuild_executor.h"
 #include "engine/circuit_breaker_executor.h"
 #include "engine/health_check_executor.h"
 #include "monitor/monitor_reporter.h"
@@ -40,12 +44,20 @@ class Engine {
 
   CircuitBreakerExecutor* GetCircuitBreakerExecutor() { return &circuit_breaker_executor_; }
 
+  // 获取指定数量的缓存重建辅助线程，不足时按需创建，引擎未启动或已停止时返回空
+  void GetCacheRebuildExecutors(std::size_t count, std::vector<CacheRebuildExecutor*>& executors);
+
+  std::size_t GetCacheRebuildExecutorCount();
+
  private:
   Context* context_;
   CacheManager cache_manager_;
   MonitorReporter monitor_reporter_;
   CircuitBreakerExecutor circuit_breaker_executor_;
   HealthCheckExecutor health_checker_executor_;
+  std::mutex cache_rebuild_lock_;
+  bool cache_rebuild_enable_;  // 引擎启动后才能创建缓存重建线程
+  std::vector<CacheRebuildExecutor*> cache_rebuild_executors_;
 };
 
 }  // namespace polaris
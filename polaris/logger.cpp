@@ -57,6 +57,88 @@ const char* LogLevelToStr(LogLevel log_level) {
   }
 }
 
+static const std::size_t kAsyncLogEntrySize = 1024;
+static const std::size_t kLogCacheLineSize = 64;
+
+/// @brief 异步日志条目，调用线程写入日志时间、级别和格式化后的内容，后台线程补充时间格式后写入文件
+struct AsyncLogEntry {
+  std::atomic<uint64_t> sequence_;  // 用于生产者和消费者之间同步条目状态
+  timespec time_;
+  LogLevel log_level_;
+  int length_;
+  char content_[kAsyncLogEntrySize - sizeof(std::atomic<uint64_t>) - sizeof(timespec) - sizeof(LogLevel) -
+                sizeof(int)];
+};
+
+/// @brief 多生产者单消费者的有界无锁环形缓冲区
+///
+/// 每个条目的序号表示条目状态：序号等于写入位置时可写，等于写入位置+1时可读。
+/// 生产者通过CAS抢占写入位置，写完内容后发布序号；消费者由持有日志文件锁的线程担任
+class AsyncLogBuffer {
+ public:
+  explicit AsyncLogBuffer(uint32_t buffer_size) : enqueue_pos_(0), dequeue_pos_(0) {
+    uint64_t capacity = 2;
+    while (capacity < buffer_size) {
+      capacity <<= 1;
+    }
+    mask_ = capacity - 1;
+    entries_ = new AsyncLogEntry[capacity];
+    for (uint64_t i = 0; i < capacity; ++i) {
+      entries_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~AsyncLogBuffer() { delete[] entries_; }
+
+  /// @brief 抢占一个可写条目，缓冲区满时返回NULL
+  AsyncLogEntry* Acquire(uint64_t& position) {
+    position = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      AsyncLogEntry* entry = &entries_[position & mask_];
+      int64_t diff = static_cast<int64_t>(entry->sequence_.load(std::memory_order_acquire)) -
+                     static_cast<int64_t>(position);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          return entry;
+        }
+      } else if (diff < 0) {
+        return nullptr;
+      } else {
+        position = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void Publish(AsyncLogEntry* entry, uint64_t position) {
+    entry->sequence_.store(position + 1, std::memory_order_release);
+  }
+
+  /// @brief 获取下一个可读条目，没有时返回NULL
+  AsyncLogEntry* Front() {
+    AsyncLogEntry* entry = &entries_[dequeue_pos_ & mask_];
+    if (entry->sequence_.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+      return nullptr;
+    }
+    return entry;
+  }
+
+  /// @brief 释放Front返回的条目供生产者复用
+  void Pop(AsyncLogEntry* entry) {
+    entry->sequence_.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+    ++dequeue_pos_;
+  }
+
+  uint64_t Capacity() const { return mask_ + 1; }
+
+ private:
+  uint64_t mask_;
+  AsyncLogEntry* entries_;
+  char padding1_[kLogCacheLineSize];
+  std::atomic<uint64_t> enqueue_pos_;
+  char padding2_[kLogCacheLineSize];
+  uint64_t dequeue_pos_;
+};
+
 LoggerImpl::LoggerImpl(const std::string& log_path, const std::string& log_file_name, int max_file_size,
                        int max_file_no)
     : log_level_(kInfoLogLevel),
@@ -66,10 +148,17 @@ LoggerImpl::LoggerImpl(const std::string& log_path, const std::string& log_file_
       max_file_no_(max_file_no),
       log_file_(nullptr),
       cur_file_size_(0),
-      next_shift_check_time_(0) {
+      next_shift_check_time_(0),
+      cached_second_(0),
+      async_buffer_(nullptr),
+      flush_stop_(false),
+      flush_thread_(0),
+      dropped_count_(0),
+      reported_dropped_count_(0) {
   if (max_file_no_ < 1) {
     max_file_no_ = 1;
   }
+  cached_time_[0] = '\0';
 }
 
 static const char kLogDefaultPath[] = "$HOME/polaris/log/";
@@ -86,9 +175,31 @@ LoggerImpl::LoggerImpl(const std::string& log_file_name)
       max_file_no_(kLogMaxFileNo),
       log_file_(nullptr),
       cur_file_size_(0),
-      next_shift_check_time_(0) {}
+      next_shift_check_time_(0),
+      cached_second_(0),
+      async_buffer_(nullptr),
+      flush_stop_(false),
+      flush_thread_(0),
+      dropped_count_(0),
+      reported_dropped_count_(0) {
+  cached_time_[0] = '\0';
+}
 
-LoggerImpl::~LoggerImpl() { CloseFile(); }
+LoggerImpl::~LoggerImpl() {
+  AsyncLogBuffer* async_buffer = async_buffer_.load(std::memory_order_acquire);
+  if (async_buffer != nullptr) {
+    flush_stop_.store(true, std::memory_order_release);
+    pthread_join(flush_thread_, nullptr);
+    do {
+      const std::lock_guard<std::mutex> mutex_guard(lock_);
+      while (FlushBuffer()) {
+      }
+    } while (false);
+    async_buffer_.store(nullptr, std::memory_order_relaxed);
+    delete async_buffer;
+  }
+  CloseFile();
+}
 
 bool LoggerImpl::isLevelEnabled(LogLevel log_level) { return log_level >= log_level_; }
 
@@ -216,54 +327,196 @@ void LoggerImpl::ShiftFile() {
   }
 }
 
-void LoggerImpl::Log(const char* file, int line, LogLevel log_level, const char* format, ...) {
-  if (log_level < log_level_) {
-    return;
-  }
-  char* message = nullptr;
-  va_list args;
-  va_start(args, format);
-  if (vasprintf(&message, format, args) == -1) {
-    va_end(args);
-    return;
-  }
-  va_end(args);
-
+static uint32_t GetLogThreadId() {
   static __thread uint32_t tid = 0;
   if (tid == 0) {
     tid = gettid();
   }
+  return tid;
+}
 
-  const char* display_file;
+static const char* GetDisplayFile(const char* file) {
   const char* final_slash = strrchr(file, '/');
-  if (final_slash == nullptr) {
-    display_file = file;
-  } else {
-    display_file = final_slash + 1;
+  return final_slash == nullptr ? file : final_slash + 1;
+}
+
+const char* LoggerImpl::FormatTime(time_t second) {
+  if (second == cached_second_ && cached_time_[0] != '\0') {
+    return cached_time_;
+  }
+  struct tm tm;
+  if (!localtime_r(&second, &tm)) {
+    snprintf(cached_time_, sizeof(cached_time_), "error:localtime");
+  } else if (0 == strftime(cached_time_, sizeof(cached_time_), "%Y-%m-%d %H:%M:%S", &tm)) {
+    snprintf(cached_time_, sizeof(cached_time_), "error:strftime");
+  }
+  cached_second_ = second;
+  return cached_time_;
+}
+
+void LoggerImpl::WriteFile(const timespec& now, LogLevel log_level, const char* content, int length) {
+  ShiftFile();
+  if (log_file_ != nullptr) {
+    int write_size = fprintf(log_file_, "[%s,%03ld] %s %.*s\n", FormatTime(static_cast<time_t>(now.tv_sec)),
+                             now.tv_nsec / 1000000L, LogLevelToStr(log_level), length, content);
+    if (write_size > 0) {
+      cur_file_size_ += write_size;
+    }
+  }
+}
+
+bool LoggerImpl::FlushBuffer() {
+  AsyncLogBuffer* async_buffer = async_buffer_.load(std::memory_order_acquire);
+  if (async_buffer == nullptr) {
+    return false;
   }
+  // 每批最多写一个缓冲区大小的日志，避免长时间持有锁
+  uint64_t count = 0;
+  AsyncLogEntry* entry;
+  while (count < async_buffer->Capacity() && (entry = async_buffer->Front()) != nullptr) {
+    WriteFile(entry->time_, entry->log_level_, entry->content_, entry->length_);
+    async_buffer->Pop(entry);
+    ++count;
+  }
+  uint64_t dropped_count = dropped_count_.load(std::memory_order_relaxed);
+  if (dropped_count != reported_dropped_count_) {
+    char content[128];
+    int length = snprintf(content, sizeof(content), "async log buffer is full, %" PRIu64 " logs dropped",
+                          dropped_count - reported_dropped_count_);
+    timespec now;
+    Time::GetSystemClockTime(now);
+    WriteFile(now, kWarnLogLevel, content, length);
+    reported_dropped_count_ = dropped_count;
+    ++count;
+  }
+  if (count > 0 && log_file_ != nullptr) {
+    fflush(log_file_);
+  }
+  return count > 0;
+}
+
+static const useconds_t kAsyncLogFlushInterval = 10 * 1000;  // 缓冲区为空时后台线程等待10ms
+
+void* LoggerImpl::FlushThread(void* args) {
+  LoggerImpl* logger = static_cast<LoggerImpl*>(args);
+  while (!logger->flush_stop_.load(std::memory_order_acquire)) {
+    bool flushed;
+    do {
+      const std::lock_guard<std::mutex> mutex_guard(logger->lock_);
+      flushed = logger->FlushBuffer();
+    } while (false);
+    if (!flushed) {
+      usleep(kAsyncLogFlushInterval);
+    }
+  }
+  return nullptr;
+}
+
+bool LoggerImpl::EnableAsync(uint32_t buffer_size) {
+  const std::lock_guard<std::mutex> mutex_guard(lock_);
+  if (async_buffer_.load(std::memory_order_relaxed) != nullptr) {
+    return false;
+  }
+  AsyncLogBuffer* async_buffer = new AsyncLogBuffer(buffer_size);
+  async_buffer_.store(async_buffer, std::memory_order_release);
+  if (pthread_create(&flush_thread_, nullptr, FlushThread, this) != 0) {
+    async_buffer_.store(nullptr, std::memory_order_relaxed);
+    delete async_buffer;
+    fprintf(stderr, "polaris c++ sdk create async log thread failed\n");
+    return false;
+  }
+#if defined(__GLIBC_PREREQ) && __GLIBC_PREREQ(2, 12) && !defined(COMPILE_FOR_PRE_CPP11)
+  pthread_setname_np(flush_thread_, "async_log");
+#endif
+  return true;
+}
+
+bool LoggerImpl::AsyncLog(const timespec& now, LogLevel log_level, const char* suffix, int suffix_length,
+                          const char* format, va_list args) {
+  AsyncLogBuffer* async_buffer = async_buffer_.load(std::memory_order_acquire);
+  if (async_buffer == nullptr) {
+    return false;
+  }
+  uint64_t position;
+  AsyncLogEntry* entry = async_buffer->Acquire(position);
+  if (entry == nullptr) {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  // 超长的内容截断，但保留线程和代码位置信息
+  int max_length = static_cast<int>(sizeof(entry->content_)) - suffix_length - 1;
+  int length = vsnprintf(entry->content_, max_length + 1, format, args);
+  if (length < 0) {
+    length = 0;
+  } else if (length > max_length) {
+    length = max_length;
+  }
+  memcpy(entry->content_ + length, suffix, suffix_length);
+  entry->time_ = now;
+  entry->log_level_ = log_level;
+  entry->length_ = length + suffix_length;
+  async_buffer->Publish(entry, position);
+  return true;
+}
+
+static const std::size_t kLogStackBufferSize = 1024;
 
+void LoggerImpl::Log(const char* file, int line, LogLevel log_level, const char* format, ...) {
+  if (log_level < log_level_) {
+    return;
+  }
   timespec now;
   Time::GetSystemClockTime(now);
-  struct tm tm;
-  char time_buffer[64];
-  time_t timer = static_cast<time_t>(now.tv_sec);
-  if (!localtime_r(&timer, &tm)) {
-    snprintf(time_buffer, sizeof(time_buffer), "error:localtime");
-  } else if (0 == strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", &tm)) {
-    snprintf(time_buffer, sizeof(time_buffer), "error:strftime");
+  char suffix[256];
+  int suffix_length = snprintf(suffix, sizeof(suffix), " (tid:%" PRId32 " %s:%d)", GetLogThreadId(),
+                               GetDisplayFile(file), line);
+  if (suffix_length < 0) {
+    return;
+  } else if (suffix_length >= static_cast<int>(sizeof(suffix))) {
+    suffix_length = sizeof(suffix) - 1;
   }
 
+  va_list args;
+  if (log_level < kFatalLogLevel) {
+    va_start(args, format);
+    bool async_logged = AsyncLog(now, log_level, suffix, suffix_length, format, args);
+    va_end(args);
+    if (async_logged) {
+      return;
+    }
+  }
+
+  // 同步写入，优先格式化到栈上，超长时才申请内存
+  char buffer[kLogStackBufferSize];
+  char* message = buffer;
+  va_start(args, format);
+  int length = vsnprintf(buffer, sizeof(buffer) - suffix_length, format, args);
+  va_end(args);
+  if (length < 0) {
+    return;
+  }
+  if (length + suffix_length >= static_cast<int>(sizeof(buffer))) {
+    message = static_cast<char*>(malloc(length + suffix_length + 1));
+    if (message == nullptr) {
+      return;
+    }
+    va_start(args, format);
+    vsnprintf(message, length + 1, format, args);
+    va_end(args);
+  }
+  memcpy(message + length, suffix, suffix_length);
+
   do {
     const std::lock_guard<std::mutex> mutex_guard(lock_);
-    ShiftFile();
+    FlushBuffer();  // 先写入缓冲区中已有的日志，保证顺序
+    WriteFile(now, log_level, message, length + suffix_length);
     if (log_file_ != nullptr) {
-      int write_size = fprintf(log_file_, "[%s,%03ld] %s %s (tid:%" PRId32 " %s:%d)\n", time_buffer,
-                               now.tv_nsec / 1000000L, LogLevelToStr(log_level), message, tid, display_file, line);
-      cur_file_size_ += write_size;
       fflush(log_file_);
     }
   } while (false);
-  free(message);
+  if (message != buffer) {
+    free(message);
+  }
 }
 
 Logger* g_logger = nullptr;
@@ -295,19 +548,32 @@ void SetLogDir(const std::string& log_dir) {
   GetStatLogger()->SetLogDir(log_dir);
 }
 
-Logger* GetLogger() {
+static LoggerImpl* GetDefaultLogger() {
   static Indestructible<LoggerImpl> default_logger(kLogDefaultFile);
+  return default_logger.Get();
+}
+
+static LoggerImpl* GetDefaultStatLogger() {
+  static Indestructible<LoggerImpl> default_stat_logger(kLogDefaultStatFile);
+  return default_stat_logger.Get();
+}
+
+void EnableAsyncLog() {
+  GetDefaultLogger()->EnableAsync();
+  GetDefaultStatLogger()->EnableAsync();
+}
+
+Logger* GetLogger() {
   if (g_logger == nullptr) {
-    return default_logger.Get();
+    return GetDefaultLogger();
   } else {
     return g_logger;
   }
 }
 
 Logger* GetStatLogger() {
-  static Indestructible<LoggerImpl> default_stat_logger(kLogDefaultStatFile);
   if (g_stat_logger == nullptr) {
-    return default_stat_logger.Get();
+    return GetDefaultStatLogger();
   } else {
     return g_stat_logger;
   }
@@ -18,9 +18,13 @@
 #  define __STDC_FORMAT_MACROS
 #endif
 #include <assert.h>
+#include <pthread.h>
+#include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <time.h>
 
+#include <atomic>
 #include <mutex>
 #include <string>
 
@@ -62,6 +66,10 @@ namespace polaris {
 
 const char* LogLevelToStr(LogLevel log_level);
 
+class AsyncLogBuffer;
+
+static const uint32_t kAsyncLogDefaultBufferSize = 1024;
+
 class LoggerImpl : public Logger {
  public:
   LoggerImpl(const std::string& log_path, const std::string& log_file_name, int max_file_size, int max_file_no);
@@ -81,12 +89,34 @@ class LoggerImpl : public Logger {
   virtual void Log(const char* file, int line, LogLevel log_level, const char* format, ...)
       __attribute__((format(printf, 5, 6)));
 
+  /// @brief 开启异步输出，开启后不能关闭
+  ///
+  /// 异步模式下调用线程将日志格式化到无锁环形缓冲区中，由后台线程批量写入文件，调用线程不再竞争文件锁。
+  /// 缓冲区满时丢弃日志并计数，后台线程会输出丢弃的日志条数。FATAL级别日志仍同步写入文件。
+  /// 单条日志超过缓冲区条目大小时会被截断
+  /// @param buffer_size 缓冲区可容纳的日志条数，向上取整为2的幂
+  /// @return true 开启成功
+  /// @return false 已经开启或创建后台线程失败
+  bool EnableAsync(uint32_t buffer_size = kAsyncLogDefaultBufferSize);
+
+  /// @brief 异步模式下因缓冲区满丢弃的日志条数
+  uint64_t GetDroppedCount() const { return dropped_count_.load(std::memory_order_relaxed); }
+
  private:
   void CloseFile();
   void OpenFile();
   void ShiftFile();
   void ShiftFileWithFileLock();
 
+  // 以下方法需要持有lock_调用
+  const char* FormatTime(time_t second);
+  void WriteFile(const timespec& now, LogLevel log_level, const char* content, int length);
+  bool FlushBuffer();
+
+  bool AsyncLog(const timespec& now, LogLevel log_level, const char* suffix, int suffix_length, const char* format,
+                va_list args);
+  static void* FlushThread(void* args);
+
  private:
   friend class LoggerTest_TestFileShift_Test;
   LogLevel log_level_;
@@ -99,6 +129,15 @@ class LoggerImpl : public Logger {
   FILE* log_file_;
   int cur_file_size_;
   uint64_t next_shift_check_time_;  // 下次检查文件是否需要滚动的时间
+
+  time_t cached_second_;  // 缓存时间字符串对应的秒数，每秒只格式化一次时间
+  char cached_time_[32];
+
+  std::atomic<AsyncLogBuffer*> async_buffer_;  // 开启异步输出后才创建
+  std::atomic<bool> flush_stop_;
+  pthread_t flush_thread_;
+  std::atomic<uint64_t> dropped_count_;
+  uint64_t reported_dropped_count_;  // 已输出到文件的丢弃条数
 };
 
 }  // namespace polaris
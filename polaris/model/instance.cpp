@@ -157,6 +157,7 @@ Instance* InstanceImpl::DumpWithLocalityAwareInfo(uint64_t locality_aware_info)
   instance_impl.remote_value_ = this->remote_value_;
   instance_impl.local_value_ = this->local_value_;
   instance_impl.owned_value_.locality_aware_info_ = locality_aware_info;
+  instance_impl.owned_value_.dense_index_ = this->owned_value_.dense_index_;
   return new_instance;
 }
 
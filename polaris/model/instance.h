@@ -14,6 +14,7 @@
 #ifndef POLARIS_CPP_POLARIS_MODEL_INSTANCE_H_
 #define POLARIS_CPP_POLARIS_MODEL_INSTANCE_H_
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -64,6 +65,18 @@ struct InstanceRemoteValue {
   std::string logic_set_;
 };
 
+/// 实例实时负载，由感知负载的负载均衡插件维护
+struct InstanceLoad {
+  InstanceLoad() : inflight_(0), latency_ewma_(0), latency_update_time_(0) {}
+
+  // 已选出但还未上报调用结果的请求数
+  std::atomic<int> inflight_;
+  // 调用耗时的峰值指数加权平均，单位微秒，0表示还没有耗时数据
+  std::atomic<uint64_t> latency_ewma_;
+  // 最近一次更新耗时平均值的单调时钟毫秒时间
+  std::atomic<uint64_t> latency_update_time_;
+};
+
 /// 实例本地数据，SDK生成的数据
 struct InstanceLocalValue {
   InstanceLocalValue() : local_id_(0), dynamic_weight_(0), hash_(0) {}
@@ -85,14 +98,20 @@ struct InstanceLocalValue {
   uint64_t hash_;
   std::vector<uint64_t> vnode_hash_;
   std::mutex vnode_hash_mutex_;
+
+  // 实例负载，感知负载的负载均衡使用
+  InstanceLoad load_;
 };
 
 /// 实例独享数据，复制时需要单独拷贝
 struct InstanceOwnedValue {
-  InstanceOwnedValue() : locality_aware_info_(0) {}
+  InstanceOwnedValue() : locality_aware_info_(0), dense_index_(0) {}
 
   // LA负载均衡跟踪信息，默认值为0，启用LA后为非0值
   uint64_t locality_aware_info_;
+
+  // 实例在所属服务实例数据中的稠密下标，用于以位集合表示实例子集
+  uint32_t dense_index_;
 };
 
 class InstanceImpl {
@@ -111,6 +130,10 @@ class InstanceImpl {
 
   void SetLocalId(uint64_t local_id);
 
+  void SetDenseIndex(uint32_t dense_index) { owned_value_.dense_index_ = dense_index; }
+
+  uint32_t GetDenseIndex() const { return owned_value_.dense_index_; }
+
   void SetLocalValue(InstanceLocalValue* localValue);
 
   void CopyLocalValue(const InstanceImpl& impl);
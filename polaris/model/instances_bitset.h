@@ -0,0 +1,77 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_MODEL_INSTANCES_BITSET_H_
+#define POLARIS_CPP_POLARIS_MODEL_INSTANCES_BITSET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "model/instance.h"
+#include "polaris/model.h"
+#include "utils/bitset.h"
+
+namespace polaris {
+
+/// @brief 以实例稠密下标表示的实例集合
+///
+/// 解析服务实例数据时为每个实例分配 [0, n) 范围内的稠密下标，同一份实例数据的实例子集可以直接做位运算。
+/// 路由插件用其表示不健康实例等中间集合，只在生成路由结果时才转换成实例列表
+class InstancesBitset {
+ public:
+  InstancesBitset() {}
+
+  explicit InstancesBitset(std::size_t size) : bits_(size) {}
+
+  /// @brief 重新设置大小，并清空所有实例
+  void Resize(std::size_t size) { bits_.Resize(size); }
+
+  /// @brief 加入实例，下标不在范围内的实例不属于该实例数据，直接忽略
+  void Insert(Instance* instance) {
+    uint32_t index = instance->GetImpl().GetDenseIndex();
+    if (index < bits_.Size()) {
+      bits_.Set(index);
+    }
+  }
+
+  bool Contains(Instance* instance) const {
+    uint32_t index = instance->GetImpl().GetDenseIndex();
+    return index < bits_.Size() && bits_.Test(index);
+  }
+
+  bool Empty() const { return !bits_.Any(); }
+
+  std::size_t Count() const { return bits_.Count(); }
+
+  Bitset& GetBits() { return bits_; }
+
+  const Bitset& GetBits() const { return bits_; }
+
+  /// @brief 按输入顺序把在(或不在)集合中的实例追加到结果中
+  void Select(const std::vector<Instance*>& instances, bool contained, std::vector<Instance*>& result) const {
+    for (std::size_t i = 0; i < instances.size(); ++i) {
+      if (Contains(instances[i]) == contained) {
+        result.push_back(instances[i]);
+      }
+    }
+  }
+
+ private:
+  Bitset bits_;
+};
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_MODEL_INSTANCES_BITSET_H_
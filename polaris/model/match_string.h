@@ -47,6 +47,10 @@ class MatchString {
 
   bool IsParameter() const { return value_type_ == v1::MatchString::PARAMETER; }
 
+  bool IsAllMatch() const { return allMatch; }
+
+  const re2::RE2* GetRegex() const { return regex_.get(); }
+
   const std::string& GetString() const { return data_; }
 
   // 判断是否为通配符，如果为通配符则返回空字符串，否则返回真实字符串
@@ -30,6 +30,7 @@
 #include <mutex>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "logger.h"
@@ -149,6 +150,28 @@ uint32_t InstancesSetImpl::CalcMaxWeight(const std::vector<Instance*>& instances
   return max_weight;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+Instance* InstancesData::FindInstance(const std::string& instance_id) {
+  std::call_once(id_index_once_, [this] {
+    id_index_.reserve(instances_map_.size());
+    for (std::map<std::string, Instance*>::iterator it = instances_map_.begin(); it != instances_map_.end(); ++it) {
+      id_index_.insert(std::make_pair(it->first, it->second));
+    }
+  });
+  std::unordered_map<std::string, Instance*>::iterator it = id_index_.find(instance_id);
+  return it != id_index_.end() ? it->second : nullptr;
+}
+
+void InstancesData::CopyLocalValues(const InstancesData* old_instances, InstancesData* new_instances) {
+  const std::map<std::string, Instance*>& old_instances_map = old_instances->instances_map_;
+  std::map<std::string, Instance*>::const_iterator old_it;
+  for (auto new_it = new_instances->instances_map_.begin(); new_it != new_instances->instances_map_.end(); ++new_it) {
+    if ((old_it = old_instances_map.find(new_it->first)) != old_instances_map.end()) {  // 迁移数据
+      new_it->second->GetImpl().CopyLocalValue(old_it->second->GetImpl());
+    }
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 const char* DataTypeToStr(ServiceDataType data_type) {
   switch (data_type) {
@@ -286,11 +309,24 @@ void ServiceDataImpl::ParseInstancesData(v1::DiscoverResponse& response) {
       instanceMap[instance->GetId()] = instance;
     }
   }
+  // 按实例列表顺序分配稠密下标，隔离实例排在最后
+  uint32_t dense_index = 0;
   std::vector<Instance*> instances;
+  instances.reserve(instanceMap.size());
   for (std::map<std::string, Instance*>::iterator it = instanceMap.begin(); it != instanceMap.end(); ++it) {
     instances.push_back(it->second);
-    if (!it->second->isHealthy()) {
-      data_.instances_->unhealthy_instances_.insert(it->second);
+    it->second->GetImpl().SetDenseIndex(dense_index++);
+  }
+  for (std::set<Instance*>::iterator it = data_.instances_->isolate_instances_.begin();
+       it != data_.instances_->isolate_instances_.end(); ++it) {
+    (*it)->GetImpl().SetDenseIndex(dense_index++);
+  }
+  data_.instances_->dense_size_ = dense_index;
+  data_.instances_->unhealthy_bitset_.Resize(dense_index);
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    if (!instances[i]->isHealthy()) {
+      data_.instances_->unhealthy_instances_.insert(instances[i]);
+      data_.instances_->unhealthy_bitset_.Insert(instances[i]);
     }
   }
   data_.instances_->instances_map_.swap(instanceMap);
@@ -363,6 +399,7 @@ void ServiceDataImpl::ParseRouteRuleData(v1::DiscoverResponse& response) {
     data_.route_rule_->outbounds_[i].recover_all_ = false;
     GetRouteRuleKeys(routing.outbounds(i), data_.route_rule_->keys_);
   }
+  data_.route_rule_->CompileMatcher();
 }
 
 void ServiceDataImpl::FillSystemVariables(const SystemVariables& variables) {
@@ -374,6 +411,7 @@ void ServiceDataImpl::FillSystemVariables(const SystemVariables& variables) {
   for (std::size_t i = 0; i < outbounds.size(); ++i) {
     outbounds[i].route_rule_.FillSystemVariables(variables);
   }
+  data_.route_rule_->CompileMatcher();
 }
 
 void ServiceDataImpl::ParseRateLimitData(v1::DiscoverResponse& response) {
@@ -22,9 +22,11 @@
 #include <mutex>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "logger.h"
+#include "model/instances_bitset.h"
 #include "plugin/load_balancer/hash/hash_manager.h"
 #include "polaris/defs.h"
 #include "polaris/model.h"
@@ -67,6 +69,9 @@ class InstancesSetImpl {
 
   std::mutex& CreationLock() { return selector_creation_mutex_; }
 
+  // 设置共享的选择器，负载均衡插件可以继续持有选择器用于实例变化后的增量构建
+  void SetSelector(const std::shared_ptr<Selector>& selector) { selector_ = selector; }
+
  public:
   std::atomic<int> count_;  // 记录这个Set被访问的次数
 
@@ -76,14 +81,18 @@ class InstancesSetImpl {
   std::map<std::string, std::string> subset_;  // 所属的subset
   std::atomic<bool> recover_all_;  // 用来标记这个集合计算的下一个路由是否发生了全死全活
   std::string recover_info_;
-  std::unique_ptr<Selector> selector_;
+  std::shared_ptr<Selector> selector_;
   std::mutex selector_creation_mutex_;
 };
 
 class InstancesData {
  public:
   InstancesData()
-      : is_enable_nearby_(false), is_enable_canary_(false), instances_(nullptr), dynamic_weight_version_(0) {}
+      : is_enable_nearby_(false),
+        is_enable_canary_(false),
+        instances_(nullptr),
+        dense_size_(0),
+        dynamic_weight_version_(0) {}
 
   ~InstancesData() {
     instances_->DecrementRef();
@@ -94,6 +103,12 @@ class InstancesData {
       delete instance;
     }
   }
+  // 根据实例ID查找实例，不存在时返回NULL。首次查找时构建哈希索引，用于上报调用结果等按ID查找的高频路径
+  Instance* FindInstance(const std::string& instance_id);
+
+  // 新实例对象沿用旧实例对象的本地数据，用于需要在实例更新后保留本地数据的插件
+  static void CopyLocalValues(const InstancesData* old_instances, InstancesData* new_instances);
+
   std::map<std::string, std::string> metadata_;
   bool is_enable_nearby_;
   bool is_enable_canary_;
@@ -101,12 +116,27 @@ class InstancesData {
   std::set<Instance*> unhealthy_instances_;
   std::set<Instance*> isolate_instances_;
   InstancesSet* instances_;
+  uint32_t dense_size_;               // 实例稠密下标数量，包括隔离实例
+  InstancesBitset unhealthy_bitset_;  // 与unhealthy_instances_相同的不健康实例集合
   std::atomic<uint64_t> dynamic_weight_version_;
+
+ private:
+  std::once_flag id_index_once_;
+  std::unordered_map<std::string, Instance*> id_index_;
 };
 
 class ServiceInstances::Impl {
  public:
   explicit Impl(ServiceData* service_data);
+
+  // 重新绑定服务数据，用于复用服务实例对象，路由过程中保留的实例子集会被清除
+  void Reset(ServiceData* service_data) { *this = Impl(service_data); }
+
+  // 重新绑定服务实例对象的服务数据，嵌套类可以访问外部类的私有成员，无需在公开头文件中声明友元
+  static void Reset(ServiceInstances& service_instances, ServiceData* service_data) {
+    service_instances.impl_->Reset(service_data);
+  }
+
   ServiceData* service_data_;
   InstancesSet* available_instances_;
   InstancesData* data_;
@@ -143,6 +173,8 @@ class ServiceDataImpl {
   // 熔断配置
   void ParseCircuitBreaker(v1::DiscoverResponse& response);
 
+  InstancesData* GetInstancesData() { return data_.instances_; }
+
   RouteRuleData* GetRouteRuleData() { return data_.route_rule_; }
 
   RateLimitData* GetRateLimitData() { return data_.rate_limit_; }
@@ -13,6 +13,8 @@
 
 #include "model/requests.h"
 
+#include "model/model_impl.h"
+
 namespace polaris {
 
 // 获取单个服务请求
@@ -67,6 +69,9 @@ void GetOneInstanceRequest::SetLabels(const std::map<std::string, std::string>&
   } else {
     *impl_->labels_ = labels;
   }
+  Labels labels_with_str;
+  labels_with_str.labels_ = labels;
+  impl_->labels_str_ = labels_with_str.GetLabelStr();
 }
 
 void GetOneInstanceRequest::SetMetadata(std::map<std::string, std::string>& metadata) {
@@ -107,6 +112,7 @@ GetOneInstanceRequest::Impl* GetOneInstanceRequest::Impl::Dump() const {
   if (timeout_.HasValue()) dump->timeout_ = timeout_;
   dump->load_balance_type_ = load_balance_type_;
   if (labels_ != nullptr) dump->labels_.reset(new std::map<std::string, std::string>(GetLabels()));
+  dump->labels_str_ = labels_str_;
   if (metadata_param_ != nullptr) {
     dump->metadata_param_.reset(new MetadataRouterParam(*metadata_param_));
   }
@@ -225,8 +231,7 @@ void ServiceCallResult::SetInstanceHostAndPort(const std::string& host, int port
   if (impl_->instance_host_port_ == nullptr) {
     impl_->instance_host_port_ = new InstanceHostPortKey();
   }
-  impl_->instance_host_port_->host_ = host;
-  impl_->instance_host_port_->port_ = port;
+  impl_->instance_host_port_->Set(host, port);
 }
 
 void ServiceCallResult::SetRetStatus(CallRetStatus ret_status) { impl_->gauge_.call_ret_status = ret_status; }
@@ -21,6 +21,7 @@
 #include <string>
 
 #include "cache/cache_manager.h"
+#include "cache/service_cache.h"
 #include "model/constants.h"
 #include "polaris/consumer.h"
 #include "polaris/defs.h"
@@ -41,7 +42,9 @@ class GetOneInstanceRequest::Impl {
   LoadBalanceType load_balance_type_;
   uint32_t backup_instance_num_;                                 ///< 返回用于重试的实例数量
   std::unique_ptr<std::map<std::string, std::string> > labels_;  ///< 请求标签，用于接口级别熔断
+  std::string labels_str_;                                       ///< 预先计算的请求标签字符串
   std::unique_ptr<MetadataRouterParam> metadata_param_;          ///< 请求元数据，用于元数据路由
+  ReusableRouteData reusable_route_data_;                        ///< 重复使用请求对象时复用的路由数据
 
   ServiceInfo* DumpSourceService() const {
     return source_service_ != nullptr ? new ServiceInfo(*source_service_) : nullptr;
@@ -13,6 +13,8 @@
 
 #include "model/responses.h"
 
+#include "model/constants.h"
+
 namespace polaris {
 
 InstancesResponse::InstancesResponse() : impl_(new InstancesResponse::Impl()) {}
@@ -40,4 +42,92 @@ const std::map<std::string, std::string>& InstancesResponse::GetSubset() { retur
 
 InstancesResponse::Impl& InstancesResponse::GetImpl() const { return *impl_; }
 
+///////////////////////////////////////////////////////////////////////////////
+InstancesView::Impl::Impl()
+    : flow_id_(0), service_data_(nullptr), instances_set_(nullptr), metadata_(nullptr), use_filtered_(false) {}
+
+InstancesView::Impl::~Impl() { Release(); }
+
+void InstancesView::Impl::Release() {
+  // 实例集合中的实例属于服务数据，必须先释放实例集合
+  if (instances_set_ != nullptr) {
+    instances_set_->DecrementRef();
+    instances_set_ = nullptr;
+  }
+  if (service_data_ != nullptr) {
+    service_data_->DecrementRef();
+    service_data_ = nullptr;
+  }
+  metadata_ = nullptr;
+  use_filtered_ = false;
+  filtered_instances_.clear();
+}
+
+void InstancesView::Impl::Reset(ServiceData* service_data, InstancesSet* instances_set,
+                                const std::map<std::string, std::string>* metadata) {
+  service_data->IncrementRef();
+  instances_set->IncrementRef();
+  Release();
+  service_data_ = service_data;
+  instances_set_ = instances_set;
+  metadata_ = metadata;
+}
+
+const std::vector<Instance*>& InstancesView::Impl::GetInstances() const {
+  static const std::vector<Instance*> kEmptyInstances;
+  if (use_filtered_) {
+    return filtered_instances_;
+  }
+  return instances_set_ != nullptr ? instances_set_->GetInstances() : kEmptyInstances;
+}
+
+InstancesView::InstancesView() : impl_(new InstancesView::Impl()) {}
+
+InstancesView::InstancesView(const InstancesView& other) : impl_(other.impl_) { impl_->IncrementRef(); }
+
+const InstancesView& InstancesView::operator=(const InstancesView& other) {
+  if (this != &other) {
+    other.impl_->IncrementRef();
+    impl_->DecrementRef();
+    impl_ = other.impl_;
+  }
+  return *this;
+}
+
+InstancesView::~InstancesView() {
+  if (impl_ != nullptr) {
+    impl_->DecrementRef();
+    impl_ = nullptr;
+  }
+}
+
+uint64_t InstancesView::GetFlowId() const { return impl_->flow_id_; }
+
+const std::string& InstancesView::GetServiceName() const {
+  return impl_->service_data_ != nullptr ? impl_->service_data_->GetServiceKey().name_ : constants::EmptyString();
+}
+
+const std::string& InstancesView::GetServiceNamespace() const {
+  return impl_->service_data_ != nullptr ? impl_->service_data_->GetServiceKey().namespace_
+                                         : constants::EmptyString();
+}
+
+const std::map<std::string, std::string>& InstancesView::GetMetadata() const {
+  return impl_->metadata_ != nullptr ? *impl_->metadata_ : constants::EmptyStringMap();
+}
+
+const std::string& InstancesView::GetRevision() const {
+  return impl_->service_data_ != nullptr ? impl_->service_data_->GetRevision() : constants::EmptyString();
+}
+
+const std::map<std::string, std::string>& InstancesView::GetSubset() const {
+  return impl_->instances_set_ != nullptr ? impl_->instances_set_->GetSubset() : constants::EmptyStringMap();
+}
+
+std::size_t InstancesView::GetInstancesSize() const { return impl_->GetInstances().size(); }
+
+const Instance& InstancesView::GetInstance(std::size_t index) const { return *impl_->GetInstances()[index]; }
+
+InstancesView::Impl& InstancesView::GetImpl() const { return *impl_; }
+
 }  // namespace polaris
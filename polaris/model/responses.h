@@ -21,6 +21,8 @@
 #include <vector>
 
 #include "polaris/consumer.h"
+#include "polaris/model.h"
+#include "utils/ref_count.h"
 
 namespace polaris {
 
@@ -37,6 +39,36 @@ class InstancesResponse::Impl {
   std::map<std::string, std::string> subset_;
 };
 
+class InstancesView::Impl : public AtomicRefCount {
+ public:
+  Impl();
+
+  /// @brief 引用新的实例快照，并释放原有快照的引用
+  ///
+  /// @param service_data 实例所属的服务数据，保证实例对象不被释放
+  /// @param instances_set 路由计算得到的实例集合
+  /// @param metadata 服务元数据，属于service_data
+  void Reset(ServiceData* service_data, InstancesSet* instances_set, const std::map<std::string, std::string>* metadata);
+
+  /// @brief 是否只被一个视图对象引用，是则可以直接复用
+  bool IsUnique() const { return ref_count_.load(std::memory_order_acquire) == 1; }
+
+  const std::vector<Instance*>& GetInstances() const;
+
+ private:
+  virtual ~Impl();
+
+  void Release();
+
+ public:
+  uint64_t flow_id_;
+  ServiceData* service_data_;
+  InstancesSet* instances_set_;
+  const std::map<std::string, std::string>* metadata_;
+  bool use_filtered_;                          // 为true表示实例集合中部分实例被过滤
+  std::vector<Instance*> filtered_instances_;  // 过滤后的实例
+};
+
 }  // namespace polaris
 
 #endif  //  POLARIS_CPP_POLARIS_MODEL_RESPONSES_H_
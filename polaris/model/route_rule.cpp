@@ -71,7 +71,7 @@ bool RouteRule::MatchSource(ServiceInfo* service_info, const ServiceKey& dst_ser
 
 // 根据Destination计算路由结果
 bool RouteRule::CalculateSet(ServiceKey& service_key, bool match_service, const std::vector<Instance*>& instances,
-                             const std::set<Instance*>& unhealthy_set,
+                             const InstancesBitset& unhealthy_set,
                              const std::map<std::string, std::string>& parameters,
                              std::map<uint32_t, std::vector<RuleRouterSet*> >& result) const {
   for (std::map<uint32_t, std::vector<RouteRuleDestination> >::const_iterator it = destinations_.begin();
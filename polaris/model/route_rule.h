@@ -37,11 +37,15 @@ class RouteRule {
   bool MatchSource(ServiceInfo* serice_info, const ServiceKey& dst_service, std::string& parameters) const;
 
   bool CalculateSet(ServiceKey& service_key, bool match_service, const std::vector<Instance*>& instances,
-                    const std::set<Instance*>& unhealthy_set, const std::map<std::string, std::string>& parameters,
+                    const InstancesBitset& unhealthy_set, const std::map<std::string, std::string>& parameters,
                     std::map<uint32_t, std::vector<RuleRouterSet*> >& result) const;
 
   const std::map<uint32_t, std::vector<RouteRuleDestination> >& GetDestinations() { return destinations_; }
 
+  bool IsValid() const { return is_valid_; }
+
+  const std::vector<RouteRuleSource>& GetSources() const { return sources_; }
+
  private:
   bool is_valid_;
   // 多条源匹配规则，只有一个源匹配则这个规则就匹配
@@ -58,7 +58,7 @@ bool RouteRuleDestination::MatchService(const ServiceKey& service_key) const {
 
 // 根据Destination计算计算实例分组
 std::map<std::string, RuleRouterSet*> RouteRuleDestination::CalculateSet(
-    const std::vector<Instance*>& instances, const std::set<Instance*>& unhealthy_set,
+    const std::vector<Instance*>& instances, const InstancesBitset& unhealthy_set,
     const std::map<std::string, std::string>& parameters) const {
   //根据instance的元数据来区分set
   std::map<std::string, RuleRouterSet*> rule_router_set_map;
@@ -84,7 +84,7 @@ std::map<std::string, RuleRouterSet*> RouteRuleDestination::CalculateSet(
       } else {
         rule_router_set = rule_router_set_map[ss.GetSubInfoStrId()];
       }
-      if (unhealthy_set.find(*instance_it) == unhealthy_set.end()) {
+      if (!unhealthy_set.Contains(*instance_it)) {
         rule_router_set->healthy_.push_back(*instance_it);
       } else {
         rule_router_set->unhealthy_.push_back(*instance_it);
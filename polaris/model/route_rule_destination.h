@@ -46,7 +46,7 @@ class RouteRuleDestination {
   bool MatchService(const ServiceKey& service_key) const;
 
   std::map<std::string, RuleRouterSet*> CalculateSet(const std::vector<Instance*>& instances,
-                                                     const std::set<Instance*>& unhealthy_set,
+                                                     const InstancesBitset& unhealthy_set,
                                                      const std::map<std::string, std::string>& parameters) const;
 
   bool HasTransfer() const { return !transfer_service_.empty(); }
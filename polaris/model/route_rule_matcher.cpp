@@ -0,0 +1,283 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "model/route_rule_matcher.h"
+
+#include "MurmurHash3.h"
+#include "logger.h"
+#include "model/service_route_rule.h"
+#include "re2/set.h"
+
+namespace polaris {
+
+static const uint32_t kExactValueTableMaxSeed = 16;
+static const std::size_t kExactValueTableMaxExpand = 3;
+
+uint32_t ExactValueTable::Hash(const std::string& value, uint32_t seed) {
+  uint32_t hash[1];
+  ::MurmurHash3_x86_32(value.data(), static_cast<int>(value.size()), seed, static_cast<void*>(hash));
+  return hash[0];
+}
+
+void ExactValueTable::Build(const std::map<std::string, Bitset>& values) {
+  slots_.clear();
+  if (values.empty()) {
+    return;
+  }
+  std::size_t min_capacity = 2;
+  while (min_capacity < values.size() * 2) {
+    min_capacity <<= 1;
+  }
+  // 优先查找无冲突的种子，容量不够时扩容重试
+  std::size_t capacity = min_capacity;
+  for (std::size_t expand = 0; expand <= kExactValueTableMaxExpand; ++expand, capacity <<= 1) {
+    for (uint32_t seed = 0; seed < kExactValueTableMaxSeed; ++seed) {
+      if (TryBuild(values, seed, capacity, false)) {
+        return;
+      }
+    }
+  }
+  TryBuild(values, 0, min_capacity, true);
+}
+
+bool ExactValueTable::TryBuild(const std::map<std::string, Bitset>& values, uint32_t seed, std::size_t capacity,
+                               bool allow_probe) {
+  slots_.assign(capacity, Slot());
+  seed_ = seed;
+  mask_ = capacity - 1;
+  for (std::map<std::string, Bitset>::const_iterator it = values.begin(); it != values.end(); ++it) {
+    std::size_t index = Hash(it->first, seed_) & mask_;
+    while (slots_[index].used_) {
+      if (!allow_probe) {
+        return false;
+      }
+      index = (index + 1) & mask_;
+    }
+    slots_[index].used_ = true;
+    slots_[index].value_ = it->first;
+    slots_[index].sources_ = it->second;
+  }
+  return true;
+}
+
+const Bitset* ExactValueTable::Find(const std::string& value) const {
+  if (slots_.empty()) {
+    return nullptr;
+  }
+  std::size_t index = Hash(value, seed_) & mask_;
+  while (slots_[index].used_) {
+    if (slots_[index].value_ == value) {
+      return &slots_[index].sources_;
+    }
+    index = (index + 1) & mask_;
+  }
+  return nullptr;
+}
+
+RouteRuleMatcher::RouteRuleMatcher() {}
+
+RouteRuleMatcher::~RouteRuleMatcher() {}
+
+void RouteRuleMatcher::Compile(const std::vector<RouteRuleBound>& bounds) {
+  key_matchers_.clear();
+  sources_.clear();
+  rules_.clear();
+
+  // 收集所有来源使用的key，按key顺序分配下标
+  std::map<std::string, std::size_t> key_index;
+  std::size_t source_count = 0;
+  for (std::size_t i = 0; i < bounds.size(); ++i) {
+    const std::vector<RouteRuleSource>& sources = bounds[i].route_rule_.GetSources();
+    source_count += sources.size();
+    for (std::size_t j = 0; j < sources.size(); ++j) {
+      const std::map<std::string, MatchString>& metadata = sources[j].GetMetadata();
+      for (std::map<std::string, MatchString>::const_iterator it = metadata.begin(); it != metadata.end(); ++it) {
+        key_index[it->first] = 0;
+      }
+    }
+  }
+  key_matchers_.resize(key_index.size());
+  std::size_t index = 0;
+  for (std::map<std::string, std::size_t>::iterator it = key_index.begin(); it != key_index.end(); ++it, ++index) {
+    it->second = index;
+    KeyMatcher& key_matcher = key_matchers_[index];
+    key_matcher.key_ = it->first;
+    key_matcher.required_.Resize(source_count);
+    key_matcher.exact_.Resize(source_count);
+    key_matcher.regex_.Resize(source_count);
+  }
+  valid_sources_.Resize(source_count);
+
+  // 将每个来源的匹配条件加入对应key的匹配表
+  std::vector<std::map<std::string, Bitset> > exact_values(key_matchers_.size());
+  std::vector<std::vector<std::pair<const RE2*, uint32_t> > > regex_values(key_matchers_.size());
+  sources_.reserve(source_count);
+  rules_.reserve(bounds.size());
+  for (std::size_t i = 0; i < bounds.size(); ++i) {
+    const RouteRule& route_rule = bounds[i].route_rule_;
+    const std::vector<RouteRuleSource>& sources = route_rule.GetSources();
+    RuleInfo rule_info;
+    rule_info.valid_ = route_rule.IsValid();
+    rule_info.source_begin_ = sources_.size();
+    for (std::size_t j = 0; j < sources.size(); ++j) {
+      uint32_t source_index = sources_.size();
+      sources_.push_back(SourceInfo());
+      SourceInfo& source_info = sources_.back();
+      source_info.source_ = &sources[j];
+      if (rule_info.valid_) {
+        valid_sources_.Set(source_index);
+      }
+      const std::map<std::string, MatchString>& metadata = sources[j].GetMetadata();
+      for (std::map<std::string, MatchString>::const_iterator it = metadata.begin(); it != metadata.end(); ++it) {
+        std::size_t key_id = key_index[it->first];
+        KeyMatcher& key_matcher = key_matchers_[key_id];
+        const MatchString& match_string = it->second;
+        key_matcher.required_.Set(source_index);
+        if (match_string.IsParameter()) {
+          source_info.parameter_keys_.push_back(&key_matcher.key_);
+        } else if (match_string.IsAllMatch()) {
+          continue;  // 只要求包含该key
+        } else if (match_string.IsRegex()) {
+          key_matcher.has_regex_ = true;
+          key_matcher.regex_.Set(source_index);
+          const RE2* regex = match_string.GetRegex();
+          if (regex != nullptr && regex->ok()) {  // 正则不可用时该来源不会匹配
+            regex_values[key_id].push_back(std::make_pair(regex, source_index));
+          }
+        } else {
+          key_matcher.exact_.Set(source_index);
+          Bitset& value_sources = exact_values[key_id][match_string.GetString()];
+          if (value_sources.Size() == 0) {
+            value_sources.Resize(source_count);
+          }
+          value_sources.Set(source_index);
+        }
+      }
+    }
+    rule_info.source_end_ = sources_.size();
+    rules_.push_back(rule_info);
+  }
+
+  for (std::size_t i = 0; i < key_matchers_.size(); ++i) {
+    KeyMatcher& key_matcher = key_matchers_[i];
+    key_matcher.exact_values_.Build(exact_values[i]);
+    const std::vector<std::pair<const RE2*, uint32_t> >& regex_list = regex_values[i];
+    if (regex_list.empty()) {
+      continue;
+    }
+    RE2::Options options(RE2::Quiet);
+    key_matcher.regex_set_.reset(new RE2::Set(options, RE2::UNANCHORED));
+    for (std::size_t j = 0; j < regex_list.size(); ++j) {
+      key_matcher.regex_sources_.push_back(regex_list[j].second);
+      key_matcher.regex_list_.push_back(regex_list[j].first);
+      if (key_matcher.regex_set_ != nullptr && key_matcher.regex_set_->Add(regex_list[j].first->pattern(), nullptr) < 0) {
+        key_matcher.regex_set_.reset();
+      }
+    }
+    if (key_matcher.regex_set_ != nullptr && !key_matcher.regex_set_->Compile()) {
+      key_matcher.regex_set_.reset();
+    }
+    if (key_matcher.regex_set_ == nullptr) {
+      POLARIS_LOG(LOG_WARN, "compile regex set for route rule key[%s] failed, fall back to match one by one",
+                  key_matcher.key_.c_str());
+    } else {
+      key_matcher.regex_list_.clear();
+    }
+  }
+}
+
+void RouteRuleMatcher::MatchRegex(const KeyMatcher& key_matcher, const std::string& value, Bitset& matched) const {
+  matched.ResetAll();
+  if (key_matcher.regex_set_ != nullptr) {
+    std::vector<int> regex_indexes;
+    if (key_matcher.regex_set_->Match(value, &regex_indexes)) {
+      for (std::size_t i = 0; i < regex_indexes.size(); ++i) {
+        matched.Set(key_matcher.regex_sources_[regex_indexes[i]]);
+      }
+    }
+    return;
+  }
+  for (std::size_t i = 0; i < key_matcher.regex_list_.size(); ++i) {
+    if (RE2::PartialMatch(value, *key_matcher.regex_list_[i])) {
+      matched.Set(key_matcher.regex_sources_[i]);
+    }
+  }
+}
+
+int RouteRuleMatcher::Match(const ServiceKey& src_service, const ServiceKey& dst_service,
+                            const std::map<std::string, std::string>& metadata, std::string& parameters) const {
+  Bitset candidates = valid_sources_;
+  Bitset regex_matched;
+  // key和请求元数据都按顺序排列，归并遍历
+  std::map<std::string, std::string>::const_iterator meta_it = metadata.begin();
+  for (std::size_t i = 0; i < key_matchers_.size(); ++i) {
+    const KeyMatcher& key_matcher = key_matchers_[i];
+    while (meta_it != metadata.end() && meta_it->first < key_matcher.key_) {
+      ++meta_it;
+    }
+    if (meta_it == metadata.end() || meta_it->first != key_matcher.key_) {
+      candidates.AndNot(key_matcher.required_);
+      continue;
+    }
+    const std::string& value = meta_it->second;
+    if (!key_matcher.exact_values_.Empty()) {
+      const Bitset* value_sources = key_matcher.exact_values_.Find(value);
+      if (value_sources != nullptr) {
+        candidates.AndNotExcept(key_matcher.exact_, *value_sources);
+      } else {
+        candidates.AndNot(key_matcher.exact_);
+      }
+    }
+    if (key_matcher.has_regex_) {
+      if (regex_matched.Size() == 0) {
+        regex_matched.Resize(sources_.size());
+      }
+      MatchRegex(key_matcher, value, regex_matched);
+      candidates.AndNotExcept(key_matcher.regex_, regex_matched);
+    }
+  }
+
+  // 按规则顺序查找第一个元数据和服务都匹配的来源
+  for (std::size_t i = 0; i < rules_.size(); ++i) {
+    const RuleInfo& rule_info = rules_[i];
+    if (!rule_info.valid_) {
+      continue;
+    }
+    if (rule_info.source_begin_ == rule_info.source_end_) {
+      return static_cast<int>(i);  // 没有来源的规则匹配所有请求
+    }
+    for (std::size_t source_index = candidates.FindNext(rule_info.source_begin_); source_index < rule_info.source_end_;
+         source_index = candidates.FindNext(source_index + 1)) {
+      const SourceInfo& source_info = sources_[source_index];
+      if (source_info.source_->MatchService(src_service, dst_service)) {
+        BuildParameters(source_info, metadata, parameters);
+        return static_cast<int>(i);
+      }
+    }
+  }
+  return -1;
+}
+
+void RouteRuleMatcher::BuildParameters(const SourceInfo& source_info,
+                                       const std::map<std::string, std::string>& metadata, std::string& parameters) {
+  // 与MatchString::MapMatch返回的参数保持一致
+  const char* separator = "";
+  parameters.clear();
+  for (std::size_t i = 0; i < source_info.parameter_keys_.size(); ++i) {
+    std::map<std::string, std::string>::const_iterator meta_it = metadata.find(*source_info.parameter_keys_[i]);
+    parameters = separator + meta_it->second;
+    separator = ",";
+  }
+}
+
+}  // namespace polaris
@@ -0,0 +1,132 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_MODEL_ROUTE_RULE_MATCHER_H_
+#define POLARIS_CPP_POLARIS_MODEL_ROUTE_RULE_MATCHER_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "polaris/defs.h"
+#include "polaris/noncopyable.h"
+#include "re2/re2.h"
+#include "utils/bitset.h"
+
+namespace polaris {
+
+struct RouteRuleBound;
+class RouteRuleSource;
+
+/// @brief 精确匹配值的查找表
+///
+/// 构建时搜索hash种子使所有值落在不同槽位，查找时只需一次hash和一次字符串比较。
+/// 找不到无冲突的种子时退化为线性探测
+class ExactValueTable {
+ public:
+  ExactValueTable() : seed_(0), mask_(0) {}
+
+  void Build(const std::map<std::string, Bitset>& values);
+
+  /// @brief 查找精确匹配该值的来源集合，不存在时返回NULL
+  const Bitset* Find(const std::string& value) const;
+
+  bool Empty() const { return slots_.empty(); }
+
+ private:
+  static uint32_t Hash(const std::string& value, uint32_t seed);
+
+  bool TryBuild(const std::map<std::string, Bitset>& values, uint32_t seed, std::size_t capacity, bool allow_probe);
+
+ private:
+  struct Slot {
+    Slot() : used_(false) {}
+    bool used_;
+    std::string value_;
+    Bitset sources_;
+  };
+  uint32_t seed_;
+  std::size_t mask_;
+  std::vector<Slot> slots_;
+};
+
+/// @brief 编译后的路由规则来源匹配器
+///
+/// 将一组路由规则的所有来源(Source)编译为按key组织的匹配表：
+/// 1. 所有来源使用的key去重后按顺序保存，与请求元数据归并遍历，每个key只查找一次
+/// 2. 每个key的精确匹配值构建查找表，得到匹配该值的来源集合
+/// 3. 每个key的正则表达式合并为一个RE2::Set，一次匹配得到所有匹配的正则
+/// 通过位集合运算得到元数据匹配的来源，再按规则顺序检查服务名，返回第一个匹配的规则
+class RouteRuleMatcher : Noncopyable {
+ public:
+  RouteRuleMatcher();
+
+  ~RouteRuleMatcher();
+
+  /// @brief 根据路由规则编译匹配器，规则修改后需要重新编译
+  void Compile(const std::vector<RouteRuleBound>& bounds);
+
+  /// @brief 查找第一个匹配请求来源的规则
+  ///
+  /// @param src_service 主调服务
+  /// @param dst_service 被调服务
+  /// @param metadata 主调元数据
+  /// @param parameters 匹配成功时返回规则中参数类型key对应的请求元数据值
+  /// @return int 匹配的规则下标，没有规则匹配返回-1
+  int Match(const ServiceKey& src_service, const ServiceKey& dst_service,
+            const std::map<std::string, std::string>& metadata, std::string& parameters) const;
+
+ private:
+  struct KeyMatcher {
+    KeyMatcher() : has_regex_(false) {}
+
+    std::string key_;
+    Bitset required_;             // 要求请求中包含该key的来源
+    Bitset exact_;                // 精确匹配该key的来源
+    ExactValueTable exact_values_;  // 精确值到来源集合的查找表
+    bool has_regex_;
+    Bitset regex_;                        // 正则匹配该key的来源
+    std::shared_ptr<RE2::Set> regex_set_;  // 该key的所有正则表达式
+    std::vector<uint32_t> regex_sources_;  // RE2::Set中正则下标对应的来源下标
+    std::vector<const RE2*> regex_list_;   // RE2::Set编译失败时逐个匹配
+  };
+
+  struct SourceInfo {
+    const RouteRuleSource* source_;
+    std::vector<const std::string*> parameter_keys_;  // 参数类型的key，按key顺序排列
+  };
+
+  struct RuleInfo {
+    bool valid_;
+    uint32_t source_begin_;
+    uint32_t source_end_;
+  };
+
+  void MatchRegex(const KeyMatcher& key_matcher, const std::string& value, Bitset& matched) const;
+
+  static void BuildParameters(const SourceInfo& source_info, const std::map<std::string, std::string>& metadata,
+                              std::string& parameters);
+
+ private:
+  std::vector<KeyMatcher> key_matchers_;  // 按key排序
+  std::vector<SourceInfo> sources_;
+  std::vector<RuleInfo> rules_;
+  Bitset valid_sources_;  // 所属规则有效且可能匹配的来源
+};
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_MODEL_ROUTE_RULE_MATCHER_H_
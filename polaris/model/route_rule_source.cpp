@@ -51,8 +51,11 @@ static bool MatchService(const ServiceKey& rule_service, const ServiceKey& input
 
 bool RouteRuleSource::Match(const ServiceKey& src_service, const ServiceKey& dst_service,
                             const std::map<std::string, std::string>& metadata, std::string& parameter) const {
-  return MatchService(src_service_, src_service) && MatchService(dst_service_, dst_service) &&
-         MatchString::MapMatch(metadata_, metadata, parameter);
+  return MatchService(src_service, dst_service) && MatchString::MapMatch(metadata_, metadata, parameter);
+}
+
+bool RouteRuleSource::MatchService(const ServiceKey& src_service, const ServiceKey& dst_service) const {
+  return polaris::MatchService(src_service_, src_service) && polaris::MatchService(dst_service_, dst_service);
 }
 
 bool RouteRuleSource::IsWildcardRule() const {
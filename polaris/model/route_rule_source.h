@@ -38,6 +38,11 @@ class RouteRuleSource {
 
   bool IsWildcardRule() const;
 
+  // 检查主调服务和被调服务是否匹配
+  bool MatchService(const ServiceKey& src_service, const ServiceKey& dst_service) const;
+
+  const std::map<std::string, MatchString>& GetMetadata() const { return metadata_; }
+
  private:
   ServiceKey src_service_;
   ServiceKey dst_service_;
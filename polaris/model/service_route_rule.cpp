@@ -31,6 +31,20 @@ const std::set<std::string>& ServiceRouteRule::GetKeys() const {
 
 ServiceData* ServiceRouteRule::GetServiceData() { return service_data_; }
 
+// 查找第一个匹配请求来源的规则，传入主调服务信息时使用编译后的匹配器
+static int MatchRouteRules(const RouteRuleMatcher& matcher, const std::vector<RouteRuleBound>& bounds,
+                           ServiceInfo* source_service_info, const ServiceKey& dst_service, std::string& parameters) {
+  if (source_service_info != nullptr) {
+    return matcher.Match(source_service_info->service_key_, dst_service, source_service_info->metadata_, parameters);
+  }
+  for (std::size_t i = 0; i < bounds.size(); ++i) {
+    if (bounds[i].route_rule_.MatchSource(source_service_info, dst_service, parameters)) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
 // 根据路由的Source匹配，查找匹配的路由
 bool ServiceRouteRule::RouteMatch(ServiceRouteRule* route_rule, const ServiceKey& dst_service,
                                   ServiceRouteRule* src_route_rule, ServiceInfo* source_service_info,
@@ -38,12 +52,12 @@ bool ServiceRouteRule::RouteMatch(ServiceRouteRule* route_rule, const ServiceKey
   // 优先匹配被调的入规则
   RouteRuleData* dst_rule_data = route_rule->RouteRule();
   std::vector<RouteRuleBound>& inbounds = dst_rule_data->inbounds_;
-  for (std::size_t i = 0; i < inbounds.size(); ++i) {
-    if (inbounds[i].route_rule_.MatchSource(source_service_info, dst_service, parameters)) {
-      matched_route = &inbounds[i];
-      *match_outbounds = false;
-      return true;
-    }
+  int matched_index =
+      MatchRouteRules(dst_rule_data->inbound_matcher_, inbounds, source_service_info, dst_service, parameters);
+  if (matched_index >= 0) {
+    matched_route = &inbounds[matched_index];
+    *match_outbounds = false;
+    return true;
   }
   if (inbounds.size() > 0) {  // 被调服务有入规则，但却没有匹配到路由
     return false;
@@ -52,12 +66,12 @@ bool ServiceRouteRule::RouteMatch(ServiceRouteRule* route_rule, const ServiceKey
   if (src_route_rule != nullptr) {
     RouteRuleData* src_rule_data = src_route_rule->RouteRule();
     std::vector<RouteRuleBound>& outbounds = src_rule_data->outbounds_;
-    for (std::size_t i = 0; i < outbounds.size(); ++i) {
-      if (outbounds[i].route_rule_.MatchSource(source_service_info, dst_service, parameters)) {
-        matched_route = &outbounds[i];
-        *match_outbounds = true;
-        return true;
-      }
+    matched_index =
+        MatchRouteRules(src_rule_data->outbound_matcher_, outbounds, source_service_info, dst_service, parameters);
+    if (matched_index >= 0) {
+      matched_route = &outbounds[matched_index];
+      *match_outbounds = true;
+      return true;
     }
     if (outbounds.size() > 0) {  // 主调服务有出规则，但却没有匹配到路由
       return false;
@@ -76,7 +90,6 @@ InstancesSet* ServiceRouteRule::SelectSet(std::map<uint32_t, InstancesSet*>& clu
   }
   uint32_t random_weight = rand_r(&thread_local_seed) % sum_weight;
   std::map<uint32_t, InstancesSet*>::iterator it = cluster.upper_bound(random_weight);
-  it->second->GetImpl()->count_++;
   return it->second;
 }
 
@@ -19,6 +19,7 @@
 #include <string>
 
 #include "model/route_rule.h"
+#include "model/route_rule_matcher.h"
 #include "polaris/model.h"
 
 namespace polaris {
@@ -34,9 +35,17 @@ struct RouteRuleBound {
 struct RouteRuleData {
   RouteRuleData(int inbound_size, int outbound_size) : inbounds_(inbound_size), outbounds_(outbound_size) {}
 
+  // 规则初始化或填充环境变量后重新编译来源匹配器
+  void CompileMatcher() {
+    inbound_matcher_.Compile(inbounds_);
+    outbound_matcher_.Compile(outbounds_);
+  }
+
   std::vector<RouteRuleBound> inbounds_;
   std::vector<RouteRuleBound> outbounds_;
   std::set<std::string> keys_;  // 规则中设置的key
+  RouteRuleMatcher inbound_matcher_;
+  RouteRuleMatcher outbound_matcher_;
 };
 
 /// @brief 服务路由：封装类型为服务路由的服务数据提供服务路由接口
@@ -53,6 +62,9 @@ class ServiceRouteRule : Noncopyable {
   /// @brief 获取封装的服务数据
   ServiceData* GetServiceData();
 
+  /// @brief 重新绑定服务数据，用于复用路由规则对象
+  void Reset(ServiceData* service_data) { service_data_ = service_data; }
+
   static bool RouteMatch(ServiceRouteRule* route_rule, const ServiceKey& dst_service, ServiceRouteRule* src_route_rule,
                          ServiceInfo* source_service_info, RouteRuleBound*& matched_route, bool* match_outbounds,
                          std::string& parameters);
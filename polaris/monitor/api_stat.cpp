@@ -21,12 +21,26 @@
 
 namespace polaris {
 
+// 每个线程每该次数API调用采样一次精确延迟，用于计算延迟分位值
+static const uint32_t kLatencySampleInterval = 16;
+
 ApiStat::ApiStat(ContextImpl* context_impl, ApiStatKey stat_key)
-    : registry_(context_impl->GetApiStatRegistry()), api_time_(Time::GetCoarseSteadyTimeMs()), stat_key_(stat_key) {}
+    : registry_(context_impl->GetApiStatRegistry()),
+      api_time_(Time::GetCoarseSteadyTimeMs()),
+      latency_time_(0),
+      stat_key_(stat_key) {
+  static __thread uint32_t api_count = 0;
+  if (++api_count % kLatencySampleInterval == 0) {
+    latency_time_ = Time::GetSteadyTimeUs();
+  }
+}
 
 void ApiStat::Record(ReturnCode ret_code) {
   if (registry_ != nullptr) {
     registry_->Record(stat_key_, ret_code, Time::GetCoarseSteadyTimeMs() - api_time_);
+    if (latency_time_ > 0) {
+      registry_->RecordLatency(stat_key_, Time::GetSteadyTimeUs() - latency_time_);
+    }
     registry_ = nullptr;
   }
 }
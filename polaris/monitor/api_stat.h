@@ -54,6 +54,7 @@ class ApiStat {
  private:
   ApiStatRegistry* registry_;  // API统计中心
   uint64_t api_time_;          // API统计开始时间
+  uint64_t latency_time_;      // 采样记录延迟分布时的精确开始时间，单位微秒，未采样时为0
   ApiStatKey stat_key_;        // API统计key
 };
 
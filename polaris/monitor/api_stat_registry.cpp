@@ -14,6 +14,7 @@
 #include "api_stat_registry.h"
 
 #include <google/protobuf/wrappers.pb.h>
+#include <inttypes.h>
 #include <stddef.h>
 #include <v1/request.pb.h>
 
@@ -56,31 +57,64 @@ static const char* g_DelayRangeStr[] = {
 
 static const int kDelayBucketCount = sizeof(g_DelayRangeStr) / sizeof(const char*);
 
+static const int kLatencyBucketCount = LatencyHistogram::kBucketCount;
+
+struct ApiStatShard {
+  explicit ApiStatShard(int ret_code_count)
+      : metrics_count_(kApiStatKeyCount * ret_code_count * kDelayBucketCount),
+        metrics_(new std::atomic<int>[metrics_count_]),
+        latency_(new std::atomic<int>[kApiStatKeyCount * kLatencyBucketCount]) {
+    for (int i = 0; i < metrics_count_; ++i) {
+      metrics_[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < kApiStatKeyCount * kLatencyBucketCount; ++i) {
+      latency_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  ~ApiStatShard() {
+    delete[] metrics_;
+    delete[] latency_;
+  }
+
+  int metrics_count_;
+  std::atomic<int>* metrics_;  // 三维数组按行展开，三个维度分别为：API key, ret_code索引, delay区间
+  std::atomic<int>* latency_;  // 二维数组按行展开，两个维度分别为：API key, 延迟分布桶
+};
+
 ApiStatRegistry::ApiStatRegistry(Context* context) {
   context_ = context;
   GetAllRetrunCodeInfo(ret_code_info_, success_code_index_);
   ret_code_count_ = ret_code_info_.size();
-  api_metrics_ = new std::atomic<int>**[kApiStatKeyCount];
-  for (int i = 0; i < kApiStatKeyCount; i++) {
-    api_metrics_[i] = new std::atomic<int>*[ret_code_count_];
-    for (int j = 0; j < ret_code_count_; j++) {
-      api_metrics_[i][j] = new std::atomic<int>[kDelayBucketCount];
-      for (int k = 0; k < kDelayBucketCount; k++) {
-        api_metrics_[i][j][k].store(0, std::memory_order_relaxed);
-      }
-    }
+  for (int i = 0; i < kApiStatShardCount; i++) {
+    shards_[i].store(nullptr, std::memory_order_relaxed);
   }
 }
 
 ApiStatRegistry::~ApiStatRegistry() {
   context_ = nullptr;
-  for (int i = 0; i < kApiStatKeyCount; i++) {
-    for (int j = 0; j < ret_code_count_; j++) {
-      delete[] api_metrics_[i][j];
+  for (int i = 0; i < kApiStatShardCount; i++) {
+    delete shards_[i].load(std::memory_order_relaxed);
+  }
+}
+
+static std::atomic<uint32_t> g_api_stat_shard_seq(0);
+
+ApiStatShard* ApiStatRegistry::GetShard() {
+  static __thread int shard_index = -1;
+  if (POLARIS_UNLIKELY(shard_index < 0)) {  // 线程轮流分配分片
+    shard_index = g_api_stat_shard_seq.fetch_add(1, std::memory_order_relaxed) % kApiStatShardCount;
+  }
+  ApiStatShard* shard = shards_[shard_index].load(std::memory_order_acquire);
+  if (POLARIS_UNLIKELY(shard == nullptr)) {
+    ApiStatShard* new_shard = new ApiStatShard(ret_code_count_);
+    if (shards_[shard_index].compare_exchange_strong(shard, new_shard, std::memory_order_acq_rel)) {
+      shard = new_shard;
+    } else {
+      delete new_shard;
     }
-    delete[] api_metrics_[i];
   }
-  delete[] api_metrics_;
+  return shard;
 }
 
 void ApiStatRegistry::Record(ApiStatKey stat_key, ReturnCode ret_code, uint64_t delay) {
@@ -98,7 +132,13 @@ void ApiStatRegistry::Record(ApiStatKey stat_key, ReturnCode ret_code, uint64_t
       delay_index = kDelayBucketCount - 1;
     }
   }
-  api_metrics_[stat_key][ret_code_index][delay_index].fetch_add(1, std::memory_order_relaxed);
+  GetShard()->metrics_[(stat_key * ret_code_count_ + ret_code_index) * kDelayBucketCount + delay_index].fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void ApiStatRegistry::RecordLatency(ApiStatKey stat_key, uint64_t delay_us) {
+  GetShard()->latency_[stat_key * kLatencyBucketCount + LatencyHistogram::BucketIndex(delay_us)].fetch_add(
+      1, std::memory_order_relaxed);
 }
 
 void ApiStatLog(google::protobuf::RepeatedField<v1::SDKAPIStatistics>& statistics) {
@@ -120,10 +160,22 @@ void ApiStatLog(google::protobuf::RepeatedField<v1::SDKAPIStatistics>& statistic
 
 void ApiStatRegistry::GetApiStatistics(google::protobuf::RepeatedField<v1::SDKAPIStatistics>& statistics) {
   const std::string& tontext_uid = context_->GetContextImpl()->GetSdkToken().uid();
+  std::vector<int> api_metrics(kApiStatKeyCount * ret_code_count_ * kDelayBucketCount, 0);
+  for (int shard_index = 0; shard_index < kApiStatShardCount; shard_index++) {
+    ApiStatShard* shard = shards_[shard_index].load(std::memory_order_acquire);
+    if (shard == nullptr) {
+      continue;
+    }
+    for (int i = 0; i < shard->metrics_count_; i++) {
+      if (shard->metrics_[i].load(std::memory_order_relaxed) != 0) {
+        api_metrics[i] += shard->metrics_[i].exchange(0, std::memory_order_relaxed);
+      }
+    }
+  }
   for (int i = 0; i < kApiStatKeyCount; i++) {
     for (int j = 0; j < ret_code_count_; j++) {
       for (int k = 0; k < kDelayBucketCount; k++) {
-        int count = api_metrics_[i][j][k].exchange(0, std::memory_order_relaxed);
+        int count = api_metrics[(i * ret_code_count_ + j) * kDelayBucketCount + k];
         if (count == 0) {
           continue;
         }
@@ -150,4 +202,38 @@ void ApiStatRegistry::GetApiStatistics(google::protobuf::RepeatedField<v1::SDKAP
   }
 }
 
+void ApiStatRegistry::GetApiLatency(std::vector<LatencyHistogram>& latency) {
+  latency.clear();
+  latency.resize(kApiStatKeyCount);
+  for (int shard_index = 0; shard_index < kApiStatShardCount; shard_index++) {
+    ApiStatShard* shard = shards_[shard_index].load(std::memory_order_acquire);
+    if (shard == nullptr) {
+      continue;
+    }
+    for (int i = 0; i < kApiStatKeyCount; i++) {
+      std::atomic<int>* buckets = shard->latency_ + i * kLatencyBucketCount;
+      for (int k = 0; k < kLatencyBucketCount; k++) {
+        if (buckets[k].load(std::memory_order_relaxed) != 0) {
+          latency[i].AddCount(k, buckets[k].exchange(0, std::memory_order_relaxed));
+        }
+      }
+    }
+  }
+}
+
+void ApiStatRegistry::LogApiLatency(const std::vector<LatencyHistogram>& latency) {
+  for (std::size_t i = 0; i < latency.size(); i++) {
+    const LatencyHistogram& histogram = latency[i];
+    if (histogram.TotalCount() == 0) {
+      continue;
+    }
+    POLARIS_STAT_LOG(LOG_INFO,
+                     "sdk api latency api:%s, sample count:%" PRIu64 ", p50:%" PRIu64 "us, p90:%" PRIu64 "us, p99:%" PRIu64
+                     "us, p999:%" PRIu64 "us",
+                     g_ApiStatKeyMap[i], histogram.TotalCount(), histogram.ValueAtPercentile(0.5),
+                     histogram.ValueAtPercentile(0.9), histogram.ValueAtPercentile(0.99),
+                     histogram.ValueAtPercentile(0.999));
+  }
+}
+
 }  // namespace polaris
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "api_stat.h"
+#include "monitor/latency_histogram.h"
 #include "polaris/defs.h"
 #include "v1/request.pb.h"
 
@@ -26,6 +27,9 @@ namespace polaris {
 
 class Context;
 struct ReturnCodeInfo;
+struct ApiStatShard;
+
+static const int kApiStatShardCount = 16;
 
 class ApiStatRegistry {
  public:
@@ -36,14 +40,28 @@ class ApiStatRegistry {
   // 记录API调用结果和延迟
   void Record(ApiStatKey stat_key, ReturnCode ret_code, uint64_t delay);
 
+  // 记录采样的API精确延迟，单位为微秒
+  void RecordLatency(ApiStatKey stat_key, uint64_t delay_us);
+
+  // 合并所有分片的调用统计并清零
   void GetApiStatistics(google::protobuf::RepeatedField<v1::SDKAPIStatistics>& statistics);
 
+  // 合并所有分片的各API延迟分布并清零，下标为ApiStatKey
+  void GetApiLatency(std::vector<LatencyHistogram>& latency);
+
+  // 输出各API的延迟分位值到统计日志
+  static void LogApiLatency(const std::vector<LatencyHistogram>& latency);
+
+ private:
+  ApiStatShard* GetShard();
+
  private:
   Context* context_;
   std::vector<ReturnCodeInfo*> ret_code_info_;
   int ret_code_count_;
   int success_code_index_;
-  std::atomic<int>*** api_metrics_;  // 三维数组，三个维度分别为：API key, ret_code索引, delay区间
+  // 按线程分片的统计数据，线程首次记录时创建对应分片，减少多线程记录时的缓存行竞争
+  std::atomic<ApiStatShard*> shards_[kApiStatShardCount];
 };
 
 }  // namespace polaris
@@ -0,0 +1,99 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_MONITOR_LATENCY_HISTOGRAM_H_
+#define POLARIS_CPP_POLARIS_MONITOR_LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+
+namespace polaris {
+
+/// @brief 对数线性分桶的延迟分布，用于计算延迟分位值
+///
+/// 小于2^(kSubBucketBits+1)的值每个值一个桶，更大的值每个2的幂区间平均分为2^kSubBucketBits个桶，
+/// 相对误差不超过1/2^kSubBucketBits。超过上限的值记入最后一个桶
+class LatencyHistogram {
+ public:
+  static const int kSubBucketBits = 4;
+  static const int kSubBucketCount = 1 << kSubBucketBits;
+  static const int kMaxValueBits = 27;  // 微秒单位时上限约134s
+  static const uint64_t kMaxValue = (1ULL << kMaxValueBits) - 1;
+  static const int kBucketCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount;
+
+  LatencyHistogram() : total_count_(0) {
+    for (int i = 0; i < kBucketCount; ++i) {
+      counts_[i] = 0;
+    }
+  }
+
+  /// @brief 计算值所在的桶下标
+  static int BucketIndex(uint64_t value) {
+    if (value > kMaxValue) {
+      value = kMaxValue;
+    }
+    if (value < 2 * kSubBucketCount) {
+      return static_cast<int>(value);
+    }
+    int shift = 63 - __builtin_clzll(value) - kSubBucketBits;
+    return (shift + 1) * kSubBucketCount + static_cast<int>((value >> shift) - kSubBucketCount);
+  }
+
+  /// @brief 桶内的最大值
+  static uint64_t BucketUpperBound(int index) {
+    if (index < 2 * kSubBucketCount) {
+      return index;
+    }
+    int shift = index / kSubBucketCount - 1;
+    uint64_t sub_bucket = index % kSubBucketCount + kSubBucketCount;
+    return ((sub_bucket + 1) << shift) - 1;
+  }
+
+  void Record(uint64_t value) { AddCount(BucketIndex(value), 1); }
+
+  void AddCount(int index, uint64_t count) {
+    counts_[index] += count;
+    total_count_ += count;
+  }
+
+  uint64_t TotalCount() const { return total_count_; }
+
+  /// @brief 计算分位值
+  ///
+  /// @param percentile 分位，取值(0, 1]，例如0.99
+  /// @return uint64_t 分位值所在桶的最大值，没有数据时返回0
+  uint64_t ValueAtPercentile(double percentile) const {
+    if (total_count_ == 0) {
+      return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(percentile * total_count_ + 0.5);
+    if (target == 0) {
+      target = 1;
+    }
+    uint64_t count = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+      count += counts_[i];
+      if (count >= target) {
+        return BucketUpperBound(i);
+      }
+    }
+    return kMaxValue;
+  }
+
+ private:
+  uint64_t total_count_;
+  uint64_t counts_[kBucketCount];
+};
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_MONITOR_LATENCY_HISTOGRAM_H_
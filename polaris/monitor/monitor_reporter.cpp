@@ -15,6 +15,7 @@
 
 #include <google/protobuf/timestamp.pb.h>
 #include <google/protobuf/wrappers.pb.h>
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <v1/code.pb.h>
@@ -347,6 +348,9 @@ void MonitorReporter::ReportSdkConfig(UnaryReport* unary_report) {
 void MonitorReporter::ReportSdkApiStat(StreamReport* stream_report) {
   MonitorReporter* reporter = stream_report->reporter_;
   ApiStatRegistry* api_stat_registry = reporter->context_->GetContextImpl()->GetApiStatRegistry();
+  std::vector<LatencyHistogram> latency;
+  api_stat_registry->GetApiLatency(latency);
+  ApiStatRegistry::LogApiLatency(latency);  // 延迟分布只输出到统计日志
   google::protobuf::RepeatedField<v1::SDKAPIStatistics> statistics;
   api_stat_registry->GetApiStatistics(statistics);
   if (statistics.empty()) {  // 这个周期没有数据
@@ -774,6 +778,15 @@ void MonitorReporter::ReportServiceRouterStat(StreamReport* stream_report) {
   std::map<std::string, uint32_t>::iterator result_it;
   for (std::size_t i = 0; i < all_service_contexts.size(); ++i) {
     all_service_contexts[i]->GetServiceRouterChain()->CollectStat(service_key, stat_data);
+    CacheRebuildStat rebuild_stat;
+    if (all_service_contexts[i]->CollectCacheRebuildStat(rebuild_stat)) {  // 缓存重建统计只输出到统计日志
+      POLARIS_STAT_LOG(LOG_INFO,
+                       "route cache rebuild service[%s/%s] count:%u, avg:%" PRIu64 "us, max:%" PRIu64
+                       "us, eager:%" PRIu64 ", lazy:%" PRIu64 ", max queue depth:%u",
+                       service_key.namespace_.c_str(), service_key.name_.c_str(), rebuild_stat.rebuild_count_,
+                       rebuild_stat.total_time_us_ / rebuild_stat.rebuild_count_, rebuild_stat.max_time_us_,
+                       rebuild_stat.eager_count_, rebuild_stat.lazy_count_, rebuild_stat.max_queue_depth_);
+    }
     if (stat_data.empty()) {
       continue;
     }
@@ -0,0 +1,101 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/instance_load.h"
+
+#include <math.h>
+
+#include "context/service_context.h"
+#include "model/instance.h"
+#include "model/model_impl.h"
+#include "plugin/plugin_manager.h"
+#include "polaris/model.h"
+#include "utils/time_clock.h"
+
+namespace polaris {
+
+// 耗时平均值的衰减时间常数，经过该时间后旧数据的权重衰减为1/e
+static const double kLatencyDecayTimeMs = 10000;
+
+static double LatencyDecay(uint64_t last_time, uint64_t now_ms) {
+  return now_ms > last_time ? exp(-static_cast<double>(now_ms - last_time) / kLatencyDecayTimeMs) : 1.0;
+}
+
+bool InstanceLoadTracker::IsLoadAware(const LoadBalanceType& load_balance_type) {
+  return load_balance_type == kLoadBalanceTypeBoundedLoadHash || load_balance_type == kLoadBalanceTypeP2CLeastRequest ||
+         load_balance_type == kLoadBalanceTypePeakEwma;
+}
+
+bool InstanceLoadTracker::IsLatencyAware(const LoadBalanceType& load_balance_type) {
+  return load_balance_type == kLoadBalanceTypePeakEwma;
+}
+
+void InstanceLoadTracker::Init() {
+  // 实例本地数据在新旧实例对象间共享，负载数据随之保留
+  PluginManager::Instance().RegisterInstancePreUpdateHandler(InstancesData::CopyLocalValues);
+}
+
+void InstanceLoadTracker::OnInstanceChosen(ServiceContext* service_context, LoadBalancer* load_balancer,
+                                           Instance* instance) {
+  if (service_context->IsLoadAware() && !IsLoadAware(load_balancer->GetLoadBalanceType())) {
+    AcquireInflight(instance);
+  }
+}
+
+void InstanceLoadTracker::AcquireInflight(Instance* instance) {
+  instance->GetImpl().GetLocalValue()->load_.inflight_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void InstanceLoadTracker::ReleaseInflight(Instance* instance) {
+  std::atomic<int>& inflight = instance->GetImpl().GetLocalValue()->load_.inflight_;
+  int current = inflight.load(std::memory_order_relaxed);
+  while (current > 0 && !inflight.compare_exchange_weak(current, current - 1, std::memory_order_relaxed)) {
+  }
+}
+
+int InstanceLoadTracker::GetInflight(Instance* instance) {
+  return instance->GetImpl().GetLocalValue()->load_.inflight_.load(std::memory_order_relaxed);
+}
+
+void InstanceLoadTracker::UpdateLatency(Instance* instance, uint64_t latency_us, uint64_t now_ms) {
+  InstanceLoad& load = instance->GetImpl().GetLocalValue()->load_;
+  double decay = LatencyDecay(load.latency_update_time_.exchange(now_ms, std::memory_order_relaxed), now_ms);
+  uint64_t current = load.latency_ewma_.load(std::memory_order_relaxed);
+  uint64_t updated;
+  do {
+    updated = latency_us >= current ? latency_us
+                                    : static_cast<uint64_t>(current * decay + latency_us * (1 - decay) + 0.5);
+  } while (!load.latency_ewma_.compare_exchange_weak(current, updated, std::memory_order_relaxed));
+}
+
+double InstanceLoadTracker::GetLatencyEwma(Instance* instance, uint64_t now_ms) {
+  InstanceLoad& load = instance->GetImpl().GetLocalValue()->load_;
+  return load.latency_ewma_.load(std::memory_order_relaxed) *
+         LatencyDecay(load.latency_update_time_.load(std::memory_order_relaxed), now_ms);
+}
+
+void InstanceLoadTracker::UpdateCallResult(ServiceContext* service_context, const InstanceGauge& gauge) {
+  ServiceData* service_data = service_context->GetInstances();
+  if (service_data == nullptr) {
+    return;
+  }
+  Instance* instance = service_data->GetServiceDataImpl()->GetInstancesData()->FindInstance(gauge.instance_id);
+  if (instance != nullptr) {
+    ReleaseInflight(instance);
+    if (service_context->IsLatencyAware()) {
+      UpdateLatency(instance, gauge.call_daley * 1000, Time::GetCoarseSteadyTimeMs());  // ms -> us
+    }
+  }
+}
+
+}  // namespace polaris
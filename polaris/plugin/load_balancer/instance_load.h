@@ -0,0 +1,71 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_INSTANCE_LOAD_H_
+#define POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_INSTANCE_LOAD_H_
+
+#include "polaris/defs.h"
+#include "polaris/plugin.h"
+
+namespace polaris {
+
+class Instance;
+class ServiceContext;
+
+/// @brief 跟踪实例的实时负载，供感知负载的负载均衡插件使用
+///
+/// 负载数据保存在实例本地数据中，服务实例更新后迁移到新的实例对象。负载均衡插件选出实例时增加进行中的请求数，
+/// 上报调用结果时减少。使用这类负载均衡时需要对选出的实例上报调用结果，否则实例会一直计为有进行中的请求。
+/// 调用结果中没有选出实例的负载均衡类型，因此服务使用过感知负载的负载均衡后，其他负载均衡选出的实例也计入
+/// 进行中的请求数，保证每次上报的调用结果都对应一次计数
+class InstanceLoadTracker {
+ public:
+  /// @brief 判断负载均衡类型是否需要根据调用结果更新实例负载
+  static bool IsLoadAware(const LoadBalanceType& load_balance_type);
+
+  /// @brief 判断负载均衡类型是否需要根据调用结果更新实例耗时平均值
+  static bool IsLatencyAware(const LoadBalanceType& load_balance_type);
+
+  /// @brief 注册服务实例更新处理函数，在新的实例对象中保留实例负载
+  static void Init();
+
+  /// @brief 选出实例后增加实例进行中的请求数
+  static void AcquireInflight(Instance* instance);
+
+  /// @brief 服务使用过感知负载的负载均衡时，为其他负载均衡选出的实例增加进行中的请求数
+  static void OnInstanceChosen(ServiceContext* service_context, LoadBalancer* load_balancer, Instance* instance);
+
+  /// @brief 减少实例进行中的请求数，不会减到0以下
+  static void ReleaseInflight(Instance* instance);
+
+  static int GetInflight(Instance* instance);
+
+  /// @brief 记录一次调用耗时，更新峰值指数加权平均
+  ///
+  /// 耗时高于当前平均值时直接取该耗时，使实例变慢后立即生效；否则按距离上次更新的时间衰减后合并
+  static void UpdateLatency(Instance* instance, uint64_t latency_us, uint64_t now_ms);
+
+  /// @brief 获取按当前时间衰减后的耗时平均值，单位微秒
+  ///
+  /// 长时间没有调用结果的实例耗时逐渐衰减到0，使其重新有机会被选中
+  static double GetLatencyEwma(Instance* instance, uint64_t now_ms);
+
+  /// @brief 根据上报的调用结果更新实例负载，通过实例数据上的ID哈希索引查找实例，实例已经不存在时忽略
+  ///
+  /// 只有服务使用过感知耗时的负载均衡时才更新耗时平均值，避免其他感知负载的负载均衡在每次上报时计算衰减
+  static void UpdateCallResult(ServiceContext* service_context, const InstanceGauge& gauge);
+};
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_INSTANCE_LOAD_H_
@@ -0,0 +1,82 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_LAST_SELECTOR_CACHE_H_
+#define POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_LAST_SELECTOR_CACHE_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "cache/service_cache.h"
+#include "polaris/defs.h"
+#include "polaris/model.h"
+#include "utils/string_utils.h"
+
+namespace polaris {
+
+/// @brief 各服务实例子集最近一次构建的选择器，实例变化后负载均衡插件基于它增量构建
+///
+/// 选择器同时由实例子集上的缓存持有。缓存清理时淘汰只被本对象持有的选择器，
+/// 服务及其实例子集的缓存过期释放后对应的选择器也随之释放
+template <typename SelectorType>
+class LastSelectorCache : public Clearable {
+ public:
+  LastSelectorCache() {}
+
+  virtual ~LastSelectorCache() {}
+
+  std::shared_ptr<SelectorType> Get(const ServiceKey& service_key, InstancesSet* instances_set) {
+    Key key(service_key, StringUtils::MapToStr(instances_set->GetSubset()));
+    std::lock_guard<std::mutex> lock_guard(lock_);
+    typename std::map<Key, std::shared_ptr<SelectorType> >::iterator it = selectors_.find(key);
+    return it != selectors_.end() ? it->second : std::shared_ptr<SelectorType>();
+  }
+
+  void Set(const ServiceKey& service_key, InstancesSet* instances_set, const std::shared_ptr<SelectorType>& selector) {
+    Key key(service_key, StringUtils::MapToStr(instances_set->GetSubset()));
+    std::lock_guard<std::mutex> lock_guard(lock_);
+    selectors_[key] = selector;
+  }
+
+  virtual void Clear(uint64_t /*min_access_time*/) {
+    std::lock_guard<std::mutex> lock_guard(lock_);
+    typename std::map<Key, std::shared_ptr<SelectorType> >::iterator it = selectors_.begin();
+    while (it != selectors_.end()) {
+      if (it->second.use_count() == 1) {  // 只能在锁内获取新的引用，引用计数为1时不会再增加
+        selectors_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  std::size_t Size() {
+    std::lock_guard<std::mutex> lock_guard(lock_);
+    return selectors_.size();
+  }
+
+ private:
+  typedef std::pair<ServiceKey, std::string> Key;  // 服务和实例子集
+
+  std::mutex lock_;
+  std::map<Key, std::shared_ptr<SelectorType> > selectors_;
+};
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_LAST_SELECTOR_CACHE_H_
@@ -0,0 +1,62 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/least_request.h"
+
+#include "plugin/load_balancer/instance_load.h"
+#include "polaris/model.h"
+#include "utils/fast_random.h"
+
+namespace polaris {
+
+LeastRequestLoadBalancer::LeastRequestLoadBalancer() {}
+
+LeastRequestLoadBalancer::~LeastRequestLoadBalancer() {}
+
+ReturnCode LeastRequestLoadBalancer::Init(Config* config, Context* context) {
+  InstanceLoadTracker::Init();
+  return RandomLoadBalancer::Init(config, context);
+}
+
+ReturnCode LeastRequestLoadBalancer::ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria,
+                                                    Instance*& next) {
+  RandomLbCacheValue* lb_value = GetCacheValue(service_instances);
+  next = nullptr;
+  if (!criteria.ignore_half_open_) {
+    service_instances->GetService()->TryChooseHalfOpenInstance(lb_value->half_open_instances_, next);
+    if (next != nullptr) {
+      InstanceLoadTracker::AcquireInflight(next);
+      return kReturnOk;
+    }
+  }
+
+  if (lb_value->sum_weight_ <= 0) {
+    return kReturnInstanceNotFound;
+  }
+
+  // 两次选择等概率随机，权重只在比较负载时计入，选中同一实例时直接使用
+  Instance* first = lb_value->SelectUniform(FastRandom::Next());
+  Instance* second = lb_value->SelectUniform(FastRandom::Next());
+  next = (first == second || LessLoaded(first, second)) ? first : second;
+  InstanceLoadTracker::AcquireInflight(next);
+  return kReturnOk;
+}
+
+bool LeastRequestLoadBalancer::LessLoaded(Instance* lhs, Instance* rhs) {
+  // 比较 (进行中请求数+1)/权重，交叉相乘避免除法
+  uint64_t lhs_load = static_cast<uint64_t>(InstanceLoadTracker::GetInflight(lhs) + 1) * GetInstanceWeight(rhs);
+  uint64_t rhs_load = static_cast<uint64_t>(InstanceLoadTracker::GetInflight(rhs) + 1) * GetInstanceWeight(lhs);
+  return lhs_load <= rhs_load;
+}
+
+}  // namespace polaris
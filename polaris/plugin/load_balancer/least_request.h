@@ -0,0 +1,49 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_LEAST_REQUEST_H_
+#define POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_LEAST_REQUEST_H_
+
+#include "plugin/load_balancer/weighted_random.h"
+
+namespace polaris {
+
+/// @brief 两次随机选择的最少请求负载均衡
+///
+/// 从权重大于0的实例中等概率随机选出两个实例，选择其中 (进行中请求数+1)/权重 较小的实例。
+/// 权重只在比较时计入一次，请求都不结束时各实例进行中的请求数与权重成比例
+/// 进行中请求数保存在实例本地数据中，选出实例时增加，上报调用结果时减少，选择过程无锁
+class LeastRequestLoadBalancer : public RandomLoadBalancer {
+ public:
+  LeastRequestLoadBalancer();
+
+  virtual ~LeastRequestLoadBalancer();
+
+  virtual ReturnCode Init(Config* config, Context* context);
+
+  virtual LoadBalanceType GetLoadBalanceType() { return kLoadBalanceTypeP2CLeastRequest; }
+
+  virtual ReturnCode ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria, Instance*& next);
+
+ protected:
+  /// @brief 比较两个随机选出的实例，返回第一个实例的负载是否更低
+  virtual bool LessLoaded(Instance* lhs, Instance* rhs);
+
+  uint32_t GetInstanceWeight(Instance* instance) const {
+    return enable_dynamic_weight_ ? instance->GetDynamicWeight() : instance->GetWeight();
+  }
+};
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_LEAST_REQUEST_H_
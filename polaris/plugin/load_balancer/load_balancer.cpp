@@ -0,0 +1,55 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/load_balancer.h"
+
+#include <set>
+#include <vector>
+
+#include "polaris/model.h"
+#include "polaris/plugin.h"
+#include "utils/fast_random.h"
+
+namespace polaris {
+
+void ChooseInstancesFromRandomOffset(const std::vector<Instance*>& instances,
+                                     const std::set<Instance*>& half_open_instances, uint32_t instance_num,
+                                     std::vector<Instance*>& selected) {
+  if (instances.empty()) {
+    return;
+  }
+  std::size_t target_num = selected.size() + instance_num;
+  std::size_t index = FastRandom::Next() % instances.size();
+  for (std::size_t i = 0; i < instances.size() && selected.size() < target_num; ++i, ++index) {
+    if (index == instances.size()) {
+      index = 0;  // 回到起点
+    }
+    if (half_open_instances.count(instances[index]) == 0) {
+      AppendDistinctInstance(selected, instances[index]);
+    }
+  }
+}
+
+ReturnCode LoadBalancer::ChooseInstances(ServiceInstances* service_instances, const Criteria& /*criteria*/,
+                                         uint32_t instance_num, std::vector<Instance*>& selected) {
+  const std::vector<Instance*>& instances = service_instances->GetAvailableInstances()->GetInstances();
+  if (instances.empty()) {
+    return kReturnOk;
+  }
+  std::set<Instance*> half_open_instances;
+  service_instances->GetHalfOpenInstances(half_open_instances);
+  ChooseInstancesFromRandomOffset(instances, half_open_instances, instance_num, selected);
+  return kReturnOk;
+}
+
+}  // namespace polaris
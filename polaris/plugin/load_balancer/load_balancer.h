@@ -0,0 +1,45 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_LOAD_BALANCER_H_
+#define POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_LOAD_BALANCER_H_
+
+#include <set>
+#include <vector>
+
+#include "polaris/instance.h"
+
+namespace polaris {
+
+/// @brief 实例不在已选择的实例中时追加到末尾，使用实例本地ID判断是否重复
+///
+/// @return bool 是否追加了实例
+inline bool AppendDistinctInstance(std::vector<Instance*>& selected, Instance* instance) {
+  uint64_t local_id = instance->GetLocalId();
+  for (std::size_t i = 0; i < selected.size(); ++i) {
+    if (selected[i]->GetLocalId() == local_id) {
+      return false;
+    }
+  }
+  selected.push_back(instance);
+  return true;
+}
+
+/// @brief 从随机位置开始顺序选择非半开实例追加到已选择的实例中，不考虑权重
+void ChooseInstancesFromRandomOffset(const std::vector<Instance*>& instances,
+                                     const std::set<Instance*>& half_open_instances, uint32_t instance_num,
+                                     std::vector<Instance*>& selected);
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_LOAD_BALANCER_H_
@@ -24,24 +24,35 @@ namespace polaris {
 
 static const int64_t kDefaultMinWeight = 1000;         // 节点默认的最小权值
 static const int64_t kDefaultDescribeInterval = 1000;  // 默认的LA状态输出间隔（写日志中） ms
-static const int kRouteKeySize = 20;                   // ROUTE_KEY位数，不能大于24位
-static const int kBeginTimeSize = 64 - kRouteKeySize;  // BEGIN_TIME_MS位数
-// 17,592,186,044,416 (44位无符号最大值)
-//    315,360,000,000 (程序启动10年时间值，以ms计)
-static const uint64_t kMaxBeginTimeMs = std::numeric_limits<uint64_t>::max() >> kRouteKeySize;
-static const uint64_t kMaxRouteKey = std::numeric_limits<uint64_t>::max() >> kBeginTimeSize;
-
-uint64_t LocalityAwareLoadBalancer::CalculateLocalityAwareInfo(uint32_t route_key, uint64_t begin_time_ms) {
-  // 要确保传入参数的范围是正确的
-  return (static_cast<uint64_t>(route_key) << kBeginTimeSize) + begin_time_ms;
+// locality_aware_info 从高位到低位依次为 ROUTE_KEY、实例下标、BEGIN_TIME_MS的低位
+static const int kRouteKeySize = 20;                                       // ROUTE_KEY位数，不能大于24位
+static const int kInstanceIndexSize = 16;                                  // 实例下标位数
+static const int kBeginTimeSize = 64 - kRouteKeySize - kInstanceIndexSize;  // BEGIN_TIME_MS位数
+// 268,435,456 (28位无符号最大值，以ms计约74小时)，Feedback时根据当前时间还原完整的开始时间
+static const uint64_t kMaxBeginTimeMs = std::numeric_limits<uint64_t>::max() >> (64 - kBeginTimeSize);
+static const uint64_t kMaxInstanceIndex = std::numeric_limits<uint64_t>::max() >> (64 - kInstanceIndexSize);
+static const uint64_t kMaxRouteKey = std::numeric_limits<uint64_t>::max() >> (64 - kRouteKeySize);
+
+uint64_t LocalityAwareLoadBalancer::CalculateLocalityAwareInfo(uint32_t route_key, std::size_t index,
+                                                               uint64_t begin_time_ms) {
+  // 下标超过上限时填写上限值，Feedback时按实例ID查找
+  uint64_t index_value = index < kMaxInstanceIndex ? index : kMaxInstanceIndex;
+  return (static_cast<uint64_t>(route_key) << (kBeginTimeSize + kInstanceIndexSize)) +
+         (index_value << kBeginTimeSize) + (begin_time_ms & kMaxBeginTimeMs);
 }
 
 uint32_t LocalityAwareLoadBalancer::GetRouteKey(uint64_t locality_aware_info) {
-  return static_cast<uint32_t>(locality_aware_info >> kBeginTimeSize);  // key在高位
+  return static_cast<uint32_t>(locality_aware_info >> (kBeginTimeSize + kInstanceIndexSize));  // key在高位
 }
 
-uint64_t LocalityAwareLoadBalancer::GetBeginTimeMs(uint64_t locality_aware_info) {
-  return locality_aware_info & kMaxBeginTimeMs;  // time在低位, 将高位的key置零
+std::size_t LocalityAwareLoadBalancer::GetInstanceIndex(uint64_t locality_aware_info) {
+  uint64_t index_value = (locality_aware_info >> kBeginTimeSize) & kMaxInstanceIndex;
+  return index_value < kMaxInstanceIndex ? static_cast<std::size_t>(index_value) : kInvalidInstanceIndex;
+}
+
+uint64_t LocalityAwareLoadBalancer::GetBeginTimeMs(uint64_t locality_aware_info, uint64_t now_time_ms) {
+  // time在低位只保存了低28位，调用时长不会超过其表示范围，取不晚于当前时间的最近一个匹配值
+  return now_time_ms - ((now_time_ms - (locality_aware_info & kMaxBeginTimeMs)) & kMaxBeginTimeMs);
 }
 
 ReturnCode LocalityAwareLoadBalancer::ChooseInstance(ServiceInstances *service_instances, const Criteria &criteria,
@@ -61,8 +72,10 @@ ReturnCode LocalityAwareLoadBalancer::ChooseInstance(ServiceInstances *service_i
         int weight = item->GetWeight();
         // 判断是不是半开实例，不向locality_aware_selector中添加半开实例
         if (new_lb_value->half_open_instances_.find(item) == new_lb_value->half_open_instances_.end()) {
-          new_lb_value->locality_aware_selector_.AddInstance(item->GetId());  // 向selector中注册实例
-          new_lb_value->instance_map_[item->GetId()] = item;                  // id到instance的映射
+          if (new_lb_value->locality_aware_selector_.AddInstance(item->GetId())) {  // 向selector中注册实例
+            new_lb_value->selector_instances_.push_back(item);  // selector中的下标到instance的映射
+          }
+          new_lb_value->instance_map_[item->GetId()] = item;  // id到instance的映射
         } else {
           weight = 1;  // 半开实例
         }
@@ -116,10 +129,6 @@ ReturnCode LocalityAwareLoadBalancer::ChooseInstance(ServiceInstances *service_i
   // SelectInstance时计数并统计时间，Feedback时清除
   uint64_t now_time_us = Time::GetSteadyTimeUs();
   uint64_t begin_time_ms = (now_time_us - system_begin_time_) / 1000;
-  if (begin_time_ms > kMaxBeginTimeMs) {
-    // 时间超过上限
-    POLARIS_LOG(LOG_ERROR, "locality aware begin_time_ms overflow : %ld", begin_time_ms);
-  }
   in.begin_time_us = begin_time_ms * 1000 + system_begin_time_;
   in.changable_weights = true;
   ReturnCode ret = lb_value->locality_aware_selector_.SelectInstance(in, &out);
@@ -147,9 +156,16 @@ ReturnCode LocalityAwareLoadBalancer::ChooseInstance(ServiceInstances *service_i
     return kReturnOk;
   }
 
-  Instance *selected_instance = lb_value->instance_map_[out.instance_id];
+  // 选择器只在创建时添加实例，下标与selector_instances_一一对应
+  Instance *selected_instance = nullptr;
+  if (out.index < lb_value->selector_instances_.size()) {
+    selected_instance = lb_value->selector_instances_[out.index];
+  }
+  if (selected_instance == nullptr || selected_instance->GetId() != out.instance_id) {
+    selected_instance = lb_value->instance_map_[out.instance_id];
+  }
   // 将LA需要传递给Feedback的信息写Instance中
-  uint64_t locality_aware_info = CalculateLocalityAwareInfo(lb_value->route_key_, begin_time_ms);
+  uint64_t locality_aware_info = CalculateLocalityAwareInfo(lb_value->route_key_, out.index, begin_time_ms);
   if (locality_aware_info > 0) {
     next = selected_instance->GetImpl().DumpWithLocalityAwareInfo(locality_aware_info);
   } else {
@@ -188,7 +204,8 @@ ReturnCode LocalityAwareLoadBalancer::Init(Config *config, Context *context) {
 ReturnCode LocalityAwareLoadBalancer::Feedback(const FeedbackInfo &info) {
   // 将la的key和time取出
   uint32_t route_key = GetRouteKey(info.locality_aware_info);
-  uint64_t begin_time_us = GetBeginTimeMs(info.locality_aware_info) * 1000 + system_begin_time_;
+  uint64_t now_time_ms = (Time::GetSteadyTimeUs() - system_begin_time_) / 1000;
+  uint64_t begin_time_us = GetBeginTimeMs(info.locality_aware_info, now_time_ms) * 1000 + system_begin_time_;
   // 读取lb_value成功,调用la的Feedback
   LocalityAwareLBCacheValue *lb_value = rout_key_data_cache_->GetWithRcuTime(route_key);
   if (lb_value == nullptr) {  // 读取lb_value失败
@@ -198,6 +215,7 @@ ReturnCode LocalityAwareLoadBalancer::Feedback(const FeedbackInfo &info) {
   call_info.call_daley = info.call_daley;
   call_info.begin_time_us = begin_time_us;
   call_info.instance_id = info.instance_id;
+  call_info.index = GetInstanceIndex(info.locality_aware_info);
   lb_value->locality_aware_selector_.Feedback(call_info);
 
   return kReturnOk;
@@ -40,6 +40,7 @@ struct FeedbackInfo {
 struct LocalityAwareLbCacheKey {
   InstancesSet *prior_data_;
   bool operator<(const LocalityAwareLbCacheKey &rhs) const { return this->prior_data_ < rhs.prior_data_; }
+  bool operator==(const LocalityAwareLbCacheKey &rhs) const { return this->prior_data_ == rhs.prior_data_; }
 };
 
 class LocalityAwareLBCacheValue : public ServiceBase {
@@ -56,6 +57,7 @@ class LocalityAwareLBCacheValue : public ServiceBase {
       prior_date_ = nullptr;
     }
     route_key_ = 0;
+    selector_instances_.clear();
     instance_map_.clear();
     sum_weight_ = 0;
     weight_instances_.clear();
@@ -73,6 +75,7 @@ class LocalityAwareLBCacheValue : public ServiceBase {
   std::set<Instance *> half_open_instances_;
   uint32_t route_key_;
   LocalityAwareSelector locality_aware_selector_;
+  std::vector<Instance *> selector_instances_;  // 按实例在selector中的下标存放
   std::map<InstanceId, Instance *> instance_map_;
   int sum_weight_;
   std::vector<WeightInstance> weight_instances_;
@@ -88,9 +91,10 @@ class LocalityAwareLoadBalancer : public LoadBalancer {
   ReturnCode Feedback(const FeedbackInfo &info);
 
  private:
-  uint64_t CalculateLocalityAwareInfo(uint32_t route_key, uint64_t begin_time_ms);
+  uint64_t CalculateLocalityAwareInfo(uint32_t route_key, std::size_t index, uint64_t begin_time_ms);
   uint32_t GetRouteKey(uint64_t locality_aware_info);
-  uint64_t GetBeginTimeMs(uint64_t locality_aware_info);
+  std::size_t GetInstanceIndex(uint64_t locality_aware_info);
+  uint64_t GetBeginTimeMs(uint64_t locality_aware_info, uint64_t now_time_ms);
 
  private:
   Context *context_;
@@ -105,4 +109,15 @@ class LocalityAwareLoadBalancer : public LoadBalancer {
 
 }  // namespace polaris
 
+namespace std {
+
+template <>
+struct hash<polaris::LocalityAwareLbCacheKey> {
+  std::size_t operator()(const polaris::LocalityAwareLbCacheKey &key) const {
+    return hash<polaris::InstancesSet *>()(key.prior_data_);
+  }
+};
+
+}  // namespace std
+
 #endif  // POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_LOCALITY_AWARE_LOCALITY_AWARE_H_
\ No newline at end of file
@@ -234,6 +234,7 @@ ReturnCode LocalityAwareSelector::SelectInstance(const SelectIn &in, SelectOut *
       }
     } else {
       out->instance_id = info.instance_id;
+      out->index = index;
       if (!in.changable_weights) {
         return kReturnOk;
       }
@@ -267,12 +268,16 @@ void LocalityAwareSelector::Feedback(const CallInfo &info) {
   if (db_instances_.Read(&s) != 0) {
     return;
   }
-  std::map<polaris::InstanceId, size_t>::const_iterator iter = s->instance_map.find(info.instance_id);
-  if (iter == s->instance_map.end()) {
-    // 实例不存在
-    return;
+  size_t index = info.index;
+  if (index >= s->weight_tree.size() || s->weight_tree[index].instance_id != info.instance_id) {
+    // 没有携带下标，或者选择后有实例被删除导致下标变化，按实例ID查找
+    std::map<polaris::InstanceId, size_t>::const_iterator iter = s->instance_map.find(info.instance_id);
+    if (iter == s->instance_map.end()) {
+      // 实例不存在
+      return;
+    }
+    index = iter->second;
   }
-  const size_t index = iter->second;
   Weight *w = s->weight_tree[index].weight;
   const int64_t diff = w->Update(info, index);  // 更新实例权重
   if (diff != 0) {
@@ -282,53 +287,69 @@ void LocalityAwareSelector::Feedback(const CallInfo &info) {
 }
 
 int64_t LocalityAwareSelector::Weight::Update(const CallInfo &ci, size_t index) {
-  // 实例节点的锁，这把锁放获取end_time_us的后面，end_time_us会更准
-  // 放前面，可以防止获取end_time_us后，其他线程往time_q_里加数据
-  const std::lock_guard<std::mutex> lock(mutex_);
-
-  // 这个end_time不是业务报进来的，但影响不大，用来快速计算QPS
-  const int64_t end_time_us = Time::GetSteadyTimeUs();
-  const int64_t latency = ci.call_daley;
-
   if (Disabled()) {
     // 该节点即将被删除，不对其进行Update
     return 0;
   }
   // 用于跟踪未返回调用的耗时，时间太长时进行处罚
-  begin_time_sum_ -= ci.begin_time_us;
+  // 先减计数再减时间和，与AddInflight中的顺序相反
   --begin_time_count_;
+  begin_time_sum_ -= ci.begin_time_us;
 
+  const int64_t latency = ci.call_daley;
   if (latency <= 0) {
     // 错误的延时
     return 0;
   }
+  pending_latency_sum_ += latency;
+  pending_count_.fetch_add(1, std::memory_order_release);
+
+  // 实例节点的锁，其他线程正在更新时不等待，本次调用由持有锁的线程或下一次反馈合入time_q_
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (!lock.owns_lock() || Disabled()) {
+    return 0;
+  }
+  const int64_t count = pending_count_.exchange(0, std::memory_order_acquire);
+  if (count == 0) {
+    // 已经被其他线程合入
+    return 0;
+  }
+  // 延时和次数不是一起取出的，可能多取到其他线程刚加入的延时，下一次合入时会多取到对应的次数，不影响窗口内的平均值
+  const int64_t latency_sum = pending_latency_sum_.exchange(0, std::memory_order_relaxed);
+
+  // 这个end_time不是业务报进来的，但影响不大，用来快速计算QPS
+  const int64_t end_time_us = Time::GetSteadyTimeUs();
 
   // Add a new entry
   TimeInfo tm_info;
-  tm_info.latency_sum = latency;
+  tm_info.latency_sum = latency_sum;
+  tm_info.count_sum = count;
   tm_info.end_time_us = end_time_us;
   if (!time_q_.Empty()) {
     tm_info.latency_sum += time_q_.Bottom()->latency_sum;
+    tm_info.count_sum += time_q_.Bottom()->count_sum;
   }
   time_q_.ElimPush(tm_info);
 
-  const int64_t top_time_us = time_q_.Top()->end_time_us;
+  const TimeInfo *top = time_q_.Top();
   const size_t n = time_q_.Size();
   int64_t scaled_qps = kDefaultQPS * kWeightScale;
-  if (end_time_us > top_time_us) {
+  if (end_time_us > top->end_time_us) {
+    const int64_t count_diff = tm_info.count_sum - top->count_sum;
     // Only calculate scaled_qps when the queue is full or the elapse
     // between bottom and top is reasonably large(so that error of the
     // calculated QPS is probably smaller).
-    if (n == time_q_.Capacity() || end_time_us >= top_time_us + 1000000L /*1s*/) {
-      // will not overflow.
-      scaled_qps = (n - 1) * 1000000L * kWeightScale / (end_time_us - top_time_us);
+    if (n == time_q_.Capacity() || end_time_us >= top->end_time_us + 1000000L /*1s*/) {
+      // 一个节点可能合入了多次调用，使用浮点数计算避免溢出
+      scaled_qps = static_cast<int64_t>(static_cast<double>(count_diff) * 1000000L * kWeightScale /
+                                        (end_time_us - top->end_time_us));
       if (scaled_qps < kWeightScale) {
         scaled_qps = kWeightScale;
       }
     }
-    avg_latency_ = (time_q_.Bottom()->latency_sum - time_q_.Top()->latency_sum) / (n - 1);
+    avg_latency_ = (tm_info.latency_sum - top->latency_sum) / count_diff;
   } else if (n == 1) {
-    avg_latency_ = time_q_.Bottom()->latency_sum;
+    avg_latency_ = tm_info.latency_sum / tm_info.count_sum;
   } else {
     // end_time_us <= top_time_us && n > 1: the QPS is so high that
     // the time elapse between top and bottom is 0(possible in examples),
@@ -346,8 +367,8 @@ void LocalityAwareSelector::Destroy() { delete this; }
 
 void LocalityAwareSelector::Weight::Describe(std::ostream &os, int64_t now) {
   mutex_.lock();
-  int64_t begin_time_sum = begin_time_sum_;
   int begin_time_count = begin_time_count_;
+  int64_t begin_time_sum = begin_time_sum_;
   int64_t weight = weight_;
   int64_t base_weight = base_weight_;
   size_t n = time_q_.Size();
@@ -356,10 +377,12 @@ void LocalityAwareSelector::Weight::Describe(std::ostream &os, int64_t now) {
   if (n <= 1UL) {
     qps = 0;
   } else {
+    // 队列未满时包含了所有调用，队列满时去掉top节点
+    int64_t count = time_q_.Bottom()->count_sum;
     if (n == time_q_.Capacity()) {
-      --n;
+      count -= time_q_.Top()->count_sum;
     }
-    qps = n * 1000000 / static_cast<double>(now - time_q_.Top()->end_time_us);
+    qps = count * 1000000 / static_cast<double>(now - time_q_.Top()->end_time_us);
   }
   mutex_.unlock();
 
@@ -377,8 +400,8 @@ void LocalityAwareSelector::Weight::Describe(std::ostream &os, int64_t now) {
 
 void LocalityAwareSelector::Weight::Describe(std::string &str, int64_t now) {
   mutex_.lock();
-  int64_t begin_time_sum = begin_time_sum_;
   int begin_time_count = begin_time_count_;
+  int64_t begin_time_sum = begin_time_sum_;
   int64_t weight = weight_;
   int64_t base_weight = base_weight_;
   size_t n = time_q_.Size();
@@ -387,11 +410,13 @@ void LocalityAwareSelector::Weight::Describe(std::string &str, int64_t now) {
   if (n <= 1UL) {
     qps = 0;
   } else {
+    // 队列未满时包含了所有调用，队列满时去掉top节点
+    int64_t count = time_q_.Bottom()->count_sum;
     if (n == time_q_.Capacity()) {
-      --n;
+      count -= time_q_.Top()->count_sum;
     }
     if (now - time_q_.Top()->end_time_us > 0) {  // 此时已上锁，time_q_不会再加数据
-      qps = n * 1000000 / static_cast<double>(now - time_q_.Top()->end_time_us);
+      qps = count * 1000000 / static_cast<double>(now - time_q_.Top()->end_time_us);
     } else {
       qps = -1;
     }
@@ -476,6 +501,8 @@ LocalityAwareSelector::Weight::Weight(int64_t initial_weight, int64_t min_weight
       min_weight_(min_weight),
       begin_time_sum_(0),
       begin_time_count_(0),
+      pending_latency_sum_(0),
+      pending_count_(0),
       old_diff_sum_(0),
       old_index_((size_t)-1L),
       old_weight_(0),
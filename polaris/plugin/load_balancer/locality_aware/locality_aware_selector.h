@@ -33,6 +33,9 @@ namespace polaris {
 
 static const double kPunishInflightRatio = 1.5;
 
+// 未知的实例下标，Feedback时需要按实例ID查找
+static const size_t kInvalidInstanceIndex = static_cast<size_t>(-1);
+
 typedef std::string InstanceId;
 
 struct SelectIn {
@@ -45,15 +48,18 @@ struct SelectIn {
 };
 
 struct SelectOut {
-  SelectOut() : need_feedback(false) {}
+  SelectOut() : need_feedback(false), index(kInvalidInstanceIndex) {}
   bool need_feedback;  // 配合SelectIn中changable_weights的字段，保留
   InstanceId instance_id;
+  size_t index;  // 实例在选择器中的下标，传给Feedback可以免去按实例ID查找
 };
 
 struct CallInfo {
+  CallInfo() : call_daley(0), begin_time_us(0), index(kInvalidInstanceIndex) {}
   uint64_t call_daley;     // 调用的延时，由业务提供
   uint64_t begin_time_us;  // 和SelectIn中begin_time_us严格一致
   InstanceId instance_id;
+  size_t index;  // SelectOut中的实例下标，实例被删除导致下标失效时按实例ID查找
 };
 
 class LocalityAwareSelector {
@@ -71,6 +77,7 @@ class LocalityAwareSelector {
  private:
   struct TimeInfo {
     int64_t latency_sum;  // microseconds
+    int64_t count_sum;    // 累计的调用次数，一个节点可能合入了多次调用
     int64_t end_time_us;
   };
 
@@ -88,7 +95,7 @@ class LocalityAwareSelector {
     int64_t Update(const CallInfo &, size_t index);
 
     // 返回_weight
-    int64_t GetWeight() const { return weight_; }
+    int64_t GetWeight() const { return weight_.load(std::memory_order_relaxed); }
 
     struct AddInflightResult {
       bool chosen;
@@ -101,19 +108,23 @@ class LocalityAwareSelector {
     void Describe(std::string &str, int64_t now);
 
     int64_t Disable();
-    bool Disabled() const { return base_weight_ < 0; }
+    bool Disabled() const { return base_weight_.load(std::memory_order_relaxed) < 0; }
     int64_t MarkOld(size_t index);
     std::pair<int64_t, int64_t> ClearOld();
 
     int64_t ResetWeight(size_t index, int64_t now_us);
 
    private:
-    int64_t weight_;       // 实际生效的weight,受min_weight等规则约束
-    int64_t base_weight_;  // 根据数学模型直接计算到的weight
-    int64_t min_weight_;   // 最小权重，可在yaml配置，默认1000
+    // 选择和反馈路径上不等待锁：未返回调用的计数直接原子更新，
+    // 其他线程持有锁时，调用延时先累加到待合入的计数中，由持有锁的线程或下一次反馈合入time_q_
+    std::atomic<int64_t> weight_;       // 实际生效的weight,受min_weight等规则约束
+    std::atomic<int64_t> base_weight_;  // 根据数学模型直接计算到的weight
+    int64_t min_weight_;                // 最小权重，可在yaml配置，默认1000
     std::mutex mutex_;
-    int64_t begin_time_sum_;
-    int begin_time_count_;
+    std::atomic<int64_t> begin_time_sum_;
+    std::atomic<int> begin_time_count_;
+    std::atomic<int64_t> pending_latency_sum_;  // 待合入time_q_的调用延时
+    std::atomic<int64_t> pending_count_;        // 待合入time_q_的调用次数
     int64_t old_diff_sum_;
     size_t old_index_;
     int64_t old_weight_;
@@ -169,8 +180,10 @@ inline void LocalityAwareSelector::Instances::UpdateParentWeights(int64_t diff,
 
 inline int64_t LocalityAwareSelector::Weight::ResetWeight(size_t index, int64_t now_us) {
   int64_t new_weight = base_weight_;
-  if (begin_time_count_ > 0) {
-    const int64_t inflight_delay = now_us - begin_time_sum_ / begin_time_count_;
+  // 计数和时间和分别原子更新，读到的中间状态只会暂时低估未返回调用的耗时
+  const int begin_time_count = begin_time_count_.load(std::memory_order_relaxed);
+  if (begin_time_count > 0) {
+    const int64_t inflight_delay = now_us - begin_time_sum_.load(std::memory_order_relaxed) / begin_time_count;
     const int64_t punish_latency = (int64_t)(avg_latency_ * kPunishInflightRatio);
     if (inflight_delay >= punish_latency && avg_latency_ > 0) {
       new_weight = new_weight * punish_latency / inflight_delay;
@@ -179,8 +192,8 @@ inline int64_t LocalityAwareSelector::Weight::ResetWeight(size_t index, int64_t
   if (new_weight < min_weight_) {
     new_weight = min_weight_;
   }
-  const int64_t old_weight = weight_;
-  weight_ = new_weight;
+  const int64_t old_weight = weight_.load(std::memory_order_relaxed);
+  weight_.store(new_weight, std::memory_order_relaxed);
   const int64_t diff = new_weight - old_weight;
   if (old_index_ == index && diff != 0) {
     old_diff_sum_ += diff;
@@ -191,26 +204,28 @@ inline int64_t LocalityAwareSelector::Weight::ResetWeight(size_t index, int64_t
 inline LocalityAwareSelector::Weight::AddInflightResult LocalityAwareSelector::Weight::AddInflight(const SelectIn &in,
                                                                                                    size_t index,
                                                                                                    int64_t dice) {
-  const std::lock_guard<std::mutex> lock(mutex_);
+  AddInflightResult r;
+  r.chosen = false;
+  r.weight_diff = 0;
   if (Disabled()) {
-    AddInflightResult r;
-    r.chosen = false;
-    r.weight_diff = 0;
     return r;
   }
-  const int64_t diff = ResetWeight(index, in.begin_time_us);
-  if (weight_ < dice) {
+  // 其他线程正在更新权重时不等待，直接使用当前权重判断
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (lock.owns_lock()) {
+    if (Disabled()) {
+      return r;
+    }
+    r.weight_diff = ResetWeight(index, in.begin_time_us);
+  }
+  if (GetWeight() < dice) {
     // inflight delay makes the weight too small to choose.
-    AddInflightResult r;
-    r.chosen = false;
-    r.weight_diff = diff;
     return r;
   }
+  // 先加时间和再加计数，与Update中的顺序相反
   begin_time_sum_ += in.begin_time_us;
   ++begin_time_count_;
-  AddInflightResult r;
   r.chosen = true;
-  r.weight_diff = diff;
   return r;
 }
 
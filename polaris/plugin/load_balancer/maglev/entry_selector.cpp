@@ -17,7 +17,10 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
 #include <memory>
+#include <unordered_map>
+#include <utility>
 
 #include "logger.h"
 #include "polaris/model.h"
@@ -28,7 +31,8 @@ MaglevEntrySelector::MaglevEntrySelector() : hash_func_(nullptr), table_size_(65
 
 MaglevEntrySelector::~MaglevEntrySelector() {}
 
-bool MaglevEntrySelector::Setup(InstancesSet* instance_set, uint32_t table_size, Hash64Func hash_func) {
+bool MaglevEntrySelector::Setup(InstancesSet* instance_set, uint32_t table_size, Hash64Func hash_func,
+                                bool incremental_rebuild) {
   if (nullptr == instance_set || nullptr == hash_func || 0 == table_size) {
     POLARIS_LOG(LOG_ERROR, "Invalid parameters. instance_set/hashFunc is nullptr, or tableSize is zero");
     return false;
@@ -69,17 +73,23 @@ bool MaglevEntrySelector::Setup(InstancesSet* instance_set, uint32_t table_size,
       slot.target_weight += max_weight;  // next target weigth
       uint32_t idx = 0;
       do {
-        idx = Permutation(slot);
-        ++slot.next;
+        idx = NextPosition(slot);
       } while (entry[idx] != INVALID);
 
-      entry[idx] = slot.index;
-      ++slot.next;
+      entry[idx] = i;
+      NextPosition(slot);  // 选中后跳过排列中的下一个位置
       ++slot.count;
       ++fill_count;
     }
   }
   entry.swap(entries_);
+  instance_ids_.clear();
+  if (incremental_rebuild) {  // 不使用增量构建时不需要复制实例ID
+    instance_ids_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      instance_ids_[i] = instances[i]->GetId();
+    }
+  }
 
   uint32_t min_entries = table_size_;
   uint32_t max_entries = 0;
@@ -92,12 +102,106 @@ bool MaglevEntrySelector::Setup(InstancesSet* instance_set, uint32_t table_size,
   return true;
 }
 
+bool MaglevEntrySelector::IncrementalSetup(const MaglevEntrySelector& previous, InstancesSet* instance_set) {
+  if (nullptr == instance_set || previous.entries_.empty() || previous.instance_ids_.empty()) {
+    return false;
+  }
+  const std::vector<Instance*>& instances = instance_set->GetInstances();
+  size_t count = instances.size();
+  uint64_t total_weight = InstancesSetImpl::CalcTotalWeight(instances);
+  if (0 == count || count > previous.table_size_ || 0 == total_weight) {
+    return false;
+  }
+  table_size_ = previous.table_size_;
+  hash_func_ = previous.hash_func_;
+  constexpr uint32_t INVALID = static_cast<uint32_t>(-1);
+
+  // 计算上一次的实例下标到本次下标的映射
+  std::unordered_map<std::string, uint32_t> id_to_index;
+  id_to_index.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    id_to_index[instances[i]->GetId()] = i;
+  }
+  std::vector<uint32_t> index_mapping(previous.instance_ids_.size(), INVALID);
+  size_t reused_count = 0;
+  for (size_t i = 0; i < previous.instance_ids_.size(); ++i) {
+    std::unordered_map<std::string, uint32_t>::iterator it = id_to_index.find(previous.instance_ids_[i]);
+    if (it != id_to_index.end()) {
+      index_mapping[i] = it->second;
+      reused_count++;
+    }
+  }
+  if (reused_count * 2 < std::max(count, previous.instance_ids_.size())) {  // 变化的实例过多时全量构建
+    return false;
+  }
+
+  // 保留仍然存在的实例在配额内的表项
+  std::vector<uint32_t> quotas(count);
+  CalcEntryQuotas(instances, total_weight, quotas);
+  std::vector<uint32_t> entry(table_size_, INVALID);
+  std::vector<Slot> slots;
+  GenerateOffsetAndSkips(instances, slots);
+  uint32_t free_count = 0;
+  for (uint32_t i = 0; i < table_size_; ++i) {
+    uint32_t index = index_mapping[previous.entries_[i]];
+    if (index != INVALID && slots[index].count < quotas[index]) {
+      entry[i] = index;
+      ++slots[index].count;
+    } else {
+      ++free_count;
+    }
+  }
+  // 未达到配额的实例轮流按各自的排列占用空闲表项
+  while (free_count > 0) {
+    for (size_t i = 0; i < count && free_count > 0; ++i) {
+      Slot& slot = slots[i];
+      if (slot.count >= quotas[i]) {
+        continue;
+      }
+      uint32_t idx = 0;
+      do {
+        idx = NextPosition(slot);
+      } while (entry[idx] != INVALID);
+      entry[idx] = i;
+      ++slot.count;
+      --free_count;
+    }
+  }
+  entry.swap(entries_);
+  instance_ids_.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    instance_ids_[i] = instances[i]->GetId();
+  }
+  POLARIS_LOG(LOG_DEBUG, "maglev| incremental build entries of %zu slots, reuse %zu slots", count, reused_count);
+  return true;
+}
+
+void MaglevEntrySelector::CalcEntryQuotas(const std::vector<Instance*>& instances, uint64_t total_weight,
+                                          std::vector<uint32_t>& quotas) const {
+  std::vector<std::pair<uint64_t, size_t> > remainders(instances.size());
+  uint64_t assigned = 0;
+  for (size_t i = 0; i < instances.size(); ++i) {
+    uint64_t share = static_cast<uint64_t>(instances[i]->GetWeight()) * table_size_;
+    quotas[i] = static_cast<uint32_t>(share / total_weight);
+    remainders[i] = std::make_pair(total_weight - share % total_weight, i);  // 余数大的排在前面
+    assigned += quotas[i];
+  }
+  std::sort(remainders.begin(), remainders.end());
+  for (size_t i = 0; assigned < table_size_; ++i, ++assigned) {
+    ++quotas[remainders[i].second];
+  }
+}
+
 int MaglevEntrySelector::Select(const Criteria& criteria) {
   if (0 == table_size_) {
     return -1;
   } else if (1 == table_size_) {
     return 0;
   }
+  return entries_[CalculateHashValue(criteria) % table_size_];
+}
+
+uint64_t MaglevEntrySelector::CalculateHashValue(const Criteria& criteria) const {
   uint64_t hash_value;
   if (criteria.hash_string_.empty()) {
     if (POLARIS_UNLIKELY(0 == criteria.hash_key_)) {
@@ -112,7 +216,7 @@ int MaglevEntrySelector::Select(const Criteria& criteria) {
     const std::string& hash_key = criteria.hash_string_;
     hash_value = hash_func_(static_cast<const void*>(hash_key.c_str()), hash_key.size(), 0);
   }
-  return entries_[hash_value % table_size_];
+  return hash_value;
 }
 
 double MaglevEntrySelector::GenerateOffsetAndSkips(const std::vector<Instance*>& instances, std::vector<Slot>& slots) {
@@ -134,8 +238,7 @@ double MaglevEntrySelector::GenerateOffsetAndSkips(const std::vector<Instance*>&
     uint32_t len = strlen(buff);
     uint64_t seed0 = hash_func_(buff, len, 1);
     uint64_t seed1 = hash_func_(buff, len, 2);
-    slot.index = i;
-    slot.offset = seed0 % table_size_;
+    slot.position = seed0 % table_size_;
     slot.skip = seed1 % (table_size_ - 1) + 1;
     slots.push_back(slot);
   }
@@ -15,6 +15,7 @@
 #define POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_MAGLEV_ENTRY_SELECTOR_H_
 
 #include <stdint.h>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -26,15 +27,13 @@ namespace polaris {
 
 // 中间建表的的数据
 struct Slot {
-  uint64_t offset;
-  uint64_t skip;
-  uint32_t index;
+  uint32_t position;  // 实例排列中的下一个位置，初始为offset，每次前进skip
+  uint32_t skip;
   uint32_t count;
   double normalized_weight;
   double target_weight;
-  uint64_t next;
 
-  Slot() : offset(0), skip(0), index(0), count(0), normalized_weight(0.0), target_weight(0.0), next(0) {}
+  Slot() : position(0), skip(0), count(0), normalized_weight(0.0), target_weight(0.0) {}
 };
 
 class MaglevEntrySelector : public Selector {
@@ -48,21 +47,53 @@ class MaglevEntrySelector : public Selector {
   /// @param instance_set: nodes to build lookup table
   /// @param table_size: lookup table size, MUST be PRIME and GREATER than size of instance_set
   /// @param hash_func: hash function to use
+  /// @param incremental_rebuild: 是否记录各下标对应的实例ID，用于之后基于本次的查找表增量构建
   ///
   /// @return bool: true - succ, false - false
-  bool Setup(InstancesSet* instance_set, uint32_t table_size, Hash64Func hash_func);
+  bool Setup(InstancesSet* instance_set, uint32_t table_size, Hash64Func hash_func, bool incremental_rebuild);
+
+  /// @desc 基于上一次构建的查找表增量构建
+  ///
+  /// 仍然存在的实例保留原有表项，只重新分配下线实例的表项和超出权重配额的表项，变化的表项数接近理论最小值。
+  /// 结果依赖于上一次的查找表，与全量构建的结果不同，多个客户端需要得到相同映射时不能使用
+  ///
+  /// @param previous: 上一次构建的查找表
+  /// @param instance_set: nodes to build lookup table
+  ///
+  /// @return bool: true - succ, false - 上一次的查找表不可用或实例变化过多，需要全量构建
+  bool IncrementalSetup(const MaglevEntrySelector& previous, InstancesSet* instance_set);
 
   virtual int Select(const Criteria& criteria);
 
+  const std::vector<uint32_t>& GetEntries() const { return entries_; }
+
+  std::set<Instance*>& GetHalfOpenInstances() { return half_open_instances_; }
+
  private:
+  uint64_t CalculateHashValue(const Criteria& criteria) const;
+
   double GenerateOffsetAndSkips(const std::vector<Instance*>& instances, std::vector<Slot>& slots);
 
-  uint32_t Permutation(const Slot& slot) { return (slot.offset + slot.skip * slot.next) % table_size_; }
+  // 按权重计算每个实例的表项配额，余数按最大余数法分配，配额总和等于表大小
+  void CalcEntryQuotas(const std::vector<Instance*>& instances, uint64_t total_weight,
+                       std::vector<uint32_t>& quotas) const;
+
+  // 返回排列中的当前位置并前进一步，用加法和比较代替乘法和取模
+  uint32_t NextPosition(Slot& slot) const {
+    uint32_t position = slot.position;
+    slot.position += slot.skip;
+    if (slot.position >= table_size_) {
+      slot.position -= table_size_;
+    }
+    return position;
+  }
 
  private:
   Hash64Func hash_func_;
-  std::vector<uint32_t> entries_;  // lookup table
-  uint32_t table_size_;            // lookup table size
+  std::vector<uint32_t> entries_;            // lookup table
+  uint32_t table_size_;                      // lookup table size
+  std::vector<std::string> instance_ids_;    // 各下标对应的实例ID，用于增量构建
+  std::set<Instance*> half_open_instances_;  // 构建时的半开实例，用于选择备份实例
 };
 
 }  // namespace polaris
@@ -21,8 +21,10 @@
 #include <string>
 #include <vector>
 
+#include "context/context_impl.h"
 #include "logger.h"
 #include "model/model_impl.h"
+#include "plugin/load_balancer/load_balancer.h"
 #include "plugin/load_balancer/maglev/entry_selector.h"
 #include "polaris/config.h"
 #include "polaris/model.h"
@@ -32,16 +34,26 @@ namespace polaris {
 
 class Context;
 
-MaglevLoadBalancer::MaglevLoadBalancer() : context_(nullptr), hash_func_(nullptr), table_size_(0) {}
+MaglevLoadBalancer::MaglevLoadBalancer()
+    : context_(nullptr), hash_func_(nullptr), table_size_(0), incremental_rebuild_(false), last_selectors_(nullptr) {}
 
-MaglevLoadBalancer::~MaglevLoadBalancer() { context_ = nullptr; }
+MaglevLoadBalancer::~MaglevLoadBalancer() {
+  if (last_selectors_ != nullptr) {
+    last_selectors_->SetClearHandler(0);
+    last_selectors_->DecrementRef();
+  }
+  context_ = nullptr;
+}
 
 ReturnCode MaglevLoadBalancer::Init(Config* config, Context* context) {
   static const uint32_t kDefaultTableSize = 65537;  // smallM, bigM=655373, must be prime
   static const char kLookupTableSize[] = "tableSize";
   static const char kHashFunction[] = "hashFunc";
   static const char kHashFunctionDefault[] = "murmur3";
+  static const char kIncrementalRebuildKey[] = "incrementalRebuild";
+  static const bool kIncrementalRebuildDefault = false;
   table_size_ = config->GetIntOrDefault(kLookupTableSize, kDefaultTableSize);
+  incremental_rebuild_ = config->GetBoolOrDefault(kIncrementalRebuildKey, kIncrementalRebuildDefault);
   if (!Utils::IsPrime(table_size_)) {
     POLARIS_LOG(LOG_ERROR, "Invalid parameters. tableSize MUST be PRIME and greater than size of instance set");
     return kReturnInvalidConfig;
@@ -52,6 +64,10 @@ ReturnCode MaglevLoadBalancer::Init(Config* config, Context* context) {
     return code;
   }
   context_ = context;
+  if (incremental_rebuild_) {
+    last_selectors_ = new LastSelectorCache<MaglevEntrySelector>();
+    context_->GetContextImpl()->RegisterCache(last_selectors_);
+  }
   return kReturnOk;
 }
 
@@ -59,6 +75,34 @@ ReturnCode MaglevLoadBalancer::ChooseInstance(ServiceInstances* service_instance
                                               Instance*& next) {
   next = nullptr;
   InstancesSet* instances_set = service_instances->GetAvailableInstances();
+  MaglevEntrySelector* selector = GetSelector(service_instances, instances_set);
+  if (selector == nullptr) {
+    return kReturnInvalidConfig;
+  }
+
+  int index = selector->Select(criteria);
+  if (-1 != index) {
+    const std::vector<Instance*>& instances = instances_set->GetInstances();
+    next = instances[index];
+    return kReturnOk;
+  }
+  return kReturnInstanceNotFound;
+}
+
+ReturnCode MaglevLoadBalancer::ChooseInstances(ServiceInstances* service_instances, const Criteria& /*criteria*/,
+                                               uint32_t instance_num, std::vector<Instance*>& selected) {
+  InstancesSet* instances_set = service_instances->GetAvailableInstances();
+  MaglevEntrySelector* selector = GetSelector(service_instances, instances_set);
+  if (selector == nullptr) {
+    return kReturnInvalidConfig;
+  }
+  ChooseInstancesFromRandomOffset(instances_set->GetInstances(), selector->GetHalfOpenInstances(), instance_num,
+                                  selected);
+  return kReturnOk;
+}
+
+MaglevEntrySelector* MaglevLoadBalancer::GetSelector(ServiceInstances* service_instances,
+                                                     InstancesSet* instances_set) {
   POLARIS_ASSERT(instances_set != nullptr);
   Selector* instances_selector = instances_set->GetSelector();
   MaglevEntrySelector* selector = nullptr;
@@ -72,22 +116,32 @@ ReturnCode MaglevLoadBalancer::ChooseInstance(ServiceInstances* service_instance
     if (instances_selector != nullptr) {
       selector = dynamic_cast<MaglevEntrySelector*>(instances_selector);
     } else {
-      selector = new MaglevEntrySelector();
-      if (!selector->Setup(instances_set, table_size_, hash_func_)) {
-        delete selector;
-        return kReturnInvalidConfig;
+      std::shared_ptr<MaglevEntrySelector> new_selector(new MaglevEntrySelector());
+      if (!SetupSelector(service_instances, instances_set, new_selector)) {
+        return nullptr;
       }
-      instances_set->SetSelector(selector);
+      service_instances->GetHalfOpenInstances(new_selector->GetHalfOpenInstances());
+      instances_set->GetImpl()->SetSelector(new_selector);
+      selector = new_selector.get();
     }
   }
+  return selector;
+}
 
-  int index = selector->Select(criteria);
-  if (-1 != index) {
-    const std::vector<Instance*>& instances = instances_set->GetInstances();
-    next = instances[index];
-    return kReturnOk;
+bool MaglevLoadBalancer::SetupSelector(ServiceInstances* service_instances, InstancesSet* instances_set,
+                                       const std::shared_ptr<MaglevEntrySelector>& selector) {
+  if (!incremental_rebuild_) {
+    return selector->Setup(instances_set, table_size_, hash_func_, false);
   }
-  return kReturnInstanceNotFound;
+  const ServiceKey& service_key = service_instances->GetService()->GetServiceKey();
+  std::shared_ptr<MaglevEntrySelector> last_selector = last_selectors_->Get(service_key, instances_set);
+  if (last_selector == nullptr || !selector->IncrementalSetup(*last_selector, instances_set)) {
+    if (!selector->Setup(instances_set, table_size_, hash_func_, true)) {
+      return false;
+    }
+  }
+  last_selectors_->Set(service_key, instances_set, selector);
+  return true;
 }
 
-}  // namespace polaris
\ No newline at end of file
+}  // namespace polaris
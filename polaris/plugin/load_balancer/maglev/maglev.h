@@ -16,7 +16,11 @@
 
 #include <stdint.h>
 
+#include <memory>
+#include <vector>
+
 #include "plugin/load_balancer/hash/hash_manager.h"
+#include "plugin/load_balancer/last_selector_cache.h"
 #include "polaris/defs.h"
 #include "polaris/plugin.h"
 
@@ -25,6 +29,8 @@ namespace polaris {
 class Config;
 class Context;
 class Instance;
+class InstancesSet;
+class MaglevEntrySelector;
 class ServiceInstances;
 
 class MaglevLoadBalancer : public LoadBalancer {
@@ -39,10 +45,23 @@ class MaglevLoadBalancer : public LoadBalancer {
 
   virtual ReturnCode ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria, Instance*& next);
 
+  // 与默认实现一样从随机位置选择备份实例，使用查找表构建时记录的半开实例集合
+  virtual ReturnCode ChooseInstances(ServiceInstances* service_instances, const Criteria& criteria,
+                                     uint32_t instance_num, std::vector<Instance*>& selected);
+
+ private:
+  // 获取实例集合上的查找表，不存在时构建，构建失败时返回nullptr
+  MaglevEntrySelector* GetSelector(ServiceInstances* service_instances, InstancesSet* instances_set);
+
+  bool SetupSelector(ServiceInstances* service_instances, InstancesSet* instances_set,
+                     const std::shared_ptr<MaglevEntrySelector>& selector);
+
  private:
   Context* context_;
   Hash64Func hash_func_;
   uint32_t table_size_;
+  bool incremental_rebuild_;  // 实例变化时基于上一次的查找表增量构建
+  LastSelectorCache<MaglevEntrySelector>* last_selectors_;  // 各实例子集最近一次构建的查找表
 };  // class MaglevLoadBalancer
 
 }  // namespace polaris
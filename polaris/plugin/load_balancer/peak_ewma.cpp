@@ -0,0 +1,43 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/peak_ewma.h"
+
+#include "plugin/load_balancer/instance_load.h"
+#include "polaris/model.h"
+#include "utils/time_clock.h"
+
+namespace polaris {
+
+// 还没有耗时数据的实例有进行中的请求时，认为其耗时很大，避免请求全部涌向新实例
+static const double kNoLatencyPenalty = 1e12;
+
+PeakEwmaLoadBalancer::PeakEwmaLoadBalancer() {}
+
+PeakEwmaLoadBalancer::~PeakEwmaLoadBalancer() {}
+
+bool PeakEwmaLoadBalancer::LessLoaded(Instance* lhs, Instance* rhs) {
+  uint64_t now_ms = Time::GetCoarseSteadyTimeMs();
+  return GetCost(lhs, now_ms) * GetInstanceWeight(rhs) <= GetCost(rhs, now_ms) * GetInstanceWeight(lhs);
+}
+
+double PeakEwmaLoadBalancer::GetCost(Instance* instance, uint64_t now_ms) {
+  int inflight = InstanceLoadTracker::GetInflight(instance);
+  double latency = InstanceLoadTracker::GetLatencyEwma(instance, now_ms);
+  if (latency <= 0) {
+    return inflight == 0 ? 0 : kNoLatencyPenalty + inflight;
+  }
+  return latency * (inflight + 1);
+}
+
+}  // namespace polaris
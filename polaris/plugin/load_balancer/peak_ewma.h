@@ -0,0 +1,43 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_PEAK_EWMA_H_
+#define POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_PEAK_EWMA_H_
+
+#include "plugin/load_balancer/least_request.h"
+
+namespace polaris {
+
+/// @brief 感知调用耗时的负载均衡
+///
+/// 从权重大于0的实例中等概率随机选出两个实例，选择其中 耗时峰值加权平均×(进行中请求数+1)/权重 较小的实例。
+/// 权重只在比较代价时计入一次。
+/// 耗时平均值根据上报的调用耗时无锁更新，耗时升高立即生效，降低则按时间衰减，变慢的实例比熔断更早被减少流量
+class PeakEwmaLoadBalancer : public LeastRequestLoadBalancer {
+ public:
+  PeakEwmaLoadBalancer();
+
+  virtual ~PeakEwmaLoadBalancer();
+
+  virtual LoadBalanceType GetLoadBalanceType() { return kLoadBalanceTypePeakEwma; }
+
+ protected:
+  virtual bool LessLoaded(Instance* lhs, Instance* rhs);
+
+ private:
+  static double GetCost(Instance* instance, uint64_t now_ms);
+};
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_PEAK_EWMA_H_
@@ -0,0 +1,310 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/rendezvous/rendezvous.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "context/context_impl.h"
+#include "model/model_impl.h"
+#include "plugin/load_balancer/load_balancer.h"
+#include "polaris/config.h"
+#include "polaris/context.h"
+#include "polaris/model.h"
+#include "utils/fast_random.h"
+
+namespace polaris {
+
+// murmur3 的32位最终混合函数，输入的每一位都会影响输出的每一位
+static inline uint32_t Fmix32(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+#if defined(__AVX2__)
+static inline __m256i Fmix32x8(__m256i h) {
+  h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+  h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int32_t>(0x85ebca6b)));
+  h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+  h = _mm256_mullo_epi32(h, _mm256_set1_epi32(static_cast<int32_t>(0xc2b2ae35)));
+  return _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+}
+#endif
+
+// 返回 [begin, end) 中得分最大的位置，得分相同时取位置靠前的，向量化与标量实现结果相同
+static uint32_t MaxScoreIndex(const uint32_t* seeds, uint32_t begin, uint32_t end, uint32_t key,
+                              uint32_t& max_score) {
+  uint32_t max_index = begin;
+  max_score = Fmix32(seeds[begin] ^ key);
+  uint32_t i = begin + 1;
+#if defined(__AVX2__)
+  if (end - begin >= 16) {
+    // 每个通道记录该通道的最大得分及其位置，无符号比较通过翻转符号位转为有符号比较
+    const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+    const __m256i key_vec = _mm256_set1_epi32(static_cast<int32_t>(key));
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256i index = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(begin)),
+                                     _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i best_index = index;
+    __m256i seed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(seeds + begin));
+    __m256i best = _mm256_xor_si256(Fmix32x8(_mm256_xor_si256(seed, key_vec)), sign);
+    for (i = begin + 8; i + 8 <= end; i += 8) {
+      index = _mm256_add_epi32(index, step);
+      seed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(seeds + i));
+      __m256i score = _mm256_xor_si256(Fmix32x8(_mm256_xor_si256(seed, key_vec)), sign);
+      __m256i greater = _mm256_cmpgt_epi32(score, best);
+      best = _mm256_blendv_epi8(best, score, greater);
+      best_index = _mm256_blendv_epi8(best_index, index, greater);
+    }
+    uint32_t lane_scores[8];
+    uint32_t lane_indexes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lane_scores), _mm256_xor_si256(best, sign));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lane_indexes), best_index);
+    max_score = lane_scores[0];
+    max_index = lane_indexes[0];
+    for (int lane = 1; lane < 8; ++lane) {
+      if (lane_scores[lane] > max_score || (lane_scores[lane] == max_score && lane_indexes[lane] < max_index)) {
+        max_score = lane_scores[lane];
+        max_index = lane_indexes[lane];
+      }
+    }
+  }
+#endif
+  for (; i < end; ++i) {
+    uint32_t score = Fmix32(seeds[i] ^ key);
+    if (score > max_score) {
+      max_score = score;
+      max_index = i;
+    }
+  }
+  return max_index;
+}
+
+void RendezvousSelector::Setup(const std::vector<Instance*>& instances, const std::set<Instance*>& excluded,
+                               bool dynamic_weight) {
+  struct SeedInstance {
+    uint32_t weight_;
+    uint32_t seed_;
+    Instance* instance_;
+  };
+  std::vector<SeedInstance> seed_instances;
+  seed_instances.reserve(instances.size());
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    Instance* instance = instances[i];
+    uint32_t weight = dynamic_weight ? instance->GetDynamicWeight() : instance->GetWeight();
+    if (weight > 0 && excluded.count(instance) == 0) {
+      uint64_t hash = instance->GetHash();
+      seed_instances.push_back({weight, static_cast<uint32_t>(hash ^ (hash >> 32)), instance});
+    }
+  }
+  // 排列顺序只取决于实例本身，保证不同客户端对相同key选出相同实例
+  std::sort(seed_instances.begin(), seed_instances.end(), [](const SeedInstance& lhs, const SeedInstance& rhs) {
+    if (lhs.weight_ != rhs.weight_) {
+      return lhs.weight_ > rhs.weight_;
+    }
+    if (lhs.seed_ != rhs.seed_) {
+      return lhs.seed_ < rhs.seed_;
+    }
+    return lhs.instance_->GetId() < rhs.instance_->GetId();
+  });
+  seeds_.resize(seed_instances.size());
+  instances_.resize(seed_instances.size());
+  groups_.clear();
+  for (std::size_t i = 0; i < seed_instances.size(); ++i) {
+    seeds_[i] = seed_instances[i].seed_;
+    instances_[i] = seed_instances[i].instance_;
+    if (groups_.empty() || groups_.back().weight_ != seed_instances[i].weight_) {
+      WeightGroup group = {static_cast<uint32_t>(i), static_cast<uint32_t>(i), seed_instances[i].weight_ * 1.0};
+      groups_.push_back(group);
+    }
+    groups_.back().end_ = static_cast<uint32_t>(i + 1);
+  }
+}
+
+uint32_t RendezvousSelector::MixKey(uint64_t hash_value) {
+  return Fmix32(static_cast<uint32_t>(hash_value ^ (hash_value >> 32)));
+}
+
+double RendezvousSelector::WeightedScore(uint32_t score, const WeightGroup& group) const {
+  // 得分映射到(0, 1]后取对数，除以权重后越大越优先
+  return log((score + 1.0) / 4294967296.0) / group.weight_;
+}
+
+Instance* RendezvousSelector::Select(uint64_t hash_value) const {
+  if (instances_.empty()) {
+    return nullptr;
+  }
+  uint32_t key = MixKey(hash_value);
+  uint32_t max_score = 0;
+  uint32_t max_index = MaxScoreIndex(seeds_.data(), groups_[0].begin_, groups_[0].end_, key, max_score);
+  if (groups_.size() == 1) {  // 权重相同时不需要计算对数
+    return instances_[max_index];
+  }
+  double max_weighted_score = WeightedScore(max_score, groups_[0]);
+  for (std::size_t i = 1; i < groups_.size(); ++i) {
+    uint32_t score = 0;
+    uint32_t index = MaxScoreIndex(seeds_.data(), groups_[i].begin_, groups_[i].end_, key, score);
+    double weighted_score = WeightedScore(score, groups_[i]);
+    if (weighted_score > max_weighted_score) {
+      max_weighted_score = weighted_score;
+      max_index = index;
+    }
+  }
+  return instances_[max_index];
+}
+
+Instance* RendezvousSelector::SelectReplicate(uint64_t hash_value, int replicate_index) const {
+  if (instances_.empty()) {
+    return nullptr;
+  }
+  std::size_t rank = static_cast<std::size_t>(replicate_index) % instances_.size();
+  if (rank == 0) {
+    return Select(hash_value);
+  }
+  uint32_t key = MixKey(hash_value);
+  std::vector<std::pair<double, uint32_t> > scores;
+  scores.reserve(instances_.size());
+  for (std::size_t i = 0; i < groups_.size(); ++i) {
+    for (uint32_t j = groups_[i].begin_; j < groups_[i].end_; ++j) {
+      scores.push_back(std::make_pair(WeightedScore(Fmix32(seeds_[j] ^ key), groups_[i]), j));
+    }
+  }
+  std::nth_element(scores.begin(), scores.begin() + rank, scores.end(),
+                   [](const std::pair<double, uint32_t>& lhs, const std::pair<double, uint32_t>& rhs) {
+                     return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+                   });
+  return instances_[scores[rank].second];
+}
+
+void RendezvousSelector::SelectTop(uint64_t hash_value, uint32_t instance_num,
+                                   std::vector<Instance*>& selected) const {
+  std::size_t target_size = selected.size() + instance_num;
+  if (instances_.empty() || instance_num == 0) {
+    return;
+  }
+  uint32_t key = MixKey(hash_value);
+  std::vector<std::pair<double, uint32_t> > scores;
+  scores.reserve(instances_.size());
+  for (std::size_t i = 0; i < groups_.size(); ++i) {
+    for (uint32_t j = groups_[i].begin_; j < groups_[i].end_; ++j) {
+      scores.push_back(std::make_pair(WeightedScore(Fmix32(seeds_[j] ^ key), groups_[i]), j));
+    }
+  }
+  // 已选实例可能在前几名中，多排序这些位置以保证能选够
+  std::size_t top = std::min(scores.size(), static_cast<std::size_t>(instance_num) + selected.size() + 1);
+  std::partial_sort(scores.begin(), scores.begin() + top, scores.end(),
+                    [](const std::pair<double, uint32_t>& lhs, const std::pair<double, uint32_t>& rhs) {
+                      return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+                    });
+  for (std::size_t i = 0; i < top && selected.size() < target_size; ++i) {
+    AppendDistinctInstance(selected, instances_[scores[i].second]);
+  }
+}
+
+RendezvousHashLoadBalancer::RendezvousHashLoadBalancer() : hash_func_(nullptr), data_cache_(nullptr) {}
+
+RendezvousHashLoadBalancer::~RendezvousHashLoadBalancer() {
+  if (data_cache_ != nullptr) {
+    data_cache_->SetClearHandler(0);
+    data_cache_->DecrementRef();
+  }
+}
+
+ReturnCode RendezvousHashLoadBalancer::Init(Config* config, Context* context) {
+  static const char kHashFunction[] = "hashFunc";
+  static const char kHashFunctionDefault[] = "murmur3";
+  std::string hash_func = config->GetStringOrDefault(kHashFunction, kHashFunctionDefault);
+  ReturnCode code = HashManager::Instance().GetHashFunction(hash_func, hash_func_);
+  if (code != kReturnOk) {
+    return code;
+  }
+  data_cache_ = new ServiceCache<RendezvousCacheKey, RendezvousCacheValue>();
+  context->GetContextImpl()->RegisterCache(data_cache_);
+  return kReturnOk;
+}
+
+RendezvousCacheValue* RendezvousHashLoadBalancer::GetCacheValue(ServiceInstances* service_instances) {
+  InstancesSet* instances_set = service_instances->GetAvailableInstances();
+  RendezvousCacheKey cache_key = {instances_set, service_instances->GetDynamicWeightVersion()};
+  RendezvousCacheValue* lb_value = data_cache_->GetWithRcuTime(cache_key);
+  if (lb_value == nullptr) {
+    lb_value = data_cache_->CreateOrGet(cache_key, [&] {
+      RendezvousCacheValue* new_lb_value = new RendezvousCacheValue();
+      new_lb_value->prior_date_ = instances_set;
+      new_lb_value->prior_date_->IncrementRef();
+      service_instances->GetHalfOpenInstances(new_lb_value->half_open_instances_);
+      const std::vector<Instance*>& instances = instances_set->GetInstances();
+      bool dynamic_weight = service_instances->GetDynamicWeightVersion() > 0;
+      new_lb_value->selector_.Setup(instances, new_lb_value->half_open_instances_, dynamic_weight);
+      if (new_lb_value->selector_.Empty()) {  // 没有正常实例，则使用半开实例
+        std::set<Instance*> empty_half_open;
+        new_lb_value->selector_.Setup(instances, empty_half_open, dynamic_weight);
+      }
+      return new_lb_value;
+    });
+  }
+  return lb_value;
+}
+
+ReturnCode RendezvousHashLoadBalancer::ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria,
+                                                      Instance*& next) {
+  RendezvousCacheValue* lb_value = GetCacheValue(service_instances);
+  next = nullptr;
+  if (!criteria.ignore_half_open_ && criteria.replicate_index_ == 0) {
+    service_instances->GetService()->TryChooseHalfOpenInstance(lb_value->half_open_instances_, next);
+    if (next != nullptr) {
+      return kReturnOk;
+    }
+  }
+  uint64_t hash_value = CalculateHashValue(criteria);
+  next = criteria.replicate_index_ <= 0 ? lb_value->selector_.Select(hash_value)
+                                        : lb_value->selector_.SelectReplicate(hash_value, criteria.replicate_index_);
+  return next != nullptr ? kReturnOk : kReturnInstanceNotFound;
+}
+
+ReturnCode RendezvousHashLoadBalancer::ChooseInstances(ServiceInstances* service_instances, const Criteria& criteria,
+                                                       uint32_t instance_num, std::vector<Instance*>& selected) {
+  RendezvousCacheValue* lb_value = GetCacheValue(service_instances);
+  if (lb_value->selector_.Empty()) {
+    return kReturnInstanceNotFound;
+  }
+  lb_value->selector_.SelectTop(CalculateHashValue(criteria), instance_num, selected);
+  return kReturnOk;
+}
+
+uint64_t RendezvousHashLoadBalancer::CalculateHashValue(const Criteria& criteria) const {
+  if (!criteria.hash_string_.empty()) {
+    const std::string& hash_key = criteria.hash_string_;
+    return hash_func_(static_cast<const void*>(hash_key.c_str()), hash_key.size(), 0);
+  }
+  if (criteria.hash_key_ != 0) {
+    return hash_func_(static_cast<const void*>(&criteria.hash_key_), sizeof(uint64_t), 0);
+  }
+  return FastRandom::Next();  // 没有传入key时随机选择
+}
+
+}  // namespace polaris
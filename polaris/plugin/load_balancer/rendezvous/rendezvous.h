@@ -0,0 +1,141 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_RENDEZVOUS_RENDEZVOUS_H_
+#define POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_RENDEZVOUS_RENDEZVOUS_H_
+
+#include <stdint.h>
+
+#include <set>
+#include <vector>
+
+#include "cache/service_cache.h"
+#include "plugin/load_balancer/hash/hash_manager.h"
+#include "polaris/defs.h"
+#include "polaris/plugin.h"
+
+namespace polaris {
+
+/// @brief 加权最高随机权重(HRW)哈希选择器
+///
+/// 每个实例与key计算一个32位得分 u = fmix32(key ^ seed)，选择 ln(u)/weight 最大的实例，实例被选中的概率与权重成正比。
+/// 实例按权重分组，组内按种子排序后连续存放，组内比较得分只需要整数运算，可向量化；只有组间比较需要计算对数。
+/// 不需要哈希环，实例上下线只影响原来映射到该实例的key
+class RendezvousSelector {
+ public:
+  /// @brief 构建选择器
+  ///
+  /// @param instances 参与选择的实例
+  /// @param excluded 不参与选择的实例，例如半开实例
+  /// @param dynamic_weight 是否使用动态权重
+  void Setup(const std::vector<Instance*>& instances, const std::set<Instance*>& excluded, bool dynamic_weight);
+
+  bool Empty() const { return instances_.empty(); }
+
+  std::size_t Size() const { return instances_.size(); }
+
+  /// @brief 选择得分最高的实例
+  Instance* Select(uint64_t hash_value) const;
+
+  /// @brief 选择得分第 replicate_index+1 高的实例，副本索引超过实例数时取模
+  Instance* SelectReplicate(uint64_t hash_value, int replicate_index) const;
+
+  /// @brief 按得分从高到低追加不在已选列表中的实例，最多追加 instance_num 个
+  void SelectTop(uint64_t hash_value, uint32_t instance_num, std::vector<Instance*>& selected) const;
+
+ private:
+  struct WeightGroup {
+    uint32_t begin_;
+    uint32_t end_;
+    double weight_;
+  };
+
+  static uint32_t MixKey(uint64_t hash_value);
+
+  double WeightedScore(uint32_t score, const WeightGroup& group) const;
+
+ private:
+  std::vector<uint32_t> seeds_;      // 实例种子，由实例ID的哈希值折叠得到
+  std::vector<Instance*> instances_;  // 与种子一一对应
+  std::vector<WeightGroup> groups_;   // 按权重从大到小排列
+};
+
+struct RendezvousCacheKey {
+  InstancesSet* prior_data_;
+  uint64_t version_;
+
+  bool operator<(const RendezvousCacheKey& rhs) const {
+    return this->prior_data_ < rhs.prior_data_ ||
+           (this->prior_data_ == rhs.prior_data_ && this->version_ < rhs.version_);
+  }
+
+  bool operator==(const RendezvousCacheKey& rhs) const {
+    return this->prior_data_ == rhs.prior_data_ && this->version_ == rhs.version_;
+  }
+};
+
+class RendezvousCacheValue : public ServiceBase {
+ public:
+  RendezvousCacheValue() : prior_date_(nullptr) {}
+
+  virtual ~RendezvousCacheValue() {
+    prior_date_->DecrementRef();
+    prior_date_ = nullptr;
+  }
+
+ public:
+  InstancesSet* prior_date_;
+  std::set<Instance*> half_open_instances_;
+  RendezvousSelector selector_;
+};
+
+class RendezvousHashLoadBalancer : public LoadBalancer {
+ public:
+  RendezvousHashLoadBalancer();
+
+  virtual ~RendezvousHashLoadBalancer();
+
+  virtual ReturnCode Init(Config* config, Context* context);
+
+  virtual LoadBalanceType GetLoadBalanceType() { return kLoadBalanceTypeRendezvousHash; }
+
+  virtual ReturnCode ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria, Instance*& next);
+
+  virtual ReturnCode ChooseInstances(ServiceInstances* service_instances, const Criteria& criteria,
+                                     uint32_t instance_num, std::vector<Instance*>& selected);
+
+ private:
+  RendezvousCacheValue* GetCacheValue(ServiceInstances* service_instances);
+
+  uint64_t CalculateHashValue(const Criteria& criteria) const;
+
+ private:
+  Hash64Func hash_func_;
+  ServiceCache<RendezvousCacheKey, RendezvousCacheValue>* data_cache_;
+};
+
+}  // namespace polaris
+
+namespace std {
+
+template <>
+struct hash<polaris::RendezvousCacheKey> {
+  std::size_t operator()(const polaris::RendezvousCacheKey& key) const {
+    std::size_t seed = hash<polaris::InstancesSet*>()(key.prior_data_);
+    return polaris::HashCombine(seed, key.version_);
+  }
+};
+
+}  // namespace std
+
+#endif  //  POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_RENDEZVOUS_RENDEZVOUS_H_
@@ -0,0 +1,100 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/ringhash/bounded_load.h"
+
+#include <vector>
+
+#include "logger.h"
+#include "plugin/load_balancer/instance_load.h"
+#include "polaris/config.h"
+#include "polaris/model.h"
+
+namespace polaris {
+
+BoundedLoadHashLoadBalancer::BoundedLoadHashLoadBalancer() : load_factor_(0) {}
+
+BoundedLoadHashLoadBalancer::~BoundedLoadHashLoadBalancer() {}
+
+ReturnCode BoundedLoadHashLoadBalancer::Init(Config* config, Context* context) {
+  static const char kLoadFactorKey[] = "loadFactor";
+  static const float kLoadFactorDefault = 1.25;
+
+  load_factor_ = config->GetFloatOrDefault(kLoadFactorKey, kLoadFactorDefault);
+  if (load_factor_ < 1) {
+    POLARIS_LOG(LOG_WARN, "%s load balancer config %s[%f] less than 1, reset to default %f",
+                kLoadBalanceTypeBoundedLoadHash.c_str(), kLoadFactorKey, load_factor_, kLoadFactorDefault);
+    load_factor_ = kLoadFactorDefault;
+  }
+  InstanceLoadTracker::Init();
+  return KetamaLoadBalancer::Init(config, context);
+}
+
+ReturnCode BoundedLoadHashLoadBalancer::ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria,
+                                                       Instance*& next) {
+  if (criteria.replicate_index_ > 0) {  // 获取副本实例时不考虑负载
+    return KetamaLoadBalancer::ChooseInstance(service_instances, criteria, next);
+  }
+  InstancesSet* instances_set = service_instances->GetAvailableInstances();
+  RingHashCacheValue* lb_value = GetCacheValue(service_instances, criteria);
+  next = nullptr;
+  if (!criteria.ignore_half_open_) {
+    service_instances->GetService()->TryChooseHalfOpenInstance(lb_value->half_open_instances_, next);
+    if (next != nullptr) {
+      InstanceLoadTracker::AcquireInflight(next);
+      return kReturnOk;
+    }
+  }
+
+  const std::vector<Instance*>& instances = instances_set->GetInstances();
+  uint64_t hash_value = lb_value->selector_->CalculateHashValue(criteria);
+  int index = lb_value->selector_->SelectByHash(hash_value);
+  if (index == -1) {
+    return kReturnInstanceNotFound;
+  }
+  if (lb_value->total_weight_ > 0) {
+    // 负载上限按权重分配，总上限大于总请求数，因此总有实例未达到上限
+    double load_limit = load_factor_ * (GetInflightEstimate(lb_value, instances) + 1) / lb_value->total_weight_;
+    auto under_limit = [&](int i) {
+      return InstanceLoadTracker::GetInflight(instances[i]) < load_limit * instances[i]->GetWeight();
+    };
+    if (!under_limit(index)) {
+      int accepted_index = lb_value->selector_->SelectAccepted(hash_value, under_limit);
+      if (accepted_index != -1) {
+        index = accepted_index;
+      }
+    }
+  }
+  next = instances[index];
+  InstanceLoadTracker::AcquireInflight(next);
+  lb_value->inflight_estimate_.fetch_add(1, std::memory_order_relaxed);
+  return kReturnOk;
+}
+
+int64_t BoundedLoadHashLoadBalancer::GetInflightEstimate(RingHashCacheValue* lb_value,
+                                                         const std::vector<Instance*>& instances) {
+  // 选出实例时只累加估计值，每选择实例数次后汇总各实例的计数扣除已经结束的请求，汇总的开销均摊到每次选择为O(1)。
+  // 估计值不小于实际值，多出的只是两次汇总之间结束的请求，负载上限不会过低
+  uint64_t choose_count = lb_value->choose_count_.fetch_add(1, std::memory_order_relaxed);
+  if (choose_count % instances.size() == 0) {
+    int64_t inflight = 0;
+    for (std::size_t i = 0; i < instances.size(); ++i) {
+      inflight += InstanceLoadTracker::GetInflight(instances[i]);
+    }
+    lb_value->inflight_estimate_.store(inflight, std::memory_order_relaxed);
+    return inflight;
+  }
+  return lb_value->inflight_estimate_.load(std::memory_order_relaxed);
+}
+
+}  // namespace polaris
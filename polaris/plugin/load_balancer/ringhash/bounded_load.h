@@ -0,0 +1,47 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_RINGHASH_BOUNDED_LOAD_H_
+#define POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_RINGHASH_BOUNDED_LOAD_H_
+
+#include "plugin/load_balancer/ringhash/ringhash.h"
+
+namespace polaris {
+
+/// @brief 有界负载的一致性哈希负载均衡
+///
+/// 在ketama哈希环的基础上限制每个实例进行中的请求数：实例负载上限为 负载系数 × (总请求数 + 1) × 实例权重占比，
+/// 哈希到的实例达到上限时沿哈希环顺时针查找下一个未达到上限的实例。实例负载通过上报调用结果减少
+class BoundedLoadHashLoadBalancer : public KetamaLoadBalancer {
+ public:
+  BoundedLoadHashLoadBalancer();
+
+  virtual ~BoundedLoadHashLoadBalancer();
+
+  virtual ReturnCode Init(Config* config, Context* context);
+
+  virtual LoadBalanceType GetLoadBalanceType() { return kLoadBalanceTypeBoundedLoadHash; }
+
+  virtual ReturnCode ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria, Instance*& next);
+
+ private:
+  // 获取实例集合进行中请求总数的估计值
+  int64_t GetInflightEstimate(RingHashCacheValue* lb_value, const std::vector<Instance*>& instances);
+
+ private:
+  float load_factor_;
+};
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_RINGHASH_BOUNDED_LOAD_H_
@@ -14,12 +14,18 @@
 #include "plugin/load_balancer/ringhash/continuum.h"
 
 #include <inttypes.h>
+#include <limits.h>
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
 #include <algorithm>
+#include <iterator>
 #include <memory>
 #include <unordered_map>
 #include <utility>
@@ -27,6 +33,7 @@
 #include "logger.h"
 #include "model/instance.h"
 #include "model/model_impl.h"
+#include "plugin/load_balancer/load_balancer.h"
 #include "polaris/model.h"
 #include "utils/utils.h"
 
@@ -35,6 +42,64 @@ namespace polaris {
 // hash 冲突情况下最多尝试次数
 static const int kMaxRehashIteration = 5;
 
+// 半开实例不加入哈希环
+static const int kVnodeLimitNotInRing = INT_MIN;
+
+void EytzingerRing::Build(const std::vector<ContinuumPoint>& ring) {
+  block_count_ = (ring.size() + kBlockSize - 1) / kBlockSize;
+  tree_.assign(block_count_ + 1, 0);
+  hashes_.assign((block_count_ + 1) * kBlockSize, UINT64_MAX);
+  indexes_.assign((block_count_ + 1) * kBlockSize, 0);
+  first_index_ = ring.empty() ? -1 : ring[0].index;
+  std::size_t block = 0;
+  FillTree(ring, 1, block);
+}
+
+void EytzingerRing::FillTree(const std::vector<ContinuumPoint>& ring, std::size_t node, std::size_t& block) {
+  if (node > block_count_) {
+    return;
+  }
+  // 中序遍历时依次填入有序的块
+  FillTree(ring, 2 * node, block);
+  std::size_t begin = block * kBlockSize;
+  std::size_t end = std::min(begin + kBlockSize, ring.size());
+  for (std::size_t i = begin; i < end; ++i) {
+    hashes_[node * kBlockSize + i - begin] = ring[i].hashVal;
+    indexes_[node * kBlockSize + i - begin] = ring[i].index;
+  }
+  tree_[node] = ring[end - 1].hashVal;
+  block++;
+  FillTree(ring, 2 * node + 1, block);
+}
+
+std::size_t EytzingerRing::CountLess(const uint64_t* block, uint64_t value) {
+#if defined(__AVX2__)
+  // 没有无符号64位比较指令，翻转符号位后使用有符号比较
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i target = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<int64_t>(value)), sign);
+  __m256i low = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block)), sign);
+  __m256i high = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 4)), sign);
+  int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(target, low))) |
+             (_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(target, high))) << 4);
+  return __builtin_popcount(mask);
+#elif defined(__SSE4_2__)
+  const __m128i sign = _mm_set1_epi64x(INT64_MIN);
+  const __m128i target = _mm_xor_si128(_mm_set1_epi64x(static_cast<int64_t>(value)), sign);
+  int mask = 0;
+  for (std::size_t i = 0; i < kBlockSize; i += 2) {
+    __m128i data = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i)), sign);
+    mask |= _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(target, data))) << i;
+  }
+  return __builtin_popcount(mask);
+#else
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < kBlockSize; ++i) {
+    count += block[i] < value;
+  }
+  return count;
+#endif
+}
+
 ContinuumSelector::ContinuumSelector(Hash64Func hash_func) : hash_func_(hash_func) {}
 
 ContinuumSelector::~ContinuumSelector() {}
@@ -44,6 +109,8 @@ void ContinuumSelector::Setup(const std::vector<Instance*>& instances, const std
   std::size_t count = instances.size();
   ring_.clear();
   ring_.reserve(count * vnode_cnt);
+  instance_ids_.clear();  // 不支持增量构建
+  vnode_limits_.clear();
 
   // 如果配置了基础权重，则以基础权重计算虚拟节点数， 否则以最大权重为基准计算虚拟节点数
   double max_weight = base_weight > 0 ? static_cast<double>(base_weight)
@@ -81,6 +148,7 @@ void ContinuumSelector::Setup(const std::vector<Instance*>& instances, const std
     }
   }
   std::sort(ring_.begin(), ring_.end());
+  lookup_ring_.Build(ring_);
 }
 
 void ContinuumSelector::FastSetup(const std::vector<Instance*>& instances,
@@ -89,86 +157,169 @@ void ContinuumSelector::FastSetup(const std::vector<Instance*>& instances,
   std::size_t count = instances.size();
   ring_.clear();
   ring_.reserve(count * vnode_cnt);
+  instance_ids_.resize(count);
+  vnode_limits_.resize(count);
 
   std::unordered_map<uint64_t, HashKeyIndex> hash_val_to_key;
-  std::unordered_map<uint64_t, HashKeyIndex>::iterator hash_it;
-
-  char buff[128];
+  std::vector<ContinuumPoint> exist_ring;
   // 如果配置了基础权重，则以基础权重计算虚拟节点数，否则以平均权重为基准使用配置的虚拟节点数
   double avg_weight = base_weight > 0 ? static_cast<double>(base_weight)
                                       : static_cast<double>(InstancesSetImpl::CalcTotalWeight(instances)) / count;
-  ContinuumPoint cp(0, 0);
-  HashKeyIndex hash_key_index;
   for (size_t i = 0; i < count; ++i) {
-    Instance* inst = instances[i];
-    if (half_open_instances.count(inst) > 0) {
+    instance_ids_[i] = instances[i]->GetId();
+    vnode_limits_[i] = CalcVnodeLimit(instances[i], half_open_instances, vnode_cnt, avg_weight, dynamic_weight);
+    if (vnode_limits_[i] != kVnodeLimitNotInRing) {
+      AddInstancePoints(instances, i, vnode_cnt, vnode_limits_[i], exist_ring, hash_val_to_key, ring_);
+    }
+  }
+  std::sort(ring_.begin(), ring_.end());
+  lookup_ring_.Build(ring_);
+}
+
+bool ContinuumSelector::IncrementalSetup(const ContinuumSelector& previous, const std::vector<Instance*>& instances,
+                                         const std::set<Instance*>& half_open_instances, uint32_t vnode_cnt,
+                                         int base_weight, bool dynamic_weight) {
+  std::size_t count = instances.size();
+  if (previous.instance_ids_.empty() || count == 0) {
+    return false;
+  }
+  double avg_weight = base_weight > 0 ? static_cast<double>(base_weight)
+                                      : static_cast<double>(InstancesSetImpl::CalcTotalWeight(instances)) / count;
+  std::vector<int> vnode_limits(count);
+  std::unordered_map<std::string, std::size_t> id_to_index;
+  id_to_index.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    vnode_limits[i] = CalcVnodeLimit(instances[i], half_open_instances, vnode_cnt, avg_weight, dynamic_weight);
+    id_to_index[instances[i]->GetId()] = i;
+  }
+
+  // 计算上一次的实例下标到本次下标的映射，实例被删除或虚拟节点数变化时为-1
+  std::vector<int> index_mapping(previous.instance_ids_.size(), -1);
+  std::vector<bool> reused(count, false);
+  std::size_t reused_count = 0;
+  for (std::size_t i = 0; i < previous.instance_ids_.size(); ++i) {
+    if (previous.vnode_limits_[i] == kVnodeLimitNotInRing) {
       continue;
     }
-    hash_key_index.instance_index_ = i;
-    hash_key_index.vnode_index_ = 0;
-    hash_val_to_key[instances[i]->GetHash()] = hash_key_index;
+    std::unordered_map<std::string, std::size_t>::iterator it = id_to_index.find(previous.instance_ids_[i]);
+    if (it != id_to_index.end() && !reused[it->second] && vnode_limits[it->second] == previous.vnode_limits_[i]) {
+      index_mapping[i] = static_cast<int>(it->second);
+      reused[it->second] = true;
+      reused_count++;
+    }
+  }
+  if (reused_count * 2 < count) {  // 变化的实例过多时全量构建
+    return false;
+  }
 
-    auto& local_value = inst->GetImpl().GetLocalValue();
-    std::vector<uint64_t>& vnodeHash = local_value->AcquireVnodeHash();
-    uint32_t instance_weight = dynamic_weight ? inst->GetDynamicWeight() : inst->GetWeight();
-    int limit = static_cast<int>(floor(instance_weight * vnode_cnt / avg_weight)) - 1;
-    cp.hashVal = inst->GetHash();
-    cp.index = i;
-    ring_.push_back(cp);  // 添加真实节点
-
-    int hashCnt = vnodeHash.size();
-    uint64_t hashVal;
-    for (int k = 0, j = hashCnt + 1; k < limit; ++k) {
-      int retry = 1;
-      do {
-        if (POLARIS_LIKELY(k < hashCnt && 1 == retry)) {  // 不需要计算哈希值
-          hashVal = vnodeHash[k];
-        } else {
-          memset(buff, 0, sizeof(buff));
-          snprintf(buff, sizeof(buff), "%s:%d", inst->GetId().c_str(), j++);
-          hashVal = hash_func_(static_cast<const void*>(buff), strlen(buff), 0);
-        }
-        hash_it = hash_val_to_key.find(hashVal);
-        if (POLARIS_LIKELY(hash_it == hash_val_to_key.end())) {
-          hash_key_index.vnode_index_ = j;
-          hash_val_to_key[hashVal] = hash_key_index;
-          cp.hashVal = hashVal;
-          ring_.push_back(cp);
-          if (k >= hashCnt) {  // 哈希值不足, 添加进去
-            vnodeHash.push_back(hashVal);
-          } else if (retry > 1) {  // 哈希有冲突, 更新一下
-            vnodeHash[k] = hashVal;
-          }
-          break;
+  // 原有的哈希环已经有序，过滤后仍然有序
+  std::vector<ContinuumPoint> reused_ring;
+  reused_ring.reserve(previous.ring_.size());
+  for (std::size_t i = 0; i < previous.ring_.size(); ++i) {
+    const ContinuumPoint& point = previous.ring_[i];
+    if (index_mapping[point.index] >= 0) {
+      reused_ring.push_back(ContinuumPoint(point.hashVal, index_mapping[point.index]));
+    }
+  }
+  // 与保留节点冲突时由新增节点重新计算哈希，不按实例顺序处理冲突，这时结果与FastSetup不同
+  std::unordered_map<uint64_t, HashKeyIndex> hash_val_to_key;
+  std::vector<ContinuumPoint> added_ring;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (!reused[i] && vnode_limits[i] != kVnodeLimitNotInRing) {
+      AddInstancePoints(instances, i, vnode_cnt, vnode_limits[i], reused_ring, hash_val_to_key, added_ring);
+    }
+  }
+  std::sort(added_ring.begin(), added_ring.end());
+
+  ring_.clear();
+  ring_.reserve(reused_ring.size() + added_ring.size());
+  std::merge(reused_ring.begin(), reused_ring.end(), added_ring.begin(), added_ring.end(), std::back_inserter(ring_));
+  lookup_ring_.Build(ring_);
+  instance_ids_.resize(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    instance_ids_[i] = instances[i]->GetId();
+  }
+  vnode_limits_.swap(vnode_limits);
+  return true;
+}
+
+int ContinuumSelector::CalcVnodeLimit(Instance* instance, const std::set<Instance*>& half_open_instances,
+                                      uint32_t vnode_cnt, double avg_weight, bool dynamic_weight) {
+  if (half_open_instances.count(instance) > 0) {
+    return kVnodeLimitNotInRing;
+  }
+  uint32_t instance_weight = dynamic_weight ? instance->GetDynamicWeight() : instance->GetWeight();
+  return static_cast<int>(floor(instance_weight * vnode_cnt / avg_weight)) - 1;
+}
+
+void ContinuumSelector::AddInstancePoints(const std::vector<Instance*>& instances, std::size_t index,
+                                          uint32_t vnode_cnt, int limit, const std::vector<ContinuumPoint>& exist_ring,
+                                          std::unordered_map<uint64_t, HashKeyIndex>& hash_val_to_key,
+                                          std::vector<ContinuumPoint>& points) {
+  Instance* inst = instances[index];
+  HashKeyIndex hash_key_index;
+  hash_key_index.instance_index_ = index;
+  hash_key_index.vnode_index_ = 0;
+  hash_val_to_key[inst->GetHash()] = hash_key_index;
+
+  auto& local_value = inst->GetImpl().GetLocalValue();
+  std::vector<uint64_t>& vnodeHash = local_value->AcquireVnodeHash();
+  ContinuumPoint cp(inst->GetHash(), index);
+  points.push_back(cp);  // 添加真实节点
+
+  char buff[128] = {0};
+  std::unordered_map<uint64_t, HashKeyIndex>::iterator hash_it;
+  int hashCnt = vnodeHash.size();
+  uint64_t hashVal;
+  for (int k = 0, j = hashCnt + 1; k < limit; ++k) {
+    int retry = 1;
+    do {
+      if (POLARIS_LIKELY(k < hashCnt && 1 == retry)) {  // 不需要计算哈希值
+        hashVal = vnodeHash[k];
+      } else {
+        memset(buff, 0, sizeof(buff));
+        snprintf(buff, sizeof(buff), "%s:%d", inst->GetId().c_str(), j++);
+        hashVal = hash_func_(static_cast<const void*>(buff), strlen(buff), 0);
+      }
+      hash_it = hash_val_to_key.find(hashVal);
+      if (POLARIS_LIKELY(hash_it == hash_val_to_key.end() &&
+                         !std::binary_search(exist_ring.begin(), exist_ring.end(), ContinuumPoint(hashVal, 0)))) {
+        hash_key_index.vnode_index_ = j;
+        hash_val_to_key[hashVal] = hash_key_index;
+        cp.hashVal = hashVal;
+        points.push_back(cp);
+        if (k >= hashCnt) {  // 哈希值不足, 添加进去
+          vnodeHash.push_back(hashVal);
+        } else if (retry > 1) {  // 哈希有冲突, 更新一下
+          vnodeHash[k] = hashVal;
         }
-        // conflict
+        break;
+      }
+      // conflict
+      if (hash_it != hash_val_to_key.end()) {
         POLARIS_LOG(LOG_WARN, "hash conflict between %s:%d and %s",
                     instances[hash_it->second.instance_index_]->GetId().c_str(), hash_it->second.vnode_index_, buff);
-      } while (++retry <= kMaxRehashIteration);
-      if (retry > kMaxRehashIteration) {
-        POLARIS_LOG(LOG_ERROR, "fail to generate hash @ %s:%u(id=%s limit=%d). reach %d tries", inst->GetHost().c_str(),
-                    inst->GetPort(), inst->GetId().c_str(), k, kMaxRehashIteration);
+      } else {
+        POLARIS_LOG(LOG_WARN, "hash conflict between exist node and %s", buff);
       }
+    } while (++retry <= kMaxRehashIteration);
+    if (retry > kMaxRehashIteration) {
+      POLARIS_LOG(LOG_ERROR, "fail to generate hash @ %s:%u(id=%s limit=%d). reach %d tries", inst->GetHost().c_str(),
+                  inst->GetPort(), inst->GetId().c_str(), k, kMaxRehashIteration);
     }
+  }
 
-    if ((vnode_cnt * 2) >= static_cast<uint32_t>(limit * 3)) {  // 记录的 hash 值大于需要的 1.5 倍
-      vnodeHash.resize(limit);
-    }
-    local_value->ReleaseVnodeHash();
+  if ((vnode_cnt * 2) >= static_cast<uint32_t>(limit * 3)) {  // 记录的 hash 值大于需要的 1.5 倍
+    vnodeHash.resize(limit);
   }
-  std::sort(ring_.begin(), ring_.end());
+  local_value->ReleaseVnodeHash();
 }
 
 int ContinuumSelector::Select(const Criteria& criteria) {
   if (ring_.empty()) {
     return -1;
   }
-  uint64_t hash_value = CalculateHashValue(criteria);
-  auto position = std::lower_bound(ring_.begin(), ring_.end(), hash_value);
-  if (POLARIS_LIKELY(ring_.end() == position)) {
-    position = ring_.begin();
-  }
-  return position->index;
+  return lookup_ring_.Find(CalculateHashValue(criteria));
 }
 
 uint64_t ContinuumSelector::CalculateHashValue(const Criteria& criteria) const {
@@ -222,6 +373,23 @@ ReturnCode ContinuumSelector::SelectReplicate(const std::vector<Instance*>& inst
   return kReturnOk;
 }
 
+void ContinuumSelector::SelectDistinct(uint64_t hash_value, const std::vector<Instance*>& instances,
+                                       uint32_t instance_num, std::vector<Instance*>& selected) const {
+  std::size_t target_num = selected.size() + instance_num;
+  std::size_t position = std::lower_bound(ring_.begin(), ring_.end(), hash_value) - ring_.begin();
+  int last_index = -1;
+  for (std::size_t i = 0; i < ring_.size() && selected.size() < target_num; ++i, ++position) {
+    if (position == ring_.size()) {
+      position = 0;
+    }
+    int index = ring_[position].index;
+    if (index != last_index) {  // 相邻节点属于同一实例时不重复判断
+      AppendDistinctInstance(selected, instances[index]);
+      last_index = index;
+    }
+  }
+}
+
 bool ContinuumSelector::ReHash(int iteration, uint64_t& hash_value, std::map<uint64_t, std::string>& hash_value_key) {
   if (iteration > kMaxRehashIteration) {
     return false;
@@ -15,7 +15,11 @@
 #define POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_RINGHASH_CONTINUUM_H_
 
 #include <stdint.h>
+
+#include <algorithm>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "model/model_impl.h"
@@ -36,6 +40,56 @@ struct ContinuumPoint {
   bool operator<(const uint64_t val) const { return this->hashVal < val; }
 };
 
+/// @brief 按Eytzinger(BFS)顺序组织的哈希环查找表
+///
+/// 有序的哈希环节点按每块8个划分，每块的哈希值占用一个缓存行。各块最大哈希值按Eytzinger顺序组成完全二叉树，
+/// 查找时无分支地从根节点下降并预取后续层级的节点，找到块后在块内计数小于目标值的节点得到结果。
+/// 查找结果与在有序哈希环上执行std::lower_bound相同
+class EytzingerRing {
+ public:
+  EytzingerRing() : block_count_(0), first_index_(-1) {}
+
+  /// @brief 根据有序的哈希环构建查找表
+  void Build(const std::vector<ContinuumPoint>& ring);
+
+  /// @brief 查找第一个哈希值不小于hash_value的节点对应的实例下标，不存在时回绕到第一个节点
+  ///
+  /// @return int 实例下标，哈希环为空时返回-1
+  int Find(uint64_t hash_value) const {
+    if (block_count_ == 0) {
+      return -1;
+    }
+    const uint64_t* tree = tree_.data();
+    std::size_t node = 1;
+    while (node <= block_count_) {
+      __builtin_prefetch(tree + node * kPrefetchStride);
+      node = 2 * node + (tree[node] < hash_value);
+    }
+    node >>= __builtin_ffsll(static_cast<long long>(~node));
+    if (node == 0) {
+      return first_index_;
+    }
+    std::size_t offset = node * kBlockSize;
+    return indexes_[offset + CountLess(&hashes_[offset], hash_value)];
+  }
+
+ private:
+  static const std::size_t kBlockSize = 8;
+  static const std::size_t kPrefetchStride = 16;  // 预取4层之后的节点
+
+  void FillTree(const std::vector<ContinuumPoint>& ring, std::size_t node, std::size_t& block);
+
+  // 块内哈希值有序，小于目标值的个数即为第一个不小于目标值的节点位置
+  static std::size_t CountLess(const uint64_t* block, uint64_t value);
+
+ private:
+  std::size_t block_count_;
+  std::vector<uint64_t> tree_;    // 各块的最大哈希值，按Eytzinger顺序排列，下标从1开始
+  std::vector<uint64_t> hashes_;  // 各块的哈希值，与tree_顺序相同，末尾不足一块的以最大值填充
+  std::vector<int> indexes_;      // 各块哈希值对应的实例下标
+  int first_index_;               // 哈希环第一个节点的实例下标
+};
+
 struct HashKeyIndex {
   std::size_t instance_index_;
   int vnode_index_;
@@ -57,17 +111,64 @@ class ContinuumSelector : public Selector {
   void FastSetup(const std::vector<Instance*>& instances, const std::set<Instance*>& half_open_instances,
                  uint32_t vnode_cnt, int base_weight, bool dynamic_weight);
 
+  // 基于上一次构建的哈希环增量构建：保留的实例直接复用原有节点，只计算新增实例的节点后归并
+  // 节点哈希值没有冲突时结果与FastSetup相同。新增节点与保留节点冲突时总是由新增节点重新计算哈希，
+  // 而FastSetup按实例顺序由下标较大的实例重新计算，此时两者构建的哈希环可能不同
+  // 上一次不是通过FastSetup构建、保留实例的虚拟节点数发生变化或保留的实例过少时返回false，需要全量构建
+  bool IncrementalSetup(const ContinuumSelector& previous, const std::vector<Instance*>& instances,
+                        const std::set<Instance*>& half_open_instances, uint32_t vnode_cnt, int base_weight,
+                        bool dynamic_weight);
+
   bool ReHash(int iteration, uint64_t& hash_value, std::map<uint64_t, std::string>& hash_value_key);
 
   bool EmptyRing() const { return ring_.empty(); }
 
   uint64_t CalculateHashValue(const Criteria& criteria) const;
 
+  // 查找哈希值在环上对应的实例下标，哈希环为空时返回-1
+  int SelectByHash(uint64_t hash_value) const { return lookup_ring_.Find(hash_value); }
+
+  // 从哈希值在环上的位置开始顺时针查找第一个accept返回true的实例下标，环上所有节点都不满足时返回-1
+  template <typename Accept>
+  int SelectAccepted(uint64_t hash_value, Accept accept) const {
+    std::size_t position = std::lower_bound(ring_.begin(), ring_.end(), hash_value) - ring_.begin();
+    int last_index = -1;
+    for (std::size_t i = 0; i < ring_.size(); ++i, ++position) {
+      if (position == ring_.size()) {
+        position = 0;
+      }
+      int index = ring_[position].index;
+      if (index != last_index && accept(index)) {  // 相邻节点属于同一实例时不重复判断
+        return index;
+      }
+      last_index = index;
+    }
+    return -1;
+  }
+
   ReturnCode SelectReplicate(const std::vector<Instance*>& instances, const Criteria& criteria, Instance*& next);
 
+  // 从哈希值在环上的位置开始顺时针选择与已选实例不重复的实例，追加instance_num个或遍历完哈希环后返回
+  void SelectDistinct(uint64_t hash_value, const std::vector<Instance*>& instances, uint32_t instance_num,
+                      std::vector<Instance*>& selected) const;
+
+ private:
+  // 计算实例的虚拟节点数(不包含真实节点)，不加入哈希环的半开实例返回kVnodeLimitNotInRing
+  static int CalcVnodeLimit(Instance* instance, const std::set<Instance*>& half_open_instances, uint32_t vnode_cnt,
+                            double avg_weight, bool dynamic_weight);
+
+  // 生成实例的真实节点和虚拟节点，与hash_val_to_key及有序的exist_ring中的节点冲突时重新计算哈希
+  void AddInstancePoints(const std::vector<Instance*>& instances, std::size_t index, uint32_t vnode_cnt, int limit,
+                         const std::vector<ContinuumPoint>& exist_ring,
+                         std::unordered_map<uint64_t, HashKeyIndex>& hash_val_to_key,
+                         std::vector<ContinuumPoint>& points);
+
  private:
   Hash64Func hash_func_;              // 哈希函数
   std::vector<ContinuumPoint> ring_;  // 哈希环
+  EytzingerRing lookup_ring_;         // 用于查找的哈希环
+  std::vector<std::string> instance_ids_;  // FastSetup构建时各下标对应的实例ID，用于增量构建
+  std::vector<int> vnode_limits_;          // FastSetup构建时各下标对应实例的虚拟节点数
 };
 
 }  // namespace polaris
@@ -25,6 +25,7 @@
 #include "logger.h"
 #include "model/model_impl.h"
 #include "plugin/load_balancer/hash/murmur.h"
+#include "plugin/load_balancer/load_balancer.h"
 #include "polaris/context.h"
 #include "utils/ip_utils.h"
 #include "utils/utils.h"
@@ -101,10 +102,7 @@ ReturnCode L5CstHashLoadBalancer::Init(Config* /*config*/, Context* context) {
   return kReturnOk;
 }
 
-ReturnCode L5CstHashLoadBalancer::ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria,
-                                                 Instance*& next) {
-  // 获取所有实例
-  next = nullptr;
+L5CstHashCacheValue* L5CstHashLoadBalancer::GetCacheValue(ServiceInstances* service_instances) {
   InstancesSet* instances_set = service_instances->GetAvailableInstances();
   L5CstHashCacheKey cache_key = {instances_set};
   L5CstHashCacheValue* lb_value = data_cache_->GetWithRcuTime(cache_key);
@@ -123,6 +121,25 @@ ReturnCode L5CstHashLoadBalancer::ChooseInstance(ServiceInstances* service_insta
       return new_lb_value;
     });
   }
+  return lb_value;
+}
+
+uint32_t L5CstHashLoadBalancer::CalculateHash(const Criteria& criteria) const {
+  if (!brpc_murmur_hash_) {
+    return Murmur3_32((const char*)&criteria.hash_key_, sizeof(criteria.hash_key_), 16);
+  }
+  if (criteria.hash_key_ != 0 || criteria.hash_string_.empty()) {
+    return criteria.hash_key_;
+  }
+  return Murmur3_32(criteria.hash_string_.data(), criteria.hash_string_.size(), 0);
+}
+
+ReturnCode L5CstHashLoadBalancer::ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria,
+                                                 Instance*& next) {
+  // 获取所有实例
+  next = nullptr;
+  InstancesSet* instances_set = service_instances->GetAvailableInstances();
+  L5CstHashCacheValue* lb_value = GetCacheValue(service_instances);
 
   if (!criteria.ignore_half_open_) {
     service_instances->GetService()->TryChooseHalfOpenInstance(lb_value->half_open_instances_, next);
@@ -135,17 +152,7 @@ ReturnCode L5CstHashLoadBalancer::ChooseInstance(ServiceInstances* service_insta
     return kReturnInstanceNotFound;
   }
 
-  uint32_t hash = 0;
-  if (brpc_murmur_hash_) {
-    if (criteria.hash_key_ != 0 || criteria.hash_string_.empty()) {
-      hash = criteria.hash_key_;
-    } else {
-      hash = Murmur3_32(criteria.hash_string_.data(), criteria.hash_string_.size(), 0);
-    }
-  } else {
-    hash = Murmur3_32((const char*)&criteria.hash_key_, sizeof(criteria.hash_key_), 16);
-  }
-  auto position = lb_value->hash_ring.lower_bound(hash);
+  auto position = lb_value->hash_ring.lower_bound(CalculateHash(criteria));
   if (POLARIS_UNLIKELY(lb_value->hash_ring.end() == position)) {
     position = lb_value->hash_ring.begin();
   }
@@ -179,4 +186,26 @@ ReturnCode L5CstHashLoadBalancer::ChooseInstance(ServiceInstances* service_insta
   return kReturnOk;
 }
 
+ReturnCode L5CstHashLoadBalancer::ChooseInstances(ServiceInstances* service_instances, const Criteria& criteria,
+                                                  uint32_t instance_num, std::vector<Instance*>& selected) {
+  L5CstHashCacheValue* lb_value = GetCacheValue(service_instances);
+  if (lb_value->hash_ring.empty()) {
+    return kReturnInstanceNotFound;
+  }
+  // 从hash key指向的节点开始顺时针选择不重复的实例
+  std::size_t target_num = selected.size() + instance_num;
+  auto position = lb_value->hash_ring.lower_bound(CalculateHash(criteria));
+  Instance* last_instance = nullptr;
+  for (std::size_t i = 0; i < lb_value->hash_ring.size() && selected.size() < target_num; ++i, ++position) {
+    if (POLARIS_UNLIKELY(lb_value->hash_ring.end() == position)) {
+      position = lb_value->hash_ring.begin();
+    }
+    if (position->second != last_instance) {  // 相邻节点属于同一实例时不重复判断
+      AppendDistinctInstance(selected, position->second);
+      last_instance = position->second;
+    }
+  }
+  return kReturnOk;
+}
+
 }  // namespace polaris
@@ -19,6 +19,7 @@
 
 #include <map>
 #include <set>
+#include <vector>
 
 #include "cache/service_cache.h"
 #include "polaris/defs.h"
@@ -34,6 +35,8 @@ struct L5CstHashCacheKey {
   InstancesSet* prior_data_;
 
   bool operator<(const L5CstHashCacheKey& rhs) const { return this->prior_data_ < rhs.prior_data_; }
+
+  bool operator==(const L5CstHashCacheKey& rhs) const { return this->prior_data_ == rhs.prior_data_; }
 };
 
 class L5CstHashCacheValue : public ServiceBase {
@@ -62,6 +65,14 @@ class L5CstHashLoadBalancer : public LoadBalancer {
 
   virtual ReturnCode ChooseInstance(ServiceInstances* instances, const Criteria& criteria, Instance*& next);
 
+  virtual ReturnCode ChooseInstances(ServiceInstances* service_instances, const Criteria& criteria,
+                                     uint32_t instance_num, std::vector<Instance*>& selected);
+
+ private:
+  L5CstHashCacheValue* GetCacheValue(ServiceInstances* service_instances);
+
+  uint32_t CalculateHash(const Criteria& criteria) const;
+
  private:
   Context* context_;
   ServiceCache<L5CstHashCacheKey, L5CstHashCacheValue>* data_cache_;
@@ -70,4 +81,15 @@ class L5CstHashLoadBalancer : public LoadBalancer {
 
 }  // namespace polaris
 
+namespace std {
+
+template <>
+struct hash<polaris::L5CstHashCacheKey> {
+  std::size_t operator()(const polaris::L5CstHashCacheKey& key) const {
+    return hash<polaris::InstancesSet*>()(key.prior_data_);
+  }
+};
+
+}  // namespace std
+
 #endif  //  POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_RINGHASH_L5_CSTHASH_H_
@@ -16,7 +16,6 @@
 #include <stdlib.h>
 
 #include <inttypes.h>
-#include <map>
 #include <string>
 #include <vector>
 
@@ -37,13 +36,18 @@ KetamaLoadBalancer::KetamaLoadBalancer()
       base_weight_(0),
       hash_func_(nullptr),
       compatible_go_(false),
-      data_cache_(nullptr) {}
+      data_cache_(nullptr),
+      last_selectors_(nullptr) {}
 
 KetamaLoadBalancer::~KetamaLoadBalancer() {
   if (data_cache_ != nullptr) {
     data_cache_->SetClearHandler(0);
     data_cache_->DecrementRef();
   }
+  if (last_selectors_ != nullptr) {
+    last_selectors_->SetClearHandler(0);
+    last_selectors_->DecrementRef();
+  }
   context_ = nullptr;
 }
 
@@ -74,16 +78,17 @@ ReturnCode KetamaLoadBalancer::Init(Config* config, Context* context) {
   if (code != kReturnOk) {
     return code;
   }
-  PluginManager::Instance().RegisterInstancePreUpdateHandler(KetamaLoadBalancer::OnInstanceUpdate);
+  PluginManager::Instance().RegisterInstancePreUpdateHandler(InstancesData::CopyLocalValues);
 
   data_cache_ = new ServiceCache<RingHashCacheKey, RingHashCacheValue>();
   context_->GetContextImpl()->RegisterCache(data_cache_);
+  last_selectors_ = new LastSelectorCache<ContinuumSelector>();
+  context_->GetContextImpl()->RegisterCache(last_selectors_);
 
   return kReturnOk;
 }
 
-ReturnCode KetamaLoadBalancer::ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria,
-                                              Instance*& next) {
+RingHashCacheValue* KetamaLoadBalancer::GetCacheValue(ServiceInstances* service_instances, const Criteria& criteria) {
   InstancesSet* instances_set = service_instances->GetAvailableInstances();
   RingHashCacheKey cache_key = {instances_set, service_instances->GetDynamicWeightVersion()};
   RingHashCacheValue* lb_value = data_cache_->GetWithRcuTime(cache_key);
@@ -102,7 +107,7 @@ ReturnCode KetamaLoadBalancer::ChooseInstance(ServiceInstances* service_instance
       service_instances->GetHalfOpenInstances(new_lb_value->half_open_instances_);
       auto& instances = instances_set->GetInstances();
       bool dynamic_weight = service_instances->GetDynamicWeightVersion() > 0;
-      auto selector = new ContinuumSelector(hash_func_);
+      std::shared_ptr<ContinuumSelector> selector(new ContinuumSelector(hash_func_));
       if (compatible_go_) {
         selector->Setup(instances, new_lb_value->half_open_instances_, vnode_cnt_, base_weight_, dynamic_weight);
         if (selector->EmptyRing()) {
@@ -110,17 +115,31 @@ ReturnCode KetamaLoadBalancer::ChooseInstance(ServiceInstances* service_instance
           selector->Setup(instances, empty_half_open, vnode_cnt_, base_weight_, dynamic_weight);
         }
       } else {
-        selector->FastSetup(instances, new_lb_value->half_open_instances_, vnode_cnt_, base_weight_, dynamic_weight);
+        const ServiceKey& service_key = service_instances->GetService()->GetServiceKey();
+        std::shared_ptr<ContinuumSelector> last_selector = last_selectors_->Get(service_key, instances_set);
+        if (last_selector == nullptr ||
+            !selector->IncrementalSetup(*last_selector, instances, new_lb_value->half_open_instances_, vnode_cnt_,
+                                        base_weight_, dynamic_weight)) {
+          selector->FastSetup(instances, new_lb_value->half_open_instances_, vnode_cnt_, base_weight_, dynamic_weight);
+        }
         if (selector->EmptyRing()) {
           std::set<Instance*> empty_half_open;
           selector->FastSetup(instances, empty_half_open, vnode_cnt_, base_weight_, dynamic_weight);
         }
+        last_selectors_->Set(service_key, instances_set, selector);
       }
-      new_lb_value->selector_.reset(selector);
+      new_lb_value->selector_ = selector;
+      new_lb_value->total_weight_ = InstancesSetImpl::CalcTotalWeight(instances);
       return new_lb_value;
     });
   }
+  return lb_value;
+}
 
+ReturnCode KetamaLoadBalancer::ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria,
+                                              Instance*& next) {
+  InstancesSet* instances_set = service_instances->GetAvailableInstances();
+  RingHashCacheValue* lb_value = GetCacheValue(service_instances, criteria);
   next = nullptr;
   if (!criteria.ignore_half_open_ && criteria.replicate_index_ == 0) {
     service_instances->GetService()->TryChooseHalfOpenInstance(lb_value->half_open_instances_, next);
@@ -142,17 +161,21 @@ ReturnCode KetamaLoadBalancer::ChooseInstance(ServiceInstances* service_instance
   return lb_value->selector_->SelectReplicate(instances_set->GetInstances(), criteria, next);
 }
 
-void KetamaLoadBalancer::OnInstanceUpdate(const InstancesData* old_instances, InstancesData* new_instances) {
-  auto new_it = new_instances->instances_map_.begin();
-  auto new_end = new_instances->instances_map_.end();
-  const std::map<std::string, Instance*>& old_instances_map = old_instances->instances_map_;
-  auto old_end = old_instances->instances_map_.end();
-  std::map<std::string, Instance*>::const_iterator old_it;
-  for (; new_it != new_end; ++new_it) {
-    if ((old_it = old_instances_map.find(new_it->second->GetId())) != old_end) {  // 迁移数据
-      new_it->second->GetImpl().CopyLocalValue(old_it->second->GetImpl());
-    }
+ReturnCode KetamaLoadBalancer::ChooseInstances(ServiceInstances* service_instances, const Criteria& criteria,
+                                               uint32_t instance_num, std::vector<Instance*>& selected) {
+  RingHashCacheValue* lb_value = GetCacheValue(service_instances, criteria);
+  if (lb_value->selector_->EmptyRing()) {
+    return kReturnInstanceNotFound;
   }
+  // 只计算一次哈希值，沿哈希环顺时针选择后续的实例
+  uint64_t hash_value = lb_value->selector_->CalculateHashValue(criteria);
+  lb_value->selector_->SelectDistinct(hash_value, service_instances->GetAvailableInstances()->GetInstances(),
+                                      instance_num, selected);
+  return kReturnOk;
+}
+
+void KetamaLoadBalancer::OnInstanceUpdate(const InstancesData* old_instances, InstancesData* new_instances) {
+  InstancesData::CopyLocalValues(old_instances, new_instances);
 }
 
 }  // namespace polaris
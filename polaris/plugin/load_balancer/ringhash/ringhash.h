@@ -16,8 +16,12 @@
 
 #include <stdint.h>
 
+#include <atomic>
+#include <memory>
+
 #include "cache/service_cache.h"
 #include "plugin/load_balancer/hash/hash_manager.h"
+#include "plugin/load_balancer/last_selector_cache.h"
 #include "plugin/load_balancer/ringhash/continuum.h"
 #include "polaris/defs.h"
 #include "polaris/plugin.h"
@@ -34,10 +38,16 @@ struct RingHashCacheKey {
     return this->prior_data_ < rhs.prior_data_ ||
            (this->prior_data_ == rhs.prior_data_ && this->version_ < rhs.version_);
   }
+
+  bool operator==(const RingHashCacheKey& rhs) const {
+    return this->prior_data_ == rhs.prior_data_ && this->version_ == rhs.version_;
+  }
 };
 
 class RingHashCacheValue : public ServiceBase {
  public:
+  RingHashCacheValue() : prior_date_(nullptr), total_weight_(0), inflight_estimate_(0), choose_count_(0) {}
+
   virtual ~RingHashCacheValue() {
     prior_date_->DecrementRef();
     prior_date_ = nullptr;
@@ -45,8 +55,13 @@ class RingHashCacheValue : public ServiceBase {
 
  public:
   InstancesSet* prior_date_;
-  std::unique_ptr<ContinuumSelector> selector_;
+  std::shared_ptr<ContinuumSelector> selector_;
   std::set<Instance*> half_open_instances_;
+
+  // 以下用于有界负载一致性哈希：实例集合的总权重，进行中请求总数的估计值，以及用于定期校正估计值的选择次数
+  uint64_t total_weight_;
+  std::atomic<int64_t> inflight_estimate_;
+  std::atomic<uint64_t> choose_count_;
 };
 
 class KetamaLoadBalancer : public LoadBalancer {
@@ -61,8 +76,15 @@ class KetamaLoadBalancer : public LoadBalancer {
 
   virtual ReturnCode ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria, Instance*& next);
 
+  virtual ReturnCode ChooseInstances(ServiceInstances* service_instances, const Criteria& criteria,
+                                     uint32_t instance_num, std::vector<Instance*>& selected);
+
   static void OnInstanceUpdate(const InstancesData* old, InstancesData* new_instances);
 
+ protected:
+  // 获取实例集合对应的哈希环缓存，不存在时构建
+  RingHashCacheValue* GetCacheValue(ServiceInstances* service_instances, const Criteria& criteria);
+
  private:
   Context* context_;
   uint32_t vnode_cnt_;
@@ -71,8 +93,21 @@ class KetamaLoadBalancer : public LoadBalancer {
   bool compatible_go_;  // 兼容golang sdk的一致性hash算法
 
   ServiceCache<RingHashCacheKey, RingHashCacheValue>* data_cache_;
+  LastSelectorCache<ContinuumSelector>* last_selectors_;  // 各实例子集最近一次构建的哈希环
 };
 
 }  // namespace polaris
 
+namespace std {
+
+template <>
+struct hash<polaris::RingHashCacheKey> {
+  std::size_t operator()(const polaris::RingHashCacheKey& key) const {
+    std::size_t seed = hash<polaris::InstancesSet*>()(key.prior_data_);
+    return polaris::HashCombine(seed, key.version_);
+  }
+};
+
+}  // namespace std
+
 #endif  //  POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_RINGHASH_RINGHASH_H_
@@ -18,40 +18,72 @@
 #include <set>
 #include <vector>
 
+#include "context/context_impl.h"
 #include "model/model_impl.h"
+#include "polaris/context.h"
 #include "polaris/model.h"
 
 namespace polaris {
 
+void SimpleHashCacheValue::Setup(const std::vector<Instance*>& instances) {
+  std::size_t count = instances.size();
+  hash_instances_ = instances;
+  // 从后向前环形遍历两圈，每个半开实例的位置填写其后第一个非半开实例
+  Instance* next_normal = nullptr;
+  for (std::size_t i = 2 * count; i > 0; --i) {
+    std::size_t index = (i - 1) % count;
+    if (half_open_instances_.count(instances[index]) == 0) {
+      next_normal = instances[index];
+    } else if (next_normal != nullptr) {
+      hash_instances_[index] = next_normal;
+    }
+  }
+}
+
+SimpleHashLoadBalancer::SimpleHashLoadBalancer() : data_cache_(nullptr) {}
+
+SimpleHashLoadBalancer::~SimpleHashLoadBalancer() {
+  if (data_cache_ != nullptr) {
+    data_cache_->SetClearHandler(0);
+    data_cache_->DecrementRef();
+  }
+}
+
+ReturnCode SimpleHashLoadBalancer::Init(Config* /*config*/, Context* context) {
+  data_cache_ = new ServiceCache<SimpleHashCacheKey, SimpleHashCacheValue>();
+  context->GetContextImpl()->RegisterCache(data_cache_);
+  return kReturnOk;
+}
+
 ReturnCode SimpleHashLoadBalancer::ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria,
                                                   Instance*& next) {
   next = nullptr;
   InstancesSet* instances_set = service_instances->GetAvailableInstances();
-  std::vector<Instance*> instances = instances_set->GetInstances();
-  std::set<Instance*> half_open_instances;
-  service_instances->GetHalfOpenInstances(half_open_instances);
+  SimpleHashCacheKey cache_key = {instances_set};
+  SimpleHashCacheValue* lb_value = data_cache_->GetWithRcuTime(cache_key);
+  if (lb_value == nullptr) {
+    lb_value = data_cache_->CreateOrGet(cache_key, [&] {
+      SimpleHashCacheValue* new_lb_value = new SimpleHashCacheValue();
+      new_lb_value->prior_date_ = instances_set;
+      new_lb_value->prior_date_->IncrementRef();
+      service_instances->GetHalfOpenInstances(new_lb_value->half_open_instances_);
+      new_lb_value->Setup(instances_set->GetInstances());
+      return new_lb_value;
+    });
+  }
 
   if (!criteria.ignore_half_open_) {
-    service_instances->GetService()->TryChooseHalfOpenInstance(half_open_instances, next);
+    service_instances->GetService()->TryChooseHalfOpenInstance(lb_value->half_open_instances_, next);
     if (next != nullptr) {
       return kReturnOk;
     }
   }
 
-  if (instances.empty()) {
+  const std::vector<Instance*>& hash_instances = lb_value->hash_instances_;
+  if (hash_instances.empty()) {
     return kReturnInstanceNotFound;
   }
-
-  next = instances[criteria.hash_key_ % instances.size()];
-  if (half_open_instances.count(next) > 0 && instances.size() != half_open_instances.size()) {
-    // 选到了半开节点，且有正常的节点，则查找到正常的节点
-    for (std::size_t i = 1; i < instances.size(); ++i) {
-      next = instances[(criteria.hash_key_ + i) % instances.size()];
-      if (half_open_instances.count(next) == 0) {
-        return kReturnOk;
-      }
-    }
-  }
+  next = hash_instances[criteria.hash_key_ % hash_instances.size()];
   return kReturnOk;
 }
 
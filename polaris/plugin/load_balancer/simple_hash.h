@@ -14,6 +14,10 @@
 #ifndef POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_SIMPLE_HASH_H_
 #define POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_SIMPLE_HASH_H_
 
+#include <set>
+#include <vector>
+
+#include "cache/service_cache.h"
 #include "polaris/defs.h"
 #include "polaris/plugin.h"
 
@@ -24,20 +28,62 @@ class Context;
 class Instance;
 class ServiceInstances;
 
+struct SimpleHashCacheKey {
+  InstancesSet* prior_data_;
+
+  bool operator<(const SimpleHashCacheKey& rhs) const { return this->prior_data_ < rhs.prior_data_; }
+
+  bool operator==(const SimpleHashCacheKey& rhs) const { return this->prior_data_ == rhs.prior_data_; }
+};
+
+class SimpleHashCacheValue : public ServiceBase {
+ public:
+  SimpleHashCacheValue() : prior_date_(nullptr) {}
+
+  virtual ~SimpleHashCacheValue() {
+    prior_date_->DecrementRef();
+    prior_date_ = nullptr;
+  }
+
+  /// @brief 预先计算每个取模结果对应的实例
+  ///
+  /// 取模选中半开实例时，向后查找第一个非半开实例，全部为半开实例时使用取模选中的实例
+  void Setup(const std::vector<Instance*>& instances);
+
+ public:
+  InstancesSet* prior_date_;
+  std::set<Instance*> half_open_instances_;
+  std::vector<Instance*> hash_instances_;  // 下标为哈希值对实例数取模的结果
+};
+
 // 兼容L5的一致性hash算法，相同数据提供与L5相同的输出
 class SimpleHashLoadBalancer : public LoadBalancer {
  public:
-  SimpleHashLoadBalancer() {}
+  SimpleHashLoadBalancer();
 
-  virtual ~SimpleHashLoadBalancer() {}
+  virtual ~SimpleHashLoadBalancer();
 
-  virtual ReturnCode Init(Config* /*config*/, Context* /*context*/) { return kReturnOk; }
+  virtual ReturnCode Init(Config* config, Context* context);
 
   virtual LoadBalanceType GetLoadBalanceType() { return kLoadBalanceTypeSimpleHash; }
 
   virtual ReturnCode ChooseInstance(ServiceInstances* instances, const Criteria& criteria, Instance*& next);
+
+ private:
+  ServiceCache<SimpleHashCacheKey, SimpleHashCacheValue>* data_cache_;
 };
 
 }  // namespace polaris
 
+namespace std {
+
+template <>
+struct hash<polaris::SimpleHashCacheKey> {
+  std::size_t operator()(const polaris::SimpleHashCacheKey& key) const {
+    return hash<polaris::InstancesSet*>()(key.prior_data_);
+  }
+};
+
+}  // namespace std
+
 #endif  //  POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_SIMPLE_HASH_H_
@@ -13,20 +13,58 @@
 
 #include "plugin/load_balancer/weighted_random.h"
 
-#include <pthread.h>
-#include <stdlib.h>
-#include <time.h>
-
-#include <algorithm>
 #include <vector>
 
 #include "context/context_impl.h"
 #include "model/model_impl.h"
+#include "plugin/load_balancer/load_balancer.h"
 #include "polaris/config.h"
 #include "polaris/context.h"
+#include "utils/fast_random.h"
 
 namespace polaris {
 
+static const uint64_t kAliasThresholdBase = 1ULL << 32;
+
+void RandomLbCacheValue::BuildAliasTable(const std::vector<WeightInstance>& weight_instances) {
+  std::size_t count = weight_instances.size();
+  alias_table_.resize(count);
+  // 所有权重乘以实例数，平均每列的权重即为总权重，全部使用整数计算
+  uint64_t sum_weight = 0;
+  std::vector<uint64_t> scaled_weights(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    scaled_weights[i] = static_cast<uint64_t>(weight_instances[i].weight_) * count;
+    sum_weight += weight_instances[i].weight_;
+    alias_table_[i].threshold_ = kAliasThresholdBase;
+    alias_table_[i].instance_ = weight_instances[i].instance_;
+    alias_table_[i].alias_ = weight_instances[i].instance_;
+  }
+  std::vector<std::size_t> small_list;
+  std::vector<std::size_t> large_list;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (scaled_weights[i] < sum_weight) {
+      small_list.push_back(i);
+    } else {
+      large_list.push_back(i);
+    }
+  }
+  // 每次用一个权重不足的列和一个权重多余的列配对，多余的列补足不足列后重新归类
+  while (!small_list.empty() && !large_list.empty()) {
+    std::size_t small = small_list.back();
+    small_list.pop_back();
+    std::size_t large = large_list.back();
+    AliasEntry& entry = alias_table_[small];
+    entry.threshold_ = static_cast<uint64_t>(static_cast<double>(scaled_weights[small]) / sum_weight * kAliasThresholdBase);
+    entry.alias_ = alias_table_[large].instance_;
+    scaled_weights[large] -= sum_weight - scaled_weights[small];
+    if (scaled_weights[large] < sum_weight) {
+      large_list.pop_back();
+      small_list.push_back(large);
+    }
+  }
+  // 剩余的列权重都等于平均权重，阈值保持为总是选择本列
+}
+
 RandomLoadBalancer::RandomLoadBalancer() : enable_dynamic_weight_(false), context_(nullptr), data_cache_(nullptr) {}
 
 RandomLoadBalancer::~RandomLoadBalancer() {
@@ -50,8 +88,7 @@ RandomLbCacheKey RandomLoadBalancer::GenCacheKey(ServiceInstances* service_insta
   return {service_instances->GetAvailableInstances(), 0};
 }
 
-ReturnCode RandomLoadBalancer::ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria,
-                                              Instance*& next) {
+RandomLbCacheValue* RandomLoadBalancer::GetCacheValue(ServiceInstances* service_instances) {
   RandomLbCacheKey cache_key = GenCacheKey(service_instances);
   RandomLbCacheValue* lb_value = data_cache_->GetWithRcuTime(cache_key);
   if (lb_value == nullptr) {
@@ -63,13 +100,14 @@ ReturnCode RandomLoadBalancer::ChooseInstance(ServiceInstances* service_instance
       new_lb_value->sum_weight_ = 0;
       service_instances->GetHalfOpenInstances(new_lb_value->half_open_instances_);
       std::vector<Instance*> instances = instances_set->GetInstances();
-      new_lb_value->weight_instances_.reserve(instances.size());
+      std::vector<WeightInstance> weight_instances;
+      weight_instances.reserve(instances.size());
       for (auto& instance : instances) {
         // 判断是否获取动态权重
         int weight = enable_dynamic_weight_ ? instance->GetDynamicWeight() : instance->GetWeight();
         if (new_lb_value->half_open_instances_.count(instance) == 0 && weight > 0) {  // 非半开实例和权重大于0实例
           new_lb_value->sum_weight_ += weight;
-          new_lb_value->weight_instances_.push_back({new_lb_value->sum_weight_, instance});
+          weight_instances.push_back({weight, instance});
         }
       }
       if (new_lb_value->sum_weight_ == 0) {  // 没有正常实例，则使用半开实例
@@ -77,14 +115,20 @@ ReturnCode RandomLoadBalancer::ChooseInstance(ServiceInstances* service_instance
           int weight = enable_dynamic_weight_ ? instance->GetDynamicWeight() : instance->GetWeight();
           if (weight > 0) {
             new_lb_value->sum_weight_ += weight;
-            new_lb_value->weight_instances_.push_back({new_lb_value->sum_weight_, instance});
+            weight_instances.push_back({weight, instance});
           }
         }
       }
+      new_lb_value->BuildAliasTable(weight_instances);
       return new_lb_value;
     });
   }
+  return lb_value;
+}
 
+ReturnCode RandomLoadBalancer::ChooseInstance(ServiceInstances* service_instances, const Criteria& criteria,
+                                              Instance*& next) {
+  RandomLbCacheValue* lb_value = GetCacheValue(service_instances);
   next = nullptr;
   if (!criteria.ignore_half_open_) {
     service_instances->GetService()->TryChooseHalfOpenInstance(lb_value->half_open_instances_, next);
@@ -97,16 +141,15 @@ ReturnCode RandomLoadBalancer::ChooseInstance(ServiceInstances* service_instance
     return kReturnInstanceNotFound;
   }
 
-  // 获取一个随机数
-  static __thread bool thread_local_seed_not_init = true;
-  static __thread unsigned int thread_local_seed = 0;
-  if (thread_local_seed_not_init) {
-    thread_local_seed_not_init = false;
-    thread_local_seed = time(nullptr) ^ pthread_self();
-  }
-  WeightInstance random_weight = {rand_r(&thread_local_seed) % lb_value->sum_weight_, nullptr};
-  auto it = std::upper_bound(lb_value->weight_instances_.begin(), lb_value->weight_instances_.end(), random_weight);
-  next = it->instance_;
+  next = lb_value->SelectInstance(FastRandom::Next());
+  return kReturnOk;
+}
+
+ReturnCode RandomLoadBalancer::ChooseInstances(ServiceInstances* service_instances, const Criteria& /*criteria*/,
+                                               uint32_t instance_num, std::vector<Instance*>& selected) {
+  RandomLbCacheValue* lb_value = GetCacheValue(service_instances);
+  ChooseInstancesFromRandomOffset(lb_value->prior_date_->GetInstances(), lb_value->half_open_instances_, instance_num,
+                                  selected);
   return kReturnOk;
 }
 
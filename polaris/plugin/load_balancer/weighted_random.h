@@ -33,13 +33,24 @@ struct RandomLbCacheKey {
     return this->prior_data_ < rhs.prior_data_ ||
            (this->prior_data_ == rhs.prior_data_ && this->version_ < rhs.version_);
   }
+
+  bool operator==(const RandomLbCacheKey& rhs) const {
+    return this->prior_data_ == rhs.prior_data_ && this->version_ == rhs.version_;
+  }
 };
 
 struct WeightInstance {
   int weight_;
   Instance* instance_;
+};
 
-  bool operator<(const WeightInstance& rhs) const { return this->weight_ < rhs.weight_; }
+/// @brief Vose别名表中的一列
+///
+/// 随机选中一列后，再用一个随机数与阈值比较，小于阈值选择本列实例，否则选择别名实例
+struct AliasEntry {
+  uint64_t threshold_;  // 选择本列实例的概率乘以2^32
+  Instance* instance_;
+  Instance* alias_;
 };
 
 class RandomLbCacheValue : public ServiceBase {
@@ -48,14 +59,28 @@ class RandomLbCacheValue : public ServiceBase {
     prior_date_->DecrementRef();
     prior_date_ = nullptr;
     sum_weight_ = 0;
-    weight_instances_.clear();
+    alias_table_.clear();
+  }
+
+  /// @brief 根据实例权重构建别名表，构建后每次选择只需要一个随机数和一次表查找
+  void BuildAliasTable(const std::vector<WeightInstance>& weight_instances);
+
+  /// @brief 使用随机数从别名表中选择实例，高32位选择列，低32位与阈值比较
+  Instance* SelectInstance(uint64_t random) const {
+    const AliasEntry& entry = alias_table_[((random >> 32) * alias_table_.size()) >> 32];
+    return (random & 0xffffffffULL) < entry.threshold_ ? entry.instance_ : entry.alias_;
+  }
+
+  /// @brief 使用随机数的高32位从别名表各列的实例中等概率选择，即不考虑权重地选择一个权重大于0的实例
+  Instance* SelectUniform(uint64_t random) const {
+    return alias_table_[((random >> 32) * alias_table_.size()) >> 32].instance_;
   }
 
  public:
   InstancesSet* prior_date_;
   std::set<Instance*> half_open_instances_;
   int sum_weight_;
-  std::vector<WeightInstance> weight_instances_;
+  std::vector<AliasEntry> alias_table_;
 };
 
 class RandomLoadBalancer : public LoadBalancer {
@@ -72,6 +97,14 @@ class RandomLoadBalancer : public LoadBalancer {
 
   virtual ReturnCode ChooseInstance(ServiceInstances* instances, const Criteria& criteria, Instance*& next);
 
+  // 与默认实现一样从随机位置选择备份实例，使用缓存中的半开实例集合
+  virtual ReturnCode ChooseInstances(ServiceInstances* service_instances, const Criteria& criteria,
+                                     uint32_t instance_num, std::vector<Instance*>& selected);
+
+ protected:
+  // 获取可用实例集合对应的别名表缓存，不存在时构建
+  RandomLbCacheValue* GetCacheValue(ServiceInstances* service_instances);
+
  protected:
   bool enable_dynamic_weight_;
   Context* context_;
@@ -82,4 +115,16 @@ class RandomLoadBalancer : public LoadBalancer {
 
 }  // namespace polaris
 
+namespace std {
+
+template <>
+struct hash<polaris::RandomLbCacheKey> {
+  std::size_t operator()(const polaris::RandomLbCacheKey& key) const {
+    std::size_t seed = hash<polaris::InstancesSet*>()(key.prior_data_);
+    return polaris::HashCombine(seed, key.version_);
+  }
+};
+
+}  // namespace std
+
 #endif  //  POLARIS_CPP_POLARIS_PLUGIN_LOAD_BALANCER_WEIGHTED_RANDOM_H_
@@ -27,8 +27,12 @@
 #include "plugin/health_checker/http_detector.h"
 #include "plugin/health_checker/tcp_detector.h"
 #include "plugin/health_checker/udp_detector.h"
+#include "plugin/load_balancer/least_request.h"
 #include "plugin/load_balancer/locality_aware/locality_aware.h"
 #include "plugin/load_balancer/maglev/maglev.h"
+#include "plugin/load_balancer/peak_ewma.h"
+#include "plugin/load_balancer/rendezvous/rendezvous.h"
+#include "plugin/load_balancer/ringhash/bounded_load.h"
 #include "plugin/load_balancer/ringhash/l5_csthash.h"
 #include "plugin/load_balancer/ringhash/ringhash.h"
 #include "plugin/load_balancer/simple_hash.h"
@@ -85,6 +89,10 @@ Plugin* L5CstHashLoadBalancerFactory() { return new L5CstHashLoadBalancer(); }
 Plugin* SimpleHashLoadBalancerFactory() { return new SimpleHashLoadBalancer(); }
 Plugin* CMurmurHashLoadBalancerFactory() { return new L5CstHashLoadBalancer(true); }
 Plugin* LocalityAwareLoadBalancerFactory() { return new LocalityAwareLoadBalancer(); }
+Plugin* BoundedLoadHashLoadBalancerFactory() { return new BoundedLoadHashLoadBalancer(); }
+Plugin* LeastRequestLoadBalancerFactory() { return new LeastRequestLoadBalancer(); }
+Plugin* PeakEwmaLoadBalancerFactory() { return new PeakEwmaLoadBalancer(); }
+Plugin* RendezvousHashLoadBalancerFactory() { return new RendezvousHashLoadBalancer(); }
 Plugin* DefaultWeightAdjusterFactory() { return new DefaultWeightAdjuster(); }
 Plugin* SlowStartWeightAdjusterFactory() { return new SlowStartWeightAdjuster(); }
 
@@ -114,6 +122,10 @@ PluginManager::PluginManager() {
   RegisterPlugin(kLoadBalanceTypeSimpleHash, kPluginLoadBalancer, SimpleHashLoadBalancerFactory);
   RegisterPlugin(kLoadBalanceTypeLocalityAware, kPluginLoadBalancer, LocalityAwareLoadBalancerFactory);
   RegisterPlugin(kLoadBalanceTypeCMurmurHash, kPluginLoadBalancer, CMurmurHashLoadBalancerFactory);
+  RegisterPlugin(kLoadBalanceTypeBoundedLoadHash, kPluginLoadBalancer, BoundedLoadHashLoadBalancerFactory);
+  RegisterPlugin(kLoadBalanceTypeP2CLeastRequest, kPluginLoadBalancer, LeastRequestLoadBalancerFactory);
+  RegisterPlugin(kLoadBalanceTypePeakEwma, kPluginLoadBalancer, PeakEwmaLoadBalancerFactory);
+  RegisterPlugin(kLoadBalanceTypeRendezvousHash, kPluginLoadBalancer, RendezvousHashLoadBalancerFactory);
 
   RegisterPlugin(kPluginDefaultWeightAdjuster, kPluginWeightAdjuster, DefaultWeightAdjusterFactory);
   RegisterPlugin(kPluginSlowStartWeightAdjuster, kPluginWeightAdjuster, SlowStartWeightAdjusterFactory);
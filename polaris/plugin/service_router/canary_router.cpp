@@ -72,8 +72,7 @@ ReturnCode CanaryServiceRouter::DoRoute(RouteInfo& route_info, RouteResult* rout
   if (cache_value == nullptr) {
     cache_value = router_cache_->CreateOrGet(cache_key, [&] {
       InstancesSet* prior_result = cache_key.prior_data_;
-      std::set<Instance*> unhealthy_set;
-      route_info.CalculateUnhealthySet(unhealthy_set);
+      const InstancesBitset& unhealthy_set = route_info.GetUnhealthySet();
       std::vector<Instance*> result;
       bool recover_all = false;
       if (cache_key.canary_value_.empty()) {
@@ -99,7 +98,7 @@ ReturnCode CanaryServiceRouter::DoRoute(RouteInfo& route_info, RouteResult* rout
       return new_cache_value;
     });
   }
-  cache_value->current_data_->GetImpl()->count_++;
+  route_result->CountInstancesSet(cache_value->current_data_);
   service_instances->UpdateAvailableInstances(cache_value->current_data_);
   return kReturnOk;
 }
@@ -107,7 +106,7 @@ ReturnCode CanaryServiceRouter::DoRoute(RouteInfo& route_info, RouteResult* rout
 RouterStatData* CanaryServiceRouter::CollectStat() { return router_cache_->CollectStat(); }
 
 bool CanaryServiceRouter::CalculateResult(const std::vector<Instance*>& instances,
-                                          const std::set<Instance*>& unhealthy_set, std::vector<Instance*>& result) {
+                                          const InstancesBitset& unhealthy_set, std::vector<Instance*>& result) {
   std::vector<Instance*> select_healthy;
   std::vector<Instance*> select_unhealthy;
   std::vector<Instance*> other_healthy;
@@ -115,13 +114,13 @@ bool CanaryServiceRouter::CalculateResult(const std::vector<Instance*>& instance
   for (std::size_t i = 0; i < instances.size(); ++i) {
     Instance* const& instance = instances[i];
     if (instance->GetMetadata().count("canary") == 0) {
-      if (unhealthy_set.count(instance) == 0) {
+      if (!unhealthy_set.Contains(instance)) {
         select_healthy.push_back(instance);
       } else {
         select_unhealthy.push_back(instance);
       }
     } else {
-      if (unhealthy_set.count(instance) == 0) {
+      if (!unhealthy_set.Contains(instance)) {
         other_healthy.push_back(instance);
       } else {
         other_unhealthy.push_back(instance);
@@ -142,7 +141,7 @@ bool CanaryServiceRouter::CalculateResult(const std::vector<Instance*>& instance
 }
 
 bool CanaryServiceRouter::CalculateResult(const std::vector<Instance*>& instances, const std::string& canary_value,
-                                          const std::set<Instance*>& unhealthy_set, std::vector<Instance*>& result) {
+                                          const InstancesBitset& unhealthy_set, std::vector<Instance*>& result) {
   std::vector<Instance*> select_healthy;    // 选中的金丝雀健康节点
   std::vector<Instance*> select_unhealthy;  // 选中的金丝雀非健康节点
   std::vector<Instance*> normal_healthy;    // 非金丝雀健康节点
@@ -154,20 +153,20 @@ bool CanaryServiceRouter::CalculateResult(const std::vector<Instance*>& instance
     std::map<std::string, std::string>::const_iterator it = instance->GetMetadata().find("canary");
     if (it != instance->GetMetadata().end()) {
       if (it->second == canary_value) {
-        if (unhealthy_set.count(instance) == 0) {
+        if (!unhealthy_set.Contains(instance)) {
           select_healthy.push_back(instance);
         } else {
           select_unhealthy.push_back(instance);
         }
       } else {
-        if (unhealthy_set.count(instance) == 0) {
+        if (!unhealthy_set.Contains(instance)) {
           other_healthy.push_back(instance);
         } else {
           other_unhealthy.push_back(instance);
         }
       }
     } else {
-      if (unhealthy_set.count(instance) == 0) {
+      if (!unhealthy_set.Contains(instance)) {
         normal_healthy.push_back(instance);
       } else {
         normal_unhealthy.push_back(instance);
@@ -39,11 +39,11 @@ class CanaryServiceRouter : public ServiceRouter {
   virtual std::string Name();
 
  private:
-  bool CalculateResult(const std::vector<Instance*>& instances, const std::set<Instance*>& unhealthy_set,
+  bool CalculateResult(const std::vector<Instance*>& instances, const InstancesBitset& unhealthy_set,
                        std::vector<Instance*>& result);
 
   bool CalculateResult(const std::vector<Instance*>& instances, const std::string& canary_value,
-                       const std::set<Instance*>& unhealthy_set, std::vector<Instance*>& result);
+                       const InstancesBitset& unhealthy_set, std::vector<Instance*>& result);
 
  private:
   Context* context_;
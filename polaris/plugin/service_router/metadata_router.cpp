@@ -16,7 +16,6 @@
 #include <stddef.h>
 #include <map>
 #include <string>
-
 #include <utility>
 
 #include "cache/service_cache.h"
@@ -24,6 +23,7 @@
 #include "logger.h"
 #include "model/model_impl.h"
 #include "monitor/service_record.h"
+#include "plugin/load_balancer/hash/murmur.h"
 #include "polaris/context.h"
 #include "polaris/model.h"
 #include "utils/time_clock.h"
@@ -33,7 +33,7 @@ namespace polaris {
 
 class Config;
 
-MetadataServiceRouter::MetadataServiceRouter() : context_(nullptr), router_cache_(nullptr) {}
+MetadataServiceRouter::MetadataServiceRouter() : context_(nullptr), router_cache_(nullptr), index_cache_(nullptr) {}
 
 MetadataServiceRouter::~MetadataServiceRouter() {
   context_ = nullptr;
@@ -42,171 +42,229 @@ MetadataServiceRouter::~MetadataServiceRouter() {
     router_cache_->DecrementRef();
     router_cache_ = nullptr;
   }
+  if (index_cache_ != nullptr) {
+    index_cache_->SetClearHandler(0);
+    index_cache_->DecrementRef();
+    index_cache_ = nullptr;
+  }
 }
 
 ReturnCode MetadataServiceRouter::Init(Config* /*config*/, Context* context) {
   context_ = context;
   router_cache_ = new ServiceCache<MetadataCacheKey, RouterSubsetCache>();
   context->GetContextImpl()->RegisterCache(router_cache_);
+  index_cache_ = new ServiceCache<InstancesSet*, MetadataIndexCacheValue>();
+  context->GetContextImpl()->RegisterCache(index_cache_);
   return kReturnOk;
 }
 
 std::string MetadataServiceRouter::Name() { return "MetadataServiceRouter"; }
 
-static bool MetadataMatch(const std::map<std::string, std::string>& metadata,
-                          const std::map<std::string, std::string>& instance_metadata) {
-  if (metadata.size() > instance_metadata.size()) {
-    return false;
+MetadataIndex::MetadataIndex(const std::vector<Instance*>& instances, std::size_t dense_size)
+    : instances_(dense_size, nullptr), members_(dense_size) {
+  std::vector<std::size_t> counts;  // 统计每个取值匹配的实例数，决定使用位置列表还是位集合
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    uint32_t index = instances[i]->GetImpl().GetDenseIndex();
+    if (index >= dense_size) {
+      continue;
+    }
+    instances_[index] = instances[i];
+    members_.Set(index);
+    const std::map<std::string, std::string>& metadata = instances[i]->GetMetadata();
+    for (std::map<std::string, std::string>::const_iterator it = metadata.begin(); it != metadata.end(); ++it) {
+      KeyPosting& key_posting = keys_[it->first];
+      if (key_posting.bits_.Size() != dense_size) {
+        key_posting.bits_.Resize(dense_size);
+      }
+      key_posting.bits_.Set(index);
+      key_posting.values_[it->second].positions_.push_back(index);
+    }
   }
-  std::map<std::string, std::string>::const_iterator it;
-  std::map<std::string, std::string>::const_iterator instance_it;
-  for (it = metadata.begin(); it != metadata.end(); ++it) {
-    instance_it = instance_metadata.find(it->first);
-    if (instance_it == instance_metadata.end() || it->second != instance_it->second) {
-      return false;
+  // 位置列表每项32位，匹配实例超过实例数的1/32时位集合更小
+  for (std::unordered_map<std::string, KeyPosting>::iterator key_it = keys_.begin(); key_it != keys_.end();
+       ++key_it) {
+    std::unordered_map<std::string, ValuePosting>& values = key_it->second.values_;
+    for (std::unordered_map<std::string, ValuePosting>::iterator it = values.begin(); it != values.end(); ++it) {
+      ValuePosting& posting = it->second;
+      if (posting.positions_.size() * 32 >= dense_size) {
+        posting.bits_.Resize(dense_size);
+        for (std::size_t i = 0; i < posting.positions_.size(); ++i) {
+          posting.bits_.Set(posting.positions_[i]);
+        }
+        std::vector<uint32_t>().swap(posting.positions_);
+      }
     }
   }
-  return true;
 }
 
-bool MetadataServiceRouter::CalculateResult(const std::vector<Instance*>& instances,
-                                            const std::set<Instance*>& unhealthy_set,
-                                            const std::map<std::string, std::string>& metadata,
-                                            MetadataFailoverType failover_type, std::vector<Instance*>& result) {
-  std::vector<Instance*> unhealthy;
-  for (std::size_t i = 0; i < instances.size(); ++i) {
-    Instance* const& instance = instances[i];
-    if (MetadataMatch(metadata, instance->GetMetadata())) {
-      if (unhealthy_set.count(instance) == 0) {
-        result.push_back(instance);
+void MetadataIndex::Match(const std::map<std::string, std::string>& metadata, Bitset& result) const {
+  if (metadata.empty()) {
+    result = members_;
+    return;
+  }
+  result.Resize(instances_.size());
+  bool first = true;
+  Bitset filtered;
+  for (std::map<std::string, std::string>::const_iterator it = metadata.begin(); it != metadata.end(); ++it) {
+    std::unordered_map<std::string, KeyPosting>::const_iterator key_it = keys_.find(it->first);
+    if (key_it == keys_.end()) {
+      result.ResetAll();
+      return;
+    }
+    std::unordered_map<std::string, ValuePosting>::const_iterator value_it = key_it->second.values_.find(it->second);
+    if (value_it == key_it->second.values_.end()) {
+      result.ResetAll();
+      return;
+    }
+    const ValuePosting& posting = value_it->second;
+    if (posting.bits_.Size() > 0) {
+      if (first) {
+        result = posting.bits_;
       } else {
-        unhealthy.push_back(instance);
+        result &= posting.bits_;
       }
+    } else {
+      filtered.Resize(instances_.size());
+      for (std::size_t i = 0; i < posting.positions_.size(); ++i) {
+        if (first || result.Test(posting.positions_[i])) {
+          filtered.Set(posting.positions_[i]);
+        }
+      }
+      std::swap(result, filtered);
     }
+    first = false;
   }
-  if (!result.empty()) {
-    return false;
-  }
-  if (!unhealthy.empty()) {
-    result.swap(unhealthy);
-    return true;
-  }
-  if (failover_type == kMetadataFailoverAll) {
-    return FailoverAll(instances, unhealthy_set, result);
-  } else if (failover_type == kMetadataFailoverNotKey) {
-    return FailoverNotKey(instances, unhealthy_set, metadata, result);
-  }
-  return false;
 }
 
-bool MetadataServiceRouter::FailoverAll(const std::vector<Instance*>& instances,
-                                        const std::set<Instance*>& unhealthy_set, std::vector<Instance*>& result) {
-  std::vector<Instance*> unhealthy;
-  for (std::size_t i = 0; i < instances.size(); ++i) {
-    Instance* const& instance = instances[i];
-    if (unhealthy_set.count(instance) == 0) {
-      result.push_back(instance);
-    } else {
-      unhealthy.push_back(instance);
+void MetadataIndex::MatchNotKey(const std::map<std::string, std::string>& metadata, Bitset& result) const {
+  result = members_;
+  for (std::map<std::string, std::string>::const_iterator it = metadata.begin(); it != metadata.end(); ++it) {
+    std::unordered_map<std::string, KeyPosting>::const_iterator key_it = keys_.find(it->first);
+    if (key_it != keys_.end()) {
+      result.AndNot(key_it->second.bits_);
     }
   }
-  if (!result.empty()) {
-    return false;
-  }
-  if (!unhealthy.empty()) {
-    result.swap(unhealthy);
-    return true;
-  }
-  return false;
 }
 
-static bool MetadataMatchNotKey(const std::map<std::string, std::string>& metadata,
-                                const std::map<std::string, std::string>& instance_metadata) {
-  if (instance_metadata.empty()) {
-    return true;
-  }
-  std::map<std::string, std::string>::const_iterator it;
-  for (it = metadata.begin(); it != metadata.end(); ++it) {
-    if (instance_metadata.count(it->first) != 0) {
-      return false;
-    }
+MetadataIndexCacheValue::MetadataIndexCacheValue(InstancesSet* prior_data, std::size_t dense_size)
+    : prior_data_(prior_data), index_(prior_data->GetInstances(), dense_size) {
+  prior_data_->IncrementRef();
+}
+
+MetadataIndexCacheValue::~MetadataIndexCacheValue() {
+  prior_data_->DecrementRef();
+  prior_data_ = nullptr;
+}
+
+// 优先选择匹配的健康实例，没有健康实例时选择匹配的不健康实例并设置全死全活，没有匹配的实例返回false
+static bool SelectInstances(const MetadataIndex& index, const Bitset& matched, const Bitset& unhealthy,
+                            std::vector<Instance*>& result, bool& recover_all) {
+  Bitset healthy = matched;
+  healthy.AndNot(unhealthy);
+  recover_all = !healthy.Any();
+  const Bitset& selected = recover_all ? matched : healthy;
+  for (std::size_t i = selected.FindFirst(); i < selected.Size(); i = selected.FindNext(i + 1)) {
+    result.push_back(index.GetInstance(i));
   }
-  return true;
+  return !result.empty();
 }
 
-bool MetadataServiceRouter::FailoverNotKey(const std::vector<Instance*>& instances,
-                                           const std::set<Instance*>& unhealthy_set,
-                                           const std::map<std::string, std::string>& metadata,
-                                           std::vector<Instance*>& result) {
-  std::vector<Instance*> unhealthy;
-  for (std::size_t i = 0; i < instances.size(); ++i) {
-    Instance* const& instance = instances[i];
-    if (MetadataMatchNotKey(metadata, instance->GetMetadata())) {
-      if (unhealthy_set.count(instance) == 0) {
-        result.push_back(instance);
-      } else {
-        unhealthy.push_back(instance);
-      }
-    }
+bool MetadataServiceRouter::CalculateResult(const MetadataIndex& index, const InstancesBitset& unhealthy_set,
+                                            const std::map<std::string, std::string>& metadata,
+                                            MetadataFailoverType failover_type, std::vector<Instance*>& result) {
+  const Bitset& unhealthy = unhealthy_set.GetBits();
+  Bitset matched;
+  index.Match(metadata, matched);
+  bool recover_all = false;
+  if (SelectInstances(index, matched, unhealthy, result, recover_all)) {
+    return recover_all;
   }
-  if (!result.empty()) {
+  if (failover_type == kMetadataFailoverAll) {
+    index.Match(std::map<std::string, std::string>(), matched);
+  } else if (failover_type == kMetadataFailoverNotKey) {
+    index.MatchNotKey(metadata, matched);
+  } else {
     return false;
   }
-  if (!unhealthy.empty()) {
-    result.swap(unhealthy);
-    return true;
+  return SelectInstances(index, matched, unhealthy, result, recover_all) && recover_all;
+}
+
+MetadataIndexCacheValue* MetadataServiceRouter::GetMetadataIndex(InstancesSet* instances_set,
+                                                                 std::size_t dense_size) {
+  MetadataIndexCacheValue* index_value = index_cache_->GetWithRcuTime(instances_set);
+  if (index_value == nullptr) {
+    index_value = index_cache_->CreateOrGet(instances_set,
+                                            [=] { return new MetadataIndexCacheValue(instances_set, dense_size); });
   }
-  return false;
+  return index_value;
+}
+
+uint64_t MetadataServiceRouter::MetadataFingerprint(const std::map<std::string, std::string>& metadata,
+                                                    uint32_t seed) {
+  uint64_t fingerprint = Murmur3_64(&seed, sizeof(seed), seed);
+  for (std::map<std::string, std::string>::const_iterator it = metadata.begin(); it != metadata.end(); ++it) {
+    fingerprint = HashCombine(fingerprint, Murmur3_64(it->first.data(), it->first.size(), seed));
+    fingerprint = HashCombine(fingerprint, Murmur3_64(it->second.data(), it->second.size(), seed));
+  }
+  return fingerprint;
 }
 
 ReturnCode MetadataServiceRouter::DoRoute(RouteInfo& route_info, RouteResult* route_result) {
   // 优先查询缓存
-  MetadataCacheKey cache_key;
+  const std::map<std::string, std::string>& metadata = route_info.GetMetadata();
   ServiceInstances* service_instances = route_info.GetServiceInstances();
+  MetadataCacheKey cache_key;
   cache_key.prior_data_ = service_instances->GetAvailableInstances();
   cache_key.circuit_breaker_version_ = route_info.GetCircuitBreakerVersion();
-  cache_key.failover_type_ = kMetadataFailoverNone;
-  if (!route_info.GetMetadata().empty()) {
-    cache_key.metadata_ = route_info.GetMetadata();
-    cache_key.failover_type_ = route_info.GetMetadataFailoverType();
-  }
+  cache_key.failover_type_ = metadata.empty() ? kMetadataFailoverNone : route_info.GetMetadataFailoverType();
 
-  RouterSubsetCache* cache_value = router_cache_->GetWithRcuTime(cache_key);
-  if (cache_value == nullptr) {
-    cache_value = router_cache_->CreateOrGet(cache_key, [&] {
-      // 出现 metadata cache 需要执行 create 时进行打印相关辅助信息日志
-      std::string metadata_str_ = "";
-      for (std::map<std::string, std::string>::iterator it = cache_key.metadata_.begin();
-           it != cache_key.metadata_.end(); it++) {
-        metadata_str_ += it->first + ":" + it->second + ",";
-      }
-      POLARIS_LOG(LOG_DEBUG,
-                  "ns(%s) svc(%s) metadata(%s) failover_type(%d) circuitbreaker_version(%" PRIu64
-                  ") router_cache run create action",
+  // 缓存Key只包含元数据指纹，命中后校验结果对应的元数据，指纹冲突时换下一个种子重新计算指纹
+  RouterSubsetCache* cache_value = nullptr;
+  for (uint32_t seed = 0; cache_value == nullptr; ++seed) {
+    cache_key.metadata_fingerprint_ = MetadataFingerprint(metadata, seed);
+    cache_value = router_cache_->GetWithRcuTime(cache_key);
+    if (cache_value == nullptr) {
+      cache_value = router_cache_->CreateOrGet(cache_key, [&] {
+        // 出现 metadata cache 需要执行 create 时进行打印相关辅助信息日志
+        std::string metadata_str_ = "";
+        for (std::map<std::string, std::string>::const_iterator it = metadata.begin(); it != metadata.end(); it++) {
+          metadata_str_ += it->first + ":" + it->second + ",";
+        }
+        POLARIS_LOG(LOG_DEBUG,
+                    "ns(%s) svc(%s) metadata(%s) failover_type(%d) circuitbreaker_version(%" PRIu64
+                    ") router_cache run create action",
+                    route_info.GetServiceKey().namespace_.c_str(), route_info.GetServiceKey().name_.c_str(),
+                    metadata_str_.c_str(), cache_key.failover_type_, cache_key.circuit_breaker_version_);
+        InstancesSet* prior_result = cache_key.prior_data_;
+        const InstancesBitset& unhealthy_set = route_info.GetUnhealthySet();
+        std::vector<Instance*> result;
+        InstancesData* instances_data = service_instances->GetServiceData()->GetServiceDataImpl()->GetInstancesData();
+        std::size_t dense_size = instances_data->dense_size_;
+        bool recover_all = CalculateResult(GetMetadataIndex(prior_result, dense_size)->index_, unhealthy_set,
+                                           metadata, cache_key.failover_type_, result);
+
+        RouterSubsetCache* new_cache_value = new RouterSubsetCache();
+        new_cache_value->instances_data_ = service_instances->GetServiceData();
+        new_cache_value->instances_data_->IncrementRef();
+        new_cache_value->current_data_ = new InstancesSet(result, metadata);
+        route_result->SetNewInstancesSet();
+        if (prior_result->GetImpl()->UpdateRecoverAll(recover_all)) {
+          const ServiceKey& service_key = service_instances->GetServiceData()->GetServiceKey();
+          context_->GetContextImpl()->GetServiceRecord()->InstanceRecoverAll(
+              service_key, new RecoverAllRecord(Time::GetSystemTimeMs(), "metadata router", recover_all));
+        }
+        return new_cache_value;
+      });
+    }
+    if (cache_value->current_data_->GetSubset() != metadata) {
+      POLARIS_LOG(LOG_WARN, "ns(%s) svc(%s) metadata fingerprint %" PRIu64 " conflict with seed %u",
                   route_info.GetServiceKey().namespace_.c_str(), route_info.GetServiceKey().name_.c_str(),
-                  metadata_str_.c_str(), cache_key.failover_type_, cache_key.circuit_breaker_version_);
-      InstancesSet* prior_result = cache_key.prior_data_;
-      std::set<Instance*> unhealthy_set;
-      route_info.CalculateUnhealthySet(unhealthy_set);
-      std::vector<Instance*> result;
-      bool recover_all = CalculateResult(prior_result->GetInstances(), unhealthy_set, cache_key.metadata_,
-                                         cache_key.failover_type_, result);
-
-      RouterSubsetCache* new_cache_value = new RouterSubsetCache();
-      new_cache_value->instances_data_ = service_instances->GetServiceData();
-      new_cache_value->instances_data_->IncrementRef();
-      new_cache_value->current_data_ = new InstancesSet(result, cache_key.metadata_);
-      route_result->SetNewInstancesSet();
-      if (prior_result->GetImpl()->UpdateRecoverAll(recover_all)) {
-        const ServiceKey& service_key = service_instances->GetServiceData()->GetServiceKey();
-        context_->GetContextImpl()->GetServiceRecord()->InstanceRecoverAll(
-            service_key, new RecoverAllRecord(Time::GetSystemTimeMs(), "metadata router", recover_all));
-      }
-      return new_cache_value;
-    });
+                  cache_key.metadata_fingerprint_, seed);
+      cache_value = nullptr;
+    }
   }
-  if (!route_info.GetMetadata().empty()) {
-    cache_value->current_data_->GetImpl()->count_++;
+  if (!metadata.empty()) {
+    route_result->CountInstancesSet(cache_value->current_data_);
   }
   service_instances->UpdateAvailableInstances(cache_value->current_data_);
   return kReturnOk;
@@ -14,16 +14,65 @@
 #ifndef POLARIS_CPP_POLARIS_PLUGIN_SERVICE_ROUTER_METADATA_ROUTER_H_
 #define POLARIS_CPP_POLARIS_PLUGIN_SERVICE_ROUTER_METADATA_ROUTER_H_
 
+#include <stdint.h>
+
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "cache/service_cache.h"
 #include "plugin/service_router/service_router.h"
+#include "utils/bitset.h"
 
 namespace polaris {
 
+// 实例元数据倒排索引，与熔断状态无关，每个实例集合只需构建一次
+// 每个元数据键值对映射到包含该键值对的实例稠密下标集合，过滤时直接与不健康实例集合做按字运算
+class MetadataIndex {
+ public:
+  // dense_size 为实例所属服务实例数据的稠密下标数量
+  MetadataIndex(const std::vector<Instance*>& instances, std::size_t dense_size);
+
+  // 按稠密下标取索引中的实例
+  Instance* GetInstance(std::size_t dense_index) const { return instances_[dense_index]; }
+
+  // 计算元数据全部匹配的实例，元数据为空时匹配所有实例
+  void Match(const std::map<std::string, std::string>& metadata, Bitset& result) const;
+
+  // 计算不包含任何请求元数据key的实例，没有元数据的实例总是匹配
+  void MatchNotKey(const std::map<std::string, std::string>& metadata, Bitset& result) const;
+
+ private:
+  // 匹配实例较少的键值对只保存位置列表，避免每个取值都占用实例数大小的位集合
+  struct ValuePosting {
+    std::vector<uint32_t> positions_;
+    Bitset bits_;  // 只在匹配实例较多时构建
+  };
+
+  struct KeyPosting {
+    Bitset bits_;  // 包含该key的实例
+    std::unordered_map<std::string, ValuePosting> values_;
+  };
+
+  std::vector<Instance*> instances_;  // 按稠密下标存放，不在实例集合中的下标为NULL
+  Bitset members_;                    // 实例集合中的实例
+  std::unordered_map<std::string, KeyPosting> keys_;
+};
+
+// 元数据路由倒排索引缓存
+class MetadataIndexCacheValue : public ServiceBase {
+ public:
+  MetadataIndexCacheValue(InstancesSet* prior_data, std::size_t dense_size);
+
+  virtual ~MetadataIndexCacheValue();
+
+ public:
+  InstancesSet* prior_data_;  // 保证索引中的实例不被释放
+  MetadataIndex index_;
+};
+
 // 就近路由的实现
 class MetadataServiceRouter : public ServiceRouter {
  public:
@@ -40,19 +89,19 @@ class MetadataServiceRouter : public ServiceRouter {
   virtual std::string Name();
 
  private:
-  bool CalculateResult(const std::vector<Instance*>& instances, const std::set<Instance*>& unhealthy_set,
+  bool CalculateResult(const MetadataIndex& index, const InstancesBitset& unhealthy_set,
                        const std::map<std::string, std::string>& metadata, MetadataFailoverType failover_type,
                        std::vector<Instance*>& result);
 
-  bool FailoverAll(const std::vector<Instance*>& instances, const std::set<Instance*>& unhealthy_set,
-                   std::vector<Instance*>& result);
+  // 获取实例集合的元数据索引，不存在时构建
+  MetadataIndexCacheValue* GetMetadataIndex(InstancesSet* instances_set, std::size_t dense_size);
 
-  bool FailoverNotKey(const std::vector<Instance*>& instances, const std::set<Instance*>& unhealthy_set,
-                      const std::map<std::string, std::string>& metadata, std::vector<Instance*>& result);
+  static uint64_t MetadataFingerprint(const std::map<std::string, std::string>& metadata, uint32_t seed);
 
  private:
   Context* context_;
-  ServiceCache<MetadataCacheKey, RouterSubsetCache>* router_cache_;  // 路由结果缓存
+  ServiceCache<MetadataCacheKey, RouterSubsetCache>* router_cache_;       // 路由结果缓存
+  ServiceCache<InstancesSet*, MetadataIndexCacheValue>* index_cache_;  // 元数据索引缓存，熔断状态变化时复用
 };
 
 }  // namespace polaris
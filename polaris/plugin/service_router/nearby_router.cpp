@@ -16,6 +16,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <memory>
 
 #include "cache/service_cache.h"
@@ -130,39 +131,139 @@ bool NearbyRouterConfig::InitRecoverConfig(Config* config) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+NearbyLocationIndex::NearbyLocationIndex(const std::vector<Instance*>& instances) {
+  struct LocatedInstance {
+    uint32_t path_[kNearbyMatchCampus];  // 各级位置所在的分桶下标
+    uint32_t index_;
+  };
+  std::vector<LocatedInstance> located_instances(instances.size());
+  buckets_.resize(1);
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    const std::string* names[kNearbyMatchCampus] = {&instances[i]->GetRegion(), &instances[i]->GetZone(),
+                                                    &instances[i]->GetCampus()};
+    uint32_t bucket = 0;
+    for (int level = 0; level < kNearbyMatchCampus; ++level) {
+      uint32_t new_bucket = static_cast<uint32_t>(buckets_.size());
+      std::pair<std::unordered_map<std::string, uint32_t>::iterator, bool> result =
+          buckets_[bucket].children_.insert(std::make_pair(*names[level], new_bucket));
+      if (result.second) {
+        buckets_.resize(buckets_.size() + 1);  // 会使引用失效，之后只通过下标访问
+      }
+      bucket = result.first->second;
+      located_instances[i].path_[level] = bucket;
+    }
+    located_instances[i].index_ = static_cast<uint32_t>(i);
+  }
+  // 下级分桶只属于一个上级分桶，按各级分桶下标排序即可使每个分桶的实例连续，相同位置的实例保持原有顺序
+  std::sort(located_instances.begin(), located_instances.end(),
+            [](const LocatedInstance& lhs, const LocatedInstance& rhs) {
+              for (int level = 0; level < kNearbyMatchCampus; ++level) {
+                if (lhs.path_[level] != rhs.path_[level]) {
+                  return lhs.path_[level] < rhs.path_[level];
+                }
+              }
+              return lhs.index_ < rhs.index_;
+            });
+  instances_.resize(instances.size());
+  indexes_.resize(instances.size());
+  for (std::size_t i = 0; i < buckets_.size(); ++i) {
+    buckets_[i].begin_ = static_cast<uint32_t>(instances.size());
+    buckets_[i].end_ = 0;
+  }
+  buckets_[0].begin_ = 0;
+  buckets_[0].end_ = static_cast<uint32_t>(instances.size());
+  for (std::size_t i = 0; i < located_instances.size(); ++i) {
+    instances_[i] = instances[located_instances[i].index_];
+    indexes_[i] = located_instances[i].index_;
+    for (int level = 0; level < kNearbyMatchCampus; ++level) {
+      LocationBucket& bucket = buckets_[located_instances[i].path_[level]];
+      bucket.begin_ = std::min(bucket.begin_, static_cast<uint32_t>(i));
+      bucket.end_ = static_cast<uint32_t>(i + 1);
+    }
+  }
+}
+
+void NearbyLocationIndex::Lookup(const Location& location, int match_level, std::size_t* begin,
+                                 std::size_t* end) const {
+  const std::string* names[kNearbyMatchCampus] = {&location.region, &location.zone, &location.campus};
+  begin[0] = buckets_[0].begin_;
+  end[0] = buckets_[0].end_;
+  const LocationBucket* bucket = &buckets_[0];
+  for (int level = 1; level <= match_level; ++level) {
+    if (bucket != nullptr) {
+      std::unordered_map<std::string, uint32_t>::const_iterator it = bucket->children_.find(*names[level - 1]);
+      bucket = it != bucket->children_.end() ? &buckets_[it->second] : nullptr;
+    }
+    if (bucket != nullptr) {
+      begin[level] = bucket->begin_;
+      end[level] = bucket->end_;
+    } else {  // 本级别或更低级别不匹配，区间为空
+      begin[level] = end[level] = begin[level - 1];
+    }
+  }
+  begin[match_level + 1] = end[match_level + 1] = begin[match_level];
+}
+
+NearbyIndexCacheValue::NearbyIndexCacheValue(InstancesSet* prior_data)
+    : prior_data_(prior_data), index_(prior_data->GetInstances()) {
+  prior_data_->IncrementRef();
+}
+
+NearbyIndexCacheValue::~NearbyIndexCacheValue() {
+  prior_data_->DecrementRef();
+  prior_data_ = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 NearbyRouterCluster::NearbyRouterCluster(const NearbyRouterConfig& nearby_router_config)
     : config_(nearby_router_config) {
   data_.resize(config_.GetMatchLevel() + 1);
 }
 
-void NearbyRouterCluster::CalculateSet(const Location& location, const std::vector<Instance*>& instances,
-                                       const std::set<Instance*>& unhealthy_set) {
-  for (std::size_t i = 0; i < instances.size(); ++i) {
-    Instance* const& instance = instances[i];
-    uint32_t level = 0;
-    if (config_.GetMatchLevel() >= kNearbyMatchRegion && location.region == instance->GetRegion()) {
-      ++level;
-      if (config_.GetMatchLevel() >= kNearbyMatchZone && location.zone == instance->GetZone()) {
-        ++level;
-        if (config_.GetMatchLevel() >= kNearbyMatchCampus && location.campus == instance->GetCampus()) {
-          ++level;
-        }
-      }
+void NearbyRouterCluster::CalculateSet(const Location& location, const NearbyLocationIndex& index,
+                                       const InstancesBitset& unhealthy_set) {
+  std::size_t begin[kNearbyMatchCampus + 2];
+  std::size_t end[kNearbyMatchCampus + 2];
+  index.Lookup(location, config_.GetMatchLevel(), begin, end);
+  const std::vector<Instance*>& instances = index.GetInstances();
+  const std::vector<uint32_t>& indexes = index.GetIndexes();
+  std::vector<std::size_t> positions;
+  // 每个级别的实例为本级别区间去掉高一级别的区间，即区间两侧的部分
+  for (int level = config_.GetMatchLevel(); level >= config_.GetMaxMatchLevel(); --level) {
+    positions.clear();
+    for (std::size_t i = begin[level]; i < begin[level + 1]; ++i) {
+      positions.push_back(i);
     }
-    if (unhealthy_set.find(instance) == unhealthy_set.end()) {
-      data_[level].healthy_.push_back(instance);
+    for (std::size_t i = end[level + 1]; i < end[level]; ++i) {
+      positions.push_back(i);
+    }
+    // 区间内的实例按位置排序，需按传入顺序输出，与逐个实例匹配位置的结果保持一致
+    std::sort(positions.begin(), positions.end(),
+              [&indexes](std::size_t lhs, std::size_t rhs) { return indexes[lhs] < indexes[rhs]; });
+    AddInstances(instances, positions, unhealthy_set, data_[level]);
+  }
+}
+
+void NearbyRouterCluster::AddInstances(const std::vector<Instance*>& instances,
+                                       const std::vector<std::size_t>& positions, const InstancesBitset& unhealthy_set,
+                                       NearbyRouterSet& router_set) {
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    Instance* instance = instances[positions[i]];
+    if (!unhealthy_set.Contains(instance)) {
+      router_set.healthy_.push_back(instance);
     } else {
-      data_[level].unhealthy_.push_back(instance);
+      router_set.unhealthy_.push_back(instance);
     }
   }
 }
 
 void NearbyRouterCluster::CalculateSet(const std::vector<Instance*>& instances,
-                                       const std::set<Instance*>& unhealthy_set) {
+                                       const InstancesBitset& unhealthy_set) {
   uint32_t level = config_.GetMatchLevel();
   for (std::size_t i = 0; i < instances.size(); ++i) {
     Instance* const& instance = instances[i];
-    if (unhealthy_set.find(instance) == unhealthy_set.end()) {
+    if (!unhealthy_set.Contains(instance)) {
       data_[level].healthy_.push_back(instance);
     } else {
       data_[level].unhealthy_.push_back(instance);
@@ -216,7 +317,7 @@ bool NearbyRouterCluster::CalculateResult(std::vector<Instance*>& result, int& m
   return match_level != config_.GetMatchLevel();
 }
 
-NearbyServiceRouter::NearbyServiceRouter() : context_(nullptr), router_cache_(nullptr) {}
+NearbyServiceRouter::NearbyServiceRouter() : context_(nullptr), router_cache_(nullptr), index_cache_(nullptr) {}
 
 NearbyServiceRouter::~NearbyServiceRouter() {
   context_ = nullptr;
@@ -225,6 +326,11 @@ NearbyServiceRouter::~NearbyServiceRouter() {
     router_cache_->DecrementRef();
     router_cache_ = nullptr;
   }
+  if (index_cache_ != nullptr) {
+    index_cache_->SetClearHandler(0);
+    index_cache_->DecrementRef();
+    index_cache_ = nullptr;
+  }
 }
 
 ReturnCode NearbyServiceRouter::Init(Config* config, Context* context) {
@@ -239,6 +345,8 @@ ReturnCode NearbyServiceRouter::Init(Config* config, Context* context) {
   }
   router_cache_ = new ServiceCache<NearbyCacheKey, RouterSubsetCache>();
   context->GetContextImpl()->RegisterCache(router_cache_);
+  index_cache_ = new ServiceCache<InstancesSet*, NearbyIndexCacheValue>();
+  context->GetContextImpl()->RegisterCache(index_cache_);
   return kReturnOk;
 }
 
@@ -282,6 +390,15 @@ void NearbyServiceRouter::GetLocationByMatchLevel(const Location& location, int
   }
 }
 
+NearbyIndexCacheValue* NearbyServiceRouter::GetLocationIndex(InstancesSet* instances_set) {
+  NearbyIndexCacheValue* index_value = index_cache_->GetWithRcuTime(instances_set);
+  if (index_value == nullptr) {
+    index_value =
+        index_cache_->CreateOrGet(instances_set, [=] { return new NearbyIndexCacheValue(instances_set); });
+  }
+  return index_value;
+}
+
 ReturnCode NearbyServiceRouter::DoRoute(RouteInfo& route_info, RouteResult* route_result) {
   if (route_info.IsNearbyRouterDisable()) {
     return kReturnOk;
@@ -304,15 +421,14 @@ ReturnCode NearbyServiceRouter::DoRoute(RouteInfo& route_info, RouteResult* rout
   if (cache_value == nullptr) {
     cache_value = router_cache_->CreateOrGet(cache_key, [&] {
       InstancesSet* prior_result = cache_key.prior_data_;
-      std::set<Instance*> unhealthy_set;
-      route_info.CalculateUnhealthySet(unhealthy_set);
+      const InstancesBitset& unhealthy_set = route_info.GetUnhealthySet();
       NearbyRouterCluster nearby_cluster(nearby_router_config_);
       Location location;
       uint32_t location_version;
       context_impl->GetClientLocation().GetLocation(location, location_version);
       if (service_instances->IsNearbyEnable()) {
         cache_key.location_version_ = location_version;  // 更新key中的version
-        nearby_cluster.CalculateSet(location, prior_result->GetInstances(), unhealthy_set);
+        nearby_cluster.CalculateSet(location, GetLocationIndex(prior_result)->index_, unhealthy_set);
       } else {
         location_version = 0;  // 就近未开启，更新version用于发生全死全活的时候上报
         nearby_cluster.CalculateSet(prior_result->GetInstances(), unhealthy_set);
@@ -345,7 +461,7 @@ ReturnCode NearbyServiceRouter::DoRoute(RouteInfo& route_info, RouteResult* rout
     });
   }
   if (service_instances->IsNearbyEnable()) {
-    cache_value->current_data_->GetImpl()->count_++;
+    route_result->CountInstancesSet(cache_value->current_data_);
   }
   service_instances->UpdateAvailableInstances(cache_value->current_data_);
   return kReturnOk;
@@ -14,8 +14,11 @@
 #ifndef POLARIS_CPP_POLARIS_PLUGIN_SERVICE_ROUTER_NEARBY_ROUTER_H_
 #define POLARIS_CPP_POLARIS_PLUGIN_SERVICE_ROUTER_NEARBY_ROUTER_H_
 
+#include <stdint.h>
+
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "cache/service_cache.h"
@@ -74,6 +77,44 @@ class NearbyRouterConfig {
   bool enable_recover_all_;                   // 是否允许全死全活
 };
 
+// 按位置分桶的实例索引，与熔断状态无关，每个实例集合只需构建一次
+// 实例按 region、zone、campus 排序后存放，同一位置的实例连续存放，每个位置对应排序后实例的一个区间
+class NearbyLocationIndex {
+ public:
+  explicit NearbyLocationIndex(const std::vector<Instance*>& instances);
+
+  // 查找位置在各就近级别匹配的实例区间[begin[level], end[level])，高级别区间包含在低级别区间中
+  // begin和end长度至少为 match_level + 2，最后一个为空区间，便于按级别求区间差
+  void Lookup(const Location& location, int match_level, std::size_t* begin, std::size_t* end) const;
+
+  const std::vector<Instance*>& GetInstances() const { return instances_; }
+
+  const std::vector<uint32_t>& GetIndexes() const { return indexes_; }
+
+ private:
+  struct LocationBucket {
+    uint32_t begin_;
+    uint32_t end_;
+    std::unordered_map<std::string, uint32_t> children_;  // 下一级位置名到分桶下标
+  };
+
+  std::vector<Instance*> instances_;     // 按位置排序后的实例
+  std::vector<uint32_t> indexes_;        // 排序后的实例在传入实例中的下标
+  std::vector<LocationBucket> buckets_;  // 第一个为包含所有实例的根分桶
+};
+
+// 就近路由位置索引缓存
+class NearbyIndexCacheValue : public ServiceBase {
+ public:
+  explicit NearbyIndexCacheValue(InstancesSet* prior_data);
+
+  virtual ~NearbyIndexCacheValue();
+
+ public:
+  InstancesSet* prior_data_;  // 保证索引中的实例不被释放
+  NearbyLocationIndex index_;
+};
+
 // 用于存储就近级别匹配结果
 struct NearbyRouterSet {
   std::vector<Instance*> healthy_;    // 就近级别匹配到的健康实例
@@ -85,18 +126,22 @@ class NearbyRouterCluster {
  public:
   explicit NearbyRouterCluster(const NearbyRouterConfig& nearby_router_config);
 
-  // 通过位置信息按就近级别计算就近结果
-  void CalculateSet(const Location& location, const std::vector<Instance*>& instances,
-                    const std::set<Instance*>& unhealthy_set);
+  // 通过位置索引查找各就近级别的实例，再按健康状态分组。低于最大降级级别的实例不会被使用，不做计算
+  void CalculateSet(const Location& location, const NearbyLocationIndex& index,
+                    const InstancesBitset& unhealthy_set);
 
   // 直接将实例按健康和不健康分到同一个就近级别
-  void CalculateSet(const std::vector<Instance*>& instances, const std::set<Instance*>& unhealthy_set);
+  void CalculateSet(const std::vector<Instance*>& instances, const InstancesBitset& unhealthy_set);
 
   // 按照就近级别计算最终结果，并返回是否降级
   bool CalculateResult(std::vector<Instance*>& result, int& match_level);
 
  private:
   friend class NearbyRouterClusterTest_CalculateLocation_Test;
+  friend class NearbyRouterClusterTest_CalculateSetKeepInstanceOrder_Test;
+
+  static void AddInstances(const std::vector<Instance*>& instances, const std::vector<std::size_t>& positions,
+                           const InstancesBitset& unhealthy_set, NearbyRouterSet& router_set);
 
   const NearbyRouterConfig& config_;   // 就近配置
   std::vector<NearbyRouterSet> data_;  // 就近匹配中间结果
@@ -123,10 +168,14 @@ class NearbyServiceRouter : public ServiceRouter {
   static void GetLocationByMatchLevel(const Location& location, int match_level, std::string& level_key,
                                       std::string& level_value);
 
+  // 获取实例集合的位置索引，不存在时构建
+  NearbyIndexCacheValue* GetLocationIndex(InstancesSet* instances_set);
+
  private:
   NearbyRouterConfig nearby_router_config_;  // 就近路由配置
   Context* context_;
   ServiceCache<NearbyCacheKey, RouterSubsetCache>* router_cache_;  // 路由结果缓存
+  ServiceCache<InstancesSet*, NearbyIndexCacheValue>* index_cache_;  // 位置索引缓存，熔断状态变化时复用
 };
 
 }  // namespace polaris
@@ -13,8 +13,10 @@
 
 #include "plugin/service_router/route_info.h"
 
+#include "cache/service_cache.h"
 #include "logger.h"
 #include "model/constants.h"
+#include "model/model_impl.h"
 #include "model/requests.h"
 
 namespace polaris {
@@ -29,8 +31,11 @@ RouteInfo::RouteInfo(const ServiceKey& service_key, ServiceInfo* source_service_
       request_flag_(0),
       nearby_disable_(false),
       labels_(nullptr),
+      labels_str_(nullptr),
       metadata_param_(nullptr),
-      circuit_breaker_version_(0) {}
+      circuit_breaker_version_(0),
+      reusable_data_(nullptr),
+      unhealthy_set_ready_(false) {}
 
 RouteInfo::RouteInfo(const ServiceKey& service_key, ServiceInfo* source_service_info, ServiceData* source_service_data)
     : service_key_(service_key),
@@ -42,16 +47,23 @@ RouteInfo::RouteInfo(const ServiceKey& service_key, ServiceInfo* source_service_
       request_flag_(0),
       nearby_disable_(false),
       labels_(nullptr),
+      labels_str_(nullptr),
       metadata_param_(nullptr),
-      circuit_breaker_version_(0) {}
+      circuit_breaker_version_(0),
+      reusable_data_(nullptr),
+      unhealthy_set_ready_(false) {}
 
 RouteInfo::~RouteInfo() {
   if (service_instances_ != nullptr) {
-    delete service_instances_;
+    if (reusable_data_ == nullptr || !reusable_data_->IsReused(service_instances_)) {
+      delete service_instances_;
+    }
     service_instances_ = nullptr;
   }
   if (service_route_rule_ != nullptr) {
-    delete service_route_rule_;
+    if (reusable_data_ == nullptr || !reusable_data_->IsReused(service_route_rule_)) {
+      delete service_route_rule_;
+    }
     service_route_rule_ = nullptr;
   }
   if (source_service_route_rule_ != nullptr) {
@@ -78,6 +90,16 @@ const std::map<std::string, std::string>& RouteInfo::GetLabels() const {
   return labels_ != nullptr ? *labels_ : constants::EmptyStringMap();
 }
 
+void RouteInfo::GetLabelsStr(std::string& labels_str) const {
+  if (labels_str_ != nullptr) {
+    labels_str = *labels_str_;
+    return;
+  }
+  Labels labels;
+  labels.labels_ = GetLabels();
+  labels_str = labels.GetLabelStr();
+}
+
 void RouteInfo::SetMetadataPara(const MetadataRouterParam& metadata_param) { metadata_param_ = &metadata_param; }
 
 const std::map<std::string, std::string>& RouteInfo::GetMetadata() const {
@@ -108,25 +130,33 @@ const std::string* RouteInfo::GetCanaryName() const {
   return nullptr;
 }
 
-void RouteInfo::CalculateUnhealthySet(std::set<Instance*>& unhealthy_set) {
+const InstancesBitset& RouteInfo::GetUnhealthySet() {
+  if (unhealthy_set_ready_) {
+    return unhealthy_set_;
+  }
+  unhealthy_set_ready_ = true;
+  InstancesData* instances_data = service_instances_->GetServiceData()->GetServiceDataImpl()->GetInstancesData();
   if (!IsIncludeUnhealthyInstances()) {
-    unhealthy_set = service_instances_->GetUnhealthyInstances();
+    unhealthy_set_ = instances_data->unhealthy_bitset_;
+  } else {
+    unhealthy_set_.Resize(instances_data->dense_size_);
   }
-  std::map<std::string, Instance*>& instances = service_instances_->GetInstances();
   if (!IsIncludeCircuitBreakerInstances()) {
     if (service_instances_->GetService() == nullptr) {
       POLARIS_LOG(LOG_ERROR, "Service member of %s:%s is null", service_key_.namespace_.c_str(),
                   service_key_.name_.c_str());
-      return;
+      return unhealthy_set_;
     }
+    std::map<std::string, Instance*>& instances = instances_data->instances_map_;
     std::set<std::string> circuit_breaker_set = service_instances_->GetService()->GetCircuitBreakerOpenInstances();
     for (std::set<std::string>::iterator it = circuit_breaker_set.begin(); it != circuit_breaker_set.end(); ++it) {
       std::map<std::string, Instance*>::iterator instance_it = instances.find(*it);
       if (instance_it != instances.end()) {
-        unhealthy_set.insert(instance_it->second);
+        unhealthy_set_.Insert(instance_it->second);
       }
     }
   }
+  return unhealthy_set_;
 }
 
 bool RouteInfoNotify::IsDataReady(bool use_disk_data) {
@@ -18,12 +18,15 @@
 #include <string>
 #include <vector>
 
+#include "model/instances_bitset.h"
 #include "model/service_route_rule.h"
 #include "polaris/defs.h"
 #include "polaris/plugin.h"
 
 namespace polaris {
 
+class ReusableRouteData;
+
 // 路由插件链入参
 class RouteInfo : Noncopyable {
  public:
@@ -48,7 +51,10 @@ class RouteInfo : Noncopyable {
   ///
   /// @note 路由插件链执行前必须设置被调服务实例
   /// @param service_instances 被调服务实例
-  void SetServiceInstances(ServiceInstances* service_instances) { service_instances_ = service_instances; }
+  void SetServiceInstances(ServiceInstances* service_instances) {
+    service_instances_ = service_instances;
+    unhealthy_set_ready_ = false;
+  }
 
   /// @brief 设置路由插件链执行需要的被调服务路由数据
   ///
@@ -123,6 +129,14 @@ class RouteInfo : Noncopyable {
   /// @brief 获取请求标签信息
   const std::map<std::string, std::string>& GetLabels() const;
 
+  /// @brief 设置预先计算的请求标签字符串，避免每次路由重复计算
+  void SetLabelsStr(const std::string& labels_str) { labels_str_ = &labels_str; }
+
+  /// @brief 获取请求标签字符串
+  ///
+  /// @param labels_str 请求标签字符串，有预先计算的结果时直接赋值
+  void GetLabelsStr(std::string& labels_str) const;
+
   /// @brief 设置请求元数据路由参数
   void SetMetadataPara(const MetadataRouterParam& metadata_param);
 
@@ -136,7 +150,10 @@ class RouteInfo : Noncopyable {
 
   const std::string* GetCanaryName() const;
 
-  void CalculateUnhealthySet(std::set<Instance*>& unhealthy_set);
+  /// @brief 获取需要剔除的不健康实例和熔断实例集合
+  ///
+  /// @note 首次调用时计算，同一次路由中缓存未命中的各个路由插件共用计算结果
+  const InstancesBitset& GetUnhealthySet();
 
   void SetCircuitBreakerVersion(uint64_t circuit_breaker_version) {
     circuit_breaker_version_ = circuit_breaker_version;
@@ -144,6 +161,14 @@ class RouteInfo : Noncopyable {
 
   uint64_t GetCircuitBreakerVersion() const { return circuit_breaker_version_; }
 
+  /// @brief 设置请求对象复用的路由数据
+  ///
+  /// @note 通过复用数据创建的服务实例和路由规则对象不会在析构时释放
+  void SetReusableData(ReusableRouteData* reusable_data) { reusable_data_ = reusable_data; }
+
+  /// @brief 获取请求对象复用的路由数据，未设置时返回NULL
+  ReusableRouteData* GetReusableData() const { return reusable_data_; }
+
  private:
   const ServiceKey& service_key_;
   ServiceInfo* source_service_info_;
@@ -157,8 +182,12 @@ class RouteInfo : Noncopyable {
   bool nearby_disable_;  // 表示不再执行就近路由
 
   const std::map<std::string, std::string>* labels_;
+  const std::string* labels_str_;
   const MetadataRouterParam* metadata_param_;
   uint64_t circuit_breaker_version_;
+  ReusableRouteData* reusable_data_;
+  bool unhealthy_set_ready_;
+  InstancesBitset unhealthy_set_;
 };
 
 static const int kDataOrNotifySize = 3;
@@ -14,10 +14,16 @@
 #include "plugin/service_router/route_result.h"
 
 #include "model/constants.h"
+#include "model/model_impl.h"
 
 namespace polaris {
 
-RouteResult::RouteResult() : redirect_service_key_(nullptr), subset_(nullptr), new_instances_set_(false) {}
+RouteResult::RouteResult()
+    : redirect_service_key_(nullptr),
+      subset_(nullptr),
+      new_instances_set_(false),
+      random_selected_(false),
+      counted_sets_(nullptr) {}
 
 RouteResult::~RouteResult() {
   if (redirect_service_key_ != nullptr) {
@@ -50,4 +56,11 @@ const std::map<std::string, std::string>& RouteResult::GetSubset() const {
   return subset_ == nullptr ? constants::EmptyStringMap() : *subset_;
 }
 
+void RouteResult::CountInstancesSet(InstancesSet* instances_set) {
+  instances_set->GetImpl()->count_++;
+  if (counted_sets_ != nullptr) {
+    counted_sets_->push_back(instances_set);
+  }
+}
+
 }  // namespace polaris
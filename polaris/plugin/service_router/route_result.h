@@ -62,11 +62,26 @@ class RouteResult : Noncopyable {
 
   bool NewInstancesSet() const { return new_instances_set_; }
 
+  /// @brief 标记路由结果为随机选择的，路由链不能缓存该结果
+  void SetRandomSelected() { random_selected_ = true; }
+
+  bool IsRandomSelected() const { return random_selected_; }
+
+  /// @brief 累加路由插件选中的实例集合的调用统计次数
+  ///
+  /// @note 设置了记录列表时同时记录该实例集合，路由链缓存命中时据此累加统计
+  void CountInstancesSet(InstancesSet* instances_set);
+
+  /// @brief 设置记录选中实例集合的列表，不需要记录时传入NULL
+  void SetCountedSets(std::vector<InstancesSet*>* counted_sets) { counted_sets_ = counted_sets; }
+
  private:
   ServiceKey* redirect_service_key_;
 
   std::map<std::string, std::string>* subset_;
   bool new_instances_set_;
+  bool random_selected_;
+  std::vector<InstancesSet*>* counted_sets_;
 };
 
 }  // namespace polaris
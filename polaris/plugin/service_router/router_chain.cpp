@@ -21,8 +21,10 @@
 #include <memory>
 #include <utility>
 
+#include "context/context_impl.h"
 #include "logger.h"
 #include "model/model_impl.h"
+#include "plugin/load_balancer/hash/murmur.h"
 #include "plugin/plugin_manager.h"
 #include "polaris/config.h"
 #include "polaris/context.h"
@@ -33,14 +35,78 @@
 
 namespace polaris {
 
+RouterChainCacheValue::RouterChainCacheValue()
+    : instances_data_(nullptr),
+      route_rule_(nullptr),
+      source_route_rule_(nullptr),
+      current_data_(nullptr),
+      refresh_time_(0),
+      refreshing_(false),
+      has_source_service_(false),
+      failover_type_(kMetadataFailoverNone) {}
+
+RouterChainCacheValue::~RouterChainCacheValue() {
+  for (std::size_t i = 0; i < counted_sets_.size(); ++i) {
+    counted_sets_[i]->DecrementRef();
+  }
+  if (current_data_ != nullptr) {
+    current_data_->DecrementRef();
+    current_data_ = nullptr;
+  }
+  if (instances_data_ != nullptr) {
+    instances_data_->DecrementRef();
+    instances_data_ = nullptr;
+  }
+  if (route_rule_ != nullptr) {
+    route_rule_->DecrementRef();
+    route_rule_ = nullptr;
+  }
+  if (source_route_rule_ != nullptr) {
+    source_route_rule_->DecrementRef();
+    source_route_rule_ = nullptr;
+  }
+}
+
+void RouterChainCacheValue::SetRequest(RouteInfo& route_info) {
+  ServiceInfo* source_service_info = route_info.GetSourceServiceInfo();
+  has_source_service_ = source_service_info != nullptr;
+  if (has_source_service_) {
+    source_service_info_.service_key_ = source_service_info->service_key_;
+    source_service_info_.metadata_ = source_service_info->metadata_;
+  }
+  labels_ = route_info.GetLabels();
+  metadata_ = route_info.GetMetadata();
+  failover_type_ = route_info.GetMetadataFailoverType();
+}
+
+bool RouterChainCacheValue::MatchRequest(RouteInfo& route_info) const {
+  ServiceInfo* source_service_info = route_info.GetSourceServiceInfo();
+  if (source_service_info != nullptr) {
+    if (!has_source_service_ || !(source_service_info->service_key_ == source_service_info_.service_key_) ||
+        source_service_info->metadata_ != source_service_info_.metadata_) {
+      return false;
+    }
+  } else if (has_source_service_) {
+    return false;
+  }
+  return failover_type_ == route_info.GetMetadataFailoverType() && metadata_ == route_info.GetMetadata() &&
+         labels_ == route_info.GetLabels();
+}
+
 ServiceRouterChain::ServiceRouterChain(const ServiceKey& service_key)
     : context_(nullptr),
       service_key_(service_key),
       is_rule_router_enable_(false),
       is_set_router_enable_(false),
-      is_canary_router_enable_(false) {}
+      is_canary_router_enable_(false),
+      chain_cache_(nullptr) {}
 
 ServiceRouterChain::~ServiceRouterChain() {
+  if (chain_cache_ != nullptr) {
+    chain_cache_->SetClearHandler(0);
+    chain_cache_->DecrementRef();
+    chain_cache_ = nullptr;
+  }
   for (std::size_t i = 0; i < service_router_list_.size(); i++) {
     delete service_router_list_[i];
   }
@@ -113,25 +179,81 @@ ReturnCode ServiceRouterChain::Init(Config* config, Context* context) {
     }
   }
   delete chain_config;
-  if (ret == kReturnOk) {
-    POLARIS_LOG(LOG_INFO, "init service router plugin[%s] for service[%s/%s] success",
-                StringUtils::JoinString(plugin_name_list_).c_str(), service_key_.namespace_.c_str(),
-                service_key_.name_.c_str());
+  if (ret != kReturnOk) {
+    return ret;
+  }
+  POLARIS_LOG(LOG_INFO, "init service router plugin[%s] for service[%s/%s] success",
+              StringUtils::JoinString(plugin_name_list_).c_str(), service_key_.namespace_.c_str(),
+              service_key_.name_.c_str());
+
+  // 内置路由插件的结果只由服务数据、版本号和请求参数决定，全部为内置插件时缓存整条路由链的结果
+  static const char kChainCacheEnableKey[] = "enableChainCache";
+  static const bool kChainCacheEnableDefault = true;
+  bool cache_enable = config->GetBoolOrDefault(kChainCacheEnableKey, kChainCacheEnableDefault);
+  for (std::size_t i = 0; cache_enable && i < plugin_name_list_.size(); ++i) {
+    const std::string& plugin_name = plugin_name_list_[i];
+    cache_enable = plugin_name == kPluginRuleServiceRouter || plugin_name == kPluginNearbyServiceRouter ||
+                   plugin_name == kPluginSetDivisionServiceRouter || plugin_name == kPluginMetadataServiceRouter ||
+                   plugin_name == kPluginCanaryServiceRouter;
+  }
+  if (cache_enable) {
+    chain_cache_ = new ServiceCache<RouterChainCacheKey, RouterChainCacheValue>();
+    context->GetContextImpl()->RegisterCache(chain_cache_);
   }
-  return ret;
+  return kReturnOk;
 }
 
 ReturnCode ServiceRouterChain::DoRoute(RouteInfo& route_info, RouteResult* route_result) {
   POLARIS_CHECK_ARGUMENT(route_info.GetServiceInstances() != nullptr);
+  if (chain_cache_ == nullptr) {
+    return DoRouteByPlugins(route_info, route_result);
+  }
+
+  // 缓存Key只包含请求参数指纹，命中后校验请求参数，指纹冲突时换下一个种子重新计算指纹
+  RouterChainCacheKey cache_key;
+  BuildCacheKey(route_info, cache_key);
+  RouterChainCacheValue* cache_value = nullptr;
+  for (uint32_t seed = 0;; ++seed) {
+    cache_key.request_fingerprint_ = RequestFingerprint(route_info, seed);
+    cache_value = chain_cache_->GetWithRcuTime(cache_key);
+    if (cache_value == nullptr || cache_value->MatchRequest(route_info)) {
+      break;
+    }
+    POLARIS_LOG(LOG_WARN, "ns(%s) svc(%s) route request fingerprint %" PRIu64 " conflict with seed %u",
+                service_key_.namespace_.c_str(), service_key_.name_.c_str(), cache_key.request_fingerprint_, seed);
+  }
+  if (cache_value == nullptr) {
+    return DoRouteWithCache(route_info, route_result, cache_key);
+  }
+  // 缓存命中时各路由插件的缓存不会被访问，定期由一个请求重新执行路由链，避免插件缓存过期后统计数据丢失
+  if (Time::GetCoarseSteadyTimeMs() >= cache_value->refresh_time_ && !cache_value->refreshing_.exchange(true)) {
+    return DoRouteWithCache(route_info, route_result, cache_key);
+  }
+  if (cache_value->current_data_ == nullptr) {  // 结果不可缓存，例如需要转发或按权重随机选择subset
+    return DoRouteByPlugins(route_info, route_result);
+  }
+  for (std::size_t i = 0; i < cache_value->counted_sets_.size(); ++i) {
+    route_result->CountInstancesSet(cache_value->counted_sets_[i]);
+  }
+  route_info.GetServiceInstances()->UpdateAvailableInstances(cache_value->current_data_);
+  if (!cache_value->subset_.empty()) {
+    route_result->SetSubset(cache_value->subset_);
+  }
+  return kReturnOk;
+}
+
+ReturnCode ServiceRouterChain::DoRouteByPlugins(RouteInfo& route_info, RouteResult* route_result) {
   ReturnCode ret;
   for (std::size_t index = 0; index < service_router_list_.size(); index++) {
     auto begin_time = std::chrono::steady_clock::now();
     ServiceRouter* router = service_router_list_[index];
     ret = router->DoRoute(route_info, route_result);
-    auto end_time = std::chrono::steady_clock::now();
-    auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - begin_time).count();
-    POLARIS_LOG(LOG_DEBUG, "router(%s) ns(%s) svc(%s) do route cost(%ld ms)", router->Name().c_str(),
-                route_info.GetServiceKey().namespace_.c_str(), route_info.GetServiceKey().name_.c_str(), delay);
+    if (POLARIS_LOG_ENABLE(kDebugLogLevel)) {  // 插件名称需要构造字符串，只在开启调试日志时获取
+      auto end_time = std::chrono::steady_clock::now();
+      auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - begin_time).count();
+      POLARIS_LOG(LOG_DEBUG, "router(%s) ns(%s) svc(%s) do route cost(%ld ms)", router->Name().c_str(),
+                  route_info.GetServiceKey().namespace_.c_str(), route_info.GetServiceKey().name_.c_str(), delay);
+    }
     if (ret != kReturnOk) {
       POLARIS_LOG(LOG_ERROR, "run service router plugin[%s] for service[%s/%s] return error[%s]",
                   plugin_name_list_[index].c_str(), service_key_.namespace_.c_str(), service_key_.name_.c_str(),
@@ -153,6 +275,83 @@ ReturnCode ServiceRouterChain::DoRoute(RouteInfo& route_info, RouteResult* route
   return kReturnOk;
 }
 
+void ServiceRouterChain::BuildCacheKey(RouteInfo& route_info, RouterChainCacheKey& cache_key) {
+  ServiceInstances* service_instances = route_info.GetServiceInstances();
+  cache_key.prior_data_ = service_instances->GetAvailableInstances();
+  ServiceRouteRule* route_rule = route_info.GetServiceRouteRule();
+  cache_key.route_rule_ = route_rule != nullptr ? route_rule->GetServiceData() : nullptr;
+  ServiceRouteRule* source_route_rule = route_info.GetSourceServiceRouteRule();
+  cache_key.source_route_rule_ = source_route_rule != nullptr ? source_route_rule->GetServiceData() : nullptr;
+  cache_key.circuit_breaker_version_ = route_info.GetCircuitBreakerVersion();
+  Service* service = service_instances->GetService();
+  cache_key.subset_circuit_breaker_version_ =
+      service != nullptr ? service->GetCircuitBreakerSetUnhealthyDataVersion() : 0;
+  cache_key.location_version_ = context_->GetContextImpl()->GetClientLocation().GetVersion();
+  cache_key.request_flags_ = route_info.GetRequestFlags();
+}
+
+static uint64_t MapFingerprint(uint64_t fingerprint, const std::map<std::string, std::string>& values,
+                               uint32_t seed) {
+  fingerprint = HashCombine(fingerprint, values.size());
+  for (std::map<std::string, std::string>::const_iterator it = values.begin(); it != values.end(); ++it) {
+    fingerprint = HashCombine(fingerprint, Murmur3_64(it->first.data(), it->first.size(), seed));
+    fingerprint = HashCombine(fingerprint, Murmur3_64(it->second.data(), it->second.size(), seed));
+  }
+  return fingerprint;
+}
+
+uint64_t ServiceRouterChain::RequestFingerprint(RouteInfo& route_info, uint32_t seed) {
+  uint64_t fingerprint = Murmur3_64(&seed, sizeof(seed), seed);
+  fingerprint = MapFingerprint(fingerprint, route_info.GetLabels(), seed);
+  fingerprint = MapFingerprint(fingerprint, route_info.GetMetadata(), seed);
+  fingerprint = HashCombine(fingerprint, static_cast<std::size_t>(route_info.GetMetadataFailoverType()));
+  ServiceInfo* source_service_info = route_info.GetSourceServiceInfo();
+  if (source_service_info != nullptr) {
+    const ServiceKey& source_key = source_service_info->service_key_;
+    fingerprint =
+        HashCombine(fingerprint, Murmur3_64(source_key.namespace_.data(), source_key.namespace_.size(), seed));
+    fingerprint = HashCombine(fingerprint, Murmur3_64(source_key.name_.data(), source_key.name_.size(), seed));
+    fingerprint = MapFingerprint(fingerprint, source_service_info->metadata_, seed);
+  }
+  return fingerprint;
+}
+
+ReturnCode ServiceRouterChain::DoRouteWithCache(RouteInfo& route_info, RouteResult* route_result,
+                                                const RouterChainCacheKey& cache_key) {
+  std::vector<InstancesSet*> counted_sets;
+  route_result->SetCountedSets(&counted_sets);
+  ReturnCode ret = DoRouteByPlugins(route_info, route_result);
+  route_result->SetCountedSets(nullptr);
+  if (ret != kReturnOk) {
+    chain_cache_->Update(cache_key, nullptr);  // 可能是刷新中的缓存，删除后由下一个请求重新执行
+    return ret;
+  }
+
+  RouterChainCacheValue* cache_value = new RouterChainCacheValue();
+  ServiceInstances* service_instances = route_info.GetServiceInstances();
+  cache_value->instances_data_ = service_instances->GetServiceData();
+  cache_value->instances_data_->IncrementRef();
+  if ((cache_value->route_rule_ = cache_key.route_rule_) != nullptr) {
+    cache_value->route_rule_->IncrementRef();
+  }
+  if ((cache_value->source_route_rule_ = cache_key.source_route_rule_) != nullptr) {
+    cache_value->source_route_rule_->IncrementRef();
+  }
+  if (!route_result->isRedirect() && !route_result->IsRandomSelected()) {
+    cache_value->current_data_ = service_instances->GetAvailableInstances();
+    cache_value->current_data_->IncrementRef();
+    cache_value->counted_sets_.swap(counted_sets);
+    for (std::size_t i = 0; i < cache_value->counted_sets_.size(); ++i) {
+      cache_value->counted_sets_[i]->IncrementRef();
+    }
+    cache_value->subset_ = route_result->GetSubset();
+  }
+  cache_value->SetRequest(route_info);
+  cache_value->refresh_time_ = Time::GetCoarseSteadyTimeMs() + context_->GetContextImpl()->GetCacheClearTime() / 2;
+  chain_cache_->Update(cache_key, cache_value);
+  return kReturnOk;
+}
+
 void ServiceRouterChain::CollectStat(ServiceKey& service_key, std::map<std::string, RouterStatData*>& stat_data) {
   service_key = service_key_;
   for (std::size_t i = 0; i < service_router_list_.size(); i++) {
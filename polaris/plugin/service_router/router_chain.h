@@ -14,13 +14,71 @@
 #ifndef POLARIS_CPP_POLARIS_PLUGIN_SERVICE_ROUTER_ROUTER_CHAIN_H_
 #define POLARIS_CPP_POLARIS_PLUGIN_SERVICE_ROUTER_ROUTER_CHAIN_H_
 
+#include <stdint.h>
+
+#include <atomic>
+#include <map>
 #include <string>
 #include <vector>
 
+#include "cache/service_cache.h"
 #include "plugin/service_router/service_router.h"
+#include "polaris/model.h"
 
 namespace polaris {
 
+// 路由链缓存Key，请求参数使用64位指纹表示，命中后由路由链校验请求参数
+struct RouterChainCacheKey {
+  InstancesSet* prior_data_;        // 执行路由链前的可用实例
+  ServiceData* route_rule_;         // 被调服务路由规则
+  ServiceData* source_route_rule_;  // 主调服务路由规则
+  uint64_t circuit_breaker_version_;
+  uint64_t subset_circuit_breaker_version_;
+  uint32_t location_version_;
+  uint8_t request_flags_;
+  uint64_t request_fingerprint_;  // 请求标签、元数据、主调服务及其元数据的指纹
+
+  bool operator==(const RouterChainCacheKey& rhs) const {
+    return this->prior_data_ == rhs.prior_data_ && this->route_rule_ == rhs.route_rule_ &&
+           this->source_route_rule_ == rhs.source_route_rule_ &&
+           this->circuit_breaker_version_ == rhs.circuit_breaker_version_ &&
+           this->subset_circuit_breaker_version_ == rhs.subset_circuit_breaker_version_ &&
+           this->location_version_ == rhs.location_version_ && this->request_flags_ == rhs.request_flags_ &&
+           this->request_fingerprint_ == rhs.request_fingerprint_;
+  }
+};
+
+// 路由链缓存Value，记录整条路由链的执行结果
+class RouterChainCacheValue : public ServiceBase {
+ public:
+  RouterChainCacheValue();
+
+  virtual ~RouterChainCacheValue();
+
+  /// @brief 记录路由链执行时的请求参数
+  void SetRequest(RouteInfo& route_info);
+
+  /// @brief 校验缓存结果对应的请求参数与本次请求是否一致
+  bool MatchRequest(RouteInfo& route_info) const;
+
+ public:
+  ServiceData* instances_data_;              // 保证原始服务实例不被释放
+  ServiceData* route_rule_;                  // 保证服务路由规则不被释放
+  ServiceData* source_route_rule_;           // 保证主调服务路由规则不被释放
+  InstancesSet* current_data_;               // 路由链最终选出的实例集合
+  std::vector<InstancesSet*> counted_sets_;  // 各路由插件计入调用统计的实例集合
+  std::map<std::string, std::string> subset_;
+  uint64_t refresh_time_;  // 到达该时间后需要重新执行一次路由链，保持各路由插件的缓存不过期
+  std::atomic<bool> refreshing_;
+
+  // 请求参数，用于校验指纹冲突
+  bool has_source_service_;
+  ServiceInfo source_service_info_;
+  std::map<std::string, std::string> labels_;
+  std::map<std::string, std::string> metadata_;
+  MetadataFailoverType failover_type_;
+};
+
 class ServiceRouterChain {
  public:
   explicit ServiceRouterChain(const ServiceKey& service_key);
@@ -62,6 +120,17 @@ class ServiceRouterChain {
   ServiceData* PrepareServiceData(const ServiceKey& service_key, ServiceDataType data_type, int notify_index,
                                   RouteInfoNotify*& notify);
 
+  /// @brief 依次执行各个路由插件
+  ReturnCode DoRouteByPlugins(RouteInfo& route_info, RouteResult* route_result);
+
+  /// @brief 根据请求信息计算路由链缓存Key
+  void BuildCacheKey(RouteInfo& route_info, RouterChainCacheKey& cache_key);
+
+  static uint64_t RequestFingerprint(RouteInfo& route_info, uint32_t seed);
+
+  /// @brief 执行路由链并缓存执行结果
+  ReturnCode DoRouteWithCache(RouteInfo& route_info, RouteResult* route_result, const RouterChainCacheKey& cache_key);
+
  private:
   Context* context_;
   ServiceKey service_key_;
@@ -70,8 +139,27 @@ class ServiceRouterChain {
   bool is_rule_router_enable_;
   bool is_set_router_enable_;
   bool is_canary_router_enable_;
+  ServiceCache<RouterChainCacheKey, RouterChainCacheValue>* chain_cache_;  // 只有全部为内置路由插件时才开启
 };
 
 }  // namespace polaris
 
+namespace std {
+
+template <>
+struct hash<polaris::RouterChainCacheKey> {
+  std::size_t operator()(const polaris::RouterChainCacheKey& key) const {
+    std::size_t seed = hash<polaris::InstancesSet*>()(key.prior_data_);
+    seed = polaris::HashCombine(seed, hash<polaris::ServiceData*>()(key.route_rule_));
+    seed = polaris::HashCombine(seed, hash<polaris::ServiceData*>()(key.source_route_rule_));
+    seed = polaris::HashCombine(seed, key.circuit_breaker_version_);
+    seed = polaris::HashCombine(seed, key.subset_circuit_breaker_version_);
+    seed = polaris::HashCombine(seed, key.location_version_);
+    seed = polaris::HashCombine(seed, key.request_flags_);
+    return polaris::HashCombine(seed, key.request_fingerprint_);
+  }
+};
+
+}  // namespace std
+
 #endif  //  POLARIS_CPP_POLARIS_PLUGIN_SERVICE_ROUTER_ROUTER_CHAIN_H_
@@ -41,7 +41,7 @@ RuleRouterCluster::~RuleRouterCluster() {
 // 根据Destination计算路由结果
 bool RuleRouterCluster::CalculateByRoute(const RouteRule& route, ServiceKey& service_key, bool match_service,
                                          const std::vector<Instance*>& instances,
-                                         const std::set<Instance*>& unhealthy_set,
+                                         const InstancesBitset& unhealthy_set,
                                          const std::map<std::string, std::string>& parameters) {
   return route.CalculateSet(service_key, match_service, instances, unhealthy_set, parameters, data_);
 }
@@ -335,7 +335,11 @@ ReturnCode RuleServiceRouter::DoRoute(RouteInfo& route_info, RouteResult* route_
 
   RouteRuleBound* matched_route = nullptr;
   bool match_outbounds = true;  // 是否匹配的源服务的出规则
-  RuleRouteCacheKey cache_key;
+  // 请求对象有复用数据时使用复用的缓存Key，避免重复分配字符串内存
+  ReusableRouteData* reusable_data = route_info.GetReusableData();
+  RuleRouteCacheKey local_cache_key;
+  RuleRouteCacheKey& cache_key = reusable_data != nullptr ? reusable_data->rule_cache_key_ : local_cache_key;
+  cache_key.parameters_.clear();
   if (!ServiceRouteRule::RouteMatch(route_rule, route_info.GetServiceKey(), source_route_rule, source_service_info,
                                     matched_route, &match_outbounds, cache_key.parameters_)) {
     not_match_count_++;
@@ -351,16 +355,16 @@ ReturnCode RuleServiceRouter::DoRoute(RouteInfo& route_info, RouteResult* route_
     cache_key.circuit_breaker_version_ = route_info.GetCircuitBreakerVersion();
     cache_key.subset_circuit_breaker_version_ =
         service_instances->GetService()->GetCircuitBreakerSetUnhealthyDataVersion();
-    Labels labels;
-    labels.labels_ = route_info.GetLabels();
-    cache_key.labels_ = labels.GetLabelStr();
+    route_info.GetLabelsStr(cache_key.labels_);
 
     RuleRouterCacheValue* cache_value = router_cache_->GetWithRcuTime(cache_key);
     if (cache_value == nullptr) {
       cache_value = router_cache_->CreateOrGet(cache_key, [&] {
+        Labels labels;
+        labels.labels_ = route_info.GetLabels();
+        labels.labels_str = cache_key.labels_;
         // 获取熔断实例和不健康实例
-        std::set<Instance*> unhealthy_set;
-        route_info.CalculateUnhealthySet(unhealthy_set);
+        const InstancesBitset& unhealthy_set = route_info.GetUnhealthySet();
         InstancesSet* available_set = service_instances->GetAvailableInstances();
         RuleRouterCluster rule_router_cluster;
         bool calculate_result;
@@ -428,8 +432,12 @@ ReturnCode RuleServiceRouter::DoRoute(RouteInfo& route_info, RouteResult* route_
       return kReturnRouteRuleNotMatch;
     }
 
+    if (cache_value->subsets_.size() > 1) {  // 按权重随机选择subset
+      route_result->SetRandomSelected();
+    }
     InstancesSet* instances_result =
         ServiceRouteRule::SelectSet(cache_value->subsets_, cache_value->subset_sum_weight_);
+    route_result->CountInstancesSet(instances_result);
     service_instances->UpdateAvailableInstances(instances_result);
     route_result->SetSubset(instances_result->GetSubset());
   }
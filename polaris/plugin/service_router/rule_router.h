@@ -34,7 +34,7 @@ class RuleRouterCluster {
   ~RuleRouterCluster();
 
   bool CalculateByRoute(const RouteRule& route, ServiceKey& service_key, bool match_service,
-                        const std::vector<Instance*>& instances, const std::set<Instance*>& unhealthy_set,
+                        const std::vector<Instance*>& instances, const InstancesBitset& unhealthy_set,
                         const std::map<std::string, std::string>& parameters);
 
   bool CalculateRouteResult(std::vector<RuleRouterSet*>& result, uint32_t* sum_weight, float percent_of_min_instances,
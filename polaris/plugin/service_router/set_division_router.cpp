@@ -174,8 +174,7 @@ ReturnCode SetDivisionServiceRouter::DoRoute(RouteInfo& route_info, RouteResult*
         const std::vector<Instance*>& instances = avail_instances->GetInstances();
         CalculateMatchResult(cache_key.caller_set_name, instances, result);
         // 从选出的列表中进一步选出active的节点，如果没有active的节点，将返回inactive的
-        std::set<Instance*> unhealthy_set;
-        route_info.CalculateUnhealthySet(unhealthy_set);
+        const InstancesBitset& unhealthy_set = route_info.GetUnhealthySet();
 
         std::vector<Instance*> healthy_result;
         GetHealthyInstances(result, unhealthy_set, healthy_result);
@@ -214,7 +213,7 @@ ReturnCode SetDivisionServiceRouter::DoRoute(RouteInfo& route_info, RouteResult*
   route_info.SetNearbyRouterDisable(true);
 
   // 更新route_result
-  cache_value->current_data_->GetImpl()->count_++;
+  route_result->CountInstancesSet(cache_value->current_data_);
   service_instances->UpdateAvailableInstances(cache_value->current_data_);
   return kReturnOk;
 }
@@ -222,14 +221,9 @@ ReturnCode SetDivisionServiceRouter::DoRoute(RouteInfo& route_info, RouteResult*
 RouterStatData* SetDivisionServiceRouter::CollectStat() { return router_cache_->CollectStat(); }
 
 int SetDivisionServiceRouter::GetHealthyInstances(const std::vector<Instance*>& input,
-                                                  const std::set<Instance*>& unhealthy_set,
+                                                  const InstancesBitset& unhealthy_set,
                                                   std::vector<Instance*>& output) {
-  for (std::size_t i = 0; i < input.size(); ++i) {
-    if (unhealthy_set.find(input[i]) == unhealthy_set.end()) {
-      output.push_back(input[i]);
-    }
-  }
-
+  unhealthy_set.Select(input, false, output);
   return 0;
 }
 
@@ -60,7 +60,7 @@ class SetDivisionServiceRouter : public ServiceRouter {
 
   // 根据输入节点集input和unhealthy节点集unhealthy_set，筛选出healthy的节点output
   // 如果input全为unhealthy,则output直接取为input
-  int GetHealthyInstances(const std::vector<Instance*>& input, const std::set<Instance*>& unhealthy_set,
+  int GetHealthyInstances(const std::vector<Instance*>& input, const InstancesBitset& unhealthy_set,
                           std::vector<Instance*>& output);
 
  private:
@@ -0,0 +1,142 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_UTILS_BITSET_H_
+#define POLARIS_CPP_POLARIS_UTILS_BITSET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace polaris {
+
+/// @brief 运行时确定大小的位集合，用于对一组对象下标做批量集合运算
+///
+/// 参与运算的位集合必须大小相同
+class Bitset {
+ public:
+  Bitset() : size_(0) {}
+
+  explicit Bitset(std::size_t size) : size_(size), words_((size + 63) / 64, 0) {}
+
+  /// @brief 重新设置大小，并清空所有位
+  void Resize(std::size_t size) {
+    size_ = size;
+    words_.assign((size + 63) / 64, 0);
+  }
+
+  std::size_t Size() const { return size_; }
+
+  void Set(std::size_t pos) { words_[pos >> 6] |= (1ULL << (pos & 63)); }
+
+  void Reset(std::size_t pos) { words_[pos >> 6] &= ~(1ULL << (pos & 63)); }
+
+  bool Test(std::size_t pos) const { return (words_[pos >> 6] >> (pos & 63)) & 1; }
+
+  void SetAll() {
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      words_[i] = ~0ULL;
+    }
+    ClearTail();
+  }
+
+  void ResetAll() {
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      words_[i] = 0;
+    }
+  }
+
+  bool Any() const {
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      if (words_[i] != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::size_t Count() const {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      count += __builtin_popcountll(words_[i]);
+    }
+    return count;
+  }
+
+  Bitset& operator&=(const Bitset& other) {
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      words_[i] &= other.words_[i];
+    }
+    return *this;
+  }
+
+  Bitset& operator|=(const Bitset& other) {
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      words_[i] |= other.words_[i];
+    }
+    return *this;
+  }
+
+  /// @brief 去掉other中的位
+  void AndNot(const Bitset& other) {
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      words_[i] &= ~other.words_[i];
+    }
+  }
+
+  /// @brief 去掉mask中但不在allowed中的位，即 this &= ~mask | allowed
+  void AndNotExcept(const Bitset& mask, const Bitset& allowed) {
+    for (std::size_t i = 0; i < words_.size(); ++i) {
+      words_[i] &= ~mask.words_[i] | allowed.words_[i];
+    }
+  }
+
+  /// @brief 查找从pos开始第一个被设置的位，不存在时返回Size()
+  std::size_t FindNext(std::size_t pos) const {
+    if (pos >= size_) {
+      return size_;
+    }
+    std::size_t index = pos >> 6;
+    uint64_t word = words_[index] & (~0ULL << (pos & 63));
+    for (;;) {
+      if (word != 0) {
+        std::size_t result = (index << 6) + __builtin_ctzll(word);
+        return result < size_ ? result : size_;
+      }
+      if (++index >= words_.size()) {
+        return size_;
+      }
+      word = words_[index];
+    }
+  }
+
+  std::size_t FindFirst() const { return FindNext(0); }
+
+  bool operator==(const Bitset& other) const { return size_ == other.size_ && words_ == other.words_; }
+
+ private:
+  void ClearTail() {
+    if ((size_ & 63) != 0) {
+      words_.back() &= (1ULL << (size_ & 63)) - 1;
+    }
+  }
+
+ private:
+  std::size_t size_;
+  std::vector<uint64_t> words_;
+};
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_UTILS_BITSET_H_
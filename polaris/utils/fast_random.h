@@ -0,0 +1,78 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#ifndef POLARIS_CPP_POLARIS_UTILS_FAST_RANDOM_H_
+#define POLARIS_CPP_POLARIS_UTILS_FAST_RANDOM_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "utils/utils.h"
+
+namespace polaris {
+
+/// @brief 线程局部的xoshiro256**伪随机数生成器
+///
+/// 用于负载均衡等调用频繁但不要求密码学安全的场景，比rand_r周期更长、分布更均匀，且不需要取模
+class FastRandom {
+ public:
+  /// @brief 获取一个64位随机数
+  static uint64_t Next() {
+    uint64_t* state = ThreadState();
+    const uint64_t result = RotateLeft(state[1] * 5, 7) * 9;
+    const uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = RotateLeft(state[3], 45);
+    return result;
+  }
+
+  /// @brief 获取[0, bound)范围内的随机数，使用乘法映射代替取模
+  static uint32_t NextUint32(uint32_t bound) {
+    return static_cast<uint32_t>(((Next() >> 32) * static_cast<uint64_t>(bound)) >> 32);
+  }
+
+ private:
+  static uint64_t RotateLeft(uint64_t value, int shift) { return (value << shift) | (value >> (64 - shift)); }
+
+  static uint64_t SplitMix64(uint64_t& seed) {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  static uint64_t* ThreadState() {
+    static __thread bool thread_state_init = false;
+    static __thread uint64_t thread_state[4];
+    if (POLARIS_UNLIKELY(!thread_state_init)) {
+      thread_state_init = true;
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      uint64_t seed = static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+      seed ^= static_cast<uint64_t>(pthread_self());
+      for (int i = 0; i < 4; ++i) {
+        thread_state[i] = SplitMix64(seed);
+      }
+    }
+    return thread_state;
+  }
+};
+
+}  // namespace polaris
+
+#endif  //  POLARIS_CPP_POLARIS_UTILS_FAST_RANDOM_H_
@@ -42,4 +42,34 @@ bool IpUtils::StrIpToInt(const std::string& str_ip, uint32_t& int_ip) {
   }
 }
 
+static uint64_t BytesToUint64(const unsigned char* bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) {
+    value = (value << 8) | bytes[i];
+  }
+  return value;
+}
+
+bool IpUtils::StrIpToInt128(const std::string& str_ip, uint64_t& ip_high, uint64_t& ip_low) {
+  struct in_addr sin_addr;
+  if (inet_pton(AF_INET, str_ip.c_str(), &sin_addr) > 0) {
+    ip_high = 0;
+    ip_low = (0xffffULL << 32) | ntohl(sin_addr.s_addr);
+    return true;
+  }
+  const char* begin = str_ip.c_str();
+  std::string without_bracket;
+  if (!str_ip.empty() && str_ip[0] == '[' && str_ip[str_ip.size() - 1] == ']') {  // [::1]格式
+    without_bracket = str_ip.substr(1, str_ip.size() - 2);
+    begin = without_bracket.c_str();
+  }
+  struct in6_addr sin6_addr;
+  if (inet_pton(AF_INET6, begin, &sin6_addr) > 0) {
+    ip_high = BytesToUint64(sin6_addr.s6_addr);
+    ip_low = BytesToUint64(sin6_addr.s6_addr + 8);
+    return true;
+  }
+  return false;
+}
+
 }  // namespace polaris
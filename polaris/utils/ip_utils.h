@@ -27,6 +27,9 @@ class IpUtils {
 
   // 将string格式的IP转换成INT类型
   static bool StrIpToInt(const std::string& str_ip, uint32_t& int_ip);
+
+  // 将string格式的IPv4或IPv6地址转换成128位整数，IPv4地址转换为IPv4映射的IPv6地址(::ffff:a.b.c.d)
+  static bool StrIpToInt128(const std::string& str_ip, uint64_t& ip_high, uint64_t& ip_low);
 };
 
 }  // namespace polaris
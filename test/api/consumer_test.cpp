@@ -22,13 +22,17 @@
 
 #include "api/consumer_api.h"
 #include "context/context_impl.h"
+#include "context/service_context.h"
 #include "mock/fake_server_response.h"
 #include "mock/mock_server_connector.h"
+#include "model/model_impl.h"
 #include "plugin/load_balancer/hash/hash_manager.h"
+#include "plugin/load_balancer/instance_load.h"
 #include "polaris/consumer.h"
 #include "polaris/plugin.h"
 #include "test_utils.h"
 #include "utils/file_utils.h"
+#include "utils/time_clock.h"
 
 namespace polaris {
 
@@ -376,6 +380,30 @@ TEST_F(ConsumerApiMockServerConnectorTest, TestGetOneInstanceWithOnlyOneInstance
   }
 }
 
+TEST_F(ConsumerApiMockServerConnectorTest, TestGetOneInstanceReuseResponse) {
+  InitServiceData();
+  EXPECT_CALL(*server_connector_,
+              RegisterEventHandler(::testing::Eq(service_key_), ::testing::_, ::testing::_, ::testing::_, ::testing::_))
+      .Times(::testing::Exactly(2))
+      .WillRepeatedly(
+          ::testing::DoAll(::testing::Invoke(this, &ConsumerApiMockServerConnectorTest::MockFireEventHandler),
+                           ::testing::Return(kReturnOk)));
+
+  GetOneInstanceRequest request(service_key_);
+  std::map<std::string, std::string> labels;
+  labels["method"] = "get";
+  request.SetLabels(labels);
+  request.SetBackupInstanceNum(1);
+  InstancesResponse response;
+  for (int i = 0; i < 10; i++) {  // 重复使用请求和应答对象，应答中的结果被覆盖
+    ASSERT_EQ(consumer_api_->GetOneInstance(request, response), kReturnOk);
+    ASSERT_EQ(response.GetInstances().size(), 2);
+    ASSERT_NE(response.GetInstances()[0].GetId(), response.GetInstances()[1].GetId());
+    ASSERT_EQ(response.GetServiceName(), service_key_.name_);
+    ASSERT_EQ(response.GetServiceNamespace(), service_key_.namespace_);
+  }
+}
+
 TEST_F(ConsumerApiMockServerConnectorTest, TestGetInstances) {
   ServiceKey service_key;
   GetInstancesRequest empty_service_name_request(service_key);
@@ -400,6 +428,50 @@ TEST_F(ConsumerApiMockServerConnectorTest, TestGetInstances) {
   delete response;
 }
 
+TEST_F(ConsumerApiMockServerConnectorTest, TestGetInstancesView) {
+  ServiceKey service_key;
+  GetInstancesRequest empty_service_name_request(service_key);
+  InstancesView view;
+  ASSERT_EQ(consumer_api_->GetInstances(empty_service_name_request, view), kReturnInvalidArgument);
+  ASSERT_EQ(view.GetInstancesSize(), 0);
+  ASSERT_TRUE(view.GetServiceName().empty());
+
+  GetInstancesRequest request(service_key_);
+  InitServiceData();
+  EXPECT_CALL(*server_connector_,
+              RegisterEventHandler(::testing::Eq(service_key_), ::testing::_, ::testing::_, ::testing::_, ::testing::_))
+      .Times(::testing::Exactly(2))
+      .WillRepeatedly(
+          ::testing::DoAll(::testing::Invoke(this, &ConsumerApiMockServerConnectorTest::MockFireEventHandler),
+                           ::testing::Return(kReturnOk)));
+
+  InstancesResponse *response = nullptr;
+  ASSERT_EQ(consumer_api_->GetInstances(request, response), kReturnOk);
+  ASSERT_EQ(consumer_api_->GetInstances(request, view), kReturnOk);
+  ASSERT_EQ(view.GetInstancesSize(), response->GetInstances().size());
+  for (std::size_t i = 0; i < view.GetInstancesSize(); ++i) {
+    ASSERT_EQ(view.GetInstance(i).GetId(), response->GetInstances()[i].GetId());
+  }
+  ASSERT_EQ(view.GetServiceName(), service_key_.name_);
+  ASSERT_EQ(view.GetServiceNamespace(), service_key_.namespace_);
+  ASSERT_EQ(view.GetMetadata(), response->GetMetadata());
+  ASSERT_EQ(view.GetRevision(), response->GetRevision());
+  delete response;
+
+  // 拷贝的视图共享快照，原视图再次查询不影响拷贝
+  InstancesView copy_view = view;
+  const Instance *first_instance = &copy_view.GetInstance(0);
+  ASSERT_EQ(consumer_api_->GetInstances(request, view), kReturnOk);
+  ASSERT_EQ(&copy_view.GetInstance(0), first_instance);
+  ASSERT_EQ(copy_view.GetInstancesSize(), view.GetInstancesSize());
+
+  // 不再拷贝后重复查询复用内部对象
+  copy_view = InstancesView();
+  InstancesView::Impl *view_impl = &view.GetImpl();
+  ASSERT_EQ(consumer_api_->GetInstances(request, view), kReturnOk);
+  ASSERT_EQ(&view.GetImpl(), view_impl);
+}
+
 TEST_F(ConsumerApiMockServerConnectorTest, TestGetAllInstances) {
   ServiceKey service_key;
   GetInstancesRequest empty_service_name_request(service_key);
@@ -614,6 +686,103 @@ TEST_F(ConsumerApiMockServerConnectorTest, TestUpdateServiceCallResult) {
   ASSERT_EQ(instance.GetId(), "instance_0");
 }
 
+TEST_F(ConsumerApiMockServerConnectorTest, TestLoadAwareCountAllChosenInstances) {
+  instance_num_ = 1;
+  InitServiceData();
+  EXPECT_CALL(*server_connector_,
+              RegisterEventHandler(::testing::Eq(service_key_), ::testing::_, ::testing::_, ::testing::_, ::testing::_))
+      .Times(::testing::Exactly(2))
+      .WillRepeatedly(
+          ::testing::DoAll(::testing::Invoke(this, &ConsumerApiMockServerConnectorTest::MockFireEventHandler),
+                           ::testing::Return(kReturnOk)));
+
+  GetOneInstanceRequest least_request(service_key_);
+  least_request.SetLoadBalanceType(kLoadBalanceTypeP2CLeastRequest);
+  GetOneInstanceRequest random_request(service_key_);
+  Instance instance;
+  ASSERT_EQ(consumer_api_->GetOneInstance(least_request, instance), kReturnOk);
+  ServiceContext *service_context = context_->GetContextImpl()->GetServiceContext(service_key_);
+  ASSERT_TRUE(service_context != nullptr && service_context->IsLoadAware());
+  Instance *tracked = service_context->GetInstances()->GetServiceDataImpl()->GetInstancesData()->FindInstance(
+      instance.GetId());
+  ASSERT_TRUE(tracked != nullptr);
+  ASSERT_EQ(InstanceLoadTracker::GetInflight(tracked), 1);
+
+  // 其他负载均衡选出的实例同样计数，上报调用结果不会扣除感知负载的负载均衡选出的请求
+  ASSERT_EQ(consumer_api_->GetOneInstance(random_request, instance), kReturnOk);
+  ASSERT_EQ(InstanceLoadTracker::GetInflight(tracked), 2);
+  ServiceCallResult result;
+  result.SetServiceNamespace(service_key_.namespace_);
+  result.SetServiceName(service_key_.name_);
+  result.SetInstanceId(instance.GetId());
+  result.SetDelay(10);
+  result.SetRetStatus(kCallRetOk);
+  ASSERT_EQ(consumer_api_->UpdateServiceCallResult(result), kReturnOk);
+  ASSERT_EQ(InstanceLoadTracker::GetInflight(tracked), 1);
+  ASSERT_EQ(consumer_api_->UpdateServiceCallResult(result), kReturnOk);
+  ASSERT_EQ(InstanceLoadTracker::GetInflight(tracked), 0);
+
+  // 使用感知耗时的负载均衡后才更新耗时平均值
+  ASSERT_FALSE(service_context->IsLatencyAware());
+  ASSERT_EQ(InstanceLoadTracker::GetLatencyEwma(tracked, Time::GetCoarseSteadyTimeMs()), 0);
+  GetOneInstanceRequest ewma_request(service_key_);
+  ewma_request.SetLoadBalanceType(kLoadBalanceTypePeakEwma);
+  ASSERT_EQ(consumer_api_->GetOneInstance(ewma_request, instance), kReturnOk);
+  ASSERT_TRUE(service_context->IsLatencyAware());
+  ASSERT_EQ(consumer_api_->UpdateServiceCallResult(result), kReturnOk);
+  ASSERT_EQ(InstanceLoadTracker::GetInflight(tracked), 0);
+  ASSERT_GT(InstanceLoadTracker::GetLatencyEwma(tracked, Time::GetCoarseSteadyTimeMs()), 0);
+}
+
+TEST_F(ConsumerApiMockServerConnectorTest, TestBatchUpdateServiceCallResult) {
+  instance_num_ = 1;
+  InitServiceData();
+  EXPECT_CALL(*server_connector_,
+              RegisterEventHandler(::testing::Eq(service_key_), ::testing::_, ::testing::_, ::testing::_, ::testing::_))
+      .Times(::testing::Exactly(2))
+      .WillRepeatedly(
+          ::testing::DoAll(::testing::Invoke(this, &ConsumerApiMockServerConnectorTest::MockFireEventHandler),
+                           ::testing::Return(kReturnOk)));
+
+  GetOneInstanceRequest request(service_key_);
+  Instance instance;
+  ASSERT_EQ(consumer_api_->GetOneInstance(request, instance), kReturnOk);
+
+  std::vector<const ServiceCallResult*> results;
+  ASSERT_EQ(consumer_api_->UpdateServiceCallResult(results), kReturnOk);
+
+  ServiceCallResult result_list[4];
+  for (int i = 0; i < 4; i++) {
+    ServiceCallResult& result = result_list[i];
+    result.SetServiceNamespace(service_key_.namespace_);
+    result.SetServiceName(service_key_.name_);
+    if (i % 2 == 0) {
+      result.SetInstanceId(instance.GetId());
+    } else {
+      result.SetInstanceHostAndPort(instance.GetHost(), instance.GetPort());
+    }
+    result.SetDelay(100);
+    result.SetRetCode(0);
+    result.SetRetStatus(kCallRetOk);
+    results.push_back(&result);
+  }
+  ASSERT_EQ(consumer_api_->UpdateServiceCallResult(results), kReturnOk);
+
+  // 部分结果参数错误或实例不存在时，其他结果仍然上报
+  ServiceCallResult no_service_result;
+  no_service_result.SetInstanceId(instance.GetId());
+  results.push_back(&no_service_result);
+  ASSERT_EQ(consumer_api_->UpdateServiceCallResult(results), kReturnInvalidArgument);
+  results.pop_back();
+
+  ServiceCallResult not_exist_result;
+  not_exist_result.SetServiceNamespace(service_key_.namespace_);
+  not_exist_result.SetServiceName(service_key_.name_);
+  not_exist_result.SetInstanceHostAndPort("not_exist_host", instance.GetPort());
+  results.insert(results.begin() + 2, &not_exist_result);
+  ASSERT_NE(consumer_api_->UpdateServiceCallResult(results), kReturnOk);
+}
+
 TEST_F(ConsumerApiMockServerConnectorTest, TestGetRouteRuleKeys) {
   const std::set<std::string> *keys = nullptr;
   (*routing_response_.mutable_routing()->add_inbounds()->add_sources()->mutable_metadata())["key1"];
@@ -17,8 +17,13 @@
 
 #include <benchmark/benchmark.h>
 
+#include <stdlib.h>
+
 #include <iostream>
+#include <map>
+#include <new>
 #include <string>
+#include <vector>
 
 #include "context/context_impl.h"
 #include "mock/fake_server_response.h"
@@ -26,6 +31,20 @@
 #include "polaris/log.h"
 #include "test_utils.h"
 
+// 统计当前线程的内存分配次数，用于验证重复使用请求对象获取实例时没有内存分配
+static __thread uint64_t g_thread_alloc_count = 0;
+
+void *operator new(std::size_t size) {
+  g_thread_alloc_count++;
+  void *ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
 namespace polaris {
 
 class BM_ConsumerApi : public benchmark::Fixture {
@@ -141,6 +160,56 @@ BENCHMARK_REGISTER_F(BM_ConsumerApi, FastGetOneInstance)
     ->MinTime(10)
     ->UseRealTime();
 
+// 上报调用结果，参数为每批上报的调用结果数，0表示逐个调用单个上报接口
+BENCHMARK_DEFINE_F(BM_ConsumerApi, UpdateServiceCallResult)
+(benchmark::State &state) {
+  if (state.thread_index == 0) {
+    InitServices(context_->GetLocalRegistry(), state);
+  }
+  ServiceKey service_key = {"benchmark_namespace", "benchmark_service_0"};
+  polaris::Instance instance;
+  polaris::GetOneInstanceRequest request(service_key);
+  ReturnCode ret_code;
+  if ((ret_code = consumer_->GetOneInstance(request, instance)) != kReturnOk) {
+    std::string err_msg = "get one instance failed:" + polaris::ReturnCodeToMsg(ret_code);
+    state.SkipWithError(err_msg.c_str());
+    return;
+  }
+  int batch_size = state.range(2);
+  std::vector<polaris::ServiceCallResult> result_list(batch_size > 0 ? batch_size : 1);
+  std::vector<const polaris::ServiceCallResult *> results;
+  for (std::size_t i = 0; i < result_list.size(); ++i) {
+    polaris::ServiceCallResult &result = result_list[i];
+    result.SetServiceNamespace(service_key.namespace_);
+    result.SetServiceName(service_key.name_);
+    result.SetInstanceId(instance.GetId());
+    result.SetDelay(100);
+    result.SetRetCode(0);
+    result.SetRetStatus(polaris::kCallRetOk);
+    results.push_back(&result);
+  }
+  while (state.KeepRunning()) {
+    if (batch_size > 0) {
+      ret_code = consumer_->UpdateServiceCallResult(results);
+    } else {
+      ret_code = consumer_->UpdateServiceCallResult(result_list[0]);
+    }
+    if (ret_code != polaris::kReturnOk) {
+      std::string err_msg = "update call result for instance with error:" + polaris::ReturnCodeToMsg(ret_code);
+      state.SkipWithError(err_msg.c_str());
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * result_list.size());
+}
+
+BENCHMARK_REGISTER_F(BM_ConsumerApi, UpdateServiceCallResult)
+    ->Args({1, 10, 0})
+    ->Args({1, 10, 16})
+    ->Args({1, 10, 128})
+    ->ThreadRange(1, 8)
+    ->UseRealTime();
+
 BENCHMARK_DEFINE_F(BM_ConsumerApi, SlowGetOneInstance)(benchmark::State &state) {
   if (state.thread_index == 0) {
     InitServices(context_->GetLocalRegistry(), state);
@@ -221,4 +290,114 @@ BENCHMARK_REGISTER_F(BM_ConsumerApi, GetOneInstance)
     ->MinTime(2)
     ->UseRealTime();
 
+BENCHMARK_DEFINE_F(BM_ConsumerApi, PreparedGetOneInstance)(benchmark::State &state) {
+  if (state.thread_index == 0) {
+    InitServices(context_->GetLocalRegistry(), state);
+    Location location = {"华南", "深圳", "南山"};
+    context_->GetContextImpl()->GetClientLocation().Update(location);
+  }
+  ServiceKey service_key = {"benchmark_namespace", "benchmark_service_0"};
+  polaris::GetOneInstanceRequest request(service_key);
+  std::map<std::string, std::string> labels;
+  labels["benchmark_method_name"] = "benchmark_method_value";
+  request.SetLabels(labels);
+  polaris::InstancesResponse response;
+  polaris::ReturnCode ret_code;
+  uint64_t alloc_count = 0;
+  bool warmed_up = false;
+  while (state.KeepRunning()) {
+    if (!warmed_up) {  // 所有线程都开始运行后再预热复用对象，并使各级缓存的读表完成重建
+      state.PauseTiming();
+      for (int i = 0; i < 1000; ++i) {
+        if ((ret_code = consumer_->GetOneInstance(request, response)) != polaris::kReturnOk) {
+          break;
+        }
+      }
+      warmed_up = true;
+      alloc_count = g_thread_alloc_count;
+      state.ResumeTiming();
+    }
+    if ((ret_code = consumer_->GetOneInstance(request, response)) != polaris::kReturnOk) {
+      std::string err_msg = "get one instance failed:" + polaris::ReturnCodeToMsg(ret_code);
+      state.SkipWithError(err_msg.c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(response.GetInstances()[0].GetPort());
+  }
+  alloc_count = g_thread_alloc_count - alloc_count;
+  state.counters["allocs_per_op"] =
+      benchmark::Counter(static_cast<double>(alloc_count), benchmark::Counter::kAvgIterations);
+  if (alloc_count > 0) {  // 复用请求和应答对象时稳定状态下不应分配内存
+    std::string err_msg = "steady state get one instance allocated " + std::to_string(alloc_count) + " times";
+    state.SkipWithError(err_msg.c_str());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_ConsumerApi, PreparedGetOneInstance)
+    ->ArgPair(1, 1000)
+    ->ThreadRange(1, 8)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_ConsumerApi, GetInstancesResponse)(benchmark::State &state) {
+  if (state.thread_index == 0) {
+    InitServices(context_->GetLocalRegistry(), state);
+  }
+  ServiceKey service_key = {"benchmark_namespace", "benchmark_service_0"};
+  polaris::GetInstancesRequest request(service_key);
+  polaris::ReturnCode ret_code;
+  while (state.KeepRunning()) {
+    polaris::InstancesResponse *response = nullptr;
+    if ((ret_code = consumer_->GetInstances(request, response)) != polaris::kReturnOk) {
+      std::string err_msg = "get instances failed:" + polaris::ReturnCodeToMsg(ret_code);
+      state.SkipWithError(err_msg.c_str());
+      break;
+    }
+    std::vector<Instance> &instances = response->GetInstances();
+    for (std::size_t i = 0; i < instances.size(); ++i) {
+      benchmark::DoNotOptimize(instances[i].GetPort());
+    }
+    delete response;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_ConsumerApi, GetInstancesResponse)
+    ->ArgPair(1, 10)
+    ->ArgPair(1, 1000)
+    ->ArgPair(1, 10000)
+    ->ThreadRange(1, 8)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_ConsumerApi, GetInstancesView)(benchmark::State &state) {
+  if (state.thread_index == 0) {
+    InitServices(context_->GetLocalRegistry(), state);
+  }
+  ServiceKey service_key = {"benchmark_namespace", "benchmark_service_0"};
+  polaris::GetInstancesRequest request(service_key);
+  polaris::InstancesView view;
+  polaris::ReturnCode ret_code;
+  while (state.KeepRunning()) {
+    if ((ret_code = consumer_->GetInstances(request, view)) != polaris::kReturnOk) {
+      std::string err_msg = "get instances view failed:" + polaris::ReturnCodeToMsg(ret_code);
+      state.SkipWithError(err_msg.c_str());
+      break;
+    }
+    for (std::size_t i = 0; i < view.GetInstancesSize(); ++i) {
+      benchmark::DoNotOptimize(view.GetInstance(i).GetPort());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_ConsumerApi, GetInstancesView)
+    ->ArgPair(1, 10)
+    ->ArgPair(1, 1000)
+    ->ArgPair(1, 10000)
+    ->ThreadRange(1, 8)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
 }  // namespace polaris
@@ -16,14 +16,30 @@
 //
 
 #include <benchmark/benchmark.h>
+#include <stdlib.h>
+
+#include <math.h>
+
+#include <algorithm>
+#include <queue>
+#include <set>
+#include <unordered_map>
 
 #include "plugin/load_balancer/hash/hash_manager.h"
+#include "plugin/load_balancer/instance_load.h"
+#include "plugin/load_balancer/least_request.h"
+#include "plugin/load_balancer/locality_aware/locality_aware_selector.h"
 #include "plugin/load_balancer/maglev/entry_selector.h"
 #include "plugin/load_balancer/maglev/maglev.h"
+#include "plugin/load_balancer/peak_ewma.h"
+#include "plugin/load_balancer/rendezvous/rendezvous.h"
+#include "plugin/load_balancer/ringhash/bounded_load.h"
 #include "plugin/load_balancer/ringhash/continuum.h"
 #include "plugin/load_balancer/ringhash/ringhash.h"
 #include "plugin/load_balancer/weighted_random.h"
 #include "polaris/context.h"
+#include "utils/fast_random.h"
+#include "utils/time_clock.h"
 #include "v1/response.pb.h"
 
 namespace polaris {
@@ -130,6 +146,104 @@ BENCHMARK_REGISTER_F(BM_LoadBalance, RandomLB)
     ->MinTime(2)
     ->UseRealTime();
 
+// 权重分布：0-所有实例权重相同，1-权重按zipf分布，2-一个实例权重远大于其他实例
+static int GetBenchmarkWeight(int distribution, int index) {
+  switch (distribution) {
+    case 1:
+      return 10000 / (index + 1) + 1;
+    case 2:
+      return index == 0 ? 100000 : 10;
+    default:
+      return 100;
+  }
+}
+
+static void WeightedRandomArguments(benchmark::internal::Benchmark *benchmark) {
+  for (int instance_num = 4; instance_num <= 16384; instance_num *= 16) {
+    for (int distribution = 0; distribution < 3; ++distribution) {
+      benchmark->Args({instance_num, distribution});
+    }
+  }
+}
+
+// 加权随机选择：对比累加权重二分查找+rand_r与别名表+FastRandom在不同实例数和权重分布下的耗时
+class BM_WeightedRandom : public benchmark::Fixture {
+ public:
+  void SetUp(const ::benchmark::State &state) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    ServiceKey service_key = {"benchmark_namespace", "benchmark_service"};
+    instances_data_ = CreateService(state.range(0), service_key);
+    ServiceInstances service_instances(instances_data_);
+    InstancesSet *instances_set = service_instances.GetAvailableInstances();
+    std::vector<Instance *> instances = instances_set->GetInstances();
+    std::vector<WeightInstance> weight_instances;
+    sum_weight_ = 0;
+    for (std::size_t i = 0; i < instances.size(); ++i) {
+      int weight = GetBenchmarkWeight(state.range(1), i);
+      sum_weight_ += weight;
+      cumulative_weights_.push_back({sum_weight_, instances[i]});
+      weight_instances.push_back({weight, instances[i]});
+    }
+    lb_value_ = new RandomLbCacheValue();
+    lb_value_->prior_date_ = instances_set;
+    lb_value_->prior_date_->IncrementRef();
+    lb_value_->sum_weight_ = sum_weight_;
+    lb_value_->BuildAliasTable(weight_instances);
+  }
+
+  void TearDown(const ::benchmark::State &state) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    lb_value_->DecrementRef();
+    lb_value_ = nullptr;
+    cumulative_weights_.clear();
+    instances_data_->DecrementRef();
+    instances_data_ = nullptr;
+  }
+
+  struct CumulativeWeight {
+    int weight_;
+    Instance *instance_;
+
+    bool operator<(const CumulativeWeight &rhs) const { return weight_ < rhs.weight_; }
+  };
+
+  ServiceData *instances_data_;
+  int sum_weight_;
+  std::vector<CumulativeWeight> cumulative_weights_;
+  RandomLbCacheValue *lb_value_;
+};
+
+BENCHMARK_DEFINE_F(BM_WeightedRandom, BinarySearch)(benchmark::State &state) {
+  unsigned int seed = time(nullptr) ^ state.thread_index;
+  while (state.KeepRunning()) {
+    CumulativeWeight random_weight = {rand_r(&seed) % sum_weight_, nullptr};
+    benchmark::DoNotOptimize(
+        std::upper_bound(cumulative_weights_.begin(), cumulative_weights_.end(), random_weight)->instance_);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_WeightedRandom, BinarySearch)
+    ->Apply(WeightedRandomArguments)
+    ->ThreadRange(1, 4)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_WeightedRandom, AliasTable)(benchmark::State &state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(lb_value_->SelectInstance(FastRandom::Next()));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_WeightedRandom, AliasTable)
+    ->Apply(WeightedRandomArguments)
+    ->ThreadRange(1, 4)
+    ->UseRealTime();
+
 class BM_LBSimple : public benchmark::Fixture {
  public:
   void SetUp(const ::benchmark::State &state) {
@@ -233,6 +347,7 @@ class BM_LBSimple : public benchmark::Fixture {
   ServiceData *instances_data_;
   ServiceInstances *service_instances_;
   InstancesSet *instances_set_;
+  std::set<Instance *> half_open_instances_;
   ContinuumSelector *selector_;
   Hash64Func hash_func_;
   std::map<uint64_t, uint64_t> hashCache_;
@@ -248,7 +363,7 @@ BENCHMARK_DEFINE_F(BM_LBSimple, RingHash)(benchmark::State &state) {
   }
 
   while (state.KeepRunning()) {
-    selector_->Setup(instances_set_->GetInstances(), state.range(0), 0, false);
+    selector_->Setup(instances_set_->GetInstances(), half_open_instances_, state.range(0), 0, false);
   }
   if (0 == state.thread_index) {
     delete selector_;
@@ -274,7 +389,7 @@ BENCHMARK_DEFINE_F(BM_LBSimple, RingHashFast)(benchmark::State &state) {
   }
 
   while (state.KeepRunning()) {
-    selector_->FastSetup(instances_set_->GetInstances(), state.range(0), 0, false);
+    selector_->FastSetup(instances_set_->GetInstances(), half_open_instances_, state.range(0), 0, false);
   }
   if (0 == state.thread_index) {
     delete selector_;
@@ -292,6 +407,142 @@ BENCHMARK_REGISTER_F(BM_LBSimple, RingHashFast)
     ->Unit(benchmark::kMillisecond)
     ->UseRealTime();
 
+// 哈希环查找：对比有序数组二分查找和Eytzinger查找表在不同节点数下的单次查找耗时
+class BM_RingLookup : public benchmark::Fixture {
+ public:
+  void SetUp(const ::benchmark::State &state) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    for (int i = 0; i < state.range(0); ++i) {
+      ring_.push_back(ContinuumPoint(FastRandom::Next(), i));
+    }
+    std::sort(ring_.begin(), ring_.end());
+    eytzinger_ring_.Build(ring_);
+    for (std::size_t i = 0; i < kLookupHashCount; ++i) {
+      lookup_hashes_.push_back(FastRandom::Next());
+    }
+  }
+
+  void TearDown(const ::benchmark::State &state) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    ring_.clear();
+    lookup_hashes_.clear();
+  }
+
+  static const std::size_t kLookupHashCount = 1 << 16;
+  std::vector<ContinuumPoint> ring_;
+  EytzingerRing eytzinger_ring_;
+  std::vector<uint64_t> lookup_hashes_;
+};
+
+BENCHMARK_DEFINE_F(BM_RingLookup, BinarySearch)(benchmark::State &state) {
+  std::size_t i = 0;
+  while (state.KeepRunning()) {
+    uint64_t hash_value = lookup_hashes_[i++ & (kLookupHashCount - 1)];
+    auto position = std::lower_bound(ring_.begin(), ring_.end(), hash_value);
+    if (position == ring_.end()) {
+      position = ring_.begin();
+    }
+    benchmark::DoNotOptimize(position->index);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_RingLookup, BinarySearch)->RangeMultiplier(10)->Range(10000, 1000000)->ThreadRange(1, 4);
+
+BENCHMARK_DEFINE_F(BM_RingLookup, Eytzinger)(benchmark::State &state) {
+  std::size_t i = 0;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(eytzinger_ring_.Find(lookup_hashes_[i++ & (kLookupHashCount - 1)]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_RingLookup, Eytzinger)->RangeMultiplier(10)->Range(10000, 1000000)->ThreadRange(1, 4);
+
+// 实例变化时重建哈希环：对比全量构建和基于上一次哈希环增量构建的耗时，每次迭代轮流下线一个实例
+class BM_RingHashChurn : public BM_LBSimple {
+ public:
+  void SetUp(const ::benchmark::State &state) {
+    BM_LBSimple::SetUp(state);
+    if (state.thread_index != 0) {
+      return;
+    }
+    instances_set_ = service_instances_->GetAvailableInstances();
+    previous_selector_ = new ContinuumSelector(hash_func_);
+    previous_selector_->FastSetup(instances_set_->GetInstances(), half_open_instances_, state.range(1), 0, false);
+  }
+
+  void TearDown(const ::benchmark::State &state) {
+    if (state.thread_index == 0) {
+      delete previous_selector_;
+      previous_selector_ = nullptr;
+    }
+    BM_LBSimple::TearDown(state);
+  }
+
+  // 获取下线一个实例后的实例列表
+  void GetChurnInstances(std::size_t offline_index, std::vector<Instance *> &instances) {
+    const std::vector<Instance *> &all_instances = instances_set_->GetInstances();
+    instances.clear();
+    for (std::size_t i = 0; i < all_instances.size(); ++i) {
+      if (i != offline_index % all_instances.size()) {
+        instances.push_back(all_instances[i]);
+      }
+    }
+  }
+
+  ContinuumSelector *previous_selector_;
+};
+
+BENCHMARK_DEFINE_F(BM_RingHashChurn, FullSetup)(benchmark::State &state) {
+  std::vector<Instance *> instances;
+  std::size_t offline_index = 0;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    GetChurnInstances(offline_index++, instances);
+    ContinuumSelector selector(hash_func_);
+    state.ResumeTiming();
+    selector.FastSetup(instances, half_open_instances_, state.range(1), 0, false);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 这个不能多线程调用
+BENCHMARK_REGISTER_F(BM_RingHashChurn, FullSetup)
+    ->Args({256, 1024})
+    ->Args({2048, 1024})
+    ->Iterations(20)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_RingHashChurn, IncrementalSetup)(benchmark::State &state) {
+  std::vector<Instance *> instances;
+  std::size_t offline_index = 0;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    GetChurnInstances(offline_index++, instances);
+    ContinuumSelector selector(hash_func_);
+    state.ResumeTiming();
+    if (!selector.IncrementalSetup(*previous_selector_, instances, half_open_instances_, state.range(1), 0, false)) {
+      state.SkipWithError("incremental setup return failure");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 这个不能多线程调用
+BENCHMARK_REGISTER_F(BM_RingHashChurn, IncrementalSetup)
+    ->Args({256, 1024})
+    ->Args({2048, 1024})
+    ->Iterations(20)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
 BENCHMARK_DEFINE_F(BM_LBSimple, CohashNoKey)(benchmark::State &state) {
   if (state.thread_index == 0) {
     lb_ = new KetamaLoadBalancer();
@@ -324,6 +575,198 @@ BENCHMARK_REGISTER_F(BM_LBSimple, CohashWithKey)
     ->MinTime(2)
     ->UseRealTime();
 
+BENCHMARK_DEFINE_F(BM_LBSimple, RendezvousWithKey)(benchmark::State &state) {
+  if (state.thread_index == 0) {
+    lb_ = new RendezvousHashLoadBalancer();
+    lb_->Init(config_, context_);
+  }
+
+  BMWithKey(state);
+}
+
+BENCHMARK_REGISTER_F(BM_LBSimple, RendezvousWithKey)
+    ->ThreadRange(1, 8)
+    ->RangeMultiplier(4)
+    ->Range(4, 4 << 10)
+    ->MinTime(2)
+    ->UseRealTime();
+
+// 只统计选择器打分的开销，编译时开启AVX2可对比向量化效果
+BENCHMARK_DEFINE_F(BM_LBSimple, RendezvousSelect)(benchmark::State &state) {
+  RendezvousSelector selector;
+  std::set<Instance *> half_open_instances;
+  selector.Setup(service_instances_->GetAvailableInstances()->GetInstances(), half_open_instances, false);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(selector.Select(FastRandom::Next()));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_LBSimple, RendezvousSelect)->Arg(16)->Arg(128)->Arg(512)->Arg(2048);
+
+// 热点key下的负载分布：请求key按zipf分布，保持每个实例平均8个进行中的请求，
+// 最早的请求结束后再发起新请求，统计实例最大进行中请求数与平均值之比。参数1为0时使用ringHash，为1时使用有界负载
+BENCHMARK_DEFINE_F(BM_LBSimple, SkewedKeyLoad)(benchmark::State &state) {
+  if (state.range(1) == 0) {
+    lb_ = new KetamaLoadBalancer();
+  } else {
+    lb_ = new BoundedLoadHashLoadBalancer();
+  }
+  lb_->Init(config_, context_);
+  const int key_count = 1000;
+  std::vector<double> cumulative_probability;
+  double sum_probability = 0;
+  for (int i = 0; i < key_count; ++i) {
+    sum_probability += 1.0 / (i + 1);
+    cumulative_probability.push_back(sum_probability);
+  }
+  std::vector<uint64_t> hash_keys(65536);
+  for (std::size_t i = 0; i < hash_keys.size(); ++i) {
+    double random = static_cast<double>(FastRandom::Next() >> 11) / (1ULL << 53) * sum_probability;
+    hash_keys[i] = std::lower_bound(cumulative_probability.begin(), cumulative_probability.end(), random) -
+                   cumulative_probability.begin() + 1;
+  }
+  const std::vector<Instance *> &instances = service_instances_->GetAvailableInstances()->GetInstances();
+  std::unordered_map<Instance *, std::size_t> instance_index;
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    instance_index[instances[i]] = i;
+  }
+  std::vector<int> loads(instances.size(), 0);
+  std::vector<Instance *> inflight_requests(instances.size() * 8, nullptr);
+  std::size_t request_index = 0;
+  int max_load = 0;
+  Criteria criteria;
+  Instance *instance = nullptr;
+  lb_->ChooseInstance(service_instances_, criteria, instance);  // 提前构建哈希环
+  InstanceLoadTracker::ReleaseInflight(instance);
+  while (state.KeepRunning()) {
+    std::size_t position = request_index % inflight_requests.size();
+    Instance *&request = inflight_requests[position];
+    if (request != nullptr) {
+      InstanceLoadTracker::ReleaseInflight(request);
+      loads[instance_index[request]]--;
+    }
+    criteria.hash_key_ = hash_keys[request_index++ % hash_keys.size()];
+    if (lb_->ChooseInstance(service_instances_, criteria, request) != kReturnOk) {
+      state.SkipWithError("choose instance return error");
+      break;
+    }
+    int &load = loads[instance_index[request]];
+    if (++load > max_load && request_index > inflight_requests.size()) {
+      max_load = load;
+    }
+  }
+  for (std::size_t i = 0; i < inflight_requests.size(); ++i) {
+    if (inflight_requests[i] != nullptr) {
+      InstanceLoadTracker::ReleaseInflight(inflight_requests[i]);
+    }
+  }
+  delete lb_;
+  lb_ = nullptr;
+  state.counters["max_mean_ratio"] = max_load / 8.0;
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_LBSimple, SkewedKeyLoad)
+    ->Args({64, 0})
+    ->Args({64, 1})
+    ->Args({1024, 0})
+    ->Args({1024, 1})
+    ->UseRealTime();
+
+// 模拟时钟，峰值耗时加权平均按模拟时间衰减
+static uint64_t g_simulate_time_ms = 0;
+
+static uint64_t SimulateTime() { return g_simulate_time_ms; }
+
+struct SimulateRequest {
+  double finish_time_;
+  double latency_;
+  Instance *instance_;
+
+  bool operator>(const SimulateRequest &rhs) const { return finish_time_ > rhs.finish_time_; }
+};
+
+// 模拟实例处理能力不同时的请求耗时：每个实例按先进先出处理请求，1/10的实例处理耗时为其他实例的5倍，
+// 请求按泊松过程到达，总请求速率为所有实例处理能力之和的70%。耗时以正常实例处理一个请求的时间为单位，
+// 一个单位对应10ms模拟时间
+BENCHMARK_DEFINE_F(BM_LBSimple, HeterogeneousLatency)(benchmark::State &state) {
+  const double kTimeUnitMs = 10;
+  if (state.range(1) == 0) {
+    lb_ = new RandomLoadBalancer();
+  } else if (state.range(1) == 1) {
+    lb_ = new LeastRequestLoadBalancer();
+  } else {
+    lb_ = new PeakEwmaLoadBalancer();
+  }
+  lb_->Init(config_, context_);
+  g_simulate_time_ms = 0;
+  Time::SetCustomTimeFunc(SimulateTime, SimulateTime);
+  const std::vector<Instance *> &instances = service_instances_->GetAvailableInstances()->GetInstances();
+  std::unordered_map<Instance *, std::size_t> instance_index;
+  std::vector<double> service_times(instances.size(), 1.0);
+  double capacity = 0;
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    instance_index[instances[i]] = i;
+    if (i % 10 == 0) {
+      service_times[i] = 5.0;
+    }
+    capacity += 1.0 / service_times[i];
+  }
+  const double arrival_interval = 1.0 / (capacity * 0.7);
+  std::priority_queue<SimulateRequest, std::vector<SimulateRequest>, std::greater<SimulateRequest> > requests;
+  std::vector<double> idle_times(instances.size(), 0);
+  std::vector<double> latencies;
+  latencies.reserve(state.max_iterations);
+  double now = 0;
+  Criteria criteria;
+  while (state.KeepRunning()) {
+    now += -log(1 - static_cast<double>(FastRandom::Next() >> 11) / (1ULL << 53)) * arrival_interval;
+    while (!requests.empty() && requests.top().finish_time_ <= now) {  // 上报调用结果
+      const SimulateRequest &request = requests.top();
+      g_simulate_time_ms = static_cast<uint64_t>(request.finish_time_ * kTimeUnitMs);
+      InstanceLoadTracker::ReleaseInflight(request.instance_);
+      InstanceLoadTracker::UpdateLatency(request.instance_, request.latency_ * kTimeUnitMs * 1000, g_simulate_time_ms);
+      requests.pop();
+    }
+    g_simulate_time_ms = static_cast<uint64_t>(now * kTimeUnitMs);
+    Instance *instance = nullptr;
+    if (lb_->ChooseInstance(service_instances_, criteria, instance) != kReturnOk) {
+      state.SkipWithError("choose instance return error");
+      break;
+    }
+    std::size_t index = instance_index[instance];
+    double finish_time = std::max(now, idle_times[index]) + service_times[index];
+    idle_times[index] = finish_time;
+    requests.push({finish_time, finish_time - now, instance});
+    latencies.push_back(finish_time - now);
+  }
+  while (!requests.empty()) {
+    InstanceLoadTracker::ReleaseInflight(requests.top().instance_);
+    requests.pop();
+  }
+  Time::SetDefaultTimeFunc();
+  delete lb_;
+  lb_ = nullptr;
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    state.counters["p50"] = latencies[latencies.size() / 2];
+    state.counters["p99"] = latencies[latencies.size() * 99 / 100];
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 固定请求数，使排队时长可比较
+BENCHMARK_REGISTER_F(BM_LBSimple, HeterogeneousLatency)
+    ->Args({20, 0})
+    ->Args({20, 1})
+    ->Args({20, 2})
+    ->Args({200, 0})
+    ->Args({200, 1})
+    ->Args({200, 2})
+    ->Iterations(200000)
+    ->UseRealTime();
+
 class BM_LBMaglev : public BM_LBSimple {
  public:
   virtual void SetupConfig() {
@@ -351,7 +794,7 @@ BENCHMARK_DEFINE_F(BM_LBMaglev, BuildLookupTable)(benchmark::State &state) {
   }
 
   while (state.KeepRunning()) {
-    if (!maglev_selector_->Setup(instances_set_, state.range(0), hash_func_)) {
+    if (!maglev_selector_->Setup(instances_set_, state.range(0), hash_func_, false)) {
       state.SkipWithError("Setup return failure");
       break;
     }
@@ -374,6 +817,47 @@ BENCHMARK_REGISTER_F(BM_LBMaglev, BuildLookupTable)
     ->MinTime(2)
     ->UseRealTime();
 
+// 下线一个实例后基于上一次的查找表增量构建
+BENCHMARK_DEFINE_F(BM_LBMaglev, IncrementalBuildLookupTable)(benchmark::State &state) {
+  MaglevEntrySelector previous;
+  std::vector<Instance *> instances;
+  if (0 == state.thread_index) {
+    instances_set_ = service_instances_->GetAvailableInstances();
+    instances = instances_set_->GetInstances();
+    if (!previous.Setup(instances_set_, state.range(1), hash_func_, true)) {
+      state.SkipWithError("Setup return failure");
+      return;
+    }
+  }
+
+  std::size_t offline_index = 0;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    std::vector<Instance *> churn_instances(instances);
+    churn_instances.erase(churn_instances.begin() + offline_index++ % instances.size());
+    InstancesSet *churn_set = new InstancesSet(churn_instances);
+    MaglevEntrySelector selector;
+    state.ResumeTiming();
+    bool result = selector.IncrementalSetup(previous, churn_set);
+    state.PauseTiming();
+    churn_set->DecrementRef();
+    state.ResumeTiming();
+    if (!result) {
+      state.SkipWithError("IncrementalSetup return failure");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 这个不能多线程调用
+BENCHMARK_REGISTER_F(BM_LBMaglev, IncrementalBuildLookupTable)
+    ->Args({1000, 65537})
+    ->Args({1000, 655373})
+    ->Iterations(100)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
 BENCHMARK_DEFINE_F(BM_LBMaglev, CohashNoKey)(benchmark::State &state) {
   if (state.thread_index == 0) {
     lb_ = new MaglevLoadBalancer();
@@ -406,4 +890,53 @@ BENCHMARK_REGISTER_F(BM_LBMaglev, CohashWithKey)
     ->MinTime(2)
     ->UseRealTime();
 
+// 局部感知选择器多线程选择并反馈：每次选出实例后立即上报调用延时，衡量反馈路径的竞争开销
+class BM_LocalityAwareSelector : public benchmark::Fixture {
+ public:
+  void SetUp(const ::benchmark::State &state) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    // 其他线程退出时才会释放线程私有的读锁，因此在下一轮开始时再释放上一轮的选择器
+    delete selector_;
+    selector_ = new LocalityAwareSelector(1000);
+    for (int i = 0; i < state.range(0); ++i) {
+      selector_->AddInstance("instance_" + std::to_string(i));
+    }
+  }
+
+  static LocalityAwareSelector *selector_;
+};
+
+LocalityAwareSelector *BM_LocalityAwareSelector::selector_ = nullptr;
+
+BENCHMARK_DEFINE_F(BM_LocalityAwareSelector, SelectWithFeedback)(benchmark::State &state) {
+  SelectIn in;
+  in.changable_weights = true;
+  CallInfo call_info;
+  int64_t select_failed = 0;
+  while (state.KeepRunning()) {
+    SelectOut out;
+    in.begin_time_us = Time::GetSteadyTimeUs();
+    if (selector_->SelectInstance(in, &out) != kReturnOk) {
+      ++select_failed;  // 负载均衡插件中会使用加权随机兜底
+      continue;
+    }
+    call_info.call_daley = 1000 + (FastRandom::Next() & 1023);
+    call_info.begin_time_us = in.begin_time_us;
+    call_info.instance_id = out.instance_id;
+    call_info.index = out.index;
+    selector_->Feedback(call_info);
+  }
+  state.counters["select_failed"] = select_failed;
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_LocalityAwareSelector, SelectWithFeedback)
+    ->ThreadRange(1, 8)
+    ->Arg(16)
+    ->Arg(256)
+    ->MinTime(2)
+    ->UseRealTime();
+
 }  // namespace polaris
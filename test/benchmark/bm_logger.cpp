@@ -0,0 +1,59 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use
+//  this file
+//  except in compliance with the License. You may obtain a copy of the License
+//  at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//  specific
+//  language governing permissions and limitations under the License.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "logger.h"
+
+namespace polaris {
+
+class BM_Logger : public benchmark::Fixture {
+ public:
+  void SetUp(const ::benchmark::State &state) {
+    if (state.thread_index == 0) {
+      logger_.reset(new LoggerImpl("/tmp/polaris_bm_log", "bm_logger.log", 64 * 1024 * 1024, 2));
+      if (state.range(0) != 0) {
+        logger_->EnableAsync(state.range(0));
+      }
+    }
+  }
+
+  void TearDown(const ::benchmark::State &state) {
+    if (state.thread_index == 0) {
+      logger_.reset();
+    }
+  }
+
+ protected:
+  std::unique_ptr<LoggerImpl> logger_;
+};
+
+// 多线程同时输出错误日志模拟下游故障时的日志风暴，参数为异步缓冲区大小，0表示同步输出
+BENCHMARK_DEFINE_F(BM_Logger, LogStorm)
+(benchmark::State &state) {
+  while (state.KeepRunning()) {
+    logger_->Log(LOG_ERROR, "get one instance for service[%s/%s] failed with error:%d", "benchmark_namespace",
+                 "benchmark_service", 1004);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_Logger, LogStorm)->Arg(0)->Arg(1024)->Arg(16384)->ThreadRange(1, 16)->UseRealTime();
+
+}  // namespace polaris
@@ -0,0 +1,94 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use
+//  this file
+//  except in compliance with the License. You may obtain a copy of the License
+//  at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//  specific
+//  language governing permissions and limitations under the License.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <stdlib.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cache/rcu_hash_map.h"
+#include "cache/rcu_map.h"
+#include "cache/service_cache.h"
+
+namespace polaris {
+
+// 使用规则路由缓存Key对比std::map与开放寻址hash表实现的读取性能
+template <typename Map>
+class BM_RcuMapLookup : public benchmark::Fixture {
+ public:
+  void SetUp(const ::benchmark::State &state) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    int key_count = state.range(0);
+    keys_.resize(key_count);
+    map_.reset(new Map());
+    for (int i = 0; i < key_count; ++i) {
+      RuleRouteCacheKey &key = keys_[i];
+      key.prior_data_ = reinterpret_cast<InstancesSet *>(0x10000 + (i % 64) * 64);
+      key.route_key_ = reinterpret_cast<RouteRuleBound *>(0x20000 + (i / 64) * 64);
+      key.circuit_breaker_version_ = i % 3;
+      key.subset_circuit_breaker_version_ = 0;
+      key.labels_ = "method:Echo";
+      key.request_flags_ = 0;
+      map_->Update(key, new ServiceBase());
+    }
+    // 读取全部key，使dirty map交换成read map，后续读取无锁
+    for (int i = 0; i < key_count; ++i) {
+      map_->GetWithRcuTime(keys_[i]);
+    }
+  }
+
+  void TearDown(const ::benchmark::State &state) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    map_.reset();
+    keys_.clear();
+  }
+
+  void RunLookup(benchmark::State &state) {
+    unsigned int seed = state.thread_index + 1;
+    std::size_t key_count = keys_.size();
+    while (state.KeepRunning()) {
+      benchmark::DoNotOptimize(map_->GetWithRcuTime(keys_[rand_r(&seed) % key_count]));
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+
+ protected:
+  std::vector<RuleRouteCacheKey> keys_;
+  std::unique_ptr<Map> map_;
+};
+
+typedef RcuMap<RuleRouteCacheKey, ServiceBase> RuleRouteRcuMap;
+typedef RcuHashMap<RuleRouteCacheKey, ServiceBase> RuleRouteRcuHashMap;
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_RcuMapLookup, RcuMap, RuleRouteRcuMap)
+(benchmark::State &state) { RunLookup(state); }
+
+BENCHMARK_TEMPLATE_DEFINE_F(BM_RcuMapLookup, RcuHashMap, RuleRouteRcuHashMap)
+(benchmark::State &state) { RunLookup(state); }
+
+BENCHMARK_REGISTER_F(BM_RcuMapLookup, RcuMap)->Arg(1000)->Arg(100000)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_REGISTER_F(BM_RcuMapLookup, RcuHashMap)->Arg(1000)->Arg(100000)->ThreadRange(1, 8)->UseRealTime();
+
+}  // namespace polaris
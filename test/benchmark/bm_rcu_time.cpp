@@ -0,0 +1,74 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use
+//  this file
+//  except in compliance with the License. You may obtain a copy of the License
+//  at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//  specific
+//  language governing permissions and limitations under the License.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "cache/rcu_time.h"
+
+namespace polaris {
+
+class BM_ThreadTimeMgr : public benchmark::Fixture {
+ public:
+  void SetUp(const ::benchmark::State &state) {
+    if (state.thread_index == 0) {
+      thread_time_mgr_.reset(new ThreadTimeMgr());
+    }
+  }
+
+  void TearDown(const ::benchmark::State &state) {
+    if (state.thread_index == 0) {
+      thread_time_mgr_.reset();
+    }
+  }
+
+ protected:
+  std::unique_ptr<ThreadTimeMgr> thread_time_mgr_;
+};
+
+// 请求线程进出RCU区域，线程数增加时单次耗时应保持稳定
+BENCHMARK_DEFINE_F(BM_ThreadTimeMgr, RcuEnterExit)
+(benchmark::State &state) {
+  while (state.KeepRunning()) {
+    thread_time_mgr_->RcuEnter();
+    thread_time_mgr_->RcuExit();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_ThreadTimeMgr, RcuEnterExit)->ThreadRange(1, 64)->Threads(128)->UseRealTime();
+
+// 请求线程进出RCU区域的同时，由一个线程持续计算最小时间模拟GC线程
+BENCHMARK_DEFINE_F(BM_ThreadTimeMgr, RcuEnterExitWithMinTime)
+(benchmark::State &state) {
+  if (state.thread_index == 0) {
+    while (state.KeepRunning()) {
+      benchmark::DoNotOptimize(thread_time_mgr_->MinTime());
+    }
+  } else {
+    while (state.KeepRunning()) {
+      thread_time_mgr_->RcuEnter();
+      thread_time_mgr_->RcuExit();
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_ThreadTimeMgr, RcuEnterExitWithMinTime)->ThreadRange(2, 64)->Threads(128)->UseRealTime();
+
+}  // namespace polaris
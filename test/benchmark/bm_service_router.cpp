@@ -18,7 +18,15 @@
 #include <benchmark/benchmark.h>
 
 #include "context/context_impl.h"
+#include "context/service_context.h"
+#include "model/route_rule_matcher.h"
+#include "model/instance.h"
+#include "model/instances_bitset.h"
+#include "model/model_impl.h"
+#include "model/service_route_rule.h"
 #include "mock/fake_server_response.h"
+#include "plugin/service_router/nearby_router.h"
+#include "polaris/config.h"
 #include "polaris/context.h"
 #include "polaris/log.h"
 #include "test_utils.h"
@@ -153,4 +161,353 @@ BENCHMARK_REGISTER_F(BM_ServiceRouter, DoRoute)
     ->MinTime(10)
     ->UseRealTime();
 
+// 规则路由来源匹配：对比逐条规则匹配与编译后的匹配器在不同规则数下的耗时
+// 每条规则匹配不同的uid取值，并带有正则匹配条件，请求只匹配最后一条规则
+class BM_RouteRuleMatch : public benchmark::Fixture {
+ public:
+  void SetUp(const ::benchmark::State &state) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    int rule_count = state.range(0);
+    bounds_.reset(new std::vector<RouteRuleBound>(rule_count));
+    for (int i = 0; i < rule_count; ++i) {
+      v1::Route route;
+      v1::Source *source = route.add_sources();
+      v1::MatchString &uid = (*source->mutable_metadata())["uid"];
+      uid.set_type(v1::MatchString::EXACT);
+      uid.mutable_value()->set_value("uid_" + std::to_string(i));
+      v1::MatchString &env = (*source->mutable_metadata())["env"];
+      env.set_type(v1::MatchString::REGEX);
+      env.mutable_value()->set_value("^env_" + std::to_string(i % 10) + "$");
+      (*bounds_)[i].route_rule_.InitFromPb(route);
+    }
+    matcher_.reset(new RouteRuleMatcher());
+    matcher_->Compile(*bounds_);
+    service_info_.service_key_.namespace_ = "benchmark_namespace";
+    service_info_.service_key_.name_ = "benchmark_caller";
+    service_info_.metadata_["uid"] = "uid_" + std::to_string(rule_count - 1);
+    service_info_.metadata_["env"] = "env_" + std::to_string((rule_count - 1) % 10);
+    dst_service_.namespace_ = "benchmark_namespace";
+    dst_service_.name_ = "benchmark_service";
+  }
+
+  void TearDown(const ::benchmark::State &state) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    matcher_.reset();
+    bounds_.reset();
+  }
+
+  std::unique_ptr<std::vector<RouteRuleBound> > bounds_;
+  std::unique_ptr<RouteRuleMatcher> matcher_;
+  ServiceInfo service_info_;
+  ServiceKey dst_service_;
+};
+
+BENCHMARK_DEFINE_F(BM_RouteRuleMatch, LinearMatch)(benchmark::State &state) {
+  std::string parameters;
+  while (state.KeepRunning()) {
+    int matched = -1;
+    for (std::size_t i = 0; i < bounds_->size(); ++i) {
+      if ((*bounds_)[i].route_rule_.MatchSource(&service_info_, dst_service_, parameters)) {
+        matched = i;
+        break;
+      }
+    }
+    benchmark::DoNotOptimize(matched);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_RouteRuleMatch, LinearMatch)->RangeMultiplier(10)->Range(10, 1000);
+
+BENCHMARK_DEFINE_F(BM_RouteRuleMatch, CompiledMatch)(benchmark::State &state) {
+  std::string parameters;
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(
+        matcher_->Match(service_info_.service_key_, dst_service_, service_info_.metadata_, parameters));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_RouteRuleMatch, CompiledMatch)->RangeMultiplier(10)->Range(10, 1000);
+
+// 实例分布在5个region的50个zone中，每个zone有4个campus，主调位于第一个zone
+// 每次计算前翻转一个实例的熔断状态，模拟熔断状态频繁变化导致就近路由缓存失效
+class BM_NearbyRouterCluster : public benchmark::Fixture {
+ public:
+  void SetUp(const ::benchmark::State &state) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    int instance_num = state.range(0);
+    for (int i = 0; i < instance_num; ++i) {
+      v1::Instance instance_pb;
+      instance_pb.mutable_id()->set_value("instance_" + std::to_string(i));
+      instance_pb.mutable_host()->set_value("host");
+      instance_pb.mutable_port()->set_value(8000 + i);
+      instance_pb.mutable_weight()->set_value(100);
+      int zone = i % 50;
+      v1::Location *location = instance_pb.mutable_location();
+      location->mutable_region()->set_value("region_" + std::to_string(zone % 5));
+      location->mutable_zone()->set_value("zone_" + std::to_string(zone));
+      location->mutable_campus()->set_value("campus_" + std::to_string(i / 50 % 4));
+      Instance *instance = new Instance();
+      instance->GetImpl().InitFromPb(instance_pb);
+      instance->GetImpl().SetDenseIndex(i);
+      instances_.push_back(instance);
+    }
+    unhealthy_bitset_.Resize(instances_.size());
+    std::string err_msg;
+    Config *config = Config::CreateFromString("matchLevel: zone", err_msg);
+    nearby_config_.Init(config);
+    delete config;
+    location_.region = "region_0";
+    location_.zone = "zone_0";
+    location_.campus = "campus_0";
+    index_.reset(new NearbyLocationIndex(instances_));
+  }
+
+  void TearDown(const ::benchmark::State &state) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    index_.reset();
+    for (std::size_t i = 0; i < instances_.size(); ++i) {
+      delete instances_[i];
+    }
+    instances_.clear();
+    unhealthy_set_.clear();
+    unhealthy_bitset_.Resize(0);
+  }
+
+  void FlipCircuitBreaker(std::size_t round) {
+    Instance *instance = instances_[round * 7919 % instances_.size()];
+    if (unhealthy_set_.erase(instance) == 0) {
+      unhealthy_set_.insert(instance);
+    }
+    std::size_t index = instance->GetImpl().GetDenseIndex();
+    if (unhealthy_bitset_.Contains(instance)) {
+      unhealthy_bitset_.GetBits().Reset(index);
+    } else {
+      unhealthy_bitset_.GetBits().Set(index);
+    }
+  }
+
+  std::vector<Instance *> instances_;
+  std::set<Instance *> unhealthy_set_;  // 线性扫描使用，对比按实例指针查找集合的开销
+  InstancesBitset unhealthy_bitset_;
+  NearbyRouterConfig nearby_config_;
+  Location location_;
+  std::unique_ptr<NearbyLocationIndex> index_;
+};
+
+BENCHMARK_DEFINE_F(BM_NearbyRouterCluster, LinearScan)(benchmark::State &state) {
+  std::size_t round = 0;
+  while (state.KeepRunning()) {
+    FlipCircuitBreaker(round++);
+    std::vector<NearbyRouterSet> data(nearby_config_.GetMatchLevel() + 1);
+    for (std::size_t i = 0; i < instances_.size(); ++i) {
+      Instance *instance = instances_[i];
+      int level = 0;
+      if (location_.region == instance->GetRegion()) {
+        ++level;
+        if (location_.zone == instance->GetZone()) {
+          ++level;
+        }
+      }
+      if (unhealthy_set_.find(instance) == unhealthy_set_.end()) {
+        data[level].healthy_.push_back(instance);
+      } else {
+        data[level].unhealthy_.push_back(instance);
+      }
+    }
+    benchmark::DoNotOptimize(data);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_NearbyRouterCluster, LinearScan)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_DEFINE_F(BM_NearbyRouterCluster, IndexLookup)(benchmark::State &state) {
+  std::size_t round = 0;
+  while (state.KeepRunning()) {
+    FlipCircuitBreaker(round++);
+    NearbyRouterCluster cluster(nearby_config_);
+    cluster.CalculateSet(location_, *index_, unhealthy_bitset_);
+    benchmark::DoNotOptimize(cluster);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_NearbyRouterCluster, IndexLookup)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_DEFINE_F(BM_NearbyRouterCluster, BuildIndex)(benchmark::State &state) {
+  while (state.KeepRunning()) {
+    NearbyLocationIndex index(instances_);
+    benchmark::DoNotOptimize(index);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_NearbyRouterCluster, BuildIndex)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+// 开启规则路由、就近路由、元数据路由和金丝雀路由4个路由插件，对比路由结果缓存命中与全部失效时整条路由链的耗时
+// 实例按 env 分为 base 和 test，按 version 分为4组，分布在5个region的50个zone中，每10个实例中有1个金丝雀实例
+// 第二个参数控制是否开启路由链缓存，关闭时只使用各路由插件的缓存
+class BM_ServiceRouterChain : public BM_ServiceRouter {
+ public:
+  void SetUp(const ::benchmark::State &state) {
+    if (state.thread_index != 0) {
+      return;
+    }
+    TestUtils::CreateTempDir(log_dir_);
+    SetLogDir(log_dir_);
+    GetLogger()->SetLogLevel(kInfoLogLevel);
+    service_key_.namespace_ = "benchmark_namespace";
+    service_key_.name_ = "benchmark_service";
+    TestUtils::CreateTempDir(persist_dir_);
+    std::string err_msg, content =
+                             "global:\n"
+                             "  serverConnector:\n"
+                             "    addresses: ['Fake:42']"
+                             "\nconsumer:\n"
+                             "  localCache:\n"
+                             "    persistDir: " +
+                             persist_dir_ +
+                             "\n  serviceRouter:\n"
+                             "    enableChainCache: " +
+                             (state.range(1) != 0 ? "true" : "false") +
+                             "\n    chain:\n"
+                             "      - ruleBasedRouter\n"
+                             "      - nearbyBasedRouter\n"
+                             "      - dstMetaRouter\n"
+                             "      - canaryRouter\n"
+                             "    plugin:\n"
+                             "      nearbyBasedRouter:\n"
+                             "        matchLevel: region";
+    Config *config = Config::CreateFromString(content, err_msg);
+    if (config == nullptr) {
+      std::cout << "create config with error: " << err_msg << std::endl;
+      exit(-1);
+    }
+    context_ = Context::Create(config);
+    delete config;
+    if (context_ == nullptr) {
+      std::cout << "create context failed" << std::endl;
+      exit(-1);
+    }
+    chain_ = context_->GetContextImpl()->GetServiceContext(service_key_)->GetServiceRouterChain();
+    if (InitService(state.range(0)) != kReturnOk) {
+      std::cout << "init service data failed" << std::endl;
+      exit(-1);
+    }
+    Location location = {"region_0", "zone_0", "campus_0"};
+    context_->GetContextImpl()->GetClientLocation().Update(location);
+    source_service_.service_key_ = service_key_;
+    source_service_.metadata_["env"] = "base";
+    metadata_param_.metadata_["version"] = "v1";
+  }
+
+  ReturnCode InitService(int instance_num) {
+    LocalRegistry *local_registry = context_->GetLocalRegistry();
+    ServiceDataNotify *data_notify = nullptr;
+    ServiceData *service_data = nullptr;
+    ReturnCode ret_code;
+    if ((ret_code = local_registry->LoadServiceDataWithNotify(service_key_, kServiceDataInstances, service_data,
+                                                              data_notify)) != kReturnOk ||
+        (ret_code = local_registry->LoadServiceDataWithNotify(service_key_, kServiceDataRouteRule, service_data,
+                                                              data_notify)) != kReturnOk) {
+      return ret_code;
+    }
+    v1::DiscoverResponse response;
+    response.mutable_code()->set_value(v1::ExecuteSuccess);
+    FakeServer::InstancesResponse(response, service_key_, "version_one");
+    (*response.mutable_service()->mutable_metadata())["internal-canary"] = "true";
+    for (int i = 0; i < instance_num; ++i) {
+      v1::Instance *instance = response.add_instances();
+      instance->mutable_namespace_()->set_value(service_key_.namespace_);
+      instance->mutable_service()->set_value(service_key_.name_);
+      instance->mutable_id()->set_value("instance_" + std::to_string(i));
+      instance->mutable_host()->set_value("host_" + std::to_string(i));
+      instance->mutable_port()->set_value(1000 + i);
+      instance->mutable_weight()->set_value(100);
+      int zone = i % 50;
+      v1::Location *location = instance->mutable_location();
+      location->mutable_region()->set_value("region_" + std::to_string(zone % 5));
+      location->mutable_zone()->set_value("zone_" + std::to_string(zone));
+      location->mutable_campus()->set_value("campus_" + std::to_string(i / 50 % 4));
+      (*instance->mutable_metadata())["env"] = i % 2 == 0 ? "base" : "test";
+      (*instance->mutable_metadata())["version"] = "v" + std::to_string(i / 2 % 4);
+      if (i % 10 == 9) {
+        (*instance->mutable_metadata())["canary"] = "true";
+      }
+    }
+    service_data = ServiceData::CreateFromPb(&response, kDataIsSyncing);
+    if ((ret_code = local_registry->UpdateServiceData(service_key_, kServiceDataInstances, service_data)) !=
+        kReturnOk) {
+      return ret_code;
+    }
+    FakeServer::CreateServiceRoute(response, service_key_, true);
+    service_data = ServiceData::CreateFromPb(&response, kDataIsSyncing);
+    return local_registry->UpdateServiceData(service_key_, kServiceDataRouteRule, service_data);
+  }
+
+  // 执行一次路由，circuit_breaker_version 变化时所有路由插件的结果缓存都不会命中
+  bool DoRoute(benchmark::State &state, uint64_t circuit_breaker_version) {
+    RouteInfo route_info(service_key_, &source_service_);
+    route_info.SetMetadataPara(metadata_param_);
+    if (chain_->PrepareRouteInfo(route_info, 1000) != kReturnOk) {
+      state.SkipWithError("prepare service data return error");
+      return false;
+    }
+    route_info.SetCircuitBreakerVersion(circuit_breaker_version);
+    RouteResult route_result;
+    if (chain_->DoRoute(route_info, &route_result) != kReturnOk) {
+      state.SkipWithError("do route return error");
+      return false;
+    }
+    benchmark::DoNotOptimize(route_info.GetServiceInstances()->GetAvailableInstances());
+    return true;
+  }
+
+  ServiceInfo source_service_;
+  MetadataRouterParam metadata_param_;
+};
+
+BENCHMARK_DEFINE_F(BM_ServiceRouterChain, CachedRoute)(benchmark::State &state) {
+  while (state.KeepRunning()) {
+    if (!DoRoute(state, 0)) {
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_ServiceRouterChain, CachedRoute)
+    ->Args({1000, 0})
+    ->Args({1000, 1})
+    ->Args({10000, 0})
+    ->Args({10000, 1})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_ServiceRouterChain, RebuildRoute)(benchmark::State &state) {
+  uint64_t circuit_breaker_version = 0;
+  while (state.KeepRunning()) {
+    if (!DoRoute(state, ++circuit_breaker_version)) {
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(BM_ServiceRouterChain, RebuildRoute)
+    ->Args({1000, 1})
+    ->Args({10000, 1})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
 }  // namespace polaris
@@ -0,0 +1,159 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use
+//  this file
+//  except in compliance with the License. You may obtain a copy of the License
+//  at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//  specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "cache/cache_manager.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mock/fake_server_response.h"
+#include "test_context.h"
+
+namespace polaris {
+
+// 实例ID和实例的host:port
+typedef std::vector<std::pair<std::string, std::pair<std::string, int>>> InstanceList;
+
+class CacheManagerHostPortTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    context_ = TestContext::CreateContext();
+    ASSERT_TRUE(context_ != nullptr);
+    cache_manager_ = context_->GetContextImpl()->GetCacheManager();
+    service_key_.namespace_ = "cache_manager_test_namespace";
+    service_key_.name_ = "cache_manager_test_service";
+    revision_ = 0;
+    ServiceDataNotify* data_notify = nullptr;
+    ServiceData* service_data = nullptr;
+    ASSERT_EQ(context_->GetLocalRegistry()->LoadServiceDataWithNotify(service_key_, kServiceDataInstances,
+                                                                      service_data, data_notify),
+              kReturnOk);
+  }
+
+  virtual void TearDown() {
+    if (context_ != nullptr) {
+      delete context_;
+      context_ = nullptr;
+    }
+  }
+
+  ServiceData* UpdateInstances(const InstanceList& instances) {
+    v1::DiscoverResponse response;
+    response.mutable_code()->set_value(v1::ExecuteSuccess);
+    FakeServer::InstancesResponse(response, service_key_, "version_" + std::to_string(++revision_));
+    for (std::size_t i = 0; i < instances.size(); ++i) {
+      v1::Instance* instance = response.add_instances();
+      instance->mutable_namespace_()->set_value(service_key_.namespace_);
+      instance->mutable_service()->set_value(service_key_.name_);
+      instance->mutable_id()->set_value(instances[i].first);
+      instance->mutable_host()->set_value(instances[i].second.first);
+      instance->mutable_port()->set_value(instances[i].second.second);
+      instance->mutable_weight()->set_value(100);
+    }
+    // 与服务端连接器一样使用递增的缓存版本号
+    ServiceData* service_data = ServiceData::CreateFromPb(&response, kDataIsSyncing, revision_);
+    EXPECT_EQ(context_->GetLocalRegistry()->UpdateServiceData(service_key_, kServiceDataInstances, service_data),
+              kReturnOk);
+    return service_data;
+  }
+
+  ReturnCode GetInstanceId(const std::string& host, int port, std::string& instance_id) {
+    InstanceHostPortKey host_port_key;
+    host_port_key.Set(host, port);
+    instance_id.clear();
+    return cache_manager_->GetInstanceId(service_key_, host_port_key, instance_id);
+  }
+
+ protected:
+  Context* context_;
+  CacheManager* cache_manager_;
+  ServiceKey service_key_;
+  int revision_;
+};
+
+TEST_F(CacheManagerHostPortTest, GetInstanceIdByAddress) {
+  InstanceList instances;
+  instances.push_back(std::make_pair("instance_v4", std::make_pair("10.0.0.1", 8000)));
+  instances.push_back(std::make_pair("instance_v6", std::make_pair("fe80::1", 8001)));
+  instances.push_back(std::make_pair("instance_host", std::make_pair("host.example", 8002)));
+  UpdateInstances(instances);
+
+  std::string instance_id;
+  ASSERT_EQ(GetInstanceId("10.0.0.1", 8000, instance_id), kReturnOk);
+  ASSERT_EQ(instance_id, "instance_v4");
+  // IPv4映射的IPv6地址与IPv4地址等价
+  ASSERT_EQ(GetInstanceId("::ffff:10.0.0.1", 8000, instance_id), kReturnOk);
+  ASSERT_EQ(instance_id, "instance_v4");
+  ASSERT_EQ(GetInstanceId("::FFFF:a00:1", 8000, instance_id), kReturnOk);
+  ASSERT_EQ(instance_id, "instance_v4");
+  // IPv6地址的不同写法
+  ASSERT_EQ(GetInstanceId("FE80:0:0:0:0:0:0:1", 8001, instance_id), kReturnOk);
+  ASSERT_EQ(instance_id, "instance_v6");
+  // 域名按字符串查找
+  ASSERT_EQ(GetInstanceId("host.example", 8002, instance_id), kReturnOk);
+  ASSERT_EQ(instance_id, "instance_host");
+
+  ASSERT_EQ(GetInstanceId("10.0.0.1", 8001, instance_id), kReturnInstanceNotFound);
+  ASSERT_EQ(GetInstanceId("HOST.example", 8002, instance_id), kReturnInstanceNotFound);
+}
+
+TEST_F(CacheManagerHostPortTest, UpdateIndexOnInstanceChange) {
+  InstanceList instances;
+  instances.push_back(std::make_pair("instance_1", std::make_pair("10.0.0.1", 8000)));
+  instances.push_back(std::make_pair("instance_2", std::make_pair("host.example", 8000)));
+  UpdateInstances(instances);
+
+  std::string instance_id;
+  ASSERT_EQ(GetInstanceId("10.0.0.1", 8000, instance_id), kReturnOk);
+  ASSERT_EQ(instance_id, "instance_1");
+  ASSERT_EQ(GetInstanceId("10.0.0.2", 8000, instance_id), kReturnInstanceNotFound);
+
+  // 删除实例1，新增两个实例
+  instances.erase(instances.begin());
+  instances.push_back(std::make_pair("instance_3", std::make_pair("10.0.0.2", 8000)));
+  instances.push_back(std::make_pair("instance_4", std::make_pair("other.example", 8000)));
+  ServiceData* service_data = UpdateInstances(instances);
+  service_data->IncrementRef();
+  cache_manager_->OnServiceDataChange(service_data);  // 测试上下文不启动线程，直接执行服务数据变更事件
+
+  ASSERT_EQ(GetInstanceId("10.0.0.1", 8000, instance_id), kReturnInstanceNotFound);
+  ASSERT_EQ(GetInstanceId("::ffff:10.0.0.2", 8000, instance_id), kReturnOk);
+  ASSERT_EQ(instance_id, "instance_3");
+  ASSERT_EQ(GetInstanceId("host.example", 8000, instance_id), kReturnOk);
+  ASSERT_EQ(instance_id, "instance_2");
+  ASSERT_EQ(GetInstanceId("other.example", 8000, instance_id), kReturnOk);
+  ASSERT_EQ(instance_id, "instance_4");
+}
+
+TEST_F(CacheManagerHostPortTest, LookupNewInstanceBeforeIndexUpdate) {
+  InstanceList instances;
+  instances.push_back(std::make_pair("instance_1", std::make_pair("10.0.0.1", 8000)));
+  UpdateInstances(instances);
+  std::string instance_id;
+  ASSERT_EQ(GetInstanceId("10.0.0.1", 8000, instance_id), kReturnOk);
+
+  // 数据变更事件处理前查找新实例，索引版本落后时立即重建
+  instances.push_back(std::make_pair("instance_2", std::make_pair("host.example", 8000)));
+  UpdateInstances(instances);
+  ASSERT_EQ(GetInstanceId("host.example", 8000, instance_id), kReturnOk);
+  ASSERT_EQ(instance_id, "instance_2");
+}
+
+}  // namespace polaris
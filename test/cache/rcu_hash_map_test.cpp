@@ -0,0 +1,236 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use
+//  this file
+//  except in compliance with the License. You may obtain a copy of the License
+//  at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//  specific
+//  language governing permissions and limitations under the License.
+//
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <pthread.h>
+
+#include "cache/rcu_hash_map.h"
+#include "cache/rcu_time.h"
+
+#include "test_utils.h"
+
+#include "polaris/model.h"
+
+namespace polaris {
+
+class HashServiceValue : public ServiceBase {
+ public:
+  explicit HashServiceValue(int value) { value_ = value; }
+
+  virtual ~HashServiceValue() {}
+
+  int GetValue() { return value_; }
+
+ private:
+  int value_;
+};
+
+// 只使用低4位的hash函数，用于构造大量hash冲突
+struct CollisionHash {
+  std::size_t operator()(int key) const { return static_cast<std::size_t>(key & 0xF); }
+};
+
+class RcuHashMapTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() { rcu_map_ = new RcuHashMap<int, HashServiceValue>(); }
+
+  virtual void TearDown() {
+    if (rcu_map_ != nullptr) {
+      delete rcu_map_;
+      rcu_map_ = nullptr;
+    }
+  }
+
+ protected:
+  RcuHashMap<int, HashServiceValue> *rcu_map_;
+};
+
+TEST_F(RcuHashMapTest, SingleThreadTest) {
+  HashServiceValue *value = rcu_map_->Get(0);
+  ASSERT_TRUE(value == nullptr);
+
+  for (int i = 0; i < 100; ++i) {
+    rcu_map_->Update(i, new HashServiceValue(i));
+    for (int j = 0; j < i; j++) {
+      if (j % 2 == 0) {
+        rcu_map_->Delete(i);
+        ASSERT_TRUE(rcu_map_->Get(i) == nullptr);
+        rcu_map_->Update(i, new HashServiceValue(j));
+      } else {
+        rcu_map_->Update(i, new HashServiceValue(i - 1));
+      }
+      value = rcu_map_->Get(i);
+      ASSERT_TRUE(value != nullptr);
+      if (j % 2 == 0) {
+        ASSERT_EQ(value->GetValue(), j);
+      } else {
+        ASSERT_EQ(value->GetValue(), i - 1);
+      }
+      value->DecrementRef();
+    }
+    rcu_map_->CheckGc(Time::GetCoarseSteadyTimeMs());
+  }
+}
+
+TEST_F(RcuHashMapTest, ReadTableAfterSwap) {
+  const int key_count = 1000;
+  for (int i = 0; i < key_count; ++i) {
+    rcu_map_->Update(i, new HashServiceValue(i));
+  }
+  // 读取所有key触发dirty map重建为read table
+  for (int i = 0; i < key_count; ++i) {
+    HashServiceValue *value = rcu_map_->GetWithRcuTime(i);
+    ASSERT_TRUE(value != nullptr);
+  }
+  for (int i = 0; i < key_count; ++i) {
+    HashServiceValue *value = rcu_map_->GetWithRcuTime(i);
+    ASSERT_TRUE(value != nullptr);
+    ASSERT_EQ(value->GetValue(), i);
+  }
+  ASSERT_TRUE(rcu_map_->GetWithRcuTime(key_count) == nullptr);
+
+  // 删除后read table中保留的key返回NULL，重新插入后可读到新值
+  for (int i = 0; i < key_count; i += 2) {
+    rcu_map_->Delete(i);
+  }
+  for (int i = 0; i < key_count; ++i) {
+    HashServiceValue *value = rcu_map_->GetWithRcuTime(i);
+    if (i % 2 == 0) {
+      ASSERT_TRUE(value == nullptr);
+      rcu_map_->Update(i, new HashServiceValue(i + key_count));
+    } else {
+      ASSERT_TRUE(value != nullptr);
+      ASSERT_EQ(value->GetValue(), i);
+    }
+  }
+  for (int i = 0; i < key_count; i += 2) {
+    HashServiceValue *value = rcu_map_->GetWithRcuTime(i);
+    ASSERT_TRUE(value != nullptr);
+    ASSERT_EQ(value->GetValue(), i + key_count);
+  }
+
+  std::vector<int> expired_keys;
+  rcu_map_->CheckExpired(Time::GetCoarseSteadyTimeMs() + 1, expired_keys);
+  ASSERT_EQ(expired_keys.size(), key_count);
+  rcu_map_->CheckGc(Time::GetCoarseSteadyTimeMs() + 1);
+}
+
+TEST(RcuHashMapCollisionTest, LinearProbing) {
+  RcuHashMap<int, int, CollisionHash> rcu_map(ValueNoOp, ValueDelete);
+  const int key_count = 256;
+  for (int i = 0; i < key_count; ++i) {
+    rcu_map.Update(i, new int(i));
+  }
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < key_count; ++i) {
+      int *value = rcu_map.Get(i);
+      ASSERT_TRUE(value != nullptr);
+      ASSERT_EQ(*value, i);
+    }
+  }
+  for (int i = key_count; i < key_count * 2; ++i) {
+    ASSERT_TRUE(rcu_map.Get(i) == nullptr);
+  }
+}
+
+struct HashThreadArgs {
+  RcuHashMap<int, HashServiceValue> *cache_;
+  ThreadTimeMgr *thread_time_mgr_;
+};
+
+void *RandomOperationHashCache(void *args) {
+  HashThreadArgs *thread_args = static_cast<HashThreadArgs *>(args);
+  int cache_num = 100;
+  int total = cache_num * 5000;
+  static __thread bool thread_local_seed_not_init = true;
+  static __thread unsigned int thread_local_seed = 0;
+  if (thread_local_seed_not_init) {
+    thread_local_seed_not_init = false;
+    thread_local_seed = time(nullptr) ^ pthread_self();
+  }
+  for (int i = 0; i < total; ++i) {
+    int key = i % cache_num;
+    int op = rand_r(&thread_local_seed) % 6;
+    if (op == 0 || op == 2 || op == 4) {
+      thread_args->thread_time_mgr_->RcuEnter();
+      HashServiceValue *value = thread_args->cache_->Get(key);
+      if (value != nullptr) {
+        EXPECT_EQ((value->GetValue()) % cache_num, key) << key << ":" << value->GetValue();
+        value->DecrementRef();
+      }
+      thread_args->thread_time_mgr_->RcuExit();
+    } else if (op == 1 || op == 3) {
+      thread_args->cache_->Update(key, new HashServiceValue(i));
+    } else {
+      thread_args->cache_->Delete(key);
+    }
+    if (key == 0) {
+      thread_args->cache_->CheckGc(thread_args->thread_time_mgr_->MinTime());
+    }
+  }
+  return nullptr;
+}
+
+TEST_F(RcuHashMapTest, MultiThreadTest) {
+  ThreadTimeMgr *thread_time_mgr = new ThreadTimeMgr();
+  ASSERT_TRUE(thread_time_mgr != nullptr);
+  std::vector<pthread_t> thread_list;
+  HashThreadArgs thread_args = {rcu_map_, thread_time_mgr};
+  pthread_t tid;
+  for (int i = 0; i < 32; ++i) {
+    pthread_create(&tid, nullptr, RandomOperationHashCache, &thread_args);
+    thread_list.push_back(tid);
+  }
+  for (std::size_t i = 0; i < thread_list.size(); ++i) {
+    pthread_join(thread_list[i], nullptr);
+  }
+
+  delete thread_time_mgr;
+}
+
+TEST(RcuHashMapNoOpTest, CreateOrGetTest) {
+  RcuHashMap<int, int> rcu_map(ValueNoOp, ValueDelete);
+  for (int i = 0; i < 1000; ++i) {
+    int key = i;
+    std::function<int *()> creator = [=] { return new int(i); };
+    int *value = rcu_map.CreateOrGet(key, creator);
+    ASSERT_TRUE(value != nullptr);
+    ASSERT_EQ(*value, i);
+    std::function<int *()> creator2 = [=] { return new int(i + 1); };
+    value = rcu_map.CreateOrGet(key, creator2);
+    ASSERT_TRUE(value != nullptr);
+    ASSERT_EQ(*value, i);
+
+    // 触发内部map交换
+    for (int j = 0; j < i + 2; ++j) {
+      value = rcu_map.Get(key);
+    }
+
+    rcu_map.Delete(key);
+    value = rcu_map.CreateOrGet(key, creator2);
+    ASSERT_TRUE(value != nullptr);
+    ASSERT_EQ(*value, i + 1);
+  }
+
+  std::vector<int *> values;
+  rcu_map.GetAllValuesWithRef(values);
+  ASSERT_EQ(values.size(), 1000);
+}
+
+}  // namespace polaris
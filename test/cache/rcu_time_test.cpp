@@ -86,6 +86,35 @@ TEST_F(RcuTimeTest, MultiThreadTest) {
   ASSERT_EQ(thread_time_mgr_->MinTime(), Time::GetCoarseSteadyTimeMs());
 }
 
+void *ThreadFuncEnterOnce(void *args) {
+  ThreadTimeMgr *thread_time_mgr = static_cast<ThreadTimeMgr *>(args);
+  thread_time_mgr->RcuEnter();
+  thread_time_mgr->RcuExit();
+  return nullptr;
+}
+
+TEST_F(RcuTimeTest, MinTimeAcrossSlotBlocks) {
+  // 主线程停留在RCU区域内，其他线程占用多个分组的槽位后退出
+  uint64_t enter_time = Time::GetCoarseSteadyTimeMs();
+  thread_time_mgr_->RcuEnter();
+  std::vector<pthread_t> thread_list;
+  pthread_t tid;
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 100; ++i) {
+      pthread_create(&tid, nullptr, ThreadFuncEnterOnce, thread_time_mgr_);
+      thread_list.push_back(tid);
+    }
+    for (std::size_t i = 0; i < thread_list.size(); ++i) {
+      pthread_join(thread_list[i], nullptr);
+    }
+    thread_list.clear();
+    TestUtils::FakeNowIncrement(1000);
+    ASSERT_EQ(thread_time_mgr_->MinTime(), enter_time);
+  }
+  thread_time_mgr_->RcuExit();
+  ASSERT_EQ(thread_time_mgr_->MinTime(), Time::GetCoarseSteadyTimeMs());
+}
+
 struct ThreadCount {
   explicit ThreadCount(ThreadTimeMgr *thread_time_mgr) : thread_time_mgr_(thread_time_mgr), count_(0) {}
   ThreadTimeMgr *thread_time_mgr_;
@@ -41,8 +41,27 @@ struct TestServiceCacheKey {
       return false;
     }
   }
+
+  bool operator==(const TestServiceCacheKey &rhs) const {
+    return this->service_base_ == rhs.service_base_ && this->index_ == rhs.index_;
+  }
 };
 
+}  // namespace polaris
+
+namespace std {
+
+template <>
+struct hash<polaris::TestServiceCacheKey> {
+  std::size_t operator()(const polaris::TestServiceCacheKey &key) const {
+    return polaris::HashCombine(hash<polaris::ServiceBase *>()(key.service_base_), key.index_);
+  }
+};
+
+}  // namespace std
+
+namespace polaris {
+
 class TestServiceCacheValue : public ServiceBase {
  public:
   virtual ~TestServiceCacheValue() {}
@@ -23,6 +23,8 @@
 #include "context/service_context.h"
 #include "mock/fake_server_response.h"
 #include "plugin/load_balancer/ringhash/ringhash.h"
+#include "plugin/service_router/route_result.h"
+#include "test_utils.h"
 
 namespace polaris {
 
@@ -31,6 +33,7 @@ class ServiceContextTest : public ::testing::Test {
   virtual void SetUp() {
     context_ = nullptr;
     config_ = nullptr;
+    TestUtils::CreateTempDir(persist_dir_);
   }
 
   virtual void TearDown() {
@@ -42,11 +45,17 @@ class ServiceContextTest : public ::testing::Test {
       delete config_;
       config_ = nullptr;
     }
+    TestUtils::RemoveDir(persist_dir_);
   }
 
+ protected:
+  // 使用常驻的重建线程重建超过并行重建最小组合数的缓存，检查重建结果及创建的辅助线程数
+  void CheckEagerRebuildWithExecutors(const std::string& threads_config, std::size_t executor_count);
+
  protected:
   Config* config_;
   Context* context_;
+  std::string persist_dir_;
 };
 
 TEST_F(ServiceContextTest, TestServiceLevelConfig) {
@@ -203,4 +212,135 @@ TEST_F(ServiceContextTest, TestInstanceExistChecker) {
   service_data->DecrementRef();
 }
 
+static bool RouteWithMetadata(ServiceContext* service_context, const ServiceKey& service_key,
+                              const std::string& version, uint64_t circuit_breaker_version) {
+  RouteInfo route_info(service_key, nullptr);
+  MetadataRouterParam metadata_param;
+  metadata_param.metadata_["version"] = version;
+  metadata_param.failover_type_ = kMetadataFailoverAll;
+  route_info.SetMetadataPara(metadata_param);
+  EXPECT_EQ(service_context->GetServiceRouterChain()->PrepareRouteInfo(route_info, 1000), kReturnOk);
+  route_info.SetCircuitBreakerVersion(circuit_breaker_version);
+  RouteResult route_result;
+  EXPECT_EQ(service_context->DoRoute(route_info, &route_result), kReturnOk);
+  return route_result.NewInstancesSet();
+}
+
+TEST_F(ServiceContextTest, TestEagerRebuildHotCache) {
+  std::string err_msg;
+  std::string content = R"##(
+global:
+  serverConnector:
+    addresses:
+    - 127.0.0.1:8091
+consumer:
+  localCache:
+    persistDir: )##" + persist_dir_ + R"##(
+  serviceRouter:
+    chain:
+      - dstMetaRouter
+    eagerRebuildSize: 2
+    eagerRebuildThreads: 2
+)##";
+
+  config_ = Config::CreateFromString(content, err_msg);
+  ASSERT_TRUE(config_ != nullptr && err_msg.empty());
+  context_ = Context::Create(config_);
+  ASSERT_TRUE(context_ != nullptr);
+
+  ServiceKey service_key = {"Test", "polaris.cpp.sdk.test"};
+  ASSERT_EQ(FakeServer::InitService(context_->GetLocalRegistry(), service_key, 10, false), kReturnOk);
+  auto service_context = context_->GetContextImpl()->GetServiceContext(service_key);
+  ASSERT_TRUE(service_context != nullptr);
+
+  // v1和v2访问较多，v3和v4只访问一次
+  for (int i = 0; i < 640; ++i) {
+    ASSERT_EQ(RouteWithMetadata(service_context, service_key, "v1", 0), i == 0);
+  }
+  for (int i = 0; i < 320; ++i) {
+    ASSERT_EQ(RouteWithMetadata(service_context, service_key, "v2", 0), i == 0);
+  }
+  ASSERT_TRUE(RouteWithMetadata(service_context, service_key, "v3", 0));
+  ASSERT_TRUE(RouteWithMetadata(service_context, service_key, "v4", 0));
+
+  CacheRebuildStat rebuild_stat;
+  ASSERT_FALSE(service_context->CollectCacheRebuildStat(rebuild_stat));
+  service_context->UpdateCircuitBreaker(service_key, 1);
+  ASSERT_TRUE(service_context->CollectCacheRebuildStat(rebuild_stat));
+  ASSERT_EQ(rebuild_stat.rebuild_count_, 1);
+  ASSERT_EQ(rebuild_stat.eager_count_, 2);
+  ASSERT_EQ(rebuild_stat.lazy_count_, 2);
+  ASSERT_EQ(rebuild_stat.max_queue_depth_, 2);
+  ASSERT_FALSE(service_context->CollectCacheRebuildStat(rebuild_stat));
+
+  // 访问较多的组合已提前重建，其余组合在请求时重建
+  ASSERT_FALSE(RouteWithMetadata(service_context, service_key, "v1", 1));
+  ASSERT_FALSE(RouteWithMetadata(service_context, service_key, "v2", 1));
+  ASSERT_TRUE(RouteWithMetadata(service_context, service_key, "v3", 1));
+  ASSERT_TRUE(RouteWithMetadata(service_context, service_key, "v4", 1));
+  // 组合较少时由发起线程直接重建，不创建辅助线程
+  ASSERT_EQ(context_->GetContextImpl()->GetCacheRebuildExecutorCount(), 0);
+}
+
+void ServiceContextTest::CheckEagerRebuildWithExecutors(const std::string& threads_config,
+                                                        std::size_t executor_count) {
+  std::string err_msg;
+  std::string content = R"##(
+global:
+  serverConnector:
+    addresses:
+    - 127.0.0.1:8091
+consumer:
+  localCache:
+    persistDir: )##" + persist_dir_ + R"##(
+  serviceRouter:
+    chain:
+      - dstMetaRouter
+    )##" + threads_config + R"##(
+)##";
+
+  config_ = Config::CreateFromString(content, err_msg);
+  ASSERT_TRUE(config_ != nullptr && err_msg.empty());
+  context_ = Context::Create(config_);
+  ASSERT_TRUE(context_ != nullptr);
+  ContextImpl* context_impl = context_->GetContextImpl();
+  ASSERT_EQ(context_impl->GetCacheRebuildExecutorCount(), 0);  // 首次并行重建时才创建辅助线程
+
+  ServiceKey service_key = {"Test", "polaris.cpp.sdk.test"};
+  ASSERT_EQ(FakeServer::InitService(context_->GetLocalRegistry(), service_key, 10, false), kReturnOk);
+  auto service_context = context_impl->GetServiceContext(service_key);
+  ASSERT_TRUE(service_context != nullptr);
+
+  const int version_count = 20;  // 超过并行重建的最小组合数
+  for (int i = 0; i < version_count; ++i) {
+    ASSERT_TRUE(RouteWithMetadata(service_context, service_key, "v" + std::to_string(i), 0));
+  }
+  for (uint64_t circuit_breaker_version = 1; circuit_breaker_version <= 10; ++circuit_breaker_version) {
+    service_context->UpdateCircuitBreaker(service_key, circuit_breaker_version);
+    for (int i = 0; i < version_count; ++i) {
+      ASSERT_FALSE(RouteWithMetadata(service_context, service_key, "v" + std::to_string(i), circuit_breaker_version));
+    }
+  }
+  ASSERT_EQ(context_impl->GetCacheRebuildExecutorCount(), executor_count);
+  CacheRebuildStat rebuild_stat;
+  ASSERT_TRUE(service_context->CollectCacheRebuildStat(rebuild_stat));
+  ASSERT_EQ(rebuild_stat.rebuild_count_, 10);
+  ASSERT_EQ(rebuild_stat.eager_count_, 10 * version_count);
+  ASSERT_EQ(rebuild_stat.lazy_count_, 0);
+  ASSERT_EQ(rebuild_stat.max_queue_depth_, version_count);
+}
+
+TEST_F(ServiceContextTest, TestEagerRebuildWithExecutors) {
+  ASSERT_NO_FATAL_FAILURE(CheckEagerRebuildWithExecutors("", 3));  // 默认每轮4个线程，包括发起线程
+}
+
+TEST_F(ServiceContextTest, TestEagerRebuildSingleThread) {
+  ASSERT_NO_FATAL_FAILURE(CheckEagerRebuildWithExecutors("eagerRebuildThreads: 1", 0));
+}
+
+TEST_F(ServiceContextTest, TestEagerRebuildThreadsLimit) {
+  // 超过上限时按上限每轮16个线程重建
+  ASSERT_NO_FATAL_FAILURE(CheckEagerRebuildWithExecutors("eagerRebuildThreads: 100", 15));
+}
+
 }  // namespace polaris
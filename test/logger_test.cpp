@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 #include <pthread.h>
 
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -136,6 +137,74 @@ TEST_F(LoggerTest, MultiThreadWriteLog) {
   delete logger;
 }
 
+struct AsyncWriteLogParam {
+  Logger *logger;
+  int log_count;
+};
+
+void *AsyncWriteLogThread(void *args) {
+  AsyncWriteLogParam *param = static_cast<AsyncWriteLogParam *>(args);
+  for (int i = 0; i < param->log_count; ++i) {
+    param->logger->Log(LOG_INFO, "async write log %d", i);
+  }
+  return nullptr;
+}
+
+TEST_F(LoggerTest, AsyncWriteLog) {
+  LoggerImpl *logger = new LoggerImpl(log_path_, log_file_name_, 32 * 1024 * 1024, max_file_no_);
+  ASSERT_TRUE(logger->EnableAsync(16));
+  ASSERT_FALSE(logger->EnableAsync(16));
+  AsyncWriteLogParam param;
+  param.logger = logger;
+  param.log_count = 2000;
+  std::vector<pthread_t> thread_list;
+  pthread_t tid;
+  for (int i = 0; i < 4; ++i) {
+    pthread_create(&tid, nullptr, AsyncWriteLogThread, &param);
+    ASSERT_TRUE(tid > 0);
+    thread_list.push_back(tid);
+  }
+  for (std::size_t i = 0; i < thread_list.size(); ++i) {
+    pthread_join(thread_list[i], nullptr);
+  }
+  // FATAL日志同步写入
+  logger->Log(LOG_FATAL, "async fatal log");
+  uint64_t dropped_count = logger->GetDroppedCount();
+  delete logger;
+
+  std::ifstream log_file((log_path_ + "/" + log_file_name_).c_str());
+  std::string line;
+  int log_count = 0;
+  int fatal_count = 0;
+  uint64_t reported_dropped_count = 0;
+  while (std::getline(log_file, line)) {
+    if (line.find(" INFO async write log ") != std::string::npos) {
+      ASSERT_TRUE(line.find("logger_test.cpp") != std::string::npos) << line;
+      log_count++;
+    } else if (line.find(" FATAL async fatal log") != std::string::npos) {
+      fatal_count++;
+    } else {
+      std::size_t pos = line.find("async log buffer is full, ");
+      ASSERT_TRUE(pos != std::string::npos) << line;
+      reported_dropped_count += strtoull(line.c_str() + pos + strlen("async log buffer is full, "), nullptr, 10);
+    }
+  }
+  ASSERT_EQ(fatal_count, 1);
+  ASSERT_EQ(reported_dropped_count, dropped_count);
+  ASSERT_EQ(log_count + dropped_count, static_cast<uint64_t>(4 * param.log_count));
+}
+
+TEST_F(LoggerTest, AsyncFileShift) {
+  LoggerImpl *logger = new LoggerImpl(log_path_, log_file_name_, max_file_size_, max_file_no_);
+  ASSERT_TRUE(logger->EnableAsync());
+  for (int i = 0; i < 10; ++i) {
+    logger->Log(LOG_INFO, "test async log file shift");
+  }
+  delete logger;
+  ASSERT_TRUE(FileUtils::FileExists(log_path_ + "/" + log_file_name_));
+  ASSERT_TRUE(FileUtils::FileExists(log_path_ + "/" + log_file_name_ + ".0"));
+}
+
 TEST_F(LoggerTest, TestChangeLogDir) {
   LoggerImpl *logger = new LoggerImpl(log_path_, log_file_name_, max_file_size_, max_file_no_);
   ASSERT_TRUE(logger != nullptr);
@@ -0,0 +1,169 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "model/route_rule_matcher.h"
+
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include "model/service_route_rule.h"
+
+namespace polaris {
+
+class RouteRuleMatcherTest : public ::testing::Test {
+  virtual void SetUp() {
+    src_service_.namespace_ = "test_namespace";
+    src_service_.name_ = "test_service";
+    dst_service_.namespace_ = "Test";
+    dst_service_.name_ = "dst_service_name";
+  }
+
+  virtual void TearDown() {}
+
+ protected:
+  void AddMatchString(v1::Source* source, const std::string& key, v1::MatchString::MatchStringType type,
+                      const std::string& value, v1::MatchString::ValueType value_type = v1::MatchString::TEXT) {
+    v1::MatchString& match_string = (*source->mutable_metadata())[key];
+    match_string.set_type(type);
+    match_string.mutable_value()->set_value(value);
+    match_string.set_value_type(value_type);
+  }
+
+  void InitBounds(std::vector<RouteRuleBound>& bounds) {
+    for (std::size_t i = 0; i < bounds.size() && i < routes_.size(); ++i) {
+      bounds[i].route_rule_.InitFromPb(routes_[i]);
+    }
+  }
+
+  // 按规则顺序逐个匹配，作为编译匹配器的对照结果
+  int LinearMatch(const std::vector<RouteRuleBound>& bounds, ServiceInfo& service_info, std::string& parameters) {
+    for (std::size_t i = 0; i < bounds.size(); ++i) {
+      if (bounds[i].route_rule_.MatchSource(&service_info, dst_service_, parameters)) {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
+ protected:
+  std::vector<v1::Route> routes_;
+  ServiceKey src_service_;
+  ServiceKey dst_service_;
+};
+
+TEST_F(RouteRuleMatcherTest, ExactRegexAndParameter) {
+  routes_.resize(4);
+  AddMatchString(routes_[0].add_sources(), "env", v1::MatchString::EXACT, "prod");
+  v1::Source* source = routes_[1].add_sources();
+  AddMatchString(source, "env", v1::MatchString::REGEX, "^te.*");
+  AddMatchString(source, "uid", v1::MatchString::EXACT, "", v1::MatchString::PARAMETER);
+  source = routes_[2].add_sources();
+  source->mutable_service()->set_value("other_service");
+  AddMatchString(source, "env", v1::MatchString::EXACT, "*");
+  AddMatchString(routes_[3].add_sources(), "env", v1::MatchString::EXACT, "*");
+  std::vector<RouteRuleBound> bounds(routes_.size());
+  InitBounds(bounds);
+  RouteRuleMatcher matcher;
+  matcher.Compile(bounds);
+
+  std::map<std::string, std::string> metadata;
+  std::string parameters;
+  ASSERT_EQ(matcher.Match(src_service_, dst_service_, metadata, parameters), -1);
+
+  metadata["env"] = "prod";
+  ASSERT_EQ(matcher.Match(src_service_, dst_service_, metadata, parameters), 0);
+
+  metadata["env"] = "test";
+  ASSERT_EQ(matcher.Match(src_service_, dst_service_, metadata, parameters), 3);  // 缺少参数key
+  metadata["uid"] = "123";
+  ASSERT_EQ(matcher.Match(src_service_, dst_service_, metadata, parameters), 1);
+  ASSERT_EQ(parameters, "123");
+
+  metadata["env"] = "dev";  // 规则2服务名不匹配
+  ASSERT_EQ(matcher.Match(src_service_, dst_service_, metadata, parameters), 3);
+  src_service_.name_ = "other_service";
+  ASSERT_EQ(matcher.Match(src_service_, dst_service_, metadata, parameters), 2);
+}
+
+TEST_F(RouteRuleMatcherTest, InvalidAndEmptySourceRule) {
+  routes_.resize(3);
+  AddMatchString(routes_[0].add_sources(), "env", v1::MatchString::REGEX, "(invalid");
+  std::vector<RouteRuleBound> bounds(routes_.size());
+  InitBounds(bounds);
+  RouteRuleMatcher matcher;
+  matcher.Compile(bounds);
+
+  std::map<std::string, std::string> metadata;
+  metadata["env"] = "(invalid";
+  std::string parameters;
+  ASSERT_EQ(matcher.Match(src_service_, dst_service_, metadata, parameters), 1);
+}
+
+TEST_F(RouteRuleMatcherTest, RandomRulesSameAsLinearMatch) {
+  unsigned int seed = 1024;
+  const int key_num = 6;
+  const int value_num = 8;
+  routes_.resize(300);
+  for (std::size_t i = 0; i < routes_.size(); ++i) {
+    int source_num = rand_r(&seed) % 3;
+    for (int j = 0; j < source_num; ++j) {
+      v1::Source* source = routes_[i].add_sources();
+      if (rand_r(&seed) % 10 == 0) {
+        source->mutable_service()->set_value("other_service");
+      }
+      int match_num = 1 + rand_r(&seed) % 3;
+      for (int k = 0; k < match_num; ++k) {
+        std::string key = "k" + std::to_string(rand_r(&seed) % key_num);
+        std::string value = "v" + std::to_string(rand_r(&seed) % value_num);
+        switch (rand_r(&seed) % 5) {
+          case 0:
+            AddMatchString(source, key, v1::MatchString::REGEX, "^" + value.substr(0, 1) + "[0-3]");
+            break;
+          case 1:
+            AddMatchString(source, key, v1::MatchString::EXACT, "*");
+            break;
+          case 2:
+            AddMatchString(source, key, v1::MatchString::EXACT, "", v1::MatchString::PARAMETER);
+            break;
+          default:
+            AddMatchString(source, key, v1::MatchString::EXACT, value);
+        }
+      }
+    }
+  }
+  std::vector<RouteRuleBound> bounds(routes_.size());
+  InitBounds(bounds);
+  RouteRuleMatcher matcher;
+  matcher.Compile(bounds);
+
+  ServiceInfo service_info;
+  service_info.service_key_ = src_service_;
+  for (int i = 0; i < 2000; ++i) {
+    service_info.metadata_.clear();
+    for (int k = 0; k < key_num; ++k) {
+      if (rand_r(&seed) % 4 != 0) {
+        service_info.metadata_["k" + std::to_string(k)] = "v" + std::to_string(rand_r(&seed) % value_num);
+      }
+    }
+    std::string linear_parameters;
+    int linear_result = LinearMatch(bounds, service_info, linear_parameters);
+    std::string parameters;
+    int result = matcher.Match(service_info.service_key_, dst_service_, service_info.metadata_, parameters);
+    ASSERT_EQ(result, linear_result);
+    if (result >= 0 && !bounds[result].route_rule_.GetSources().empty()) {
+      ASSERT_EQ(parameters, linear_parameters);
+    }
+  }
+}
+
+}  // namespace polaris
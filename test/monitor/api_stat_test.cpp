@@ -18,6 +18,9 @@
 #include "monitor/api_stat_registry.h"
 
 #include <gtest/gtest.h>
+#include <pthread.h>
+
+#include <vector>
 
 #include "test_context.h"
 #include "v1/request.pb.h"
@@ -55,6 +58,12 @@ TEST_F(ApiStatTest, ApiStatRecord) {
   api_stat_registry_->GetApiStatistics(statistics);
   // 1个接口  3种返回码 1个延迟范围
   ASSERT_EQ(statistics.size(), 1 * 3 * 1);
+
+  // 只有采样的调用记录精确延迟
+  std::vector<LatencyHistogram> latency;
+  api_stat_registry_->GetApiLatency(latency);
+  ASSERT_GT(latency[kApiStatConsumerGetOne].TotalCount(), 0);
+  ASSERT_LT(latency[kApiStatConsumerGetOne].TotalCount(), 100);
 }
 
 TEST_F(ApiStatTest, ApiStatReport) {
@@ -74,4 +83,85 @@ TEST_F(ApiStatTest, ApiStatReport) {
   ASSERT_EQ(statistics.size(), 0);
 }
 
+TEST_F(ApiStatTest, ApiLatencyPercentile) {
+  for (int i = 1; i <= 10000; i++) {
+    api_stat_registry_->RecordLatency(kApiStatConsumerGetOne, i);
+  }
+  api_stat_registry_->RecordLatency(kApiStatConsumerGetBatch, 100);
+  std::vector<LatencyHistogram> latency;
+  api_stat_registry_->GetApiLatency(latency);
+  ASSERT_EQ(latency.size(), static_cast<std::size_t>(kApiStatKeyCount));
+  const LatencyHistogram& get_one = latency[kApiStatConsumerGetOne];
+  ASSERT_EQ(get_one.TotalCount(), 10000);
+  // 分桶相对误差不超过1/16
+  uint64_t percentile_values[] = {5000, 9000, 9900, 9990};
+  double percentiles[] = {0.5, 0.9, 0.99, 0.999};
+  for (int i = 0; i < 4; ++i) {
+    uint64_t value = get_one.ValueAtPercentile(percentiles[i]);
+    ASSERT_GE(value, percentile_values[i]);
+    ASSERT_LE(value, percentile_values[i] + percentile_values[i] / LatencyHistogram::kSubBucketCount);
+  }
+  ASSERT_EQ(latency[kApiStatConsumerGetBatch].TotalCount(), 1);
+  ASSERT_EQ(latency[kApiStatConsumerGetBatch].ValueAtPercentile(0.999),
+            LatencyHistogram::BucketUpperBound(LatencyHistogram::BucketIndex(100)));
+  ASSERT_EQ(latency[kApiStatConsumerGetAll].TotalCount(), 0);
+
+  // 获取后清零
+  api_stat_registry_->GetApiLatency(latency);
+  ASSERT_EQ(latency[kApiStatConsumerGetOne].TotalCount(), 0);
+}
+
+TEST_F(ApiStatTest, LatencyHistogramBucket) {
+  for (uint64_t value = 0; value < 100000; ++value) {
+    int index = LatencyHistogram::BucketIndex(value);
+    ASSERT_GE(LatencyHistogram::BucketUpperBound(index), value);
+    if (index > 0) {
+      ASSERT_LT(LatencyHistogram::BucketUpperBound(index - 1), value);
+    }
+  }
+  ASSERT_EQ(LatencyHistogram::BucketIndex(LatencyHistogram::kMaxValue + 1), LatencyHistogram::kBucketCount - 1);
+}
+
+struct ApiStatRecordParam {
+  ApiStatRegistry* registry_;
+  int record_count_;
+};
+
+void* ApiStatRecordThread(void* args) {
+  ApiStatRecordParam* param = static_cast<ApiStatRecordParam*>(args);
+  for (int i = 0; i < param->record_count_; ++i) {
+    param->registry_->Record(kApiStatConsumerGetOne, kReturnOk, i % 3);
+    param->registry_->RecordLatency(kApiStatConsumerGetOne, i % 3000);
+  }
+  return nullptr;
+}
+
+TEST_F(ApiStatTest, MultiThreadRecord) {
+  ApiStatRecordParam param;
+  param.registry_ = api_stat_registry_;
+  param.record_count_ = 10000;
+  std::vector<pthread_t> thread_list;
+  for (int i = 0; i < kApiStatShardCount + 4; ++i) {
+    pthread_t tid;
+    ASSERT_EQ(pthread_create(&tid, nullptr, ApiStatRecordThread, &param), 0);
+    thread_list.push_back(tid);
+  }
+  for (std::size_t i = 0; i < thread_list.size(); ++i) {
+    pthread_join(thread_list[i], nullptr);
+  }
+  uint64_t expect_count = thread_list.size() * param.record_count_;
+  std::vector<LatencyHistogram> latency;
+  api_stat_registry_->GetApiLatency(latency);
+  ASSERT_EQ(latency[kApiStatConsumerGetOne].TotalCount(), expect_count);
+
+  google::protobuf::RepeatedField<v1::SDKAPIStatistics> statistics;
+  api_stat_registry_->GetApiStatistics(statistics);
+  ASSERT_EQ(statistics.size(), 2);  // [0ms,2ms) 和 [2ms, 10ms)
+  uint64_t total_count = 0;
+  for (int i = 0; i < statistics.size(); ++i) {
+    total_count += statistics[i].value().total_request_per_minute().value();
+  }
+  ASSERT_EQ(total_count, expect_count);
+}
+
 }  // namespace polaris
@@ -101,6 +101,9 @@ class BackupInstanceMockServerConnectorTest : public MockServerConnectorTest {
     FakeServer::RoutingResponse(routing_response_, service_key_);
   }
 
+  // 设置不同的备份实例数获取实例，检查返回的实例数和实例不重复
+  void CheckBackupInstances(GetOneInstanceRequest &request);
+
  public:
   void MockFireEventHandler(const ServiceKey &service_key, ServiceDataType data_type, uint64_t /*sync_interval*/,
                             const std::string & /*disk_revision*/, ServiceEventHandler *handler) {
@@ -148,6 +151,19 @@ bool CheckDuplicate(std::vector<Instance> &instances) {
   return true;
 }
 
+void BackupInstanceMockServerConnectorTest::CheckBackupInstances(GetOneInstanceRequest &request) {
+  for (uint32_t i = 0; i < 20UL; i++) {
+    InstancesResponse *resp;
+    request.SetBackupInstanceNum(i);
+    ASSERT_EQ(consumer_api_->GetOneInstance(request, resp), kReturnOk);
+    std::vector<Instance> instances = resp->GetInstances();
+    delete resp;
+    uint32_t ans_num = (i + 1) > static_cast<uint32_t>(instance_num_) ? instance_num_ : (i + 1);
+    ASSERT_EQ(instances.size(), ans_num);
+    ASSERT_TRUE(CheckDuplicate(instances));
+  }
+}
+
 TEST_F(BackupInstanceMockServerConnectorTest, TestSetAndGetRoute) {
   InitServiceData();
   EXPECT_CALL(*server_connector_,
@@ -175,61 +191,16 @@ TEST_F(BackupInstanceMockServerConnectorTest, TestSetAndGetRoute) {
 
   // 正常返回个数
   request.SetLoadBalanceType(kLoadBalanceTypeWeightedRandom);
-  for (uint32_t i = 0; i < 20UL; i++) {
-    InstancesResponse *resp;
-    request.SetBackupInstanceNum(i);
-    ret = consumer_api_->GetOneInstance(request, resp);
-    ASSERT_EQ(ret, kReturnOk);
-    std::vector<Instance> instances = resp->GetInstances();
-    uint32_t ans_num = (i + 1) > static_cast<uint32_t>(instance_num_) ? instance_num_ : (i + 1);
-    ASSERT_EQ(instances.size(), ans_num);
-    ASSERT_TRUE(CheckDuplicate(instances));
-    delete resp;
-  }
-
-  // kLoadBalanceTypeRingHash
-  request.SetLoadBalanceType(kLoadBalanceTypeRingHash);
-  for (uint32_t i = 0; i < 20UL; i++) {
-    InstancesResponse *resp;
-    request.SetBackupInstanceNum(i);
-    request.SetHashKey(100);
-    ret = consumer_api_->GetOneInstance(request, resp);
-    ASSERT_EQ(ret, kReturnOk);
-    std::vector<Instance> instances = resp->GetInstances();
-    uint32_t ans_num = (i + 1) > static_cast<uint32_t>(instance_num_) ? instance_num_ : (i + 1);
-    ASSERT_EQ(instances.size(), ans_num);
-    ASSERT_TRUE(CheckDuplicate(instances));
-    delete resp;
-  }
-
-  // kLoadBalanceTypeL5CstHash
-  request.SetLoadBalanceType(kLoadBalanceTypeL5CstHash);
-  for (uint32_t i = 0; i < 20UL; i++) {
-    InstancesResponse *resp;
-    request.SetBackupInstanceNum(i);
-    request.SetHashKey(100);
-    ret = consumer_api_->GetOneInstance(request, resp);
-    ASSERT_EQ(ret, kReturnOk);
-    std::vector<Instance> instances = resp->GetInstances();
-    uint32_t ans_num = (i + 1) > static_cast<uint32_t>(instance_num_) ? instance_num_ : (i + 1);
-    ASSERT_EQ(instances.size(), ans_num);
-    ASSERT_TRUE(CheckDuplicate(instances));
-    delete resp;
-  }
-
-  // kLoadBalanceTypeCMurmurHash
-  request.SetLoadBalanceType(kLoadBalanceTypeCMurmurHash);
-  for (uint32_t i = 0; i < 20UL; i++) {
-    InstancesResponse *resp;
-    request.SetBackupInstanceNum(i);
-    request.SetHashKey(100);
-    ret = consumer_api_->GetOneInstance(request, resp);
-    ASSERT_EQ(ret, kReturnOk);
-    std::vector<Instance> instances = resp->GetInstances();
-    uint32_t ans_num = (i + 1) > static_cast<uint32_t>(instance_num_) ? instance_num_ : (i + 1);
-    ASSERT_EQ(instances.size(), ans_num);
-    ASSERT_TRUE(CheckDuplicate(instances));
-    delete resp;
+  ASSERT_NO_FATAL_FAILURE(CheckBackupInstances(request));
+
+  // 哈希负载均衡
+  LoadBalanceType hash_lb_types[] = {kLoadBalanceTypeRingHash, kLoadBalanceTypeL5CstHash, kLoadBalanceTypeCMurmurHash,
+                                     kLoadBalanceTypeMaglevHash, kLoadBalanceTypeRendezvousHash,
+                                     kLoadBalanceTypeSimpleHash};
+  request.SetHashKey(100);
+  for (std::size_t i = 0; i < sizeof(hash_lb_types) / sizeof(hash_lb_types[0]); ++i) {
+    request.SetLoadBalanceType(hash_lb_types[i]);
+    ASSERT_NO_FATAL_FAILURE(CheckBackupInstances(request));
   }
 }
 
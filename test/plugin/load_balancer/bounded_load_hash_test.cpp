@@ -0,0 +1,123 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/ringhash/bounded_load.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mock/fake_server_response.h"
+#include "model/model_impl.h"
+#include "plugin/load_balancer/instance_load.h"
+#include "test_context.h"
+
+namespace polaris {
+
+class BoundedLoadHashLbTest : public ::testing::Test {
+  virtual void SetUp() {
+    context_.reset(TestContext::CreateContext());
+    ASSERT_TRUE(context_ != nullptr);
+    std::string err_msg;
+    std::unique_ptr<Config> config(Config::CreateFromString("", err_msg));
+    load_balancer_.reset(new BoundedLoadHashLoadBalancer());
+    ASSERT_EQ(load_balancer_->Init(config.get(), context_.get()), kReturnOk);
+    ring_hash_lb_.reset(new KetamaLoadBalancer());
+    ASSERT_EQ(ring_hash_lb_->Init(config.get(), context_.get()), kReturnOk);
+
+    service_key_.namespace_ = "test_namespace";
+    service_key_.name_ = "test_name";
+    v1::DiscoverResponse response;
+    FakeServer::InstancesResponse(response, service_key_);
+    for (int i = 0; i < kInstanceCount; ++i) {
+      v1::Instance *instance = response.add_instances();
+      instance->mutable_id()->set_value("instance_" + std::to_string(i));
+      instance->mutable_host()->set_value("127.0.0." + std::to_string(i));
+      instance->mutable_port()->set_value(8000 + i);
+      instance->mutable_weight()->set_value(100);
+    }
+    service_data_ = ServiceData::CreateFromPb(&response, kDataIsSyncing);
+    service_.reset(new Service(service_key_, 1));
+    service_->UpdateData(service_data_);
+    service_instances_.reset(new ServiceInstances(service_data_));
+  }
+
+  virtual void TearDown() {
+    service_instances_.reset();
+    service_.reset();
+    service_data_->DecrementRef();
+    load_balancer_.reset();
+    ring_hash_lb_.reset();
+    context_.reset();
+  }
+
+ protected:
+  static const int kInstanceCount = 10;
+  ServiceKey service_key_;
+  ServiceData *service_data_;
+  std::unique_ptr<Service> service_;
+  std::unique_ptr<ServiceInstances> service_instances_;
+  std::unique_ptr<BoundedLoadHashLoadBalancer> load_balancer_;
+  std::unique_ptr<KetamaLoadBalancer> ring_hash_lb_;
+  std::unique_ptr<Context> context_;
+};
+
+TEST_F(BoundedLoadHashLbTest, SameAsRingHashWithoutLoad) {
+  for (int i = 0; i < 1000; ++i) {
+    Criteria criteria;
+    criteria.hash_key_ = i + 1;
+    Instance *instance = nullptr;
+    ASSERT_EQ(load_balancer_->ChooseInstance(service_instances_.get(), criteria, instance), kReturnOk);
+    ASSERT_EQ(InstanceLoadTracker::GetInflight(instance), 1);
+    InstanceLoadTracker::ReleaseInflight(instance);
+    ASSERT_EQ(InstanceLoadTracker::GetInflight(instance), 0);
+    Instance *ring_hash_instance = nullptr;
+    ASSERT_EQ(ring_hash_lb_->ChooseInstance(service_instances_.get(), criteria, ring_hash_instance), kReturnOk);
+    ASSERT_EQ(instance, ring_hash_instance);
+  }
+}
+
+TEST_F(BoundedLoadHashLbTest, HotKeySpillOver) {
+  Criteria criteria;
+  criteria.hash_key_ = 12345;
+  Instance *hash_instance = nullptr;
+  ASSERT_EQ(ring_hash_lb_->ChooseInstance(service_instances_.get(), criteria, hash_instance), kReturnOk);
+
+  // 同一个key的请求超过负载上限后分散到其他实例
+  const int request_count = 1000;
+  std::vector<Instance *> chosen_instances;
+  std::map<Instance *, int> instance_count;
+  for (int i = 0; i < request_count; ++i) {
+    Instance *instance = nullptr;
+    ASSERT_EQ(load_balancer_->ChooseInstance(service_instances_.get(), criteria, instance), kReturnOk);
+    chosen_instances.push_back(instance);
+    instance_count[instance]++;
+    ASSERT_LE(InstanceLoadTracker::GetInflight(instance), 1.25 * (i + 1) / kInstanceCount + 1);
+  }
+  ASSERT_GE(instance_count.size(), 8);  // 每个实例不超过平均负载的1.25倍，至少分散到8个实例
+  ASSERT_EQ(chosen_instances[0], hash_instance);
+
+  // 请求结束后重新选择哈希到的实例
+  for (std::size_t i = 0; i < chosen_instances.size(); ++i) {
+    InstanceLoadTracker::ReleaseInflight(chosen_instances[i]);
+  }
+  InstanceLoadTracker::ReleaseInflight(hash_instance);  // 不会减到0以下
+  ASSERT_EQ(InstanceLoadTracker::GetInflight(hash_instance), 0);
+  Instance *instance = nullptr;
+  ASSERT_EQ(load_balancer_->ChooseInstance(service_instances_.get(), criteria, instance), kReturnOk);
+  ASSERT_EQ(instance, hash_instance);
+}
+
+}  // namespace polaris
@@ -0,0 +1,143 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/least_request.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+
+#include "mock/fake_server_response.h"
+#include "model/model_impl.h"
+#include "plugin/load_balancer/instance_load.h"
+#include "test_context.h"
+
+namespace polaris {
+
+class LeastRequestLbTest : public ::testing::Test {
+  virtual void SetUp() {
+    context_.reset(TestContext::CreateContext());
+    ASSERT_TRUE(context_ != nullptr);
+    std::string err_msg;
+    std::unique_ptr<Config> config(Config::CreateFromString("", err_msg));
+    load_balancer_.reset(new LeastRequestLoadBalancer());
+    ASSERT_EQ(load_balancer_->Init(config.get(), context_.get()), kReturnOk);
+    service_key_.namespace_ = "test_namespace";
+    service_key_.name_ = "test_name";
+    service_data_ = nullptr;
+  }
+
+  virtual void TearDown() {
+    service_instances_.reset();
+    service_.reset();
+    if (service_data_ != nullptr) {
+      service_data_->DecrementRef();
+    }
+    load_balancer_.reset();
+    context_.reset();
+  }
+
+ protected:
+  void CreateInstances(const std::vector<int> &weights) {
+    v1::DiscoverResponse response;
+    FakeServer::InstancesResponse(response, service_key_);
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+      v1::Instance *instance = response.add_instances();
+      instance->mutable_id()->set_value("instance_" + std::to_string(i));
+      instance->mutable_host()->set_value("127.0.0." + std::to_string(i));
+      instance->mutable_port()->set_value(8000 + i);
+      instance->mutable_weight()->set_value(weights[i]);
+    }
+    service_data_ = ServiceData::CreateFromPb(&response, kDataIsSyncing);
+    service_.reset(new Service(service_key_, 1));
+    service_->UpdateData(service_data_);
+    service_instances_.reset(new ServiceInstances(service_data_));
+  }
+
+ protected:
+  ServiceKey service_key_;
+  ServiceData *service_data_;
+  std::unique_ptr<Service> service_;
+  std::unique_ptr<ServiceInstances> service_instances_;
+  std::unique_ptr<LeastRequestLoadBalancer> load_balancer_;
+  std::unique_ptr<Context> context_;
+};
+
+TEST_F(LeastRequestLbTest, AvoidLoadedInstance) {
+  CreateInstances({100, 100});
+  Criteria criteria;
+  Instance *loaded_instance = nullptr;
+  ASSERT_EQ(load_balancer_->ChooseInstance(service_instances_.get(), criteria, loaded_instance), kReturnOk);
+  for (int i = 0; i < 10; ++i) {
+    InstanceLoadTracker::AcquireInflight(loaded_instance);
+  }
+  // 只有两次都选中负载高的实例时才会选择它，概率为1/4
+  int loaded_count = 0;
+  for (int i = 0; i < 4000; ++i) {
+    Instance *instance = nullptr;
+    ASSERT_EQ(load_balancer_->ChooseInstance(service_instances_.get(), criteria, instance), kReturnOk);
+    if (instance == loaded_instance) {
+      loaded_count++;
+    }
+    InstanceLoadTracker::ReleaseInflight(instance);
+  }
+  ASSERT_GT(loaded_count, 800);
+  ASSERT_LT(loaded_count, 1200);
+  ASSERT_EQ(InstanceLoadTracker::GetInflight(loaded_instance), 11);
+}
+
+TEST_F(LeastRequestLbTest, BalanceInflightByWeight) {
+  CreateInstances({100, 200, 300, 400});
+  Criteria criteria;
+  // 请求都不结束时，进行中请求数按权重比例分布
+  std::map<Instance *, int> instance_count;
+  const int request_count = 10000;
+  for (int i = 0; i < request_count; ++i) {
+    Instance *instance = nullptr;
+    ASSERT_EQ(load_balancer_->ChooseInstance(service_instances_.get(), criteria, instance), kReturnOk);
+    instance_count[instance]++;
+  }
+  ASSERT_EQ(instance_count.size(), 4);
+  for (std::map<Instance *, int>::iterator it = instance_count.begin(); it != instance_count.end(); ++it) {
+    ASSERT_EQ(InstanceLoadTracker::GetInflight(it->first), it->second);
+    double expect_count = request_count * it->first->GetWeight() / 1000.0;
+    ASSERT_NEAR(it->second, expect_count, expect_count * 0.05);
+  }
+}
+
+TEST_F(LeastRequestLbTest, CountWeightOnce) {
+  CreateInstances({100, 300});
+  Criteria criteria;
+  // 请求立即结束时负载相同，两个候选实例中选择权重大的实例。候选实例等概率选出，权重只计入一次，
+  // 选中比例与权重成比例；若候选实例也按权重选出，权重小的实例只有两次都选中时才会选择，比例为1/16
+  std::map<uint32_t, int> weight_count;
+  const int request_count = 8000;
+  for (int i = 0; i < request_count; ++i) {
+    Instance *instance = nullptr;
+    ASSERT_EQ(load_balancer_->ChooseInstance(service_instances_.get(), criteria, instance), kReturnOk);
+    weight_count[instance->GetWeight()]++;
+    InstanceLoadTracker::ReleaseInflight(instance);
+  }
+  ASSERT_NEAR(weight_count[100], request_count / 4, request_count * 0.03);
+  ASSERT_NEAR(weight_count[300], request_count * 3 / 4, request_count * 0.03);
+}
+
+TEST_F(LeastRequestLbTest, NoAvailableInstance) {
+  CreateInstances({0, 0});
+  Criteria criteria;
+  Instance *instance = nullptr;
+  ASSERT_EQ(load_balancer_->ChooseInstance(service_instances_.get(), criteria, instance), kReturnInstanceNotFound);
+}
+
+}  // namespace polaris
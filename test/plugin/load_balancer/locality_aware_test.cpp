@@ -230,6 +230,46 @@ TEST_F(LocalityAwareLBBaseTest, TestLocalityAwareSelector) {
   }
 }
 
+// 反馈时携带选择结果中的下标，下标因删除实例变化后按实例ID查找
+TEST_F(LocalityAwareLBBaseTest, TestLocalityAwareSelectorFeedbackWithIndex) {
+  LocalityAwareSelector lalb(1000);
+  const int instance_num = 10;
+  for (int i = 0; i < instance_num; ++i) {
+    ASSERT_TRUE(lalb.AddInstance("instance:" + std::to_string(i)));
+  }
+
+  SelectIn in;
+  in.begin_time_us = Time::GetSteadyTimeUs();
+  in.changable_weights = true;
+  std::vector<SelectOut> outs;
+  for (int i = 0; i < instance_num * 10; ++i) {
+    SelectOut out;
+    ASSERT_EQ(kReturnOk, lalb.SelectInstance(in, &out));
+    ASSERT_TRUE(out.need_feedback);
+    ASSERT_LT(out.index, static_cast<size_t>(instance_num));
+    ASSERT_EQ(out.instance_id, "instance:" + std::to_string(out.index));
+    outs.push_back(out);
+  }
+  std::string info;
+  lalb.Describe(info);
+  ASSERT_NE(info.find("count="), std::string::npos);
+
+  // 删除下标为0的实例，最后一个实例移动到下标0，其下标失效
+  ASSERT_TRUE(lalb.RemoveInstance("instance:0"));
+  for (std::size_t i = 0; i < outs.size(); ++i) {
+    CallInfo call_info;
+    call_info.call_daley = 1000;
+    call_info.begin_time_us = in.begin_time_us;
+    call_info.instance_id = outs[i].instance_id;
+    call_info.index = outs[i].index;
+    lalb.Feedback(call_info);
+  }
+  // 所有未删除实例的进行中调用都已经结束
+  info.clear();
+  lalb.Describe(info);
+  ASSERT_EQ(info.find("count="), std::string::npos) << info;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // 测试LocalityAwareLoadBalancer
 
@@ -0,0 +1,256 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/maglev/entry_selector.h"
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mock/fake_server_response.h"
+#include "model/model_impl.h"
+#include "plugin/load_balancer/maglev/maglev.h"
+#include "polaris/config.h"
+#include "test_context.h"
+
+namespace polaris {
+
+class MaglevEntrySelectorTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    service_key_.namespace_ = "test_namespace";
+    service_key_.name_ = "test_name";
+    ASSERT_EQ(HashManager::Instance().GetHashFunction("murmur3", hash_func_), kReturnOk);
+    v1::DiscoverResponse response;
+    FakeServer::InstancesResponse(response, service_key_);
+    for (int i = 0; i < 101; ++i) {
+      v1::Instance* instance = response.add_instances();
+      instance->mutable_id()->set_value("instance_" + std::to_string(i));
+      instance->mutable_host()->set_value("127.0.0." + std::to_string(i));
+      instance->mutable_port()->set_value(8000 + i);
+      instance->mutable_weight()->set_value(i % 2 == 0 ? 100 : 50);
+    }
+    service_data_ = ServiceData::CreateFromPb(&response, kDataIsSyncing);
+    ASSERT_TRUE(service_data_ != nullptr);
+    service_ = new Service(service_key_, 1);
+    service_->UpdateData(service_data_);
+    service_instances_ = new ServiceInstances(service_data_);
+    all_instances_ = service_instances_->GetAvailableInstances()->GetInstances();
+  }
+
+  virtual void TearDown() {
+    for (std::size_t i = 0; i < instances_sets_.size(); ++i) {
+      instances_sets_[i]->DecrementRef();
+    }
+    delete service_instances_;
+    delete service_;
+    service_data_->DecrementRef();
+  }
+
+  InstancesSet* CreateInstancesSet(const std::vector<Instance*>& instances) {
+    InstancesSet* instances_set = new InstancesSet(instances);
+    instances_sets_.push_back(instances_set);
+    return instances_set;
+  }
+
+  // 原有的建表实现，用于检查优化后的结果不变
+  std::vector<uint32_t> ReferenceSetup(const std::vector<Instance*>& instances, uint32_t table_size) {
+    std::vector<uint64_t> offsets, skips, nexts(instances.size(), 0);
+    std::vector<double> normalized_weights, target_weights(instances.size(), 0);
+    double total_weight = static_cast<double>(InstancesSetImpl::CalcTotalWeight(instances));
+    double max_weight = 0;
+    char buff[128];
+    for (std::size_t i = 0; i < instances.size(); ++i) {
+      normalized_weights.push_back(instances[i]->GetWeight() / total_weight);
+      max_weight = std::max(max_weight, normalized_weights[i]);
+      snprintf(buff, sizeof(buff), "%s:%d", instances[i]->GetHost().c_str(), instances[i]->GetPort());
+      offsets.push_back(hash_func_(buff, strlen(buff), 1) % table_size);
+      skips.push_back(hash_func_(buff, strlen(buff), 2) % (table_size - 1) + 1);
+    }
+    std::vector<uint32_t> entries(table_size, static_cast<uint32_t>(-1));
+    uint32_t fill_count = 0;
+    for (uint32_t iteration = 1; fill_count < table_size; ++iteration) {
+      for (uint32_t i = 0; i < instances.size() && fill_count < table_size; ++i) {
+        if (iteration * normalized_weights[i] < target_weights[i]) {
+          continue;
+        }
+        target_weights[i] += max_weight;
+        uint32_t idx = 0;
+        do {
+          idx = (offsets[i] + skips[i] * nexts[i]) % table_size;
+          ++nexts[i];
+        } while (entries[idx] != static_cast<uint32_t>(-1));
+        entries[idx] = i;
+        ++nexts[i];
+        ++fill_count;
+      }
+    }
+    return entries;
+  }
+
+  // 计算两个查找表中映射到不同实例的表项比例
+  static double DisruptionRate(const MaglevEntrySelector& lhs, const std::vector<Instance*>& lhs_instances,
+                               const MaglevEntrySelector& rhs, const std::vector<Instance*>& rhs_instances) {
+    const std::vector<uint32_t>& lhs_entries = lhs.GetEntries();
+    const std::vector<uint32_t>& rhs_entries = rhs.GetEntries();
+    std::size_t changed = 0;
+    for (std::size_t i = 0; i < lhs_entries.size(); ++i) {
+      if (lhs_instances[lhs_entries[i]]->GetId() != rhs_instances[rhs_entries[i]]->GetId()) {
+        changed++;
+      }
+    }
+    return static_cast<double>(changed) / lhs_entries.size();
+  }
+
+  // 检查每个实例的表项数与按权重计算的配额相差不超过1
+  static void CheckBalance(const MaglevEntrySelector& selector, const std::vector<Instance*>& instances) {
+    std::vector<uint32_t> counts(instances.size(), 0);
+    for (std::size_t i = 0; i < selector.GetEntries().size(); ++i) {
+      counts[selector.GetEntries()[i]]++;
+    }
+    double total_weight = static_cast<double>(InstancesSetImpl::CalcTotalWeight(instances));
+    for (std::size_t i = 0; i < instances.size(); ++i) {
+      double quota = instances[i]->GetWeight() * selector.GetEntries().size() / total_weight;
+      ASSERT_NEAR(counts[i], quota, 1.0);
+    }
+  }
+
+ protected:
+  ServiceKey service_key_;
+  Hash64Func hash_func_;
+  ServiceData* service_data_;
+  Service* service_;
+  ServiceInstances* service_instances_;
+  std::vector<Instance*> all_instances_;
+  std::vector<InstancesSet*> instances_sets_;
+};
+
+TEST_F(MaglevEntrySelectorTest, SetupSameAsReference) {
+  uint32_t table_sizes[] = {1021, 65537};
+  for (std::size_t i = 0; i < sizeof(table_sizes) / sizeof(table_sizes[0]); ++i) {
+    MaglevEntrySelector selector;
+    ASSERT_TRUE(selector.Setup(CreateInstancesSet(all_instances_), table_sizes[i], hash_func_, false));
+    ASSERT_TRUE(selector.GetEntries() == ReferenceSetup(all_instances_, table_sizes[i]));
+  }
+}
+
+TEST_F(MaglevEntrySelectorTest, IncrementalSetupDisruption) {
+  const uint32_t table_size = 65537;
+  std::vector<Instance*> instances(all_instances_.begin(), all_instances_.end() - 1);
+  MaglevEntrySelector previous;
+  ASSERT_TRUE(previous.Setup(CreateInstancesSet(instances), table_size, hash_func_, true));
+
+  // 下线一个实例，只有该实例的表项变化
+  std::vector<Instance*> removed_instances(instances);
+  removed_instances.erase(removed_instances.begin() + 10);
+  InstancesSet* removed_set = CreateInstancesSet(removed_instances);
+  MaglevEntrySelector incremental;
+  ASSERT_TRUE(incremental.IncrementalSetup(previous, removed_set));
+  MaglevEntrySelector full;
+  ASSERT_TRUE(full.Setup(removed_set, table_size, hash_func_, false));
+  std::size_t removed_count = 0;
+  for (std::size_t i = 0; i < previous.GetEntries().size(); ++i) {
+    removed_count += previous.GetEntries()[i] == 10 ? 1 : 0;
+  }
+  double removed_rate = static_cast<double>(removed_count) / table_size;
+  double incremental_rate = DisruptionRate(previous, instances, incremental, removed_instances);
+  ASSERT_DOUBLE_EQ(incremental_rate, removed_rate);
+  ASSERT_LE(incremental_rate, DisruptionRate(previous, instances, full, removed_instances));
+  CheckBalance(incremental, removed_instances);
+
+  // 上线一个实例，只有分配给新实例的表项变化
+  InstancesSet* added_set = CreateInstancesSet(all_instances_);
+  ASSERT_TRUE(incremental.IncrementalSetup(previous, added_set));
+  ASSERT_TRUE(full.Setup(added_set, table_size, hash_func_, false));
+  std::size_t added_count = 0;
+  for (std::size_t i = 0; i < incremental.GetEntries().size(); ++i) {
+    added_count += incremental.GetEntries()[i] == all_instances_.size() - 1 ? 1 : 0;
+  }
+  double added_rate = static_cast<double>(added_count) / table_size;
+  incremental_rate = DisruptionRate(previous, instances, incremental, all_instances_);
+  ASSERT_DOUBLE_EQ(incremental_rate, added_rate);
+  ASSERT_LE(incremental_rate, DisruptionRate(previous, instances, full, all_instances_));
+  CheckBalance(incremental, all_instances_);
+
+  // 大部分实例变化时需要全量构建
+  std::vector<Instance*> other_instances(all_instances_.begin() + 80, all_instances_.end());
+  InstancesSet* other_set = CreateInstancesSet(other_instances);
+  ASSERT_FALSE(incremental.IncrementalSetup(previous, other_set));
+}
+
+TEST_F(MaglevEntrySelectorTest, LoadBalancerIncrementalRebuild) {
+  std::unique_ptr<Context> context(TestContext::CreateContext());
+  ASSERT_TRUE(context != nullptr);
+  std::string err_msg;
+  std::unique_ptr<Config> config(Config::CreateFromString("tableSize: 1021\nincrementalRebuild: true", err_msg));
+  ASSERT_TRUE(config != nullptr) << err_msg;
+  MaglevLoadBalancer load_balancer;
+  ASSERT_EQ(load_balancer.Init(config.get(), context.get()), kReturnOk);
+
+  std::vector<Instance*> instances(all_instances_.begin(), all_instances_.end() - 1);
+  InstancesSet* previous_set = CreateInstancesSet(instances);
+  ServiceInstances previous_instances(service_data_);
+  previous_instances.UpdateAvailableInstances(previous_set);
+  Criteria criteria;
+  Instance* instance = nullptr;
+  ASSERT_EQ(load_balancer.ChooseInstance(&previous_instances, criteria, instance), kReturnOk);
+  MaglevEntrySelector* previous = dynamic_cast<MaglevEntrySelector*>(previous_set->GetSelector());
+  ASSERT_TRUE(previous != nullptr);
+
+  // 实例变化后基于上一次构建的查找表增量构建
+  instances.erase(instances.begin() + 10);
+  InstancesSet* current_set = CreateInstancesSet(instances);
+  ServiceInstances current_instances(service_data_);
+  current_instances.UpdateAvailableInstances(current_set);
+  ASSERT_EQ(load_balancer.ChooseInstance(&current_instances, criteria, instance), kReturnOk);
+  MaglevEntrySelector* current = dynamic_cast<MaglevEntrySelector*>(current_set->GetSelector());
+  ASSERT_TRUE(current != nullptr);
+  MaglevEntrySelector incremental;
+  ASSERT_TRUE(incremental.IncrementalSetup(*previous, current_set));
+  ASSERT_TRUE(current->GetEntries() == incremental.GetEntries());
+}
+
+TEST_F(MaglevEntrySelectorTest, LoadBalancerBackupInstancesSkipHalfOpen) {
+  std::unique_ptr<Context> context(TestContext::CreateContext());
+  ASSERT_TRUE(context != nullptr);
+  std::string err_msg;
+  std::unique_ptr<Config> config(Config::CreateFromString("tableSize: 1021", err_msg));
+  ASSERT_TRUE(config != nullptr) << err_msg;
+  MaglevLoadBalancer load_balancer;
+  ASSERT_EQ(load_balancer.Init(config.get(), context.get()), kReturnOk);
+
+  CircuitBreakerData circuit_breaker_data;
+  circuit_breaker_data.version = 1;
+  circuit_breaker_data.half_open_instances["instance_0"] = 1;
+  circuit_breaker_data.half_open_instances["instance_1"] = 1;
+  service_->SetCircuitBreakerData(circuit_breaker_data);
+
+  // 备份实例与其他负载均衡一样从随机位置选择，不选择半开实例
+  Criteria criteria;
+  criteria.hash_key_ = 100;
+  for (int i = 0; i < 10; ++i) {
+    std::vector<Instance*> selected;
+    ASSERT_EQ(load_balancer.ChooseInstances(service_instances_, criteria, all_instances_.size(), selected), kReturnOk);
+    ASSERT_EQ(selected.size(), all_instances_.size() - 2);
+    for (std::size_t j = 0; j < selected.size(); ++j) {
+      ASSERT_NE(selected[j]->GetId(), "instance_0");
+      ASSERT_NE(selected[j]->GetId(), "instance_1");
+    }
+  }
+}
+
+}  // namespace polaris
@@ -0,0 +1,147 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/peak_ewma.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "mock/fake_server_response.h"
+#include "model/model_impl.h"
+#include "plugin/load_balancer/instance_load.h"
+#include "test_context.h"
+#include "test_utils.h"
+
+namespace polaris {
+
+class PeakEwmaLbTest : public ::testing::Test {
+  virtual void SetUp() {
+    TestUtils::SetUpFakeTime();
+    context_.reset(TestContext::CreateContext());
+    ASSERT_TRUE(context_ != nullptr);
+    std::string err_msg;
+    std::unique_ptr<Config> config(Config::CreateFromString("", err_msg));
+    load_balancer_.reset(new PeakEwmaLoadBalancer());
+    ASSERT_EQ(load_balancer_->Init(config.get(), context_.get()), kReturnOk);
+
+    service_key_.namespace_ = "test_namespace";
+    service_key_.name_ = "test_name";
+    v1::DiscoverResponse response;
+    FakeServer::InstancesResponse(response, service_key_);
+    for (int i = 0; i < 2; ++i) {
+      v1::Instance *instance = response.add_instances();
+      instance->mutable_id()->set_value("instance_" + std::to_string(i));
+      instance->mutable_host()->set_value("127.0.0." + std::to_string(i));
+      instance->mutable_port()->set_value(8000 + i);
+      instance->mutable_weight()->set_value(100);
+    }
+    service_data_ = ServiceData::CreateFromPb(&response, kDataIsSyncing);
+    service_.reset(new Service(service_key_, 1));
+    service_->UpdateData(service_data_);
+    service_instances_.reset(new ServiceInstances(service_data_));
+    const std::vector<Instance *> &instances = service_instances_->GetAvailableInstances()->GetInstances();
+    slow_instance_ = instances[0];
+    fast_instance_ = instances[1];
+  }
+
+  virtual void TearDown() {
+    service_instances_.reset();
+    service_.reset();
+    service_data_->DecrementRef();
+    load_balancer_.reset();
+    context_.reset();
+    TestUtils::TearDownFakeTime();
+  }
+
+ protected:
+  // 选择多次实例，每次选出后立即结束请求，返回选中慢实例的次数
+  int ChooseSlowCount(int choose_count) {
+    int slow_count = 0;
+    for (int i = 0; i < choose_count; ++i) {
+      Criteria criteria;
+      Instance *instance = nullptr;
+      EXPECT_EQ(load_balancer_->ChooseInstance(service_instances_.get(), criteria, instance), kReturnOk);
+      if (instance == slow_instance_) {
+        slow_count++;
+      }
+      InstanceLoadTracker::ReleaseInflight(instance);
+    }
+    return slow_count;
+  }
+
+ protected:
+  ServiceKey service_key_;
+  ServiceData *service_data_;
+  std::unique_ptr<Service> service_;
+  std::unique_ptr<ServiceInstances> service_instances_;
+  std::unique_ptr<PeakEwmaLoadBalancer> load_balancer_;
+  std::unique_ptr<Context> context_;
+  Instance *slow_instance_;
+  Instance *fast_instance_;
+};
+
+TEST_F(PeakEwmaLbTest, PeakLatencyTakeEffectImmediately) {
+  uint64_t now_ms = Time::GetCoarseSteadyTimeMs();
+  InstanceLoadTracker::UpdateLatency(fast_instance_, 1000, now_ms);
+  ASSERT_EQ(InstanceLoadTracker::GetLatencyEwma(fast_instance_, now_ms), 1000);
+  InstanceLoadTracker::UpdateLatency(fast_instance_, 5000, now_ms);
+  ASSERT_EQ(InstanceLoadTracker::GetLatencyEwma(fast_instance_, now_ms), 5000);
+
+  // 耗时降低时按时间衰减合并
+  InstanceLoadTracker::UpdateLatency(fast_instance_, 1000, now_ms + 10000);
+  double latency = InstanceLoadTracker::GetLatencyEwma(fast_instance_, now_ms + 10000);
+  ASSERT_NEAR(latency, 1000 + 4000 / 2.718281828, 1);
+}
+
+TEST_F(PeakEwmaLbTest, StaleLatencyDecay) {
+  uint64_t now_ms = Time::GetCoarseSteadyTimeMs();
+  InstanceLoadTracker::UpdateLatency(slow_instance_, 10000, now_ms);
+  ASSERT_NEAR(InstanceLoadTracker::GetLatencyEwma(slow_instance_, now_ms + 10000), 10000 / 2.718281828, 1);
+  ASSERT_LT(InstanceLoadTracker::GetLatencyEwma(slow_instance_, now_ms + 100000), 1);
+}
+
+TEST_F(PeakEwmaLbTest, AvoidSlowInstance) {
+  uint64_t now_ms = Time::GetCoarseSteadyTimeMs();
+  InstanceLoadTracker::UpdateLatency(slow_instance_, 10000, now_ms);
+  InstanceLoadTracker::UpdateLatency(fast_instance_, 1000, now_ms);
+  // 只有两次都随机到慢实例时才会选中，概率为1/4
+  int slow_count = ChooseSlowCount(4000);
+  ASSERT_GT(slow_count, 800);
+  ASSERT_LT(slow_count, 1200);
+
+  // 快实例进行中的请求数使其代价超过慢实例后选择慢实例
+  for (int i = 0; i < 10; ++i) {
+    InstanceLoadTracker::AcquireInflight(fast_instance_);
+  }
+  ASSERT_GT(ChooseSlowCount(4000), 2800);
+  for (int i = 0; i < 10; ++i) {
+    InstanceLoadTracker::ReleaseInflight(fast_instance_);
+  }
+
+  // 慢实例长时间没有调用后耗时衰减，重新被选中
+  TestUtils::FakeNowIncrement(60 * 1000);
+  InstanceLoadTracker::UpdateLatency(fast_instance_, 1000, Time::GetCoarseSteadyTimeMs());
+  ASSERT_GT(ChooseSlowCount(4000), 2800);
+}
+
+TEST_F(PeakEwmaLbTest, PenalizeInstanceWithoutLatency) {
+  InstanceLoadTracker::UpdateLatency(fast_instance_, 1000, Time::GetCoarseSteadyTimeMs());
+  // 没有耗时数据的实例没有进行中请求时优先选择，有进行中请求时尽量避免选择
+  ASSERT_GT(ChooseSlowCount(4000), 2800);
+  InstanceLoadTracker::AcquireInflight(slow_instance_);
+  ASSERT_LT(ChooseSlowCount(4000), 1200);
+  InstanceLoadTracker::ReleaseInflight(slow_instance_);
+}
+
+}  // namespace polaris
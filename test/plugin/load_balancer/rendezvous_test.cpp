@@ -0,0 +1,172 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/rendezvous/rendezvous.h"
+
+#include <gtest/gtest.h>
+#include <math.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mock/fake_server_response.h"
+#include "model/model_impl.h"
+#include "test_context.h"
+
+namespace polaris {
+
+static uint32_t Fmix32(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+class RendezvousHashLbTest : public ::testing::Test {
+  virtual void SetUp() {
+    context_.reset(TestContext::CreateContext());
+    ASSERT_TRUE(context_ != nullptr);
+    std::string err_msg;
+    std::unique_ptr<Config> config(Config::CreateFromString("", err_msg));
+    load_balancer_.reset(new RendezvousHashLoadBalancer());
+    ASSERT_EQ(load_balancer_->Init(config.get(), context_.get()), kReturnOk);
+    service_key_.namespace_ = "test_namespace";
+    service_key_.name_ = "test_name";
+  }
+
+  virtual void TearDown() {
+    for (std::size_t i = 0; i < service_data_list_.size(); ++i) {
+      service_data_list_[i]->DecrementRef();
+    }
+    load_balancer_.reset();
+    context_.reset();
+  }
+
+ protected:
+  ServiceData *CreateServiceData(const std::vector<int> &weights, int skip_index) {
+    v1::DiscoverResponse response;
+    FakeServer::InstancesResponse(response, service_key_);
+    for (int i = 0; i < static_cast<int>(weights.size()); ++i) {
+      if (i == skip_index) {
+        continue;
+      }
+      v1::Instance *instance = response.add_instances();
+      instance->mutable_id()->set_value("instance_" + std::to_string(i));
+      instance->mutable_host()->set_value("127.0.0." + std::to_string(i));
+      instance->mutable_port()->set_value(8000 + i);
+      instance->mutable_weight()->set_value(weights[i]);
+    }
+    ServiceData *service_data = ServiceData::CreateFromPb(&response, kDataIsSyncing);
+    service_data_list_.push_back(service_data);
+    return service_data;
+  }
+
+  Instance *Choose(ServiceData *service_data, uint64_t hash_key, int replicate_index = 0) {
+    Service service(service_key_, 1);
+    service.UpdateData(service_data);
+    ServiceInstances service_instances(service_data);
+    Criteria criteria;
+    criteria.hash_key_ = hash_key;
+    criteria.replicate_index_ = replicate_index;
+    Instance *instance = nullptr;
+    EXPECT_EQ(load_balancer_->ChooseInstance(&service_instances, criteria, instance), kReturnOk);
+    return instance;
+  }
+
+ protected:
+  ServiceKey service_key_;
+  std::vector<ServiceData *> service_data_list_;
+  std::unique_ptr<RendezvousHashLoadBalancer> load_balancer_;
+  std::unique_ptr<Context> context_;
+};
+
+TEST_F(RendezvousHashLbTest, DistributionByWeight) {
+  ServiceData *service_data = CreateServiceData({100, 200, 300, 400}, -1);
+  std::map<std::string, int> instance_count;
+  const int key_count = 100000;
+  for (int i = 1; i <= key_count; ++i) {
+    instance_count[Choose(service_data, i)->GetId()]++;
+  }
+  ASSERT_EQ(instance_count.size(), 4);
+  for (int i = 0; i < 4; ++i) {
+    double expect_count = key_count * (i + 1) / 10.0;
+    ASSERT_NEAR(instance_count["instance_" + std::to_string(i)], expect_count, expect_count * 0.05);
+  }
+}
+
+TEST_F(RendezvousHashLbTest, MinimalDisruption) {
+  std::vector<int> weights;
+  for (int i = 0; i < 100; ++i) {
+    weights.push_back(i % 3 == 0 ? 200 : 100);
+  }
+  ServiceData *service_data = CreateServiceData(weights, -1);
+  ServiceData *new_service_data = CreateServiceData(weights, 42);  // 下线一个实例
+  int moved_count = 0;
+  for (int i = 1; i <= 10000; ++i) {
+    Instance *instance = Choose(service_data, i);
+    Instance *new_instance = Choose(new_service_data, i);
+    if (instance->GetId() == "instance_42") {
+      moved_count++;
+    } else {
+      ASSERT_EQ(instance->GetId(), new_instance->GetId());
+    }
+  }
+  ASSERT_GT(moved_count, 0);
+}
+
+TEST_F(RendezvousHashLbTest, SameAsReference) {
+  // 超过向量化的最小实例数，且包含多个权重分组
+  std::vector<int> weights;
+  for (int i = 0; i < 300; ++i) {
+    weights.push_back(100 * (i % 4 + 1));
+  }
+  ServiceData *service_data = CreateServiceData(weights, -1);
+  ServiceInstances service_instances(service_data);
+  const std::vector<Instance *> &instances = service_instances.GetAvailableInstances()->GetInstances();
+  Hash64Func hash_func = nullptr;
+  ASSERT_EQ(HashManager::Instance().GetHashFunction("murmur3", hash_func), kReturnOk);
+  for (uint64_t hash_key = 1; hash_key <= 2000; ++hash_key) {
+    uint64_t hash_value = hash_func(static_cast<const void *>(&hash_key), sizeof(hash_key), 0);
+    uint32_t key = Fmix32(static_cast<uint32_t>(hash_value ^ (hash_value >> 32)));
+    Instance *expect_instance = nullptr;
+    double max_score = 0;
+    for (std::size_t i = 0; i < instances.size(); ++i) {
+      uint64_t seed = instances[i]->GetHash();
+      uint32_t score = Fmix32(static_cast<uint32_t>(seed ^ (seed >> 32)) ^ key);
+      double weighted_score = log((score + 1.0) / 4294967296.0) / instances[i]->GetWeight();
+      if (expect_instance == nullptr || weighted_score > max_score) {
+        max_score = weighted_score;
+        expect_instance = instances[i];
+      }
+    }
+    ASSERT_EQ(Choose(service_data, hash_key), expect_instance);
+  }
+}
+
+TEST_F(RendezvousHashLbTest, ReplicateInstances) {
+  ServiceData *service_data = CreateServiceData({100, 100, 200, 200, 300}, -1);
+  for (uint64_t hash_key = 1; hash_key <= 100; ++hash_key) {
+    std::set<Instance *> replicate_instances;
+    for (int i = 0; i < 5; ++i) {
+      replicate_instances.insert(Choose(service_data, hash_key, i));
+    }
+    ASSERT_EQ(replicate_instances.size(), 5);  // 得分依次降低的实例各不相同
+    ASSERT_EQ(Choose(service_data, hash_key, 5), Choose(service_data, hash_key, 0));
+  }
+}
+
+}  // namespace polaris
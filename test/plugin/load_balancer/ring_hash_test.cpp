@@ -18,6 +18,9 @@
 #include "plugin/load_balancer/ringhash/ringhash.h"
 
 #include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include <algorithm>
 
 #include "mock/fake_server_response.h"
 #include "model/model_impl.h"
@@ -217,4 +220,118 @@ TEST_P(RingHashCstLbTest, TestSelectReplicateInstance) {
 
 INSTANTIATE_TEST_CASE_P(Test, RingHashCstLbTest, ::testing::Bool());
 
+TEST(ContinuumSelectorTest, IncrementalSetupSameAsFastSetup) {
+  ServiceKey service_key = {"test_namespace", "test_name"};
+  v1::DiscoverResponse response;
+  FakeServer::InstancesResponse(response, service_key);
+  for (int i = 0; i < 60; ++i) {
+    v1::Instance *instance = response.add_instances();
+    instance->mutable_id()->set_value("instance_" + std::to_string(i));
+    instance->mutable_host()->set_value("127.0.0." + std::to_string(i));
+    instance->mutable_port()->set_value(8000 + i);
+    instance->mutable_weight()->set_value(80 + random() % 40);
+  }
+  ServiceData *service_data = ServiceData::CreateFromPb(&response, kDataIsSyncing);
+  ASSERT_TRUE(service_data != nullptr);
+  Service service(service_key, 1);
+  service.UpdateData(service_data);
+  ServiceInstances service_instances(service_data);
+  const std::vector<Instance *> &all_instances = service_instances.GetAvailableInstances()->GetInstances();
+  Hash64Func hash_func = nullptr;
+  ASSERT_EQ(HashManager::Instance().GetHashFunction("murmur3", hash_func), kReturnOk);
+  const uint32_t vnode_count = 100;
+  const int base_weight = 100;  // 设置基础权重，实例变化不影响其他实例的虚拟节点数
+  std::set<Instance *> half_open_instances;
+
+  std::vector<Instance *> instances(all_instances.begin(), all_instances.begin() + 50);
+  ContinuumSelector previous(hash_func);
+  previous.FastSetup(instances, half_open_instances, vnode_count, base_weight, false);
+  // 下线2个实例，上线5个实例，并把一个实例设置为半开
+  instances.erase(instances.begin() + 10);
+  instances.erase(instances.begin() + 20);
+  instances.insert(instances.end(), all_instances.begin() + 50, all_instances.begin() + 55);
+  half_open_instances.insert(instances[30]);
+  ContinuumSelector incremental(hash_func);
+  ASSERT_TRUE(incremental.IncrementalSetup(previous, instances, half_open_instances, vnode_count, base_weight, false));
+  ContinuumSelector full(hash_func);
+  full.FastSetup(instances, half_open_instances, vnode_count, base_weight, false);
+  // 节点哈希值没有冲突，增量构建与全量构建的哈希环相同
+  for (int i = 0; i < 10000; ++i) {
+    Criteria criteria;
+    criteria.hash_key_ = random();
+    ASSERT_EQ(incremental.Select(criteria), full.Select(criteria));
+  }
+
+  // 大部分实例变化时需要全量构建
+  std::vector<Instance *> other_instances(all_instances.begin() + 45, all_instances.end());
+  ContinuumSelector changed(hash_func);
+  ASSERT_FALSE(changed.IncrementalSetup(previous, other_instances, half_open_instances, vnode_count, base_weight, false));
+  service_data->DecrementRef();
+}
+
+TEST(LastSelectorCacheTest, KeyBySubsetAndEvictUnused) {
+  ServiceKey service_key = {"test_namespace", "test_name"};
+  std::vector<Instance *> instances;
+  std::map<std::string, std::string> subset_a, subset_b;
+  subset_a["zone"] = "a";
+  subset_b["zone"] = "b";
+  InstancesSet *set_a = new InstancesSet(instances, subset_a);
+  InstancesSet *set_b = new InstancesSet(instances, subset_b);
+  InstancesSet *other_set_a = new InstancesSet(instances, subset_a);
+
+  LastSelectorCache<ContinuumSelector> *cache = new LastSelectorCache<ContinuumSelector>();
+  std::shared_ptr<ContinuumSelector> selector_a(new ContinuumSelector(nullptr));
+  std::shared_ptr<ContinuumSelector> selector_b(new ContinuumSelector(nullptr));
+  cache->Set(service_key, set_a, selector_a);
+  cache->Set(service_key, set_b, selector_b);
+  // 同一服务的不同实例子集互不覆盖，相同子集的新实例集合可以获取上一次的选择器
+  ASSERT_EQ(cache->Get(service_key, set_b), selector_b);
+  ASSERT_EQ(cache->Get(service_key, other_set_a), selector_a);
+  ServiceKey other_service = {"test_namespace", "other_name"};
+  ASSERT_TRUE(cache->Get(other_service, set_a) == nullptr);
+
+  // 选择器仍被持有时不淘汰，不再被持有后清理时淘汰
+  selector_b.reset();
+  cache->Clear(0);
+  ASSERT_EQ(cache->Size(), 1);
+  ASSERT_TRUE(cache->Get(service_key, set_b) == nullptr);
+  selector_a.reset();
+  cache->Clear(0);
+  ASSERT_EQ(cache->Size(), 0);
+
+  cache->DecrementRef();
+  set_a->DecrementRef();
+  set_b->DecrementRef();
+  other_set_a->DecrementRef();
+}
+
+TEST(EytzingerRingTest, FindSameAsLowerBound) {
+  unsigned int seed = time(nullptr);
+  int ring_sizes[] = {0, 1, 7, 8, 9, 63, 64, 65, 1000, 10007};
+  for (std::size_t i = 0; i < sizeof(ring_sizes) / sizeof(ring_sizes[0]); ++i) {
+    std::vector<ContinuumPoint> ring;
+    for (int j = 0; j < ring_sizes[i]; ++j) {
+      uint64_t hash_value = (static_cast<uint64_t>(rand_r(&seed)) << 33) ^ rand_r(&seed);
+      ring.push_back(ContinuumPoint(hash_value, j));
+      if (j % 10 == 0) {
+        ring.push_back(ContinuumPoint(hash_value, j));  // 相同哈希值的节点
+      }
+    }
+    std::sort(ring.begin(), ring.end());
+    EytzingerRing eytzinger_ring;
+    eytzinger_ring.Build(ring);
+    for (int j = 0; j < 10000; ++j) {
+      uint64_t hash_value = (static_cast<uint64_t>(rand_r(&seed)) << 33) ^ rand_r(&seed);
+      if (!ring.empty() && j % 3 == 0) {
+        hash_value = ring[rand_r(&seed) % ring.size()].hashVal;
+      } else if (j % 100 == 1) {
+        hash_value = j % 2 == 0 ? 0 : UINT64_MAX;
+      }
+      auto position = std::lower_bound(ring.begin(), ring.end(), hash_value);
+      int expect_index = ring.empty() ? -1 : (position == ring.end() ? ring.begin()->index : position->index);
+      ASSERT_EQ(eytzinger_ring.Find(hash_value), expect_index) << ring_sizes[i] << " " << hash_value;
+    }
+  }
+}
+
 }  // namespace polaris
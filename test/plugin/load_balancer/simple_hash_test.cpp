@@ -0,0 +1,108 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/simple_hash.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "mock/fake_server_response.h"
+#include "model/model_impl.h"
+#include "test_context.h"
+
+namespace polaris {
+
+class SimpleHashLbTest : public ::testing::Test {
+  virtual void SetUp() {
+    context_.reset(TestContext::CreateContext());
+    ASSERT_TRUE(context_ != nullptr);
+    std::string err_msg;
+    std::unique_ptr<Config> config(Config::CreateFromString("", err_msg));
+    load_balancer_.reset(new SimpleHashLoadBalancer());
+    ASSERT_EQ(load_balancer_->Init(config.get(), context_.get()), kReturnOk);
+    service_key_.namespace_ = "test_namespace";
+    service_key_.name_ = "test_name";
+
+    v1::DiscoverResponse response;
+    FakeServer::InstancesResponse(response, service_key_);
+    for (int i = 0; i < 10; ++i) {
+      v1::Instance *instance = response.add_instances();
+      instance->mutable_id()->set_value("instance_" + std::to_string(i));
+      instance->mutable_host()->set_value("127.0.0." + std::to_string(i));
+      instance->mutable_port()->set_value(8000 + i);
+      instance->mutable_weight()->set_value(100);
+    }
+    service_data_ = ServiceData::CreateFromPb(&response, kDataIsSyncing);
+  }
+
+  virtual void TearDown() {
+    service_data_->DecrementRef();
+    load_balancer_.reset();
+    context_.reset();
+  }
+
+ protected:
+  ServiceKey service_key_;
+  ServiceData *service_data_;
+  std::unique_ptr<SimpleHashLoadBalancer> load_balancer_;
+  std::unique_ptr<Context> context_;
+};
+
+TEST_F(SimpleHashLbTest, ChooseByModulo) {
+  Service service(service_key_, 1);
+  service.UpdateData(service_data_);
+  ServiceInstances service_instances(service_data_);
+  std::vector<Instance *> instances = service_instances.GetAvailableInstances()->GetInstances();
+  ASSERT_EQ(instances.size(), 10);
+  for (int round = 0; round < 2; ++round) {  // 第二轮使用缓存的结果
+    for (uint64_t hash_key = 0; hash_key < 100; ++hash_key) {
+      Criteria criteria;
+      criteria.hash_key_ = hash_key;
+      Instance *instance = nullptr;
+      ASSERT_EQ(load_balancer_->ChooseInstance(&service_instances, criteria, instance), kReturnOk);
+      ASSERT_EQ(instance, instances[hash_key % instances.size()]);
+    }
+  }
+}
+
+TEST_F(SimpleHashLbTest, SkipHalfOpenInstances) {
+  ServiceInstances service_instances(service_data_);
+  std::vector<Instance *> instances = service_instances.GetAvailableInstances()->GetInstances();
+  SimpleHashCacheValue *lb_value = new SimpleHashCacheValue();
+  lb_value->prior_date_ = new InstancesSet(instances);
+  // 半开实例位于中间和末尾，末尾的半开实例需要回绕到第一个实例
+  lb_value->half_open_instances_.insert(instances[3]);
+  lb_value->half_open_instances_.insert(instances[4]);
+  lb_value->half_open_instances_.insert(instances[9]);
+  lb_value->Setup(instances);
+  ASSERT_EQ(lb_value->hash_instances_.size(), instances.size());
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    Instance *expect = instances[i];
+    if (i == 3 || i == 4) {
+      expect = instances[5];
+    } else if (i == 9) {
+      expect = instances[0];
+    }
+    ASSERT_EQ(lb_value->hash_instances_[i], expect) << i;
+  }
+
+  // 全部为半开实例时使用取模选中的实例
+  lb_value->half_open_instances_.insert(instances.begin(), instances.end());
+  lb_value->Setup(instances);
+  ASSERT_EQ(lb_value->hash_instances_, instances);
+  lb_value->DecrementRef();
+}
+
+}  // namespace polaris
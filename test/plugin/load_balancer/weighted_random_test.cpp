@@ -0,0 +1,112 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use this file
+//  except in compliance with the License. You may obtain a copy of the License at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/load_balancer/weighted_random.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "utils/fast_random.h"
+
+namespace polaris {
+
+class WeightedRandomAliasTableTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() { lb_value_ = nullptr; }
+
+  virtual void TearDown() {
+    if (lb_value_ != nullptr) {
+      lb_value_->DecrementRef();
+    }
+    for (std::size_t i = 0; i < instances_.size(); ++i) {
+      delete instances_[i];
+    }
+  }
+
+  void BuildAliasTable(const std::vector<int>& weights) {
+    std::vector<WeightInstance> weight_instances;
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+      instances_.push_back(new Instance("instance_" + std::to_string(i), "host", 8000 + i, weights[i]));
+      weight_instances.push_back({weights[i], instances_[i]});
+    }
+    lb_value_ = new RandomLbCacheValue();
+    lb_value_->prior_date_ = new InstancesSet(instances_);
+    lb_value_->BuildAliasTable(weight_instances);
+  }
+
+  // 根据别名表计算每个实例被选中的精确概率
+  std::map<Instance*, double> CalcProbability() {
+    std::map<Instance*, double> probability;
+    const std::vector<AliasEntry>& table = lb_value_->alias_table_;
+    for (std::size_t i = 0; i < table.size(); ++i) {
+      double self = static_cast<double>(table[i].threshold_) / (1ULL << 32);
+      probability[table[i].instance_] += self / table.size();
+      probability[table[i].alias_] += (1 - self) / table.size();
+    }
+    return probability;
+  }
+
+ protected:
+  std::vector<Instance*> instances_;
+  RandomLbCacheValue* lb_value_;
+};
+
+TEST_F(WeightedRandomAliasTableTest, ProbabilityMatchWeight) {
+  std::vector<int> weights;
+  int sum_weight = 0;
+  for (int i = 0; i < 100; ++i) {
+    weights.push_back(10000 / (i + 1) + i % 7);
+    sum_weight += weights.back();
+  }
+  BuildAliasTable(weights);
+  ASSERT_EQ(lb_value_->alias_table_.size(), weights.size());
+  std::map<Instance*, double> probability = CalcProbability();
+  for (std::size_t i = 0; i < instances_.size(); ++i) {
+    ASSERT_NEAR(probability[instances_[i]], static_cast<double>(weights[i]) / sum_weight, 1e-6);
+  }
+}
+
+TEST_F(WeightedRandomAliasTableTest, EqualAndSingleWeight) {
+  std::vector<int> weights(5, 100);
+  BuildAliasTable(weights);
+  for (std::size_t i = 0; i < lb_value_->alias_table_.size(); ++i) {
+    ASSERT_EQ(lb_value_->alias_table_[i].instance_, instances_[i]);
+    ASSERT_EQ(lb_value_->alias_table_[i].threshold_, 1ULL << 32);
+  }
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(lb_value_->SelectInstance(FastRandom::Next()) != nullptr);
+  }
+}
+
+TEST_F(WeightedRandomAliasTableTest, SelectDistribution) {
+  std::vector<int> weights;
+  weights.push_back(1000);
+  weights.push_back(10);
+  weights.push_back(10);
+  weights.push_back(100);
+  BuildAliasTable(weights);
+  std::map<Instance*, int> select_count;
+  const int select_times = 1000000;
+  for (int i = 0; i < select_times; ++i) {
+    select_count[lb_value_->SelectInstance(FastRandom::Next())]++;
+  }
+  for (std::size_t i = 0; i < instances_.size(); ++i) {
+    double expect = static_cast<double>(weights[i]) / 1120 * select_times;
+    ASSERT_NEAR(select_count[instances_[i]], expect, expect * 0.1);
+  }
+}
+
+}  // namespace polaris
@@ -0,0 +1,214 @@
+//  Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+//  Licensed under the BSD 3-Clause License (the "License"); you may not use
+//  this file
+//  except in compliance with the License. You may obtain a copy of the License
+//  at
+//
+//  https://opensource.org/licenses/BSD-3-Clause
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed
+//  under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+//  CONDITIONS OF ANY KIND, either express or implied. See the License for the
+//  specific
+//  language governing permissions and limitations under the License.
+//
+
+#include "plugin/service_router/metadata_router.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mock/fake_server_response.h"
+#include "model/instance.h"
+#include "model/model_impl.h"
+#include "test_context.h"
+
+namespace polaris {
+
+class MetadataIndexTest : public ::testing::Test {
+ protected:
+  // 每10个实例中第一个没有元数据，其余实例的env交替为prod和test，host每个实例都不相同
+  virtual void SetUp() {
+    for (int i = 0; i < 100; i++) {
+      v1::Instance instance_pb;
+      instance_pb.mutable_id()->set_value("instance_" + std::to_string(i));
+      instance_pb.mutable_host()->set_value("host");
+      instance_pb.mutable_port()->set_value(8000 + i);
+      instance_pb.mutable_weight()->set_value(100);
+      if (i % 10 != 0) {
+        (*instance_pb.mutable_metadata())["env"] = i % 2 == 0 ? "prod" : "test";
+        (*instance_pb.mutable_metadata())["host"] = "host_" + std::to_string(i);
+      }
+      Instance *instance = new Instance();
+      instance->GetImpl().InitFromPb(instance_pb);
+      instance->GetImpl().SetDenseIndex(i);
+      instances_.push_back(instance);
+    }
+  }
+
+  virtual void TearDown() {
+    for (std::size_t i = 0; i < instances_.size(); i++) {
+      delete instances_[i];
+    }
+  }
+
+  std::vector<Instance *> instances_;
+};
+
+TEST_F(MetadataIndexTest, Match) {
+  MetadataIndex index(instances_, instances_.size());
+  Bitset result;
+  std::map<std::string, std::string> metadata;
+  index.Match(metadata, result);
+  ASSERT_EQ(result.Count(), instances_.size());
+
+  metadata["env"] = "prod";
+  index.Match(metadata, result);
+  ASSERT_EQ(result.Count(), 40);
+  for (std::size_t i = result.FindFirst(); i < result.Size(); i = result.FindNext(i + 1)) {
+    ASSERT_EQ(instances_[i]->GetMetadata().at("env"), "prod");
+  }
+
+  metadata["host"] = "host_12";  // 同时匹配实例较多和实例较少的键值对
+  index.Match(metadata, result);
+  ASSERT_EQ(result.Count(), 1);
+  ASSERT_EQ(result.FindFirst(), 12);
+
+  metadata["host"] = "host_13";
+  index.Match(metadata, result);
+  ASSERT_FALSE(result.Any());
+
+  metadata.clear();
+  metadata["host"] = "host_13";
+  metadata["version"] = "v1";  // key不存在
+  index.Match(metadata, result);
+  ASSERT_FALSE(result.Any());
+}
+
+TEST_F(MetadataIndexTest, MatchNotKeyWithUnhealthy) {
+  MetadataIndex index(instances_, instances_.size());
+  Bitset result;
+  std::map<std::string, std::string> metadata;
+  metadata["env"] = "gray";
+  index.MatchNotKey(metadata, result);
+  ASSERT_EQ(result.Count(), 10);  // 只有没有元数据的实例
+  for (std::size_t i = result.FindFirst(); i < result.Size(); i = result.FindNext(i + 1)) {
+    ASSERT_TRUE(instances_[i]->GetMetadata().empty());
+  }
+
+  metadata.clear();
+  metadata["version"] = "v1";
+  index.MatchNotKey(metadata, result);
+  ASSERT_EQ(result.Count(), instances_.size());
+
+  InstancesBitset unhealthy_set(instances_.size());
+  unhealthy_set.Insert(instances_[3]);
+  unhealthy_set.Insert(instances_[99]);
+  Instance other_instance;
+  other_instance.GetImpl().SetDenseIndex(instances_.size());
+  unhealthy_set.Insert(&other_instance);  // 不属于该实例数据的实例忽略
+  ASSERT_EQ(unhealthy_set.Count(), 2);
+  ASSERT_FALSE(unhealthy_set.Contains(&other_instance));
+  result.AndNot(unhealthy_set.GetBits());  // 与不健康实例集合直接做位运算
+  ASSERT_EQ(result.Count(), instances_.size() - 2);
+  ASSERT_FALSE(result.Test(3));
+  ASSERT_FALSE(result.Test(99));
+}
+
+TEST_F(MetadataIndexTest, PartialInstances) {
+  // 实例子集的索引使用完整实例数据的稠密下标
+  std::vector<Instance *> instances(instances_.begin() + 50, instances_.end());
+  MetadataIndex index(instances, instances_.size());
+  Bitset result;
+  std::map<std::string, std::string> metadata;
+  index.Match(metadata, result);
+  ASSERT_EQ(result.Size(), instances_.size());
+  ASSERT_EQ(result.Count(), instances.size());
+  ASSERT_EQ(result.FindFirst(), 50);
+  ASSERT_EQ(index.GetInstance(50), instances_[50]);
+  ASSERT_TRUE(index.GetInstance(49) == nullptr);
+
+  metadata["env"] = "gray";
+  index.MatchNotKey(metadata, result);
+  ASSERT_EQ(result.Count(), 5);  // 50、60、70、80、90
+}
+
+// 元数据路由测试
+class MetadataServiceRouterTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    context_ = TestContext::CreateContext();
+    service_router_ = new MetadataServiceRouter();
+    ASSERT_EQ(service_router_->Init(nullptr, context_), kReturnOk);
+    ServiceKey service_key = {"test_service_namespace", "test_service_name"};
+    v1::DiscoverResponse response;
+    response.set_type(v1::DiscoverResponse::INSTANCE);
+    FakeServer::InstancesResponse(response, service_key);
+    for (int i = 0; i < 6; i++) {
+      v1::Instance *instance = response.add_instances();
+      instance->mutable_id()->set_value("instance_" + std::to_string(i));
+      instance->mutable_host()->set_value("127.0.0.1");
+      instance->mutable_port()->set_value(8000 + i);
+      instance->mutable_weight()->set_value(100);
+      if (i < 4) {
+        (*instance->mutable_metadata())["env"] = i % 2 == 0 ? "prod" : "test";
+      }
+    }
+    service_ = new Service(service_key, 0);
+    service_data_ = ServiceData::CreateFromPb(&response, kDataInitFromDisk);
+    service_->UpdateData(service_data_);
+  }
+
+  virtual void TearDown() {
+    delete service_router_;
+    delete context_;
+    service_data_->DecrementRef();
+    delete service_;
+  }
+
+  InstancesSet *DoRoute(const std::map<std::string, std::string> &metadata, MetadataFailoverType failover_type) {
+    ServiceKey service_key = {"test_service_namespace", "test_service_name"};
+    RouteInfo route_info(service_key, nullptr);
+    MetadataRouterParam metadata_param;
+    metadata_param.metadata_ = metadata;
+    metadata_param.failover_type_ = failover_type;
+    route_info.SetMetadataPara(metadata_param);
+    route_info.SetServiceInstances(new ServiceInstances(service_data_));
+    RouteResult route_result;
+    EXPECT_EQ(service_router_->DoRoute(route_info, &route_result), kReturnOk);
+    return route_info.GetServiceInstances()->GetAvailableInstances();
+  }
+
+ protected:
+  Context *context_;
+  ServiceRouter *service_router_;
+  Service *service_;
+  ServiceData *service_data_;
+};
+
+TEST_F(MetadataServiceRouterTest, RouteWithCache) {
+  std::map<std::string, std::string> metadata;
+  metadata["env"] = "prod";
+  InstancesSet *instances_set = DoRoute(metadata, kMetadataFailoverNone);
+  ASSERT_EQ(instances_set->GetInstances().size(), 2);
+  ASSERT_EQ(instances_set->GetInstances()[0]->GetId(), "instance_0");
+  ASSERT_EQ(instances_set->GetInstances()[1]->GetId(), "instance_2");
+  ASSERT_EQ(instances_set->GetSubset(), metadata);
+  ASSERT_EQ(DoRoute(metadata, kMetadataFailoverNone), instances_set);  // 命中缓存
+
+  metadata["env"] = "gray";
+  ASSERT_TRUE(DoRoute(metadata, kMetadataFailoverNone)->GetInstances().empty());
+  ASSERT_EQ(DoRoute(metadata, kMetadataFailoverAll)->GetInstances().size(), 6);
+  instances_set = DoRoute(metadata, kMetadataFailoverNotKey);
+  ASSERT_EQ(instances_set->GetInstances().size(), 2);
+  ASSERT_EQ(instances_set->GetInstances()[0]->GetId(), "instance_4");
+  ASSERT_EQ(instances_set->GetInstances()[1]->GetId(), "instance_5");
+}
+
+}  // namespace polaris
@@ -100,7 +100,10 @@ TEST_F(NearbyRouterConfigTest, InitFailed) {
 // 就近路由cluster测试
 class NearbyRouterClusterTest : public ::testing::Test {
  protected:
-  virtual void SetUp() { CreateInstances(instances_); }
+  virtual void SetUp() {
+    CreateInstances(instances_);
+    unhealthy_set_.Resize(instances_.size());
+  }
   virtual void TearDown() {
     for (std::size_t i = 0; i < instances_.size(); i++) {
       delete instances_[i];
@@ -110,7 +113,7 @@ class NearbyRouterClusterTest : public ::testing::Test {
   static void CreateInstances(std::vector<Instance *> &instances);
 
   std::vector<Instance *> instances_;
-  std::set<Instance *> unhealthy_set_;
+  InstancesBitset unhealthy_set_;
   NearbyRouterConfig nearby_router_config_;
   std::vector<Instance *> result_set_;
 };
@@ -138,14 +141,15 @@ void NearbyRouterClusterTest::CreateInstances(std::vector<Instance *> &instances
     }
     Instance *instance = new Instance();
     instance->GetImpl().InitFromPb(instance_pb);
+    instance->GetImpl().SetDenseIndex(i);
     instances.push_back(instance);
   }
 }
 
 TEST_F(NearbyRouterClusterTest, DegradeWithDefaultConfig) {
-  unhealthy_set_.insert(instances_[0]);
-  unhealthy_set_.insert(instances_[1]);
-  unhealthy_set_.insert(instances_[2]);
+  unhealthy_set_.Insert(instances_[0]);
+  unhealthy_set_.Insert(instances_[1]);
+  unhealthy_set_.Insert(instances_[2]);
 
   Location location = {"华南", "深圳", "南山"};
   int match_level;
@@ -153,7 +157,7 @@ TEST_F(NearbyRouterClusterTest, DegradeWithDefaultConfig) {
     std::string content = i == 0 ? "" : "matchLevel: campus";
     ASSERT_TRUE(InitNearbyRouterConfig(nearby_router_config_, content));
     NearbyRouterCluster nearby_router_cluster(nearby_router_config_);
-    nearby_router_cluster.CalculateSet(location, instances_, unhealthy_set_);
+    nearby_router_cluster.CalculateSet(location, NearbyLocationIndex(instances_), unhealthy_set_);
     std::vector<Instance *> result_set;  // 根据健康比例选择实例
     if (i == 0) {
       // case1: 默认匹配region时，还有3个健康节点不用降级
@@ -172,7 +176,7 @@ TEST_F(NearbyRouterClusterTest, DegradeWithDefaultConfig) {
     std::string content = "matchLevel: campus\nmaxMatchLevel: campus";
     ASSERT_TRUE(InitNearbyRouterConfig(nearby_router_config_, content));
     NearbyRouterCluster nearby_router_cluster(nearby_router_config_);
-    nearby_router_cluster.CalculateSet(location, instances_, unhealthy_set_);
+    nearby_router_cluster.CalculateSet(location, NearbyLocationIndex(instances_), unhealthy_set_);
     std::vector<Instance *> result_set;  // 根据健康比例选择实例
     ASSERT_TRUE(nearby_router_cluster.CalculateResult(result_set, match_level));
     ASSERT_EQ(result_set.size(), 3);
@@ -182,8 +186,41 @@ TEST_F(NearbyRouterClusterTest, DegradeWithDefaultConfig) {
   }
 }
 
+TEST_F(NearbyRouterClusterTest, LocationIndexLookup) {
+  std::vector<Instance *> instances(instances_.rbegin(), instances_.rend());
+  NearbyLocationIndex index(instances);
+  const std::vector<Instance *> &sorted_instances = index.GetInstances();
+  ASSERT_EQ(sorted_instances.size(), instances_.size());
+  std::size_t begin[kNearbyMatchCampus + 2];
+  std::size_t end[kNearbyMatchCampus + 2];
+
+  // 不同zone下同名的campus属于不同分桶，同一位置的实例保持传入顺序
+  Location location = {"华南", "广州", "南山"};
+  index.Lookup(location, kNearbyMatchCampus, begin, end);
+  ASSERT_EQ(end[kNearbyMatchNone] - begin[kNearbyMatchNone], 10);
+  ASSERT_EQ(end[kNearbyMatchRegion] - begin[kNearbyMatchRegion], 9);
+  ASSERT_EQ(end[kNearbyMatchZone] - begin[kNearbyMatchZone], 3);
+  ASSERT_EQ(end[kNearbyMatchCampus] - begin[kNearbyMatchCampus], 3);
+  ASSERT_EQ(sorted_instances[begin[kNearbyMatchCampus]], instances_[8]);
+  ASSERT_EQ(sorted_instances[begin[kNearbyMatchCampus] + 2], instances_[6]);
+  ASSERT_EQ(begin[kNearbyMatchCampus + 1], end[kNearbyMatchCampus + 1]);
+
+  // 上一级不匹配时，更高级别均为空区间
+  location.zone = "上海";
+  index.Lookup(location, kNearbyMatchCampus, begin, end);
+  ASSERT_EQ(end[kNearbyMatchRegion] - begin[kNearbyMatchRegion], 9);
+  ASSERT_EQ(end[kNearbyMatchZone], begin[kNearbyMatchZone]);
+  ASSERT_EQ(end[kNearbyMatchCampus], begin[kNearbyMatchCampus]);
+
+  // 只查找到配置的就近级别
+  location.zone = "深圳";
+  index.Lookup(location, kNearbyMatchZone, begin, end);
+  ASSERT_EQ(end[kNearbyMatchZone] - begin[kNearbyMatchZone], 6);
+  ASSERT_EQ(begin[kNearbyMatchCampus], end[kNearbyMatchCampus]);
+}
+
 TEST_F(NearbyRouterClusterTest, CalculateLocation) {
-  unhealthy_set_.insert(instances_[0]);
+  unhealthy_set_.Insert(instances_[0]);
   int match_level;
   for (int i = 0; i < 2; ++i) {
     Location location = {"华南", "深圳", ""};
@@ -191,7 +228,7 @@ TEST_F(NearbyRouterClusterTest, CalculateLocation) {
     if (i > 0) content += "\nunhealthyPercentToDegrade: 15";
     ASSERT_TRUE(InitNearbyRouterConfig(nearby_router_config_, content));
     NearbyRouterCluster instances_with_only_zone(nearby_router_config_);
-    instances_with_only_zone.CalculateSet(location, instances_, unhealthy_set_);
+    instances_with_only_zone.CalculateSet(location, NearbyLocationIndex(instances_), unhealthy_set_);
     ASSERT_EQ(instances_with_only_zone.data_.size(), 4);  // 4个级别分组
     ASSERT_EQ(instances_with_only_zone.data_[kNearbyMatchCampus].healthy_.size(), 0);
     ASSERT_EQ(instances_with_only_zone.data_[kNearbyMatchCampus].unhealthy_.size(), 0);
@@ -213,7 +250,7 @@ TEST_F(NearbyRouterClusterTest, CalculateLocation) {
   Location location = {"华南", "深圳", "南山"};
   ASSERT_TRUE(InitNearbyRouterConfig(nearby_router_config_, "matchLevel: region"));
   NearbyRouterCluster instances_match_region(nearby_router_config_);
-  instances_match_region.CalculateSet(location, instances_, unhealthy_set_);
+  instances_match_region.CalculateSet(location, NearbyLocationIndex(instances_), unhealthy_set_);
   ASSERT_EQ(instances_match_region.data_.size(), 2);  // 2个级别分组
   ASSERT_EQ(instances_match_region.data_[kNearbyMatchRegion].healthy_.size(), 8);
   ASSERT_EQ(instances_match_region.data_[kNearbyMatchRegion].unhealthy_.size(), 1);
@@ -225,7 +262,7 @@ TEST_F(NearbyRouterClusterTest, CalculateLocation) {
   // 只匹配region和zone
   ASSERT_TRUE(InitNearbyRouterConfig(nearby_router_config_, "matchLevel: zone"));
   NearbyRouterCluster instances_match_zone(nearby_router_config_);
-  instances_match_zone.CalculateSet(location, instances_, unhealthy_set_);
+  instances_match_zone.CalculateSet(location, NearbyLocationIndex(instances_), unhealthy_set_);
   ASSERT_EQ(instances_match_zone.data_.size(), 3);  // 3个级别分组
   ASSERT_EQ(instances_match_zone.data_[kNearbyMatchZone].healthy_.size(), 5);
   ASSERT_EQ(instances_match_zone.data_[kNearbyMatchZone].unhealthy_.size(), 1);
@@ -241,13 +278,13 @@ TEST_F(NearbyRouterClusterTest, CalculateLocation) {
     content += std::to_string(i);  // 不健康比例: 10, 20, 30, 40
     ASSERT_TRUE(InitNearbyRouterConfig(nearby_router_config_, content));
     NearbyRouterCluster instances_set(nearby_router_config_);
-    instances_set.CalculateSet(location, instances_, unhealthy_set_);
+    instances_set.CalculateSet(location, NearbyLocationIndex(instances_), unhealthy_set_);
     ASSERT_EQ(instances_set.data_.size(), 4);  // 4个级别分组
     ASSERT_EQ(instances_set.data_[kNearbyMatchCampus].healthy_.size(), 2);
     ASSERT_EQ(instances_set.data_[kNearbyMatchCampus].unhealthy_.size(), 1);
     ASSERT_EQ(instances_set.data_[kNearbyMatchZone].healthy_.size(), 3);
     ASSERT_EQ(instances_set.data_[kNearbyMatchRegion].healthy_.size(), 3);
-    ASSERT_EQ(instances_set.data_[kNearbyMatchNone].healthy_.size(), 1);
+    ASSERT_EQ(instances_set.data_[kNearbyMatchNone].healthy_.size(), 0);  // 低于最大降级级别，不做计算
     result_set_.clear();
     if (i == 10 || i == 40) {  // 降级无法满足10%的比例，退回到campus就近
       ASSERT_FALSE(instances_set.CalculateResult(result_set_, match_level));
@@ -259,6 +296,62 @@ TEST_F(NearbyRouterClusterTest, CalculateLocation) {
   }
 }
 
+// 逐个实例匹配位置的原有实现，用于检查通过位置索引计算的各级别实例及其顺序不变
+static void ReferenceCalculateSet(const NearbyRouterConfig &config, const Location &location,
+                                  const std::vector<Instance *> &instances, const InstancesBitset &unhealthy_set,
+                                  std::vector<NearbyRouterSet> &data) {
+  data.resize(config.GetMatchLevel() + 1);
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    Instance *instance = instances[i];
+    int level = 0;
+    if (config.GetMatchLevel() >= kNearbyMatchRegion && location.region == instance->GetRegion()) {
+      ++level;
+      if (config.GetMatchLevel() >= kNearbyMatchZone && location.zone == instance->GetZone()) {
+        ++level;
+        if (config.GetMatchLevel() >= kNearbyMatchCampus && location.campus == instance->GetCampus()) {
+          ++level;
+        }
+      }
+    }
+    if (!unhealthy_set.Contains(instance)) {
+      data[level].healthy_.push_back(instance);
+    } else {
+      data[level].unhealthy_.push_back(instance);
+    }
+  }
+}
+
+TEST_F(NearbyRouterClusterTest, CalculateSetKeepInstanceOrder) {
+  // 打乱实例顺序，使同一级别的实例分散在多个分桶中
+  std::vector<Instance *> instances;
+  for (int i = 0; i < 5; ++i) {
+    instances.push_back(instances_[9 - i]);
+    instances.push_back(instances_[i]);
+  }
+  unhealthy_set_.Insert(instances_[1]);
+  unhealthy_set_.Insert(instances_[4]);
+  unhealthy_set_.Insert(instances_[7]);
+  NearbyLocationIndex index(instances);
+  Location locations[] = {{"华南", "深圳", "南山"}, {"华南", "广州", "南山"}, {"华南", "深圳", "宝安"},
+                          {"华北", "北京", "朝阳"}, {"华南", "上海", ""}};
+  const char *contents[] = {"matchLevel: campus\nmaxMatchLevel: none", "matchLevel: zone\nmaxMatchLevel: none",
+                            "matchLevel: region\nmaxMatchLevel: none"};
+  for (std::size_t i = 0; i < sizeof(contents) / sizeof(contents[0]); ++i) {
+    ASSERT_TRUE(InitNearbyRouterConfig(nearby_router_config_, contents[i]));
+    for (std::size_t j = 0; j < sizeof(locations) / sizeof(locations[0]); ++j) {
+      NearbyRouterCluster nearby_router_cluster(nearby_router_config_);
+      nearby_router_cluster.CalculateSet(locations[j], index, unhealthy_set_);
+      std::vector<NearbyRouterSet> expect;
+      ReferenceCalculateSet(nearby_router_config_, locations[j], instances, unhealthy_set_, expect);
+      ASSERT_EQ(nearby_router_cluster.data_.size(), expect.size());
+      for (std::size_t level = 0; level < expect.size(); ++level) {
+        ASSERT_TRUE(nearby_router_cluster.data_[level].healthy_ == expect[level].healthy_) << i << " " << j;
+        ASSERT_TRUE(nearby_router_cluster.data_[level].unhealthy_ == expect[level].unhealthy_) << i << " " << j;
+      }
+    }
+  }
+}
+
 // 就近路由测试
 class NearbyServiceRouterTest : public ::testing::Test {
  protected:
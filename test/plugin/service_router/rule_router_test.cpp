@@ -63,7 +63,7 @@ static const uint32_t kRuleDefaultWeight = 0;
 
 TEST_F(RuleServiceRouterTest, CalculateByRoute) {
   std::vector<Instance *> instances;
-  std::set<Instance *> unhealthy_instances;
+  InstancesBitset unhealthy_instances(10);
   for (int i = 0; i < 10; i++) {
     v1::Instance instance_pb;
     instance_pb.mutable_id()->set_value("instance_" + std::to_string(i));
@@ -74,6 +74,7 @@ TEST_F(RuleServiceRouterTest, CalculateByRoute) {
     (*instance_pb.mutable_metadata())["key4"] = "v" + std::to_string(i % 4);
     Instance *instance = new Instance();
     instance->GetImpl().InitFromPb(instance_pb);
+    instance->GetImpl().SetDenseIndex(i);
     instances.push_back(instance);
   }
   // id   0   1   2   3   4   5   6   7   8   9
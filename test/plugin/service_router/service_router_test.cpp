@@ -422,4 +422,114 @@ TEST_F(ServiceRouterChainTest, RouteRuleNotMatch) {
   EXPECT_EQ(service_route_->DecrementAndGetRef(), 0);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// 路由链缓存测试
+class ServiceRouterChainCacheTest : public ::testing::Test {
+  virtual void SetUp() {
+    context_ = TestContext::CreateContext();
+    ASSERT_TRUE(context_ != nullptr);
+    service_key_.namespace_ = "test_namespace";
+    service_key_.name_ = "test_name";
+    v1::DiscoverResponse response;
+    FakeServer::InstancesResponse(response, service_key_);
+    for (int i = 0; i < 6; i++) {
+      v1::Instance *instance = response.add_instances();
+      instance->mutable_id()->set_value("instance_" + std::to_string(i));
+      instance->mutable_host()->set_value("host");
+      instance->mutable_port()->set_value(i);
+      instance->mutable_weight()->set_value(100);
+      (*instance->mutable_metadata())["env"] = i % 2 == 0 ? "prod" : "test";
+    }
+    service_ = new Service(service_key_, 0);
+    service_data_ = ServiceData::CreateFromPb(&response, kDataInitFromDisk);
+    service_->UpdateData(service_data_);
+    service_router_chain_ = new ServiceRouterChain(service_key_);
+  }
+
+  virtual void TearDown() {
+    delete service_router_chain_;
+    delete context_;
+    service_data_->DecrementRef();
+    delete service_;
+  }
+
+ protected:
+  void InitChain(const std::string &content) {
+    std::string err_msg;
+    Config *config = Config::CreateFromString(content, err_msg);
+    ASSERT_TRUE(config != nullptr) << err_msg;
+    ASSERT_EQ(service_router_chain_->Init(config, context_), kReturnOk);
+    delete config;
+  }
+
+  InstancesSet *DoRoute(const std::map<std::string, std::string> &metadata, uint64_t circuit_breaker_version) {
+    RouteInfo route_info(service_key_, nullptr);
+    MetadataRouterParam metadata_param;
+    metadata_param.metadata_ = metadata;
+    route_info.SetMetadataPara(metadata_param);
+    route_info.SetCircuitBreakerVersion(circuit_breaker_version);
+    route_info.SetServiceInstances(new ServiceInstances(service_data_));
+    RouteResult route_result;
+    EXPECT_EQ(service_router_chain_->DoRoute(route_info, &route_result), kReturnOk);
+    return route_info.GetServiceInstances()->GetAvailableInstances();
+  }
+
+  int CollectMetadataRouterStat() {
+    ServiceKey service_key;
+    std::map<std::string, RouterStatData *> stat_data;
+    service_router_chain_->CollectStat(service_key, stat_data);
+    int count = 0;
+    for (std::map<std::string, RouterStatData *>::iterator it = stat_data.begin(); it != stat_data.end(); ++it) {
+      if (it->first == "dstMetaRouter") {
+        for (int i = 0; i < it->second->record_.results_size(); ++i) {
+          count += it->second->record_.results(i).period_times();
+        }
+      }
+      delete it->second;
+    }
+    return count;
+  }
+
+  Context *context_;
+  ServiceKey service_key_;
+  Service *service_;
+  ServiceData *service_data_;
+  ServiceRouterChain *service_router_chain_;
+};
+
+TEST_F(ServiceRouterChainCacheTest, RouteWithCache) {
+  InitChain("chain:\n  - dstMetaRouter\n  - nearbyBasedRouter");
+  std::map<std::string, std::string> metadata;
+  metadata["env"] = "prod";
+  InstancesSet *instances_set = DoRoute(metadata, 0);
+  ASSERT_EQ(instances_set->GetInstances().size(), 3);
+  for (int i = 0; i < 3; ++i) {  // 命中路由链缓存，调用统计与执行各路由插件时一致
+    ASSERT_EQ(DoRoute(metadata, 0), instances_set);
+  }
+  ASSERT_EQ(CollectMetadataRouterStat(), 4);
+
+  metadata["env"] = "test";  // 请求参数不同
+  InstancesSet *test_set = DoRoute(metadata, 0);
+  ASSERT_NE(test_set, instances_set);
+  ASSERT_EQ(test_set->GetInstances().size(), 3);
+  for (std::size_t i = 0; i < test_set->GetInstances().size(); ++i) {
+    ASSERT_EQ(test_set->GetInstances()[i]->GetMetadata().at("env"), "test");
+  }
+
+  metadata["env"] = "prod";  // 熔断版本变化后重新执行路由链
+  InstancesSet *new_set = DoRoute(metadata, 1);
+  ASSERT_EQ(new_set->GetInstances().size(), 3);
+  ASSERT_EQ(DoRoute(metadata, 1), new_set);
+  ASSERT_EQ(CollectMetadataRouterStat(), 3);
+}
+
+TEST_F(ServiceRouterChainCacheTest, CacheDisable) {
+  InitChain("enableChainCache: false\nchain:\n  - dstMetaRouter");
+  std::map<std::string, std::string> metadata;
+  metadata["env"] = "prod";
+  InstancesSet *instances_set = DoRoute(metadata, 0);
+  ASSERT_EQ(DoRoute(metadata, 0), instances_set);  // 命中元数据路由插件缓存
+  ASSERT_EQ(CollectMetadataRouterStat(), 2);
+}
+
 }  // namespace polaris
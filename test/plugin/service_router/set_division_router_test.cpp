@@ -58,9 +58,11 @@ class SetDivisionServiceRouterTest : public ::testing::Test {
 
       Instance *instance = new Instance();
       instance->GetImpl().InitFromPb(instance_pb);
+      instance->GetImpl().SetDenseIndex(i - 1);
       callee_instances_.push_back(instance);
-      if (i == 6) unhealthy_set_.insert(instance);
     }
+    unhealthy_set_.Resize(callee_instances_.size());
+    unhealthy_set_.Insert(callee_instances_[5]);
   }
 
   virtual void TearDown() {
@@ -80,7 +82,7 @@ class SetDivisionServiceRouterTest : public ::testing::Test {
 
  public:
   std::vector<Instance *> callee_instances_;
-  std::set<Instance *> unhealthy_set_;
+  InstancesBitset unhealthy_set_;
 
   SetDivisionServiceRouter *service_router_;
   Context *context_;
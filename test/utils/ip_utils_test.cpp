@@ -39,4 +39,28 @@ TEST(IPUtilsTest, Translate) {
   }
 }
 
+TEST(IPUtilsTest, StrIpToInt128) {
+  uint64_t ip_high = 1;
+  uint64_t ip_low = 1;
+  ASSERT_TRUE(IpUtils::StrIpToInt128("127.0.0.1", ip_high, ip_low));
+  ASSERT_EQ(ip_high, 0);
+  ASSERT_EQ(ip_low, 0xffff7f000001ULL);
+  uint64_t ipv6_high = 1;
+  uint64_t ipv6_low = 1;
+  ASSERT_TRUE(IpUtils::StrIpToInt128("::ffff:127.0.0.1", ipv6_high, ipv6_low));
+  ASSERT_EQ(ipv6_high, ip_high);
+  ASSERT_EQ(ipv6_low, ip_low);
+
+  ASSERT_TRUE(IpUtils::StrIpToInt128("fe80::1:2", ip_high, ip_low));
+  ASSERT_EQ(ip_high, 0xfe80000000000000ULL);
+  ASSERT_EQ(ip_low, 0x0000000000010002ULL);
+  ASSERT_TRUE(IpUtils::StrIpToInt128("[fe80::1:2]", ipv6_high, ipv6_low));
+  ASSERT_EQ(ipv6_high, ip_high);
+  ASSERT_EQ(ipv6_low, ip_low);
+
+  ASSERT_FALSE(IpUtils::StrIpToInt128("", ip_high, ip_low));
+  ASSERT_FALSE(IpUtils::StrIpToInt128("polaris.example.com", ip_high, ip_low));
+  ASSERT_FALSE(IpUtils::StrIpToInt128("256.0.0.1", ip_high, ip_low));
+}
+
 }  // namespace polaris